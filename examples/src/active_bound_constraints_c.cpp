@@ -66,6 +66,8 @@ int main(int argc, char *argv[]) {
   myprob.set_output_filename("../output/mango_out." + extension);
   myprob.mpi_init(MPI_COMM_WORLD);
   myprob.set_max_function_evaluations(500);
+  // A fixed seed makes the stochastic algorithms, such as mango_differential_evolution, reproducible.
+  myprob.set_random_seed(1);
 
   double lower_bounds[N_dims];
   double upper_bounds[N_dims];
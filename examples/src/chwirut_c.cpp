@@ -81,6 +81,7 @@ int main(int argc, char *argv[]) {
   myprob.set_verbose(verbose_level);
   myprob.read_input_file("../input/mango_in." + extension);
   myprob.set_output_filename("../output/mango_out." + extension);
+  myprob.mpi_partition.set_command_size(myprob.get_N_parameters()); // The state vector is sent to the workers with each task.
   myprob.mpi_init(MPI_COMM_WORLD);
   myprob.mpi_partition.write("../output/mango_mpi." + extension);
   // myprob.centered_differences = true;
@@ -132,12 +133,8 @@ void residual_function(int* N_parameters, const double* x, int* N_terms_copy, do
   MPI_Comm comm_worker_groups = this_problem->mpi_partition.get_comm_worker_groups();
   int N_procs_worker_groups = this_problem->mpi_partition.get_N_procs_worker_groups();
 
-  // Mobilize the workers in the group with this group leader:
-  this_problem->mpi_partition.mobilize_workers();
-
-  // Send the state vector to all the other procs:
-  int N = *N_parameters;
-  MPI_Bcast((double*)x, N, MPI_DOUBLE, 0, comm_worker_groups);
+  // Mobilize the workers in the group with this group leader, sending them the state vector at the same time:
+  this_problem->mpi_partition.mobilize_workers(0, x);
 
   // Compute the residual terms on this proc, or receive the terms from the worker procs.
   for (j=0; j < N_procs_worker_groups; j++) {
@@ -160,18 +157,16 @@ void worker(mango::Least_squares_problem* myprob, datapoint* yt_data) {
   int N_parameters = myprob->get_N_parameters();
   int mpi_rank_worker_groups = myprob->mpi_partition.get_rank_worker_groups();
 
-  int start_index, stop_index;
+  int start_index, stop_index, task;
   double x[3];
   double f[N_terms];
 
   partition_work(mpi_rank_worker_groups, myprob->mpi_partition.get_N_procs_worker_groups(), &start_index, &stop_index);
 
-  while (myprob->mpi_partition.continue_worker_loop()) {
+  // The state vector arrives with each task.
+  while (myprob->mpi_partition.continue_worker_loop(&task, x)) {
     if (verbose_level > 0) std::cout<< "Proc " << std::setw(5) << myprob->mpi_partition.get_rank_world() << " is processing indices " << start_index << " to " << stop_index << "\n";
 
-    // Get the state vector
-    MPI_Bcast(x, N_parameters, MPI_DOUBLE, 0, mpi_comm_worker_groups);
-	
     do_work(N_parameters, x, f, start_index, stop_index, yt_data);
 
     // Send my terms of the residual back to the master proc.
@@ -0,0 +1,116 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+////////////////////////////////////////////////////////////////////////
+
+// The purpose of this example is to test the output file for each of the residual storage policies
+// of mango::Least_squares_problem::set_residual_storage(). The same problem is solved once per policy.
+// The run with the default policy, RESIDUALS_ALL, writes output/mango_out.residual_storage_c, and the
+// runs with the other policies write output/mango_out.residual_storage_c.<policy>. run_examples checks
+// all of these files with tests/verify_increment_and_last_line_matches_internal_line.py.
+//
+// Objective function: the Rosenbrock function in least-squares form,
+// f = [10 * (y - x^2)]^2 + [1 - x]^2
+// State vector at optimum: [1, 1]
+// Minimum objective function: f = 0
+
+#define verbose_level 0
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <mpi.h>
+#include <stdlib.h>
+#include "mango.hpp"
+
+#define N_parameters 2
+#define N_terms 2
+
+void residual_function(int*, const double*, int*, double*, int*, mango::Problem*, void*);
+
+void worker(mango::Least_squares_problem*);
+
+void solve(int argc, char *argv[], mango::residual_storage_type policy, std::string suffix) {
+  double state_vector[N_parameters] = {0.0, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0};
+  double targets[N_terms] = {0.0, 0.0};
+  double best_residual_function[N_terms];
+  mango::Least_squares_problem myprob(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &residual_function, argc, argv);
+
+  myprob.set_verbose(verbose_level);
+  myprob.read_input_file("../input/mango_in.residual_storage_c");
+  myprob.set_output_filename("../output/mango_out.residual_storage_c" + suffix);
+  myprob.mpi_init(MPI_COMM_WORLD);
+  myprob.set_centered_differences(true);
+  myprob.set_max_function_evaluations(200);
+  myprob.set_N_line_search(3); // To make results independent of the # of MPI processes, N_line_search must be set to any positive integer.
+  myprob.set_residual_storage(policy);
+  myprob.set_residual_storage_interval(3); // Only used by RESIDUALS_EVERY_K.
+
+  if (myprob.mpi_partition.get_proc0_worker_groups()) {
+    double best_objective_function = myprob.optimize();
+    myprob.mpi_partition.stop_workers();
+    if (myprob.mpi_partition.get_proc0_world() && (verbose_level > 0)) {
+      std::cout << "Residual storage policy " << policy << ": best objective function " << std::setprecision(16) << best_objective_function << std::endl;
+    }
+  } else {
+    worker(&myprob);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int ierr;
+
+  if (verbose_level > 0) std::cout << "Hello world from residual_storage_c." << std::endl;
+
+  ierr = MPI_Init(&argc, &argv);
+  if (ierr != 0) {
+    std::cerr << "Error in MPI_Init." << std::endl;
+    exit(1);
+  }
+
+  solve(argc, argv, mango::RESIDUALS_BEST_ONLY, ".best_only");
+  solve(argc, argv, mango::RESIDUALS_EVERY_K, ".every_k");
+  solve(argc, argv, mango::RESIDUALS_SINGLE_PRECISION, ".single_precision");
+  solve(argc, argv, mango::RESIDUALS_DELTA_FROM_BEST, ".delta_from_best");
+  // The output file for the default policy is the one used for the summary and regression test.
+  solve(argc, argv, mango::RESIDUALS_ALL, "");
+
+  MPI_Finalize();
+
+  return 0;
+}
+
+
+void residual_function(int* N, const double* x, int* M, double* f, int* failed, mango::Problem* this_problem, void* void_user_data) {
+  // Mobilize the workers in the group with this group leader:
+  this_problem->mpi_partition.mobilize_workers();
+
+  f[0] = 10 * (x[1] - x[0] * x[0]);
+  f[1] = 1 - x[0];
+
+  *failed = false;
+}
+
+
+void worker(mango::Least_squares_problem* myprob) {
+  while (myprob->mpi_partition.continue_worker_loop()) {
+    // For this problem, the workers don't actually do any work.
+    if (verbose_level > 0) std::cout << "Proc " << std::setw(5) << myprob->mpi_partition.get_rank_world() << " could do some work here." << std::endl;
+  }
+}
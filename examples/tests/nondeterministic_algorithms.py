@@ -2,7 +2,7 @@
 
 # <nondeterministic_algorithms>
 ## This section was automatically generated by ./update_algorithms
-nondeterministic_algorithms = ["petsc_pounders","nlopt_gn_direct_l_rand","nlopt_gn_direct_l_rand_noscal","nlopt_gn_crs2_lm","nlopt_ln_praxis","nlopt_ld_mma","hopspack"]
+nondeterministic_algorithms = ["mango_cmaes","mango_differential_evolution","mango_bayesian_optimization","petsc_pounders","nlopt_gn_direct_l_rand","nlopt_gn_direct_l_rand_noscal","nlopt_gn_crs2_lm","nlopt_ln_praxis","nlopt_ld_mma","hopspack"]
 # </nondeterministic_algorithms>
 
 #'petsc_pounders','nlopt_gn_direct_l_rand','nlopt_gn_direct_l_rand_noscal','nlopt_gn_crs2_lm','nlopt_ln_praxis']
@@ -0,0 +1,383 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <Package_mango.hpp>
+#include "Bayesian_optimization.hpp"
+
+#ifndef MANGO_EIGEN_AVAILABLE
+// Eigen is NOT available.
+
+mango::Bayesian_optimization::Bayesian_optimization(Solver* solver_in) {
+  throw std::runtime_error("ERROR: The algorithm mango_bayesian_optimization was selected. This algorithm requires Eigen, but MANGO was built without Eigen.");
+}
+
+void mango::Bayesian_optimization::solve() {}
+
+#else
+// The rest of this file is used when Eigen IS available.
+
+namespace {
+  // Call work(j) for j = 0, ..., N - 1, using up to N_threads threads. As in Solver::evaluate_points_with_threads(),
+  // each thread takes the next unclaimed index whenever it finishes one.
+  void parallel_for(int N, int N_threads, const std::function<void(int)>& work) {
+    std::atomic<int> next(0);
+    auto thread_work = [&]() {
+      for (int j = next++; j < N; j = next++) work(j);
+    };
+    std::vector<std::thread> threads;
+    for (int j_thread = 1; j_thread < std::min(N_threads, N); j_thread++) threads.push_back(std::thread(thread_work));
+    thread_work();
+    for (int j_thread = 0; j_thread < (int) threads.size(); j_thread++) threads[j_thread].join();
+  }
+}
+
+//! Constructor
+mango::Bayesian_optimization::Bayesian_optimization(Solver* solver_in) {
+  solver = solver_in;
+
+  // Define shorthand variable names:
+  N_parameters = solver->N_parameters;
+  N_worker_groups = solver->mpi_partition->get_N_worker_groups();
+  N_threads = std::max(1, solver->N_threads);
+  verbose = solver->verbose;
+  max_function_evaluations = solver->max_function_evaluations;
+  proc0_world = solver->mpi_partition->get_proc0_world();
+  comm_group_leaders = solver->mpi_partition->get_comm_group_leaders();
+
+  // Parameters of the algorithm:
+  // The initial design has at least 2 * (N_parameters + 1) points, rounded up to a multiple of N_worker_groups:
+  N_initial_points = ((std::max(2 * (N_parameters + 1), N_worker_groups) + N_worker_groups - 1) / N_worker_groups) * N_worker_groups;
+  // The acquisition function is maximized over this many random points, before refining the best one:
+  N_candidates = 500 + 100 * N_parameters;
+  // The likelihood is maximized with a local search from the previous length scales and from this many random length scales:
+  N_hyperparameter_starts = 10;
+  // Added to the diagonal of the correlation matrix for numerical stability:
+  nugget = 1.0e-8;
+  // Range of the length scales, relative to the unit box:
+  min_log_length_scale = log(0.01);
+  max_log_length_scale = log(10.0);
+  // If a seed is set with Problem::set_random_seed(), results are reproducible for a given N_worker_groups.
+  // Otherwise the seed is taken from the clock.
+  seed = solver->broadcast_random_seed(comm_group_leaders);
+
+  // Make sure all group leaders agree on the bound constraints and initial condition.
+  solver->broadcast_bound_constraints(lower_bounds, upper_bounds);
+  initial_condition.resize(N_parameters);
+  solver->broadcast_initial_condition(initial_condition.data());
+
+  // Scale the initial condition to the unit box, projecting it onto the box if necessary.
+  for (int j = 0; j < N_parameters; j++) {
+    initial_condition[j] = (initial_condition[j] - lower_bounds[j]) / (upper_bounds[j] - lower_bounds[j]);
+    initial_condition[j] = std::min(1.0, std::max(0.0, initial_condition[j]));
+  }
+
+  points.resize(N_parameters, 0);
+  log_length_scales = Eigen::VectorXd::Constant(N_parameters, log(0.3));
+  random_number_generator.seed(seed);
+  function_evaluations = 0;
+}
+
+//! The main driver for Bayesian optimization
+/**
+ * The objective function is modeled by a Gaussian process with a constant mean and a Matern 5/2 kernel, with a separate length scale
+ * for each parameter. The length scales are fit by maximizing the likelihood. The initial design consists of the initial condition
+ * and a Latin hypercube in the box. After that, each round proposes one point per worker group, using expected improvement with
+ * the local penalization of Gonzalez et al, Proc. AISTATS 51, 648 (2016): the first point maximizes the expected improvement, and
+ * each subsequent point maximizes the expected improvement multiplied by penalties that vanish near the points already in the batch.
+ * The batch is then evaluated concurrently.
+ * The Gaussian process is fit on proc0_world, using N_threads threads for the likelihood and acquisition function evaluations.
+ * The other group leaders only evaluate the points they are sent.
+ */
+void mango::Bayesian_optimization::solve() {
+  if (!proc0_world) {
+    // Evaluate batches until proc0_world sends a batch size of 0.
+    int N_set;
+    while (true) {
+      MPI_Bcast(&N_set, 1, MPI_INT, 0, comm_group_leaders);
+      if (N_set == 0) break;
+      Eigen::MatrixXd new_points(N_parameters, N_set);
+      evaluate(new_points);
+    }
+    return;
+  }
+
+  Eigen::MatrixXd new_points(N_parameters, N_initial_points);
+  latin_hypercube(N_initial_points, random_number_generator, new_points);
+  new_points.col(0) = initial_condition;
+  evaluate(new_points);
+
+  while (function_evaluations < max_function_evaluations) {
+    fit_hyperparameters();
+    int N_set = std::min(N_worker_groups, max_function_evaluations - function_evaluations);
+    propose_batch(N_set, new_points);
+    evaluate(new_points);
+  }
+
+  int N_set = 0;
+  MPI_Bcast(&N_set, 1, MPI_INT, 0, comm_group_leaders);
+}
+
+//! Evaluate the objective function at a set of points concurrently, and store the results on proc0_world.
+/**
+ * All group leaders call this method. On proc0_world, the size of the set is broadcast first.
+ * @param[in] new_points The points, scaled to the unit box, one per column. Only used on proc0_world.
+ */
+void mango::Bayesian_optimization::evaluate(Eigen::MatrixXd& new_points) {
+  int N_set = new_points.cols();
+  if (proc0_world) MPI_Bcast(&N_set, 1, MPI_INT, 0, comm_group_leaders);
+  Eigen::MatrixXd unscaled_points(N_parameters, N_set);
+  for (int k = 0; k < N_set; k++) {
+    for (int j = 0; j < N_parameters; j++) unscaled_points(j, k) = lower_bounds[j] + new_points(j, k) * (upper_bounds[j] - lower_bounds[j]);
+  }
+  std::vector<double> new_objective_functions(N_set);
+  solver->evaluate_objective_set_in_parallel(N_set, unscaled_points.data(), new_objective_functions.data());
+  function_evaluations += N_set;
+  if (solver->stop_requested) max_function_evaluations = function_evaluations;
+  if (!proc0_world) return;
+
+  int N_old_points = points.cols();
+  points.conservativeResize(Eigen::NoChange, N_old_points + N_set);
+  points.rightCols(N_set) = new_points;
+  for (int k = 0; k < N_set; k++) objective_functions.push_back(new_objective_functions[k]);
+  if (verbose > 0) {
+    std::cout << "Bayesian optimization: " << function_evaluations << " function evaluations. Best objective function = " << std::setprecision(16)
+	      << *std::min_element(objective_functions.begin(), objective_functions.end()) << std::endl;
+  }
+}
+
+//! Fit the length scales of the Gaussian process by maximizing the likelihood, and factorize the correlation matrix.
+/**
+ * Failed evaluations are assigned the largest objective function among the successful ones. The values are standardized to zero
+ * mean and unit variance. Starting from the best of the previous length scales and N_hyperparameter_starts random ones, a compass
+ * search in the logarithms of the length scales is carried out. The likelihoods at each set of trial length scales are computed concurrently with threads.
+ */
+void mango::Bayesian_optimization::fit_hyperparameters() {
+  int N_points = points.cols();
+  double max_finite = -std::numeric_limits<double>::infinity();
+  for (int k = 0; k < N_points; k++) {
+    if (std::isfinite(objective_functions[k])) max_finite = std::max(max_finite, objective_functions[k]);
+  }
+  if (!std::isfinite(max_finite)) max_finite = 0;
+  standardized_values.resize(N_points);
+  for (int k = 0; k < N_points; k++) standardized_values[k] = std::isfinite(objective_functions[k]) ? objective_functions[k] : max_finite;
+  value_mean = standardized_values.mean();
+  value_scale = sqrt((standardized_values.array() - value_mean).square().sum() / N_points);
+  if (!(value_scale > 0)) value_scale = 1;
+  standardized_values = (standardized_values.array() - value_mean) / value_scale;
+
+  // Starting points for the local search:
+  std::uniform_real_distribution<double> uniform(min_log_length_scale, max_log_length_scale);
+  std::vector<Eigen::VectorXd> trials(N_hyperparameter_starts + 1, log_length_scales);
+  for (int m = 1; m <= N_hyperparameter_starts; m++) {
+    for (int j = 0; j < N_parameters; j++) trials[m][j] = uniform(random_number_generator);
+  }
+  std::vector<double> likelihoods(trials.size());
+  parallel_for(trials.size(), N_threads, [&](int m) { likelihoods[m] = log_likelihood(trials[m]); });
+  int best = std::max_element(likelihoods.begin(), likelihoods.end()) - likelihoods.begin();
+  Eigen::VectorXd center = trials[best];
+  double best_likelihood = likelihoods[best];
+
+  // Compass search:
+  for (double step = 1.0; step >= 0.05;) {
+    trials.assign(2 * N_parameters, center);
+    for (int j = 0; j < N_parameters; j++) {
+      trials[2 * j][j] = std::min(max_log_length_scale, center[j] + step);
+      trials[2 * j + 1][j] = std::max(min_log_length_scale, center[j] - step);
+    }
+    likelihoods.resize(trials.size());
+    parallel_for(trials.size(), N_threads, [&](int m) { likelihoods[m] = log_likelihood(trials[m]); });
+    best = std::max_element(likelihoods.begin(), likelihoods.end()) - likelihoods.begin();
+    if (likelihoods[best] > best_likelihood) {
+      best_likelihood = likelihoods[best];
+      center = trials[best];
+    } else {
+      step *= 0.5;
+    }
+  }
+
+  log_length_scales = center;
+  log_likelihood(log_length_scales, &cholesky);
+  alpha = cholesky.solve(standardized_values);
+  signal_variance = standardized_values.dot(alpha) / N_points;
+  if (verbose > 0) std::cout << "Bayesian optimization: length scales = " << log_length_scales.array().exp().transpose() << std::endl;
+}
+
+//! The logarithm of the likelihood of the standardized values, maximized over the signal variance, for given length scales.
+/**
+ * @param[in] log_length_scales_in The logarithms of the length scales.
+ * @param[out] cholesky_out If not NULL, the Cholesky factorization of the correlation matrix is stored here.
+ * @return The log likelihood, up to a constant, or -infinity if the correlation matrix could not be factorized.
+ */
+double mango::Bayesian_optimization::log_likelihood(const Eigen::VectorXd& log_length_scales_in, Eigen::LLT<Eigen::MatrixXd>* cholesky_out) {
+  int N_points = points.cols();
+  Eigen::VectorXd inverse_length_scales = (-log_length_scales_in).array().exp();
+  Eigen::MatrixXd scaled_points = inverse_length_scales.asDiagonal() * points;
+  Eigen::MatrixXd correlations(N_points, N_points);
+  for (int k = 0; k < N_points; k++) {
+    correlations(k, k) = 1 + nugget;
+    for (int m = 0; m < k; m++) {
+      correlations(k, m) = correlation((scaled_points.col(k) - scaled_points.col(m)).norm());
+      correlations(m, k) = correlations(k, m);
+    }
+  }
+  Eigen::LLT<Eigen::MatrixXd> factorization(correlations);
+  if (factorization.info() != Eigen::Success) return -std::numeric_limits<double>::infinity();
+  double variance = standardized_values.dot(factorization.solve(standardized_values)) / N_points;
+  double log_determinant = 2 * factorization.matrixLLT().diagonal().array().log().sum();
+  if (cholesky_out != NULL) *cholesky_out = factorization;
+  return -0.5 * N_points * log(std::max(variance, 1.0e-300)) - 0.5 * log_determinant;
+}
+
+//! The mean and standard deviation of the Gaussian process at a point, in standardized units.
+void mango::Bayesian_optimization::predict(const Eigen::VectorXd& x, double& mean, double& standard_deviation) {
+  int N_points = points.cols();
+  Eigen::VectorXd inverse_length_scales = (-log_length_scales).array().exp();
+  Eigen::VectorXd k(N_points);
+  for (int m = 0; m < N_points; m++) k[m] = correlation((inverse_length_scales.asDiagonal() * (x - points.col(m))).norm());
+  mean = k.dot(alpha);
+  Eigen::VectorXd v = cholesky.matrixL().solve(k);
+  standard_deviation = sqrt(std::max(0.0, signal_variance * (1 + nugget - v.squaredNorm())));
+}
+
+//! The gradient of the mean of the Gaussian process, in standardized units, with respect to the scaled parameters.
+Eigen::VectorXd mango::Bayesian_optimization::mean_gradient(const Eigen::VectorXd& x) {
+  Eigen::VectorXd inverse_squared_length_scales = (-2 * log_length_scales).array().exp();
+  Eigen::VectorXd inverse_length_scales = (-log_length_scales).array().exp();
+  Eigen::VectorXd gradient = Eigen::VectorXd::Zero(N_parameters);
+  for (int m = 0; m < points.cols(); m++) {
+    double r = (inverse_length_scales.asDiagonal() * (x - points.col(m))).norm();
+    // d/dr of the Matern 5/2 correlation is -(5/3) r (1 + sqrt(5) r) exp(-sqrt(5) r), and dr/dx_j = (x_j - y_j) / (l_j^2 r).
+    double factor = -(5.0 / 3.0) * (1 + sqrt(5.0) * r) * exp(-sqrt(5.0) * r);
+    gradient += alpha[m] * factor * inverse_squared_length_scales.cwiseProduct(x - points.col(m));
+  }
+  return gradient;
+}
+
+//! Choose a batch of points to evaluate next, using expected improvement with local penalization.
+/**
+ * The Lipschitz constant of the objective function is estimated as the largest gradient of the mean of the Gaussian process over
+ * the candidate points. Each point of the batch is found by maximizing the acquisition function over random candidate points,
+ * half of them uniform in the box and half near the best points found so far, and then refining the best candidate with a
+ * compass search. The acquisition function is evaluated at the candidate points concurrently with threads.
+ * @param[in] N_set The number of points in the batch.
+ * @param[out] batch The points, scaled to the unit box, one per column.
+ */
+void mango::Bayesian_optimization::propose_batch(int N_set, Eigen::MatrixXd& batch) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::normal_distribution<double> normal(0.0, 0.05);
+  int N_points = points.cols();
+  std::vector<int> order(N_points);
+  for (int k = 0; k < N_points; k++) order[k] = k;
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return standardized_values[a] < standardized_values[b]; });
+  double best_value = standardized_values[order[0]];
+
+  Eigen::MatrixXd candidates(N_parameters, N_candidates);
+  for (int m = 0; m < N_candidates; m++) {
+    if (m % 2 == 0) {
+      for (int j = 0; j < N_parameters; j++) candidates(j, m) = uniform(random_number_generator);
+    } else {
+      int k = order[(m / 2) % std::min(N_points, 10)];
+      for (int j = 0; j < N_parameters; j++) candidates(j, m) = std::min(1.0, std::max(0.0, points(j, k) + normal(random_number_generator)));
+    }
+  }
+
+  std::vector<double> gradient_norms(N_candidates);
+  parallel_for(N_candidates, N_threads, [&](int m) { gradient_norms[m] = mean_gradient(candidates.col(m)).norm(); });
+  double Lipschitz_constant = std::max(1.0e-7, *std::max_element(gradient_norms.begin(), gradient_norms.end()));
+
+  batch.resize(N_parameters, 0);
+  std::vector<double> batch_means, batch_standard_deviations;
+  std::vector<double> scores(N_candidates);
+  for (int k = 0; k < N_set; k++) {
+    parallel_for(N_candidates, N_threads, [&](int m) {
+	scores[m] = acquisition(candidates.col(m), best_value, Lipschitz_constant, batch, batch_means, batch_standard_deviations);
+      });
+    int best = std::max_element(scores.begin(), scores.end()) - scores.begin();
+    Eigen::VectorXd x = candidates.col(best);
+    double score = scores[best];
+
+    // Refine the best candidate with a compass search.
+    for (double step = 0.05; step >= 1.0e-4;) {
+      bool improved = false;
+      for (int j = 0; j < 2 * N_parameters && !improved; j++) {
+	Eigen::VectorXd trial = x;
+	trial[j / 2] = std::min(1.0, std::max(0.0, trial[j / 2] + ((j % 2 == 0) ? step : -step)));
+	double trial_score = acquisition(trial, best_value, Lipschitz_constant, batch, batch_means, batch_standard_deviations);
+	if (trial_score > score) {
+	  x = trial;
+	  score = trial_score;
+	  improved = true;
+	}
+      }
+      if (!improved) step *= 0.5;
+    }
+
+    batch.conservativeResize(Eigen::NoChange, k + 1);
+    batch.col(k) = x;
+    double mean, standard_deviation;
+    predict(x, mean, standard_deviation);
+    batch_means.push_back(mean);
+    batch_standard_deviations.push_back(standard_deviation);
+  }
+}
+
+//! The expected improvement at a point, multiplied by the local penalties for the points already in the batch.
+/**
+ * For a batch point \f$ x_j \f$ with predicted mean \f$ \mu_j \f$ and standard deviation \f$ \sigma_j \f$, the penalty is
+ * \f$ \Phi((L |x - x_j| - \mu_j + y_{min}) / \sigma_j) \f$, where \f$ \Phi \f$ is the standard normal cumulative distribution
+ * function, L is the Lipschitz constant, and \f$ y_{min} \f$ is the best value found. This is the probability that x lies outside
+ * the ball around \f$ x_j \f$ that cannot contain the minimum.
+ */
+double mango::Bayesian_optimization::acquisition(const Eigen::VectorXd& x, double best_value, double Lipschitz_constant, const Eigen::MatrixXd& batch,
+						 const std::vector<double>& batch_means, const std::vector<double>& batch_standard_deviations) {
+  double mean, standard_deviation;
+  predict(x, mean, standard_deviation);
+  double score = expected_improvement(mean, standard_deviation, best_value);
+  for (int k = 0; k < batch.cols(); k++) {
+    double z = (Lipschitz_constant * (x - batch.col(k)).norm() - batch_means[k] + best_value) / std::max(batch_standard_deviations[k], 1.0e-12);
+    score *= 0.5 * erfc(-z / sqrt(2.0));
+  }
+  return score;
+}
+
+//! The Matern 5/2 correlation function.
+/**
+ * @param[in] r The distance between two points, in units of the length scales.
+ */
+double mango::Bayesian_optimization::correlation(double r) {
+  return (1 + sqrt(5.0) * r + (5.0 / 3.0) * r * r) * exp(-sqrt(5.0) * r);
+}
+
+//! The expected improvement over best_value for minimization, for a normal distribution with the given mean and standard deviation.
+double mango::Bayesian_optimization::expected_improvement(double mean, double standard_deviation, double best_value) {
+  if (!(standard_deviation > 0)) return std::max(0.0, best_value - mean);
+  double z = (best_value - mean) / standard_deviation;
+  return standard_deviation * (z * 0.5 * erfc(-z / sqrt(2.0)) + exp(-0.5 * z * z) / sqrt(2 * M_PI));
+}
+
+//! Generate a Latin hypercube design in the unit box.
+/**
+ * @param[in] N_points The number of points.
+ * @param[in] random_number_generator The random number generator.
+ * @param[out] points The points, one per column. For each parameter, exactly one point lies in each interval [k, k+1] / N_points.
+ *   The number of rows determines the number of parameters.
+ */
+void mango::Bayesian_optimization::latin_hypercube(int N_points, std::mt19937& random_number_generator, Eigen::MatrixXd& points) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<int> permutation(N_points);
+  points.conservativeResize(Eigen::NoChange, N_points);
+  for (int j = 0; j < points.rows(); j++) {
+    for (int k = 0; k < N_points; k++) permutation[k] = k;
+    std::shuffle(permutation.begin(), permutation.end(), random_number_generator);
+    for (int k = 0; k < N_points; k++) points(j, k) = (permutation[k] + uniform(random_number_generator)) / N_points;
+  }
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef MANGO_BAYESIAN_OPTIMIZATION_H
+#define MANGO_BAYESIAN_OPTIMIZATION_H
+
+#include <vector>
+#include <random>
+#include "Package_mango.hpp"
+#include "Solver.hpp"
+
+#ifdef MANGO_EIGEN_AVAILABLE
+#include <Eigen/Dense>
+#endif
+
+namespace mango {
+  class Bayesian_optimization : public Algorithm {
+  public:
+#ifdef MANGO_EIGEN_AVAILABLE
+    Solver* solver;
+
+    // Define shorthand variable names:
+    int N_parameters;
+    int N_worker_groups;
+    int N_threads;
+    int verbose;
+    bool proc0_world;
+    MPI_Comm comm_group_leaders;
+
+    // Copies of the bound constraints and the initial condition scaled to the unit box, which are the same on all group leaders:
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+    Eigen::VectorXd initial_condition;
+
+    // Parameters of the algorithm:
+    int N_initial_points;
+    int N_candidates;
+    int N_hyperparameter_starts;
+    double nugget;
+    double min_log_length_scale;
+    double max_log_length_scale;
+    unsigned int seed;
+
+    // The points evaluated so far, scaled to the unit box, one per column, and their objective functions:
+    Eigen::MatrixXd points;
+    std::vector<double> objective_functions;
+
+    // The Gaussian process, which is only used on proc0_world:
+    Eigen::VectorXd log_length_scales;
+    Eigen::VectorXd standardized_values;
+    double value_mean;
+    double value_scale;
+    double signal_variance;
+    Eigen::LLT<Eigen::MatrixXd> cholesky;
+    Eigen::VectorXd alpha;
+
+    std::mt19937 random_number_generator;
+    int function_evaluations;
+    int max_function_evaluations;
+
+    void evaluate(Eigen::MatrixXd& new_points);
+    void fit_hyperparameters();
+    double log_likelihood(const Eigen::VectorXd& log_length_scales_in, Eigen::LLT<Eigen::MatrixXd>* cholesky_out = NULL);
+    void predict(const Eigen::VectorXd& x, double& mean, double& standard_deviation);
+    Eigen::VectorXd mean_gradient(const Eigen::VectorXd& x);
+    void propose_batch(int N_set, Eigen::MatrixXd& batch);
+    double acquisition(const Eigen::VectorXd& x, double best_value, double Lipschitz_constant, const Eigen::MatrixXd& batch,
+		       const std::vector<double>& batch_means, const std::vector<double>& batch_standard_deviations);
+
+    static double correlation(double r);
+    static double expected_improvement(double mean, double standard_deviation, double best_value);
+    static void latin_hypercube(int N_points, std::mt19937& random_number_generator, Eigen::MatrixXd& points);
+
+#endif
+    Bayesian_optimization(Solver*);
+    void solve();
+  };
+}
+
+#endif
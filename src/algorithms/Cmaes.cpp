@@ -0,0 +1,313 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <Package_mango.hpp>
+#include "Cmaes.hpp"
+
+#ifdef MANGO_EIGEN_AVAILABLE
+#include <Eigen/Dense>
+#endif
+
+#ifndef MANGO_EIGEN_AVAILABLE
+// Eigen is NOT available.
+
+mango::Cmaes::Cmaes(Solver* solver_in) {
+  throw std::runtime_error("ERROR: The algorithm mango_cmaes was selected. This algorithm requires Eigen, but MANGO was built without Eigen.");
+}
+
+void mango::Cmaes::solve() {}
+
+#else
+// The rest of this file is used when Eigen IS available.
+
+//! Constructor
+mango::Cmaes::Cmaes(Solver* solver_in) {
+  solver = solver_in;
+
+  // Define shorthand variable names:
+  N_parameters = solver->N_parameters;
+  N_worker_groups = solver->mpi_partition->get_N_worker_groups();
+  verbose = solver->verbose;
+  max_function_evaluations = solver->max_function_evaluations;
+  proc0_world = solver->mpi_partition->get_proc0_world();
+  comm_group_leaders = solver->mpi_partition->get_comm_group_leaders();
+  bound_constraints_set = solver->bound_constraints_set && algorithms[solver->algorithm].allows_bound_constraints;
+
+  // Parameters of the algorithm:
+  // The default population size of Hansen (2016), rounded up to a multiple of N_worker_groups so every group is busy in every generation:
+  default_population_size = round_population_size(4 + (int)floor(3 * log((double)N_parameters)), N_worker_groups);
+  // If bipop is true, restarts alternate between increasing and small populations as in Hansen (2009). Otherwise the restarts are IPOP.
+  bipop = true;
+  // A run stops when sigma times the largest standard deviation has shrunk by tolerance_x relative to initial_sigma:
+  tolerance_x = 1.0e-12;
+  // A run stops when the range of recent objective function values is below tolerance_function:
+  tolerance_function = 1.0e-12;
+  // A run stops when the condition number of the covariance matrix exceeds max_condition:
+  max_condition = 1.0e14;
+  // The random numbers are the same on all group leaders. If a seed is set with Problem::set_random_seed(), they are also the same
+  // for every run, so results are reproducible for a given N_worker_groups. Otherwise the seed is taken from the clock.
+  seed = solver->broadcast_random_seed(comm_group_leaders);
+
+  // Make sure all group leaders agree on the bound constraints and initial condition.
+  std::vector<double> x(N_parameters);
+  solver->broadcast_initial_condition(x.data());
+  initial_mean.resize(N_parameters);
+  if (bound_constraints_set) {
+    solver->broadcast_bound_constraints(lower_bounds, upper_bounds);
+    // With bound constraints, the algorithm works with the parameters scaled so the box is [0,1]^N_parameters.
+    for (int j = 0; j < N_parameters; j++) {
+      initial_mean[j] = std::min(1.0, std::max(0.0, (x[j] - lower_bounds[j]) / (upper_bounds[j] - lower_bounds[j])));
+    }
+    initial_sigma = 0.3;
+  } else {
+    double max_abs_x = 1.0;
+    for (int j = 0; j < N_parameters; j++) {
+      initial_mean[j] = x[j];
+      max_abs_x = std::max(max_abs_x, std::abs(x[j]));
+    }
+    initial_sigma = 0.3 * max_abs_x;
+  }
+
+  random_number_generator.seed(seed);
+  function_evaluations = 0;
+}
+
+//! The main driver for CMA-ES with restarts
+/**
+ * The first run starts from the initial condition with the default population size. Afterwards, in the large-population regime,
+ * each restart doubles the population size (IPOP). If bipop is true, restarts in a small-population regime, with a random
+ * population size and a smaller random initial step size, are interleaved so the function evaluations spent in the two
+ * regimes stay balanced (BIPOP). With bound constraints, restarts begin from a random point in the box.
+ * Restarts continue until max_function_evaluations is reached.
+ */
+void mango::Cmaes::solve() {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  N_large_restarts = 0;
+  N_small_restarts = 0;
+  evaluations_in_small_regime = 0;
+
+  population_size = default_population_size;
+  mean = initial_mean;
+  run(initial_sigma);
+  evaluations_in_large_regime = function_evaluations;
+
+  while (function_evaluations < max_function_evaluations) {
+    int old_function_evaluations = function_evaluations;
+    int large_population_size = default_population_size * (1 << N_large_restarts);
+    double sigma_for_restart = initial_sigma;
+    bool large_regime = (!bipop) || (evaluations_in_small_regime >= evaluations_in_large_regime);
+    if (large_regime) {
+      N_large_restarts++;
+      population_size = 2 * large_population_size;
+    } else {
+      N_small_restarts++;
+      double u1 = uniform(random_number_generator);
+      double u2 = uniform(random_number_generator);
+      population_size = small_population_size(default_population_size, large_population_size, u1, N_worker_groups);
+      sigma_for_restart = initial_sigma * pow(10.0, -2 * u2);
+    }
+    if (bound_constraints_set) {
+      for (int j = 0; j < N_parameters; j++) mean[j] = uniform(random_number_generator);
+    } else {
+      mean = initial_mean;
+    }
+    if (verbose > 0 && proc0_world) std::cout << "CMA-ES restart in the " << (large_regime ? "large" : "small") << "-population regime, population size = "
+					      << population_size << std::endl;
+    run(sigma_for_restart);
+    if (large_regime) {
+      evaluations_in_large_regime += function_evaluations - old_function_evaluations;
+    } else {
+      evaluations_in_small_regime += function_evaluations - old_function_evaluations;
+    }
+  }
+}
+
+//! Carry out one run of CMA-ES, from the current mean and population size, until it converges or max_function_evaluations is reached.
+/**
+ * This is the (mu/mu_w, lambda)-CMA-ES as described in Hansen, "The CMA Evolution Strategy: A Tutorial", arXiv:1604.00772 (2016).
+ * The population of each generation is evaluated as one set, concurrently.
+ * With bound constraints, the objective function is evaluated at the projection of each sample onto the box, and for ranking
+ * the samples a penalty proportional to the squared distance from the box is added.
+ * @param[in] sigma_in The initial step size.
+ */
+void mango::Cmaes::run(double sigma_in) {
+  const int n = N_parameters;
+  int j, k;
+  compute_weights(population_size, weights, mu_eff);
+  N_parents = weights.size();
+  c_sigma = (mu_eff + 2) / (n + mu_eff + 5);
+  d_sigma = 1 + 2 * std::max(0.0, sqrt((mu_eff - 1) / (n + 1)) - 1) + c_sigma;
+  c_c = (4 + mu_eff / n) / (n + 4 + 2 * mu_eff / n);
+  c_1 = 2 / ((n + 1.3) * (n + 1.3) + mu_eff);
+  c_mu = std::min(1 - c_1, 2 * (mu_eff - 2 + 1 / mu_eff) / ((n + 2) * (n + 2) + mu_eff));
+  chi_N = sqrt((double)n) * (1 - 1.0 / (4 * n) + 1.0 / (21 * n * n));
+
+  sigma = sigma_in;
+  p_c = Eigen::VectorXd::Zero(n);
+  p_sigma = Eigen::VectorXd::Zero(n);
+  C = Eigen::MatrixXd::Identity(n, n);
+  B = Eigen::MatrixXd::Identity(n, n);
+  D = Eigen::VectorXd::Ones(n);
+  generation = 0;
+  best_objective_function_history.clear();
+
+  std::normal_distribution<double> normal(0.0, 1.0);
+  Eigen::MatrixXd samples(n, population_size);
+  std::vector<double> points(population_size * n);
+  std::vector<double> objective_functions;
+  std::vector<double> fitness(population_size);
+  std::vector<int> order(population_size);
+  Eigen::VectorXd z(n);
+
+  while (function_evaluations < max_function_evaluations) {
+    generation++;
+    for (k = 0; k < population_size; k++) {
+      for (j = 0; j < n; j++) z[j] = normal(random_number_generator);
+      samples.col(k) = mean + sigma * (B * D.cwiseProduct(z));
+      for (j = 0; j < n; j++) {
+	points[k * n + j] = bound_constraints_set ? std::min(1.0, std::max(0.0, samples(j, k))) : samples(j, k);
+      }
+    }
+    evaluate(population_size, points, objective_functions);
+
+    fitness = objective_functions;
+    if (bound_constraints_set) {
+      // Scale the penalty by the typical magnitude of the objective function in this generation.
+      std::vector<double> finite_values;
+      for (k = 0; k < population_size; k++) {
+	if (std::isfinite(objective_functions[k])) finite_values.push_back(std::abs(objective_functions[k]));
+      }
+      double penalty_weight = 1.0;
+      if (finite_values.size() > 0) {
+	std::nth_element(finite_values.begin(), finite_values.begin() + finite_values.size() / 2, finite_values.end());
+	penalty_weight += finite_values[finite_values.size() / 2];
+      }
+      for (k = 0; k < population_size; k++) {
+	double distance_squared = 0;
+	for (j = 0; j < n; j++) distance_squared += (samples(j, k) - points[k * n + j]) * (samples(j, k) - points[k * n + j]);
+	fitness[k] += penalty_weight * distance_squared;
+      }
+    }
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&fitness](int a, int b) { return fitness[a] < fitness[b]; });
+
+    // Update the mean and the evolution paths:
+    Eigen::VectorXd old_mean = mean;
+    mean = Eigen::VectorXd::Zero(n);
+    for (k = 0; k < N_parents; k++) mean += weights[k] * samples.col(order[k]);
+    Eigen::VectorXd y_w = (mean - old_mean) / sigma;
+    Eigen::VectorXd C_inverse_sqrt_y_w = B * (B.transpose() * y_w).cwiseQuotient(D);
+    p_sigma = (1 - c_sigma) * p_sigma + sqrt(c_sigma * (2 - c_sigma) * mu_eff) * C_inverse_sqrt_y_w;
+    double p_sigma_norm = p_sigma.norm();
+    bool h_sigma = p_sigma_norm / sqrt(1 - pow(1 - c_sigma, 2 * generation)) / chi_N < 1.4 + 2.0 / (n + 1);
+    p_c = (1 - c_c) * p_c + (h_sigma ? sqrt(c_c * (2 - c_c) * mu_eff) : 0.0) * y_w;
+
+    // Update the covariance matrix and step size:
+    Eigen::MatrixXd rank_mu_update = Eigen::MatrixXd::Zero(n, n);
+    for (k = 0; k < N_parents; k++) {
+      Eigen::VectorXd y = (samples.col(order[k]) - old_mean) / sigma;
+      rank_mu_update += weights[k] * y * y.transpose();
+    }
+    C = (1 - c_1 - c_mu) * C + c_1 * (p_c * p_c.transpose() + (h_sigma ? 0.0 : c_c * (2 - c_c)) * C) + c_mu * rank_mu_update;
+    C = 0.5 * (C + C.transpose());
+    sigma = sigma * exp((c_sigma / d_sigma) * (p_sigma_norm / chi_N - 1));
+
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigensolver(C);
+    B = eigensolver.eigenvectors();
+    D = eigensolver.eigenvalues().cwiseMax(0.0).cwiseSqrt();
+
+    std::vector<double> sorted_objective_functions(population_size);
+    for (k = 0; k < population_size; k++) sorted_objective_functions[k] = fitness[order[k]];
+    if (verbose > 0 && proc0_world) std::cout << "CMA-ES generation " << generation << ": best objective function = " << std::setprecision(16)
+					      << sorted_objective_functions[0] << ", sigma = " << sigma << std::endl;
+    if (converged(sorted_objective_functions)) break;
+  }
+}
+
+//! Evaluate the objective function at a set of points, concurrently.
+/**
+ * @param[in] N_set The number of points.
+ * @param[in] scaled_points The points, stored contiguously. If there are bound constraints, these are in the coordinates for which the box is [0,1]^N_parameters.
+ * @param[out] objective_functions The values of the objective function, on all group leaders. Failed evaluations give infinity.
+ */
+void mango::Cmaes::evaluate(int N_set, std::vector<double>& scaled_points, std::vector<double>& objective_functions) {
+  std::vector<double> state_vectors(scaled_points);
+  if (bound_constraints_set) {
+    for (int j_set = 0; j_set < N_set; j_set++) {
+      for (int j = 0; j < N_parameters; j++) {
+	state_vectors[j_set * N_parameters + j] = lower_bounds[j] + scaled_points[j_set * N_parameters + j] * (upper_bounds[j] - lower_bounds[j]);
+      }
+    }
+  }
+  objective_functions.resize(N_set);
+  solver->evaluate_objective_set_in_parallel(N_set, state_vectors.data(), objective_functions.data());
+  function_evaluations += N_set;
+  if (solver->stop_requested) max_function_evaluations = function_evaluations;
+}
+
+//! Check the stopping criteria for the current run.
+/**
+ * @param[in] sorted_objective_functions The values used to rank the samples of the current generation, in increasing order.
+ * @return true if the run should stop.
+ */
+bool mango::Cmaes::converged(const std::vector<double>& sorted_objective_functions) {
+  // The range of the objective function over the current generation and the best values of recent generations is tiny:
+  size_t history_length = 10 + (size_t)ceil(30.0 * N_parameters / population_size);
+  best_objective_function_history.push_back(sorted_objective_functions[0]);
+  if (best_objective_function_history.size() > history_length) best_objective_function_history.erase(best_objective_function_history.begin());
+  if (best_objective_function_history.size() == history_length) {
+    double max_value = *std::max_element(best_objective_function_history.begin(), best_objective_function_history.end());
+    double min_value = *std::min_element(best_objective_function_history.begin(), best_objective_function_history.end());
+    max_value = std::max(max_value, sorted_objective_functions.back());
+    if (max_value - min_value < tolerance_function) return true;
+  }
+
+  // The distribution has shrunk:
+  double max_standard_deviation = sqrt(C.diagonal().maxCoeff());
+  if (sigma * max_standard_deviation < tolerance_x * initial_sigma && sigma * p_c.cwiseAbs().maxCoeff() < tolerance_x * initial_sigma) return true;
+
+  // The covariance matrix is badly conditioned:
+  double min_D = D.minCoeff();
+  if (!(min_D > 0) || (D.maxCoeff() / min_D) * (D.maxCoeff() / min_D) > max_condition) return true;
+
+  return false;
+}
+
+//! Round a population size up to a multiple of the number of worker groups.
+int mango::Cmaes::round_population_size(int population_size, int N_worker_groups) {
+  return ((population_size + N_worker_groups - 1) / N_worker_groups) * N_worker_groups;
+}
+
+//! Choose the population size for a restart in the small-population regime of BIPOP.
+/**
+ * @param[in] default_population_size The population size of the first run.
+ * @param[in] large_population_size The population size of the latest restart in the large-population regime.
+ * @param[in] u A uniform random number in [0, 1).
+ * @param[in] N_worker_groups The number of worker groups.
+ * @return A population size between default_population_size and large_population_size / 2, distributed as in Hansen (2009),
+ *   and rounded up to a multiple of N_worker_groups.
+ */
+int mango::Cmaes::small_population_size(int default_population_size, int large_population_size, double u, int N_worker_groups) {
+  int population_size = (int)floor(default_population_size * pow(0.5 * large_population_size / default_population_size, u * u));
+  return round_population_size(std::max(default_population_size, population_size), N_worker_groups);
+}
+
+//! Compute the recombination weights for the best half of the population.
+/**
+ * @param[in] population_size The number of samples per generation, lambda.
+ * @param[out] weights The positive weights, in decreasing order, which sum to 1. The length is floor(lambda/2).
+ * @param[out] mu_eff The variance effective selection mass, 1 / sum(weights^2).
+ */
+void mango::Cmaes::compute_weights(int population_size, Eigen::VectorXd& weights, double& mu_eff) {
+  int N_parents = population_size / 2;
+  weights.resize(N_parents);
+  for (int k = 0; k < N_parents; k++) weights[k] = log((population_size + 1) / 2.0) - log(k + 1.0);
+  weights = weights / weights.sum();
+  mu_eff = 1.0 / weights.squaredNorm();
+}
+#endif
@@ -0,0 +1,81 @@
+#ifndef MANGO_CMAES_H
+#define MANGO_CMAES_H
+
+#include <vector>
+#include <random>
+#include "Package_mango.hpp"
+#include "Solver.hpp"
+
+#ifdef MANGO_EIGEN_AVAILABLE
+#include <Eigen/Dense>
+#endif
+
+namespace mango {
+  class Cmaes : public Algorithm {
+  public:
+#ifdef MANGO_EIGEN_AVAILABLE
+    Solver* solver;
+
+    // Define shorthand variable names:
+    int N_parameters;
+    int N_worker_groups;
+    int verbose;
+    bool proc0_world;
+    MPI_Comm comm_group_leaders;
+    bool bound_constraints_set;
+
+    // Copies of the bound constraints and initial condition, which are the same on all group leaders:
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+    Eigen::VectorXd initial_mean;
+
+    // Parameters of the algorithm:
+    double initial_sigma;
+    int default_population_size;
+    bool bipop;
+    double tolerance_x;
+    double tolerance_function;
+    double max_condition;
+    unsigned int seed;
+
+    // State of the restarts:
+    int N_large_restarts;
+    int N_small_restarts;
+    int evaluations_in_large_regime;
+    int evaluations_in_small_regime;
+
+    // State of the current run:
+    int population_size;
+    int N_parents;
+    Eigen::VectorXd weights;
+    double mu_eff;
+    double c_c, c_sigma, c_1, c_mu, d_sigma, chi_N;
+    double sigma;
+    Eigen::VectorXd mean;
+    Eigen::VectorXd p_c;
+    Eigen::VectorXd p_sigma;
+    Eigen::MatrixXd C;
+    Eigen::MatrixXd B;
+    Eigen::VectorXd D;
+    int generation;
+    std::vector<double> best_objective_function_history;
+
+    std::mt19937 random_number_generator;
+    int function_evaluations;
+    int max_function_evaluations;
+
+    void run(double sigma_in);
+    void evaluate(int N_set, std::vector<double>& scaled_points, std::vector<double>& objective_functions);
+    bool converged(const std::vector<double>& sorted_objective_functions);
+
+    static int round_population_size(int population_size, int N_worker_groups);
+    static int small_population_size(int default_population_size, int large_population_size, double u, int N_worker_groups);
+    static void compute_weights(int population_size, Eigen::VectorXd& weights, double& mu_eff);
+
+#endif
+    Cmaes(Solver*);
+    void solve();
+  };
+}
+
+#endif
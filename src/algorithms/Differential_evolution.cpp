@@ -0,0 +1,165 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <Package_mango.hpp>
+#include "Differential_evolution.hpp"
+
+//! Constructor
+mango::Differential_evolution::Differential_evolution(Solver* solver_in) {
+  solver = solver_in;
+
+  // Define shorthand variable names:
+  N_parameters = solver->N_parameters;
+  verbose = solver->verbose;
+  max_function_evaluations = solver->max_function_evaluations;
+  proc0_world = solver->mpi_partition->get_proc0_world();
+  comm_group_leaders = solver->mpi_partition->get_comm_group_leaders();
+
+  // Parameters of the algorithm:
+  // The usual choice of 10 members per parameter, with enough members to choose 3 distinct ones other than the target:
+  population_size = std::max(10 * N_parameters, 4);
+  // The scale factor F for the difference vector, and the crossover probability CR, in DE/rand/1/bin:
+  differential_weight = 0.5;
+  crossover_probability = 0.9;
+  // The algorithm stops when the population spans less than this fraction of the box in every direction:
+  tolerance_x = 1.0e-10;
+  // If a random seed is set, results are used in order with a fixed lag, so the sequence of evaluations does not depend on timing:
+  reproducible = (solver->random_seed >= 0);
+
+  // Make sure all group leaders agree on the bound constraints and initial condition.
+  solver->broadcast_bound_constraints(lower_bounds, upper_bounds);
+  x0.resize(N_parameters);
+  solver->broadcast_initial_condition(x0.data());
+  Solver::project_onto_bounds(lower_bounds, upper_bounds, x0.data());
+
+  random_number_generator.seed(solver->broadcast_random_seed(comm_group_leaders));
+  next_target = 0;
+  best_objective_function = std::numeric_limits<double>::infinity();
+  function_evaluations = 0;
+}
+
+//! The main driver for asynchronous differential evolution
+/**
+ * This is the DE/rand/1/bin method of Storn and Price, J Global Optimization 11, 341 (1997), with the asynchronous replacement
+ * of Zhabitsky and Zhabitskaya, Computational Mathematics and Mathematical Physics 53, 1770 (2013). The initial population,
+ * consisting of the initial condition and uniformly random points in the box, is evaluated as one set. After that there is no
+ * generation barrier: each time a worker group becomes free, a trial point is generated for the next member of the population
+ * in turn, using the population as it stands at that moment, and when the evaluation finishes the trial point replaces that
+ * member if it is at least as good. The algorithm stops when max_function_evaluations is reached, or when the population has
+ * converged to a point.
+ * The population is kept on proc0_world. The other group leaders only evaluate the points they are sent.
+ */
+void mango::Differential_evolution::solve() {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  population.resize(population_size * N_parameters);
+  population_objective_functions.resize(population_size);
+  if (proc0_world) {
+    for (int j = 0; j < N_parameters; j++) population[j] = x0[j];
+    for (int k = 1; k < population_size; k++) {
+      for (int j = 0; j < N_parameters; j++) {
+	population[k * N_parameters + j] = lower_bounds[j] + uniform(random_number_generator) * (upper_bounds[j] - lower_bounds[j]);
+      }
+    }
+  }
+  solver->evaluate_objective_set_in_parallel(population_size, population.data(), population_objective_functions.data());
+  function_evaluations += population_size;
+  if (proc0_world) {
+    for (int k = 0; k < population_size; k++) {
+      best_objective_function = std::min(best_objective_function, population_objective_functions[k]);
+    }
+    if (verbose > 0) std::cout << "Differential evolution: initial population evaluated. Best objective function = "
+			       << std::setprecision(16) << best_objective_function << std::endl;
+  }
+
+  // With a lag of population_size, each trial point is generated from the population after exactly the trials generated
+  // population_size points earlier have been received, so up to population_size evaluations can be under way at once.
+  solver->evaluate_objective_asynchronously(reproducible ? population_size : -1,
+					    [&](int index, double* trial) { return generate_trial(index, trial); },
+					    [&](int index, const double* trial, double objective_function) { receive_trial(index, trial, objective_function); });
+}
+
+//! Generate a trial point for the next member of the population.
+/**
+ * @param[in] index The index of the trial point, which is passed back to receive_trial().
+ * @param[out] trial The trial point.
+ * @return false if no more points should be evaluated, true otherwise.
+ */
+bool mango::Differential_evolution::generate_trial(int index, double* trial) {
+  if (function_evaluations >= max_function_evaluations || solver->stop_requested || converged()) return false;
+
+  int target = next_target;
+  next_target = (next_target + 1) % population_size;
+
+  // Choose 3 distinct members of the population other than the target.
+  std::uniform_int_distribution<int> random_member(0, population_size - 1);
+  int members[3];
+  for (int m = 0; m < 3; m++) {
+    bool distinct;
+    do {
+      members[m] = random_member(random_number_generator);
+      distinct = (members[m] != target);
+      for (int m2 = 0; m2 < m; m2++) distinct = distinct && (members[m] != members[m2]);
+    } while (!distinct);
+  }
+
+  // Mutation and binomial crossover. At least one coordinate, j_mutated, is always taken from the mutant.
+  // Coordinates of the mutant that leave the box are moved halfway between the target and the bound.
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  int j_mutated = std::uniform_int_distribution<int>(0, N_parameters - 1)(random_number_generator);
+  const double* x_target = &population[target * N_parameters];
+  for (int j = 0; j < N_parameters; j++) {
+    double r = uniform(random_number_generator);
+    if (j != j_mutated && r >= crossover_probability) {
+      trial[j] = x_target[j];
+      continue;
+    }
+    trial[j] = population[members[0] * N_parameters + j]
+      + differential_weight * (population[members[1] * N_parameters + j] - population[members[2] * N_parameters + j]);
+    if (trial[j] < lower_bounds[j]) trial[j] = 0.5 * (lower_bounds[j] + x_target[j]);
+    if (trial[j] > upper_bounds[j]) trial[j] = 0.5 * (upper_bounds[j] + x_target[j]);
+  }
+
+  pending_targets[index] = target;
+  function_evaluations++;
+  return true;
+}
+
+//! Replace the member of the population that a trial point competes with, if the trial point is at least as good.
+/**
+ * @param[in] index The index of the trial point, as given to generate_trial().
+ * @param[in] trial The trial point.
+ * @param[in] objective_function The objective function at the trial point.
+ */
+void mango::Differential_evolution::receive_trial(int index, const double* trial, double objective_function) {
+  std::map<int, int>::iterator it = pending_targets.find(index);
+  if (it == pending_targets.end()) throw std::runtime_error("Error in mango::Differential_evolution::receive_trial. Unexpected point.");
+  int target = it->second;
+
+  if (objective_function <= population_objective_functions[target]) {
+    for (int j = 0; j < N_parameters; j++) population[target * N_parameters + j] = trial[j];
+    population_objective_functions[target] = objective_function;
+    if (objective_function < best_objective_function) {
+      best_objective_function = objective_function;
+      if (verbose > 0) std::cout << "Differential evolution: " << function_evaluations << " points generated. New best objective function = "
+				 << std::setprecision(16) << best_objective_function << std::endl;
+    }
+  }
+  pending_targets.erase(it);
+}
+
+//! Returns true if the population spans less than tolerance_x times the width of the box in every direction.
+bool mango::Differential_evolution::converged() {
+  for (int j = 0; j < N_parameters; j++) {
+    double min_x = population[j], max_x = population[j];
+    for (int k = 1; k < population_size; k++) {
+      min_x = std::min(min_x, population[k * N_parameters + j]);
+      max_x = std::max(max_x, population[k * N_parameters + j]);
+    }
+    if (max_x - min_x > tolerance_x * (upper_bounds[j] - lower_bounds[j])) return false;
+  }
+  return true;
+}
@@ -0,0 +1,51 @@
+#ifndef MANGO_DIFFERENTIAL_EVOLUTION_H
+#define MANGO_DIFFERENTIAL_EVOLUTION_H
+
+#include <vector>
+#include <map>
+#include <random>
+#include "Package_mango.hpp"
+#include "Solver.hpp"
+
+namespace mango {
+  class Differential_evolution : public Algorithm {
+  public:
+    Solver* solver;
+
+    // Define shorthand variable names:
+    int N_parameters;
+    int verbose;
+    bool proc0_world;
+    MPI_Comm comm_group_leaders;
+
+    // Copies of the bound constraints and initial condition, which are the same on all group leaders:
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+    std::vector<double> x0;
+
+    // Parameters of the algorithm:
+    int population_size;
+    double differential_weight;
+    double crossover_probability;
+    double tolerance_x;
+    bool reproducible;
+
+    // State of the algorithm, which is only used on proc0_world:
+    std::vector<double> population;
+    std::vector<double> population_objective_functions;
+    std::map<int, int> pending_targets; // For each trial point that has been generated but not received, by index, the member it competes with.
+    int next_target;
+    double best_objective_function;
+    std::mt19937 random_number_generator;
+    int function_evaluations;
+    int max_function_evaluations;
+
+    Differential_evolution(Solver*);
+    void solve();
+    bool generate_trial(int index, double* trial);
+    void receive_trial(int index, const double* trial, double objective_function);
+    bool converged();
+  };
+}
+
+#endif
@@ -0,0 +1,234 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <Package_mango.hpp>
+#include "Direct.hpp"
+#include "Direct_l.hpp"
+
+//! Constructor
+mango::Direct::Direct(Solver* solver_in) {
+  solver = solver_in;
+
+  // Parameters of the algorithm:
+  // If true, rectangles are measured by their longest side and only one rectangle of each size is divided per iteration (DIRECT-L):
+  locally_biased = false;
+  // A rectangle is only divided if it could improve on the best objective function by at least epsilon * |best objective function|:
+  epsilon = 1.0e-4;
+  // Rectangles whose shortest side is 3^(-max_level) times the width of the box are not divided further:
+  max_level = 30;
+
+  // Define shorthand variable names:
+  N_parameters = solver->N_parameters;
+  verbose = solver->verbose;
+  max_function_evaluations = solver->max_function_evaluations;
+  proc0_world = solver->mpi_partition->get_proc0_world();
+  comm_group_leaders = solver->mpi_partition->get_comm_group_leaders();
+
+  // Make sure all group leaders agree on the bound constraints.
+  solver->broadcast_bound_constraints(lower_bounds, upper_bounds);
+
+  function_evaluations = 0;
+  iteration = 0;
+}
+
+//! Constructor for the locally biased variant
+mango::Direct_l::Direct_l(Solver* solver_in) : Direct(solver_in) {
+  locally_biased = true;
+}
+
+//! The main driver for the DIRECT algorithm
+/**
+ * This is the DIRECT (DIviding RECTangles) algorithm of Jones, Perttunen, and Stuckman, J Optim Theory Appl 79, 157 (1993),
+ * for global optimization in a box. The box is divided into hyperrectangles, each with the objective function known at its center.
+ * At each iteration, the potentially optimal rectangles are selected: those with the lowest objective function for some
+ * assumed Lipschitz constant. Each is trisected along its longest sides, in order of the objective function at the new centers.
+ * With locally_biased = true (mango_direct_l), this is the DIRECT-L variant of Gablonsky and Kelley, J Global Optim 21, 27 (2001),
+ * which measures rectangles by their longest side and divides only one rectangle of each size per iteration.
+ *
+ * In contrast to nlopt_gn_direct and nlopt_gn_direct_l, which evaluate one point at a time, the new centers of all the rectangles
+ * divided in an iteration are evaluated as one set, concurrently. The set is built in a fixed order, and all group leaders
+ * carry out the same computations using the function values broadcast from proc0_world, so the results do not depend on the
+ * number of worker groups. An iteration is only started if its whole set fits within max_function_evaluations. The initial
+ * condition is not used, since the first point is the center of the box.
+ */
+void mango::Direct::solve() {
+  std::vector<double> points(N_parameters, 0.5);
+  std::vector<double> new_objective_functions;
+  centers = points;
+  levels.assign(N_parameters, 0);
+  evaluate(1, points, new_objective_functions);
+  objective_functions = new_objective_functions;
+
+  std::vector<double> sizes, values;
+  std::vector<int> selected, divisions;
+  std::vector<std::vector<int> > long_sides;
+  while (function_evaluations < max_function_evaluations) {
+    iteration++;
+    int N_rectangles = objective_functions.size();
+
+    // Failed evaluations are treated as the largest finite objective function, so their rectangles are not preferred.
+    double max_finite = -std::numeric_limits<double>::infinity();
+    for (int k = 0; k < N_rectangles; k++) {
+      if (std::isfinite(objective_functions[k])) max_finite = std::max(max_finite, objective_functions[k]);
+    }
+    if (!std::isfinite(max_finite)) max_finite = 0;
+    sizes.resize(N_rectangles);
+    values.resize(N_rectangles);
+    for (int k = 0; k < N_rectangles; k++) {
+      sizes[k] = size(k);
+      values[k] = std::isfinite(objective_functions[k]) ? objective_functions[k] : max_finite;
+    }
+    select_potentially_optimal(sizes, values, epsilon, locally_biased, selected);
+
+    // Collect the new centers of all the selected rectangles, as long as they fit in the remaining function evaluations.
+    points.clear();
+    divisions.clear();
+    long_sides.clear();
+    for (int j_selected = 0; j_selected < (int) selected.size(); j_selected++) {
+      int k = selected[j_selected];
+      int min_level = *std::min_element(&levels[k * N_parameters], &levels[(k + 1) * N_parameters]);
+      if (min_level >= max_level) continue;
+      std::vector<int> sides;
+      for (int j = 0; j < N_parameters; j++) {
+	if (levels[k * N_parameters + j] == min_level) sides.push_back(j);
+      }
+      if (function_evaluations + (int) points.size() / N_parameters + 2 * (int) sides.size() > max_function_evaluations) break;
+      double delta = pow(3.0, -(min_level + 1));
+      for (int m = 0; m < (int) sides.size(); m++) {
+	for (int sign = 1; sign >= -1; sign -= 2) {
+	  for (int j = 0; j < N_parameters; j++) points.push_back(centers[k * N_parameters + j]);
+	  points[points.size() - N_parameters + sides[m]] += sign * delta;
+	}
+      }
+      divisions.push_back(k);
+      long_sides.push_back(sides);
+    }
+    if (divisions.empty()) break;
+    evaluate(points.size() / N_parameters, points, new_objective_functions);
+
+    // Trisect each rectangle, first along the side whose new centers have the lowest objective function, so the best new centers get the largest rectangles.
+    int j_point = 0;
+    for (int j_division = 0; j_division < (int) divisions.size(); j_division++) {
+      int k = divisions[j_division];
+      std::vector<int>& sides = long_sides[j_division];
+      std::vector<std::pair<double, int> > order;
+      for (int m = 0; m < (int) sides.size(); m++) {
+	double w = std::min(new_objective_functions[j_point + 2 * m], new_objective_functions[j_point + 2 * m + 1]);
+	order.push_back(std::make_pair(w, m));
+      }
+      std::stable_sort(order.begin(), order.end());
+      std::vector<int> new_levels(&levels[k * N_parameters], &levels[(k + 1) * N_parameters]);
+      for (int m_sorted = 0; m_sorted < (int) order.size(); m_sorted++) {
+	int m = order[m_sorted].second;
+	new_levels[sides[m]]++;
+	for (int child = 0; child < 2; child++) {
+	  int j_new = j_point + 2 * m + child;
+	  centers.insert(centers.end(), &points[j_new * N_parameters], &points[(j_new + 1) * N_parameters]);
+	  levels.insert(levels.end(), new_levels.begin(), new_levels.end());
+	  objective_functions.push_back(new_objective_functions[j_new]);
+	}
+      }
+      for (int j = 0; j < N_parameters; j++) levels[k * N_parameters + j] = new_levels[j];
+      j_point += 2 * sides.size();
+    }
+
+    if (verbose > 0 && proc0_world) std::cout << "DIRECT iteration " << iteration << ": divided " << divisions.size() << " rectangles, best objective function = "
+					      << std::setprecision(16) << *std::min_element(objective_functions.begin(), objective_functions.end()) << std::endl;
+  }
+}
+
+//! Evaluate the objective function at a set of points in the unit box, concurrently.
+/**
+ * @param[in] N_set The number of points.
+ * @param[in] points The points, scaled to the unit box, stored contiguously.
+ * @param[out] new_objective_functions The values of the objective function, on all group leaders. Failed evaluations give infinity.
+ */
+void mango::Direct::evaluate(int N_set, std::vector<double>& points, std::vector<double>& new_objective_functions) {
+  std::vector<double> unscaled_points(N_set * N_parameters);
+  for (int k = 0; k < N_set; k++) {
+    for (int j = 0; j < N_parameters; j++) {
+      unscaled_points[k * N_parameters + j] = lower_bounds[j] + points[k * N_parameters + j] * (upper_bounds[j] - lower_bounds[j]);
+    }
+  }
+  new_objective_functions.resize(N_set);
+  solver->evaluate_objective_set_in_parallel(N_set, unscaled_points.data(), new_objective_functions.data());
+  function_evaluations += N_set;
+  if (solver->stop_requested) max_function_evaluations = function_evaluations;
+}
+
+//! The measure of the size of a rectangle: half the length of its diagonal, or for DIRECT-L, its longest side.
+double mango::Direct::size(int k) {
+  if (locally_biased) {
+    return pow(3.0, -*std::min_element(&levels[k * N_parameters], &levels[(k + 1) * N_parameters]));
+  }
+  double sum = 0;
+  for (int j = 0; j < N_parameters; j++) sum += pow(9.0, -levels[k * N_parameters + j]);
+  return 0.5 * sqrt(sum);
+}
+
+//! Find the potentially optimal rectangles.
+/**
+ * Rectangle k is potentially optimal if, for some Lipschitz constant K > 0, values[k] - K * sizes[k] is no larger than the same quantity for
+ * every other rectangle, and is at least epsilon * |min(values)| below min(values). These rectangles lie on the lower right convex
+ * hull of the points (sizes, values).
+ * @param[in] sizes The size of each rectangle.
+ * @param[in] values The objective function at the center of each rectangle.
+ * @param[in] epsilon The minimum relative improvement.
+ * @param[in] locally_biased If true, only one rectangle of each size is selected. Otherwise all rectangles of that size with the same lowest value are selected.
+ * @param[out] selected The indices of the potentially optimal rectangles, in increasing order.
+ */
+void mango::Direct::select_potentially_optimal(const std::vector<double>& sizes, const std::vector<double>& values, double epsilon,
+					       bool locally_biased, std::vector<int>& selected) {
+  // For each size, find the rectangle with the lowest value, taking the first in case of ties:
+  std::map<double, int> best_of_size;
+  for (int k = 0; k < (int) sizes.size(); k++) {
+    std::map<double, int>::iterator it = best_of_size.find(sizes[k]);
+    if (it == best_of_size.end() || values[k] < values[it->second]) best_of_size[sizes[k]] = k;
+  }
+  std::vector<int> candidates;
+  for (std::map<double, int>::iterator it = best_of_size.begin(); it != best_of_size.end(); ++it) candidates.push_back(it->second);
+
+  // Start the hull at the lowest value, taking the largest size in case of ties:
+  int start = 0;
+  for (int m = 1; m < (int) candidates.size(); m++) {
+    if (values[candidates[m]] <= values[candidates[start]]) start = m;
+  }
+  double min_value = values[candidates[start]];
+
+  // Lower convex hull of the candidates with sizes >= the size at the start, keeping collinear points:
+  std::vector<int> hull;
+  for (int m = start; m < (int) candidates.size(); m++) {
+    int c = candidates[m];
+    while (hull.size() >= 2) {
+      int a = hull[hull.size() - 2], b = hull[hull.size() - 1];
+      double cross = (sizes[b] - sizes[a]) * (values[c] - values[a]) - (values[b] - values[a]) * (sizes[c] - sizes[a]);
+      if (cross >= 0) break;
+      hull.pop_back();
+    }
+    hull.push_back(c);
+  }
+
+  selected.clear();
+  for (int h = 0; h < (int) hull.size(); h++) {
+    int k = hull[h];
+    if (h < (int) hull.size() - 1) {
+      // The largest Lipschitz constant for which rectangle k is on the hull is the slope to the next point:
+      int next = hull[h + 1];
+      double K = (values[next] - values[k]) / (sizes[next] - sizes[k]);
+      if (values[k] - K * sizes[k] > min_value - epsilon * std::abs(min_value)) continue;
+    }
+    if (locally_biased) {
+      selected.push_back(k);
+    } else {
+      for (int k2 = 0; k2 < (int) sizes.size(); k2++) {
+	if (sizes[k2] == sizes[k] && values[k2] == values[k]) selected.push_back(k2);
+      }
+    }
+  }
+  std::sort(selected.begin(), selected.end());
+}
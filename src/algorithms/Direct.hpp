@@ -0,0 +1,48 @@
+#ifndef MANGO_DIRECT_H
+#define MANGO_DIRECT_H
+
+#include <vector>
+#include "Package_mango.hpp"
+#include "Solver.hpp"
+
+namespace mango {
+  class Direct : public Algorithm {
+  public:
+    Solver* solver;
+
+    // Define shorthand variable names:
+    int N_parameters;
+    int verbose;
+    bool proc0_world;
+    MPI_Comm comm_group_leaders;
+
+    // Copies of the bound constraints, which are the same on all group leaders:
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+
+    // Parameters of the algorithm:
+    bool locally_biased;
+    double epsilon;
+    int max_level;
+
+    // The hyperrectangles, in the unit box. Rectangle k has center centers[k * N_parameters + j] and
+    // side 3^(-levels[k * N_parameters + j]) in direction j:
+    std::vector<double> centers;
+    std::vector<int> levels;
+    std::vector<double> objective_functions;
+
+    int function_evaluations;
+    int max_function_evaluations;
+    int iteration;
+
+    Direct(Solver*);
+    void solve();
+    void evaluate(int N_set, std::vector<double>& points, std::vector<double>& new_objective_functions);
+    double size(int k);
+
+    static void select_potentially_optimal(const std::vector<double>& sizes, const std::vector<double>& values, double epsilon,
+					   bool locally_biased, std::vector<int>& selected);
+  };
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef MANGO_DIRECT_L_H
+#define MANGO_DIRECT_L_H
+
+#include "Direct.hpp"
+
+namespace mango {
+  // The locally biased variant of DIRECT. See Direct.cpp.
+  class Direct_l : public Direct {
+  public:
+    Direct_l(Solver*);
+  };
+}
+
+#endif
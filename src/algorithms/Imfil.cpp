@@ -1,11 +1,303 @@
 #include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 #include <Package_mango.hpp>
 #include "Imfil.hpp"
 
-mango::Imfil::Imfil(Solver* solver) {
-  std::cout << "Hello from Imfil::Imfil(). This is just a stub." << std::endl;
+//! Constructor
+mango::Imfil::Imfil(Solver* solver_in) {
+  solver = solver_in;
+
+  // Parameters of the algorithm:
+  // The stencil scale starts at half the width of the box, and is halved each time stencil failure occurs,
+  // down to 0.5^scale_depth times the width of the box.
+  scale_depth = 10;
+  // The line search tries steps of line_search_factor^k times the quasi-Newton step, for k = 0, 1, ..., N_line_search-1.
+  line_search_factor = 0.5;
+  // Constant in the Armijo condition for the line search:
+  sufficient_decrease = 1.0e-4;
+
+  // Define shorthand variable names:
+  N_parameters = solver->N_parameters;
+  N_line_search = solver->N_line_search;
+  verbose = solver->verbose;
+  max_function_evaluations = solver->max_function_evaluations;
+  proc0_world = solver->mpi_partition->get_proc0_world();
+  comm_group_leaders = solver->mpi_partition->get_comm_group_leaders();
+
+  if (N_line_search < 1) throw std::runtime_error("N_line_search must be >= 1.");
+
+  // Make sure all group leaders agree on the bound constraints and initial condition.
+  solver->broadcast_bound_constraints(lower_bounds, upper_bounds);
+  x.resize(N_parameters);
+  solver->broadcast_initial_condition(x.data());
+
+  // Scale the initial condition to the unit box, projecting it onto the box if necessary.
+  for (int j = 0; j < N_parameters; j++) {
+    x[j] = (x[j] - lower_bounds[j]) / (upper_bounds[j] - lower_bounds[j]);
+    x[j] = std::min(1.0, std::max(0.0, x[j]));
+  }
+
+  gradient.resize(N_parameters);
+  previous_gradient.resize(N_parameters);
+  step.resize(N_parameters);
+  inverse_Hessian.resize(N_parameters * N_parameters);
+  best_stencil_point.resize(N_parameters);
+  function_evaluations = 0;
+  iteration = 0;
 }
 
+//! The main driver for the implicit filtering algorithm
+/**
+ * At each iteration, the objective function is evaluated on a stencil of up to 2*N_parameters points around the current point,
+ * concurrently. If no stencil point is better than the current point, this is stencil failure, and the stencil is shrunk.
+ * Otherwise the stencil gives a finite-difference gradient, from which a quasi-Newton step is computed, and a set of
+ * N_line_search step lengths along it is evaluated concurrently. The best point from the line search or the stencil is taken.
+ * All group leaders carry out the same computations, using the function values broadcast from proc0_world.
+ */
 void mango::Imfil::solve() {
-  std::cout << "Hello from Imfil::solve(). This is just a stub." << std::endl;
+  std::vector<double> objective_functions(1);
+  evaluate(1, x, objective_functions);
+  objective_function = objective_functions[0];
+
+  reset_inverse_Hessian();
+  stencil_scale = 0.5;
+  double min_stencil_scale = pow(0.5, scale_depth);
+
+  while (stencil_scale >= min_stencil_scale && function_evaluations < max_function_evaluations) {
+    iteration++;
+    if (!evaluate_stencil()) {
+      // Stencil failure: the current point is better than all its neighbors on the stencil, so refine the stencil.
+      // The last step and the stencil gradient before it are kept, so the quasi-Newton update can be made at the next successful stencil.
+      stencil_scale = stencil_scale * 0.5;
+      if (verbose > 0 && proc0_world) std::cout << "Imfil iteration " << iteration << ": stencil failure. New stencil scale = " << stencil_scale << std::endl;
+      continue;
+    }
+
+    if (have_previous_gradient) update_inverse_Hessian();
+
+    std::vector<double> old_x = x;
+    bool line_search_succeeded = (function_evaluations < max_function_evaluations) && line_search();
+    if (!line_search_succeeded || best_stencil_objective_function < objective_function) {
+      // Take the best point from the stencil, which is guaranteed to be better than the current point.
+      x = best_stencil_point;
+      objective_function = best_stencil_objective_function;
+    }
+    for (int j = 0; j < N_parameters; j++) step[j] = x[j] - old_x[j];
+    previous_gradient = gradient;
+    have_previous_gradient = true;
+    if (verbose > 0 && proc0_world) std::cout << "Imfil iteration " << iteration << ": objective function = " << std::setprecision(16) << objective_function
+					      << ", line search " << (line_search_succeeded ? "succeeded" : "failed") << std::endl;
+  }
+}
+
+//! Evaluate the objective function at a set of points in the scaled coordinates, concurrently.
+/**
+ * @param[in] N_set The number of points.
+ * @param[in] scaled_points The points, stored contiguously, in the coordinates for which the box is [0,1]^N_parameters.
+ * @param[out] objective_functions The values of the objective function, on all group leaders. Failed evaluations give infinity.
+ */
+void mango::Imfil::evaluate(int N_set, std::vector<double>& scaled_points, std::vector<double>& objective_functions) {
+  std::vector<double> state_vectors(N_set * N_parameters);
+  for (int j_set = 0; j_set < N_set; j_set++) {
+    for (int j = 0; j < N_parameters; j++) {
+      state_vectors[j_set * N_parameters + j] = lower_bounds[j] + scaled_points[j_set * N_parameters + j] * (upper_bounds[j] - lower_bounds[j]);
+    }
+  }
+  objective_functions.resize(N_set);
+  solver->evaluate_objective_set_in_parallel(N_set, state_vectors.data(), objective_functions.data());
+  function_evaluations += N_set;
+  if (solver->stop_requested) max_function_evaluations = function_evaluations;
+}
+
+//! Evaluate the stencil around the current point, and compute the stencil gradient.
+/**
+ * @return true if some point of the stencil is better than the current point, false if stencil failure occurred.
+ */
+bool mango::Imfil::evaluate_stencil() {
+  std::vector<double> points;
+  std::vector<int> directions;
+  int N_stencil = build_stencil(N_parameters, x.data(), stencil_scale, points, directions);
+  std::vector<double> stencil_objective_functions;
+  evaluate(N_stencil, points, stencil_objective_functions);
+
+  int best_index = -1;
+  best_stencil_objective_function = objective_function;
+  for (int k = 0; k < N_stencil; k++) {
+    if (stencil_objective_functions[k] < best_stencil_objective_function) {
+      best_stencil_objective_function = stencil_objective_functions[k];
+      best_index = k;
+    }
+  }
+  if (best_index < 0) return false;
+
+  for (int j = 0; j < N_parameters; j++) best_stencil_point[j] = points[best_index * N_parameters + j];
+  stencil_gradient(N_parameters, objective_function, stencil_scale, directions, stencil_objective_functions, gradient.data());
+  return true;
+}
+
+//! Evaluate a set of steps along the quasi-Newton direction concurrently.
+/**
+ * If one of the steps satisfies the sufficient decrease condition, the best such step is taken, updating x and objective_function.
+ * @return true if the line search succeeded.
+ */
+bool mango::Imfil::line_search() {
+  int j, k;
+  // Quasi-Newton direction, with the components that would leave the box at active bounds removed:
+  std::vector<double> direction(N_parameters, 0.0);
+  for (j = 0; j < N_parameters; j++) {
+    for (k = 0; k < N_parameters; k++) direction[j] -= inverse_Hessian[j * N_parameters + k] * gradient[k];
+  }
+  double directional_derivative = 0;
+  for (j = 0; j < N_parameters; j++) directional_derivative += direction[j] * gradient[j];
+  if (directional_derivative >= 0) {
+    // The quasi-Newton direction is not a descent direction, so fall back to steepest descent.
+    reset_inverse_Hessian();
+    for (j = 0; j < N_parameters; j++) direction[j] = -gradient[j];
+  }
+  double max_component = 0;
+  for (j = 0; j < N_parameters; j++) {
+    if ((x[j] <= 0 && direction[j] < 0) || (x[j] >= 1 && direction[j] > 0)) direction[j] = 0;
+    max_component = std::max(max_component, std::abs(direction[j]));
+  }
+  if (max_component == 0) return false;
+  // Without curvature information the length of the step is unknown, so the first step is the size of the stencil.
+  // In any case, do not step further than the width of the box.
+  double max_step = (have_curvature ? 1.0 : stencil_scale);
+  if (max_component > max_step || !have_curvature) {
+    for (j = 0; j < N_parameters; j++) direction[j] = direction[j] * max_step / max_component;
+  }
+
+  std::vector<double> points(N_line_search * N_parameters);
+  double step_length = 1.0;
+  for (k = 0; k < N_line_search; k++) {
+    for (j = 0; j < N_parameters; j++) {
+      points[k * N_parameters + j] = std::min(1.0, std::max(0.0, x[j] + step_length * direction[j]));
+    }
+    step_length = step_length * line_search_factor;
+  }
+  std::vector<double> line_search_objective_functions;
+  evaluate(N_line_search, points, line_search_objective_functions);
+
+  int best_index = -1;
+  double best_objective_function = objective_function;
+  for (k = 0; k < N_line_search; k++) {
+    double predicted_decrease = 0;
+    for (j = 0; j < N_parameters; j++) predicted_decrease += gradient[j] * (points[k * N_parameters + j] - x[j]);
+    if (line_search_objective_functions[k] <= objective_function + sufficient_decrease * predicted_decrease
+	&& line_search_objective_functions[k] < best_objective_function) {
+      best_objective_function = line_search_objective_functions[k];
+      best_index = k;
+    }
+  }
+  if (best_index < 0) return false;
+
+  for (j = 0; j < N_parameters; j++) x[j] = points[best_index * N_parameters + j];
+  objective_function = best_objective_function;
+  return true;
+}
+
+//! Apply the BFGS update to the approximate inverse Hessian, using the last step and the change in the stencil gradient.
+void mango::Imfil::update_inverse_Hessian() {
+  int j, k;
+  std::vector<double> y(N_parameters);
+  double ys = 0, yy = 0, ss = 0;
+  for (j = 0; j < N_parameters; j++) {
+    y[j] = gradient[j] - previous_gradient[j];
+    ys += y[j] * step[j];
+    yy += y[j] * y[j];
+    ss += step[j] * step[j];
+  }
+  // Skip the update unless the curvature condition holds, so the inverse Hessian stays positive definite.
+  if (ys <= 1.0e-10 * sqrt(yy * ss)) return;
+
+  if (!have_curvature) {
+    // Scale the initial inverse Hessian as in Nocedal & Wright, eq (6.20), before the first update.
+    for (j = 0; j < N_parameters; j++) inverse_Hessian[j * N_parameters + j] = ys / yy;
+    have_curvature = true;
+  }
+
+  double rho = 1.0 / ys;
+  std::vector<double> Hy(N_parameters, 0.0);
+  double yHy = 0;
+  for (j = 0; j < N_parameters; j++) {
+    for (k = 0; k < N_parameters; k++) Hy[j] += inverse_Hessian[j * N_parameters + k] * y[k];
+    yHy += y[j] * Hy[j];
+  }
+  for (j = 0; j < N_parameters; j++) {
+    for (k = 0; k < N_parameters; k++) {
+      inverse_Hessian[j * N_parameters + k] += -rho * (step[j] * Hy[k] + Hy[j] * step[k]) + (rho * rho * yHy + rho) * step[j] * step[k];
+    }
+  }
+}
+
+void mango::Imfil::reset_inverse_Hessian() {
+  for (int j = 0; j < N_parameters * N_parameters; j++) inverse_Hessian[j] = 0;
+  for (int j = 0; j < N_parameters; j++) inverse_Hessian[j * N_parameters + j] = 1;
+  have_previous_gradient = false;
+  have_curvature = false;
+}
+
+//! Build the stencil of points around x, omitting points that would lie outside the box [0,1]^N_parameters.
+/**
+ * @param[in] N_parameters The number of parameters.
+ * @param[in] x The center of the stencil.
+ * @param[in] scale The stencil scale.
+ * @param[out] points The stencil points, stored contiguously.
+ * @param[out] directions For each stencil point, j+1 if it is x + scale * e_j, or -(j+1) if it is x - scale * e_j.
+ * @return The number of stencil points.
+ */
+int mango::Imfil::build_stencil(int N_parameters, const double* x, double scale, std::vector<double>& points, std::vector<int>& directions) {
+  points.clear();
+  directions.clear();
+  for (int j = 0; j < N_parameters; j++) {
+    for (int sign = 1; sign >= -1; sign -= 2) {
+      double value = x[j] + sign * scale;
+      if (value < 0 || value > 1) continue;
+      for (int k = 0; k < N_parameters; k++) points.push_back(k == j ? value : x[k]);
+      directions.push_back(sign * (j + 1));
+    }
+  }
+  return directions.size();
+}
+
+//! Compute the stencil gradient.
+/**
+ * Centered differences are used where both stencil points in a direction are available, and one-sided differences otherwise.
+ * Components for which no finite stencil value is available are set to 0.
+ * @param[in] N_parameters The number of parameters.
+ * @param[in] objective_function The objective function at the center of the stencil.
+ * @param[in] scale The stencil scale.
+ * @param[in] directions The directions of the stencil points, as returned by build_stencil().
+ * @param[in] stencil_objective_functions The objective function at each stencil point.
+ * @param[out] gradient The stencil gradient.
+ */
+void mango::Imfil::stencil_gradient(int N_parameters, double objective_function, double scale, const std::vector<int>& directions,
+				    const std::vector<double>& stencil_objective_functions, double* gradient) {
+  std::vector<double> f_plus(N_parameters, std::numeric_limits<double>::infinity());
+  std::vector<double> f_minus(N_parameters, std::numeric_limits<double>::infinity());
+  for (size_t k = 0; k < directions.size(); k++) {
+    if (directions[k] > 0) {
+      f_plus[directions[k] - 1] = stencil_objective_functions[k];
+    } else {
+      f_minus[-directions[k] - 1] = stencil_objective_functions[k];
+    }
+  }
+  bool center_finite = std::isfinite(objective_function);
+  for (int j = 0; j < N_parameters; j++) {
+    bool plus = std::isfinite(f_plus[j]);
+    bool minus = std::isfinite(f_minus[j]);
+    if (plus && minus) {
+      gradient[j] = (f_plus[j] - f_minus[j]) / (2 * scale);
+    } else if (plus && center_finite) {
+      gradient[j] = (f_plus[j] - objective_function) / scale;
+    } else if (minus && center_finite) {
+      gradient[j] = (objective_function - f_minus[j]) / scale;
+    } else {
+      gradient[j] = 0;
+    }
+  }
 }
@@ -1,15 +1,59 @@
 #ifndef MANGO_IMFIL_H
 #define MANGO_IMFIL_H
 
+#include <vector>
 #include "Package_mango.hpp"
 #include "Solver.hpp"
 
 namespace mango {
   class Imfil : public Algorithm {
-
   public:
+    Solver* solver;
+
+    // Define shorthand variable names:
+    int N_parameters;
+    int N_line_search;
+    int verbose;
+    bool proc0_world;
+    MPI_Comm comm_group_leaders;
+
+    // Copies of the bound constraints, which are the same on all group leaders:
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+
+    // The algorithm works with the parameters scaled so the box is [0,1]^N_parameters.
+    std::vector<double> x;
+    double objective_function;
+    double stencil_scale;
+    int scale_depth;
+    double line_search_factor;
+    double sufficient_decrease;
+    int function_evaluations;
+    int max_function_evaluations;
+    int iteration;
+
+    std::vector<double> gradient;
+    std::vector<double> previous_gradient;
+    std::vector<double> step;
+    std::vector<double> inverse_Hessian;
+    bool have_previous_gradient;
+    bool have_curvature;
+
+    // Results of the most recent stencil:
+    std::vector<double> best_stencil_point;
+    double best_stencil_objective_function;
+
     Imfil(Solver*);
     void solve();
+    void evaluate(int N_set, std::vector<double>& scaled_points, std::vector<double>& objective_functions);
+    bool evaluate_stencil();
+    bool line_search();
+    void update_inverse_Hessian();
+    void reset_inverse_Hessian();
+
+    static int build_stencil(int N_parameters, const double* x, double scale, std::vector<double>& points, std::vector<int>& directions);
+    static void stencil_gradient(int N_parameters, double objective_function, double scale, const std::vector<int>& directions,
+				 const std::vector<double>& stencil_objective_functions, double* gradient);
   };
 }
 
@@ -0,0 +1,329 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <Package_mango.hpp>
+#include "Least_squares_solver.hpp"
+#include "Lbfgs.hpp"
+
+//! Constructor
+mango::Lbfgs::Lbfgs(Solver* solver_in) {
+  solver = solver_in;
+
+  // Parameters of the algorithm:
+  // Number of (s, y) pairs kept for the inverse Hessian approximation:
+  memory = 10;
+  // Constant in the Armijo sufficient decrease condition:
+  sufficient_decrease = 1.0e-4;
+  // The first step, in the infinity norm, relative to the width of the box, or to max(|x|, 1) if there are no bound constraints:
+  initial_step_fraction = 0.1;
+
+  // Define shorthand variable names:
+  N_parameters = solver->N_parameters;
+  verbose = solver->verbose;
+  N_line_search = solver->N_line_search;
+  max_function_evaluations = solver->max_function_evaluations;
+  proc0_world = solver->mpi_partition->get_proc0_world();
+  comm_group_leaders = solver->mpi_partition->get_comm_group_leaders();
+  bound_constraints_set = solver->bound_constraints_set && algorithms[solver->algorithm].allows_bound_constraints;
+  // For least-squares problems, the gradient is computed from the residuals:
+  least_squares_solver = dynamic_cast<Least_squares_solver*>(solver);
+  N_values = (least_squares_solver == NULL) ? 1 : least_squares_solver->N_terms;
+
+  if (N_line_search < 1) throw std::runtime_error("N_line_search must be >= 1.");
+  // Each failed line search shrinks the step lengths by 2^N_line_search. Give up after a total reduction of about 10^6:
+  max_line_search_iterations = (20 + N_line_search - 1) / N_line_search;
+
+  // Make sure all group leaders agree on the bound constraints and initial condition.
+  state_vector.resize(N_parameters);
+  solver->broadcast_initial_condition(state_vector.data());
+  double scale = 0;
+  if (bound_constraints_set) {
+    solver->broadcast_bound_constraints(lower_bounds, upper_bounds);
+    for (int j = 0; j < N_parameters; j++) scale = std::max(scale, upper_bounds[j] - lower_bounds[j]);
+  } else {
+    scale = 1;
+    for (int j = 0; j < N_parameters; j++) scale = std::max(scale, std::abs(state_vector[j]));
+  }
+  Solver::project_onto_bounds(lower_bounds, upper_bounds, state_vector.data());
+  steepest_descent_step = initial_step_fraction * scale;
+
+  gradient.resize(N_parameters);
+  function_evaluations = 0;
+  iteration = 0;
+}
+
+//! The main driver for the L-BFGS algorithm
+/**
+ * This is the limited-memory BFGS quasi-Newton method, with the gradient computed by finite differences. In contrast to
+ * gsl_bfgs and nlopt_ld_lbfgs, both halves of each iteration are concurrent: the finite-difference stencil is evaluated as one
+ * set, and the line search evaluates N_line_search step lengths along the search direction as one set, in the same way that
+ * mango_levenberg_marquardt scans its grid of lambda values. Of the step lengths satisfying the Armijo condition, the one with
+ * the lowest objective function is accepted. If none does, the grid is shifted to shorter steps and evaluated again.
+ * If bound constraints are set, trial points are projected onto the box, and parameters at a bound whose gradient points out of
+ * the box are held fixed in the search direction.
+ * The algorithm stops when max_function_evaluations is reached, or when the line search fails even along the steepest descent direction.
+ * All group leaders carry out the same computations, using the function values broadcast from proc0_world, so the results do not
+ * depend on the number of worker groups.
+ */
+void mango::Lbfgs::solve() {
+  if (!compute_gradient(true)) {
+    if (proc0_world) std::cerr << "Warning: mango_lbfgs stopped, since the objective function or its gradient could not be evaluated at the initial condition." << std::endl;
+    return;
+  }
+
+  std::vector<double> direction(N_parameters);
+  std::vector<double> old_state_vector, old_gradient;
+  std::vector<double> s(N_parameters), y(N_parameters);
+  while (function_evaluations < max_function_evaluations) {
+    iteration++;
+    search_direction(direction);
+    bool nonzero = false;
+    for (int j = 0; j < N_parameters; j++) nonzero = nonzero || (direction[j] != 0);
+    if (!nonzero) break; // The projected gradient vanishes.
+
+    old_state_vector = state_vector;
+    old_gradient = gradient;
+    if (!line_search(direction)) {
+      if (s_history.empty() || function_evaluations >= max_function_evaluations) break;
+      // Try again along the steepest descent direction.
+      if (verbose > 0 && proc0_world) std::cout << "L-BFGS: line search failed, so clearing the memory." << std::endl;
+      s_history.clear();
+      y_history.clear();
+      continue;
+    }
+    if (function_evaluations >= max_function_evaluations) break;
+    if (!compute_gradient(false)) break;
+
+    // Update the memory, skipping pairs that do not satisfy the curvature condition.
+    double sy = 0, ss = 0, yy = 0;
+    for (int j = 0; j < N_parameters; j++) {
+      s[j] = state_vector[j] - old_state_vector[j];
+      y[j] = gradient[j] - old_gradient[j];
+      sy += s[j] * y[j];
+      ss += s[j] * s[j];
+      yy += y[j] * y[j];
+    }
+    if (sy > 1.0e-10 * sqrt(ss * yy)) {
+      s_history.push_back(s);
+      y_history.push_back(y);
+      if ((int) s_history.size() > memory) {
+	s_history.pop_front();
+	y_history.pop_front();
+      }
+    }
+  }
+}
+
+//! Compute the gradient at state_vector by finite differences, evaluating the stencil concurrently.
+/**
+ * The step size and the choice of 1-sided or centered differences are those of the Problem. If a step would leave the box,
+ * the 1-sided difference is taken in the opposite direction, and the centered difference is replaced by a 2nd-order 1-sided difference.
+ * For least-squares problems the residuals are differenced, and the gradient is 2 J^T r as in Least_squares_solver::finite_difference_gradient(),
+ * so the error in the gradient vanishes as the residuals do.
+ * @param[in] evaluate_base_case If true, the objective function at state_vector is evaluated too. Otherwise the stored values are used.
+ * @return True if the objective function and all components of the gradient are finite.
+ */
+bool mango::Lbfgs::compute_gradient(bool evaluate_base_case) {
+  double h = solver->finite_difference_step_size;
+  bool centered = solver->centered_differences;
+  int N_per_parameter = centered ? 2 : 1;
+  int N_base = evaluate_base_case ? 1 : 0;
+  int N_set = N_base + N_per_parameter * N_parameters;
+  // For each parameter, directions[j] is +1 or -1 for a 1-sided difference, and 0 for a centered difference.
+  std::vector<int> directions(N_parameters);
+  std::vector<double> points(N_set * N_parameters);
+  std::vector<double> objective_functions;
+
+  for (int k = 0; k < N_set; k++) {
+    for (int j = 0; j < N_parameters; j++) points[k * N_parameters + j] = state_vector[j];
+  }
+  for (int j = 0; j < N_parameters; j++) {
+    bool forward_fits = !bound_constraints_set || state_vector[j] + N_per_parameter * h <= upper_bounds[j];
+    if (centered) {
+      bool both_fit = !bound_constraints_set || (state_vector[j] + h <= upper_bounds[j] && state_vector[j] - h >= lower_bounds[j]);
+      directions[j] = both_fit ? 0 : (forward_fits ? 1 : -1);
+    } else {
+      directions[j] = forward_fits ? 1 : -1;
+    }
+    int k = N_base + N_per_parameter * j;
+    if (directions[j] == 0) {
+      points[k * N_parameters + j] += h;
+      points[(k + 1) * N_parameters + j] -= h;
+    } else {
+      for (int m = 0; m < N_per_parameter; m++) points[(k + m) * N_parameters + j] += (m + 1) * directions[j] * h;
+    }
+  }
+
+  evaluate(N_set, points, objective_functions);
+  if (evaluate_base_case) {
+    objective_function = objective_functions[0];
+    current_values.assign(set_values.begin(), set_values.begin() + N_values);
+  }
+
+  bool finite = std::isfinite(objective_function);
+  for (int j = 0; j < N_parameters; j++) {
+    gradient[j] = 0;
+    for (int c = 0; c < N_values; c++) {
+      const double f0 = current_values[c];
+      const double f1 = set_values[(N_base + N_per_parameter * j) * N_values + c];
+      double derivative;
+      if (!centered) {
+	derivative = (f1 - f0) / (directions[j] * h);
+      } else {
+	const double f2 = set_values[(N_base + N_per_parameter * j + 1) * N_values + c];
+	if (directions[j] == 0) {
+	  derivative = (f1 - f2) / (2 * h);
+	} else {
+	  derivative = directions[j] * (-3 * f0 + 4 * f1 - f2) / (2 * h);
+	}
+      }
+      gradient[j] += (least_squares_solver == NULL) ? derivative : 2 * f0 * derivative;
+    }
+    finite = finite && std::isfinite(gradient[j]);
+  }
+  return finite;
+}
+
+//! Compute the search direction -H g from the L-BFGS approximation H of the inverse Hessian.
+/**
+ * Parameters at a bound whose gradient points out of the box are held fixed. If the memory is empty, or the direction is not a
+ * descent direction, the memory is cleared and the steepest descent direction is used, scaled so its infinity norm is steepest_descent_step.
+ * @param[out] direction The search direction.
+ */
+void mango::Lbfgs::search_direction(std::vector<double>& direction) {
+  std::vector<bool> fixed(N_parameters, false);
+  if (bound_constraints_set) {
+    for (int j = 0; j < N_parameters; j++) {
+      fixed[j] = (state_vector[j] <= lower_bounds[j] && gradient[j] > 0) || (state_vector[j] >= upper_bounds[j] && gradient[j] < 0);
+    }
+  }
+
+  double slope = 0;
+  if (!s_history.empty()) {
+    two_loop_recursion(s_history, y_history, gradient, direction);
+    for (int j = 0; j < N_parameters; j++) {
+      if (fixed[j]) direction[j] = 0;
+      slope += direction[j] * gradient[j];
+    }
+  }
+  if (!(slope < 0)) {
+    if (!s_history.empty() && verbose > 0 && proc0_world) std::cout << "L-BFGS: not a descent direction, so clearing the memory." << std::endl;
+    s_history.clear();
+    y_history.clear();
+    double gradient_norm = 0;
+    for (int j = 0; j < N_parameters; j++) {
+      if (!fixed[j]) gradient_norm = std::max(gradient_norm, std::abs(gradient[j]));
+    }
+    for (int j = 0; j < N_parameters; j++) direction[j] = (fixed[j] || gradient_norm == 0) ? 0 : -gradient[j] * steepest_descent_step / gradient_norm;
+  }
+}
+
+//! Evaluate N_line_search step lengths along the search direction concurrently, and move to the best one that gives sufficient decrease.
+/**
+ * The step lengths are alpha * 2^((N_line_search - 1) / 2 - k) for k = 0, ..., N_line_search - 1, with alpha = 1 at first.
+ * If no step length satisfies the Armijo condition, alpha is divided by 2^N_line_search and the line search is repeated, up to
+ * max_line_search_iterations times.
+ * @param[in] direction The search direction.
+ * @return True if a step was accepted, in which case state_vector and objective_function are updated.
+ */
+bool mango::Lbfgs::line_search(const std::vector<double>& direction) {
+  std::vector<double> points(N_line_search * N_parameters);
+  std::vector<double> objective_functions;
+  double alpha = 1.0;
+  for (int j_line_search = 0; j_line_search < max_line_search_iterations; j_line_search++) {
+    for (int k = 0; k < N_line_search; k++) {
+      double step_length = alpha * pow(2.0, 0.5 * (N_line_search - 1) - k);
+      for (int j = 0; j < N_parameters; j++) points[k * N_parameters + j] = state_vector[j] + step_length * direction[j];
+      Solver::project_onto_bounds(lower_bounds, upper_bounds, &points[k * N_parameters]);
+    }
+    evaluate(N_line_search, points, objective_functions);
+
+    int best = -1;
+    for (int k = 0; k < N_line_search; k++) {
+      double predicted_decrease = 0;
+      for (int j = 0; j < N_parameters; j++) predicted_decrease += gradient[j] * (points[k * N_parameters + j] - state_vector[j]);
+      bool sufficient = objective_functions[k] < objective_function && objective_functions[k] <= objective_function + sufficient_decrease * predicted_decrease;
+      if (sufficient && (best < 0 || objective_functions[k] < objective_functions[best])) best = k;
+    }
+
+    if (best >= 0) {
+      // Scale the next steepest descent step to the one just taken, allowing it to grow if the longest step was the best.
+      double step = 0;
+      for (int j = 0; j < N_parameters; j++) step = std::max(step, std::abs(points[best * N_parameters + j] - state_vector[j]));
+      if (step > 0) steepest_descent_step = (best == 0) ? 2 * step : step;
+      for (int j = 0; j < N_parameters; j++) state_vector[j] = points[best * N_parameters + j];
+      objective_function = objective_functions[best];
+      current_values.assign(set_values.begin() + best * N_values, set_values.begin() + (best + 1) * N_values);
+      if (verbose > 0 && proc0_world) std::cout << "L-BFGS iteration " << iteration << ": accepted step " << best << " of line search " << j_line_search
+						<< ", objective function = " << std::setprecision(16) << objective_function << std::endl;
+      return true;
+    }
+    if (function_evaluations >= max_function_evaluations) break;
+    alpha *= pow(2.0, -N_line_search);
+  }
+  return false;
+}
+
+//! Evaluate the objective function at a set of points, concurrently.
+/**
+ * For least-squares problems, the shifted residuals (residuals - targets) / sigmas are evaluated and stored in set_values.
+ * Otherwise set_values holds the objective functions.
+ * @param[in] N_set The number of points.
+ * @param[in] points The points, stored contiguously.
+ * @param[out] objective_functions The values of the objective function, on all group leaders. Failed evaluations give infinity.
+ */
+void mango::Lbfgs::evaluate(int N_set, std::vector<double>& points, std::vector<double>& objective_functions) {
+  objective_functions.resize(N_set);
+  set_values.assign(N_set * N_values, 0.0);
+  if (least_squares_solver == NULL) {
+    solver->evaluate_objective_set_in_parallel(N_set, points.data(), objective_functions.data());
+    set_values = objective_functions;
+  } else {
+    least_squares_solver->evaluate_shifted_residual_set_in_parallel(N_set, points.data(), set_values.data(), objective_functions.data());
+  }
+  function_evaluations += N_set;
+  if (solver->stop_requested) max_function_evaluations = function_evaluations;
+}
+
+//! Multiply the gradient by minus the L-BFGS approximation of the inverse Hessian.
+/**
+ * This is the two-loop recursion of Nocedal, Math. Comp. 35, 773 (1980), with the initial inverse Hessian
+ * (s^T y / y^T y) I from the most recent pair.
+ * @param[in] s_history The differences between successive state vectors, oldest first. Must not be empty.
+ * @param[in] y_history The corresponding differences between successive gradients.
+ * @param[in] gradient The gradient.
+ * @param[out] direction -H times the gradient.
+ */
+void mango::Lbfgs::two_loop_recursion(const std::deque<std::vector<double> >& s_history, const std::deque<std::vector<double> >& y_history,
+				      const std::vector<double>& gradient, std::vector<double>& direction) {
+  int N = gradient.size();
+  int N_pairs = s_history.size();
+  std::vector<double> rho(N_pairs), a(N_pairs);
+  std::vector<double> q = gradient;
+  for (int m = N_pairs - 1; m >= 0; m--) {
+    double sy = 0, sq = 0;
+    for (int j = 0; j < N; j++) {
+      sy += s_history[m][j] * y_history[m][j];
+      sq += s_history[m][j] * q[j];
+    }
+    rho[m] = 1 / sy;
+    a[m] = rho[m] * sq;
+    for (int j = 0; j < N; j++) q[j] -= a[m] * y_history[m][j];
+  }
+  double yy = 0;
+  for (int j = 0; j < N; j++) yy += y_history[N_pairs - 1][j] * y_history[N_pairs - 1][j];
+  double gamma = 1 / (rho[N_pairs - 1] * yy);
+  for (int j = 0; j < N; j++) q[j] *= gamma;
+  for (int m = 0; m < N_pairs; m++) {
+    double yr = 0;
+    for (int j = 0; j < N; j++) yr += y_history[m][j] * q[j];
+    double b = rho[m] * yr;
+    for (int j = 0; j < N; j++) q[j] += (a[m] - b) * s_history[m][j];
+  }
+  direction.resize(N);
+  for (int j = 0; j < N; j++) direction[j] = -q[j];
+}
@@ -0,0 +1,64 @@
+#ifndef MANGO_LBFGS_H
+#define MANGO_LBFGS_H
+
+#include <vector>
+#include <deque>
+#include "Package_mango.hpp"
+#include "Solver.hpp"
+#include "Least_squares_solver.hpp"
+
+namespace mango {
+  class Lbfgs : public Algorithm {
+  public:
+    Solver* solver;
+
+    // Define shorthand variable names:
+    int N_parameters;
+    int verbose;
+    int N_line_search;
+    bool proc0_world;
+    MPI_Comm comm_group_leaders;
+    bool bound_constraints_set;
+
+    // For least-squares problems, the solver and the number of residuals. Otherwise NULL and 1:
+    Least_squares_solver* least_squares_solver;
+    int N_values;
+
+    // Copies of the bound constraints, which are the same on all group leaders:
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+
+    // Parameters of the algorithm:
+    int memory;
+    double sufficient_decrease;
+    double initial_step_fraction;
+    int max_line_search_iterations;
+
+    // State of the algorithm:
+    std::vector<double> state_vector;
+    double objective_function;
+    // The quantities that are differenced to get the gradient (the objective function, or the shifted residuals),
+    // at state_vector and at each point of the set evaluated most recently:
+    std::vector<double> current_values;
+    std::vector<double> set_values;
+    std::vector<double> gradient;
+    std::deque<std::vector<double> > s_history;
+    std::deque<std::vector<double> > y_history;
+    double steepest_descent_step;
+    int function_evaluations;
+    int max_function_evaluations;
+    int iteration;
+
+    Lbfgs(Solver*);
+    void solve();
+    bool compute_gradient(bool evaluate_base_case);
+    void search_direction(std::vector<double>& direction);
+    bool line_search(const std::vector<double>& direction);
+    void evaluate(int N_set, std::vector<double>& points, std::vector<double>& objective_functions);
+
+    static void two_loop_recursion(const std::deque<std::vector<double> >& s_history, const std::deque<std::vector<double> >& y_history,
+				   const std::vector<double>& gradient, std::vector<double>& direction);
+  };
+}
+
+#endif
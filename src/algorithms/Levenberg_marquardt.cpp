@@ -1,5 +1,8 @@
 #include <iostream>
 #include <iomanip>
+#include <vector>
+#include <cmath>
+#include <limits>
 #include "Least_squares_solver.hpp"
 #include "Package_mango.hpp"
 #include "Levenberg_marquardt.hpp"
@@ -63,6 +66,7 @@ mango::Levenberg_marquardt::Levenberg_marquardt(Least_squares_solver* solver_in)
   delta_x.resize(N_parameters);
   lambda_scan_residuals.resize(N_terms, N_line_search);
   lambda_scan_state_vectors.resize(N_parameters, N_line_search);
+  lambda_scan_failures.assign(N_line_search, 0);
   lambdas.resize(N_line_search);
   lambda_scan_objective_functions.resize(N_line_search);
   if (check_least_squares_solution) {
@@ -186,6 +190,8 @@ void mango::Levenberg_marquardt::line_search() {
 void mango::Levenberg_marquardt::evaluate_on_lambda_grid() {
   lambda_scan_residuals = Eigen::MatrixXd::Zero(N_terms, N_line_search); // Initialize residuals to 0.
   lambda_scan_state_vectors = Eigen::MatrixXd::Zero(N_parameters, N_line_search); // Initialize to 0.
+  lambda_scan_failures.assign(N_line_search, 0);
+  std::vector<int> my_points;
   // Perform concurrent function evaluations for several values of lambda: 
   for (j_lambda_grid = 0; j_lambda_grid < N_line_search; j_lambda_grid++) {
     lambda = central_lambda * normalized_lambda_grid[j_lambda_grid];
@@ -222,12 +228,14 @@ void mango::Levenberg_marquardt::evaluate_on_lambda_grid() {
       
       state_vector_tentative = state_vector + delta_x;
       lambda_scan_state_vectors.col(j_lambda_grid) = state_vector_tentative;
-      
-      // Evaluate the residuals at the new point
-      solver->residual_function(&N_parameters, state_vector_tentative.data(), &N_terms, residuals.data(), &failed_int, solver->problem, solver->user_data);
-      lambda_scan_residuals.col(j_lambda_grid) = residuals;
+      my_points.push_back(j_lambda_grid);
     } // if this MPI proc owns this point in the lambda grid
   } // End of loop over lambda grid.
+
+  // Evaluate the residuals at the new points owned by this proc. Since Eigen matrices are stored column-major,
+  // column j_lambda_grid is stored contiguously, as evaluate_points() expects.
+  // Depending on the settings, the points are evaluated one at a time, using threads, or in a single batch.
+  solver->evaluate_points(solver->residual_function, N_terms, my_points, lambda_scan_state_vectors.data(), lambda_scan_residuals.data(), lambda_scan_failures.data());
   
   // Send the computed state vectors and residuals back to proc0_world.
   // The approach requiring least communication would be to have each proc only send the residuals it evaluated.
@@ -235,9 +243,11 @@ void mango::Levenberg_marquardt::evaluate_on_lambda_grid() {
   if (proc0_world) {
     MPI_Reduce(MPI_IN_PLACE,                     lambda_scan_state_vectors.data(), N_line_search * N_parameters, MPI_DOUBLE, MPI_SUM, 0, comm_group_leaders);
     MPI_Reduce(MPI_IN_PLACE,                         lambda_scan_residuals.data(), N_line_search * N_terms,      MPI_DOUBLE, MPI_SUM, 0, comm_group_leaders);
+    MPI_Reduce(MPI_IN_PLACE,                          lambda_scan_failures.data(), N_line_search,                MPI_INT,    MPI_SUM, 0, comm_group_leaders);
   } else {
     MPI_Reduce(lambda_scan_state_vectors.data(), lambda_scan_state_vectors.data(), N_line_search * N_parameters, MPI_DOUBLE, MPI_SUM, 0, comm_group_leaders);
     MPI_Reduce(lambda_scan_residuals.data(),         lambda_scan_residuals.data(), N_line_search * N_terms,      MPI_DOUBLE, MPI_SUM, 0, comm_group_leaders);
+    MPI_Reduce(lambda_scan_failures.data(),           lambda_scan_failures.data(), N_line_search,                MPI_INT,    MPI_SUM, 0, comm_group_leaders);
   }
 }
 
@@ -250,13 +260,15 @@ void mango::Levenberg_marquardt::process_lambda_grid_results() {
 
   if (proc0_world) {
     // proc0 is responsible for finding the best function evaluation and deciding how to proceed.
-    failed = false;
     for (j_lambda_grid = 0; j_lambda_grid < N_line_search; j_lambda_grid++) {
+      failed = (lambda_scan_failures[j_lambda_grid] != 0);
       // Record the function evaluations from the lambda scan. This line also increments the counter for function evaluations.
       solver->record_function_evaluation_pointer(lambda_scan_state_vectors.col(j_lambda_grid).data(), lambda_scan_residuals.col(j_lambda_grid).data(), failed);
       // Apply the transformation involving sigmas and targets:
       shifted_residuals = (lambda_scan_residuals.col(j_lambda_grid) - targets).cwiseQuotient(sigmas);
       tentative_objective_function = shifted_residuals.dot(shifted_residuals);
+      // A failed evaluation is never taken as the best point in the lambda scan.
+      if (failed || !std::isfinite(tentative_objective_function)) tentative_objective_function = std::numeric_limits<double>::infinity();
       if (verbose>0) std::cout<< "For j_lambda_grid=" << j_lambda_grid << ", objective function=" << tentative_objective_function << std::endl;
       lambda_scan_objective_functions(j_lambda_grid) = tentative_objective_function;
       // Find the index in the lambda grid with smallest value of the objective function:
@@ -284,6 +296,7 @@ void mango::Levenberg_marquardt::process_lambda_grid_results() {
       central_lambda = central_lambda * lambda_increase_factor;
       if (verbose>0) std::cout << "Increasing central lambda to " << central_lambda << std::endl;
     }
+    solver->metrics->set_levenberg_marquardt_state(outer_iteration, central_lambda);
     //std::cout << "solver->function_evaluations: " << solver->function_evaluations << ", solver->max_function_evaluations: " << solver->max_function_evaluations << std::endl;
     if (solver->function_evaluations >= solver->max_function_evaluations) {
       // Quit due to hitting max_function_evaluations
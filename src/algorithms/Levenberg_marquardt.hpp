@@ -37,6 +37,7 @@ namespace mango {
     Eigen::VectorXd delta_x;
     Eigen::MatrixXd lambda_scan_residuals;
     Eigen::MatrixXd lambda_scan_state_vectors;
+    std::vector<int> lambda_scan_failures;
     Eigen::VectorXd lambdas;
     Eigen::VectorXd lambda_scan_objective_functions;
     Eigen::VectorXd delta_x_direct;
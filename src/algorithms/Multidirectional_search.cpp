@@ -0,0 +1,186 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <Package_mango.hpp>
+#include "Multidirectional_search.hpp"
+
+//! Constructor
+mango::Multidirectional_search::Multidirectional_search(Solver* solver_in) {
+  solver = solver_in;
+
+  // Parameters of the algorithm:
+  // The edges of the initial simplex, relative to the width of the box (see initialize_simplex()):
+  initial_step_fraction = 0.1;
+  // Factors by which the edges of the simplex are scaled for the expansion and contraction steps:
+  expansion_factor = 2.0;
+  contraction_factor = 0.5;
+  // The search restarts when the simplex has shrunk by this factor relative to the initial simplex:
+  simplex_tolerance = 1.0e-8;
+
+  // Define shorthand variable names:
+  N_parameters = solver->N_parameters;
+  verbose = solver->verbose;
+  max_function_evaluations = solver->max_function_evaluations;
+  proc0_world = solver->mpi_partition->get_proc0_world();
+  comm_group_leaders = solver->mpi_partition->get_comm_group_leaders();
+  bound_constraints_set = solver->bound_constraints_set && algorithms[solver->algorithm].allows_bound_constraints;
+
+  // Make sure all group leaders agree on the bound constraints and initial condition.
+  std::vector<double> x(N_parameters);
+  solver->broadcast_initial_condition(x.data());
+  if (bound_constraints_set) solver->broadcast_bound_constraints(lower_bounds, upper_bounds);
+
+  // Initial simplex: the initial condition, and a step along each coordinate direction.
+  vertices.resize((N_parameters + 1) * N_parameters);
+  Solver::project_onto_bounds(lower_bounds, upper_bounds, x.data());
+  for (int j = 0; j < N_parameters; j++) vertices[j] = x[j];
+  initialize_simplex();
+
+  function_evaluations = 0;
+  iteration = 0;
+}
+
+//! The main driver for the multidirectional search algorithm
+/**
+ * This is the multidirectional search of Torczon, SIAM J Optimization 1, 123 (1991). At each iteration, the simplex is
+ * reflected, expanded, and contracted through its best vertex. The N_parameters reflected, N_parameters expanded, and
+ * N_parameters contracted vertices are all evaluated as one set, concurrently. If the best reflected vertex improves on the
+ * best vertex, the expanded simplex is accepted if it is better still, and otherwise the reflected simplex is accepted.
+ * Otherwise the contracted simplex is accepted.
+ * When the simplex has shrunk by a factor simplex_tolerance, the search is restarted from a new simplex around the best vertex,
+ * since the simplex can collapse without reaching a minimum for nonsmooth objectives. The algorithm stops when a restart does not
+ * improve on the best vertex, or when max_function_evaluations is reached.
+ * All group leaders carry out the same computations, using the function values broadcast from proc0_world.
+ */
+void mango::Multidirectional_search::solve() {
+  evaluate(N_parameters + 1, vertices, vertex_objective_functions);
+  double restart_objective_function = std::numeric_limits<double>::infinity();
+
+  while (true) {
+    search();
+    if (function_evaluations >= max_function_evaluations || !(vertex_objective_functions[0] < restart_objective_function)) break;
+    restart_objective_function = vertex_objective_functions[0];
+    if (verbose > 0 && proc0_world) std::cout << "Multidirectional search: restarting from a new simplex around the best vertex." << std::endl;
+
+    initialize_simplex();
+    std::vector<double> new_vertices(vertices.begin() + N_parameters, vertices.end());
+    std::vector<double> new_objective_functions;
+    evaluate(N_parameters, new_vertices, new_objective_functions);
+    for (int k = 0; k < N_parameters; k++) vertex_objective_functions[k + 1] = new_objective_functions[k];
+  }
+}
+
+//! Carry out iterations of the multidirectional search until the simplex has shrunk by a factor simplex_tolerance.
+void mango::Multidirectional_search::search() {
+  int j, k;
+  const double factors[3] = {-1.0, -expansion_factor, contraction_factor};
+  const char* step_names[3] = {"reflection", "expansion", "contraction"};
+  std::vector<double> candidates(3 * N_parameters * N_parameters);
+  std::vector<double> candidate_objective_functions;
+  double initial_simplex_size = -1;
+
+  while (true) {
+    // Move the best vertex to the front.
+    int best_index = 0;
+    for (k = 1; k <= N_parameters; k++) {
+      if (vertex_objective_functions[k] < vertex_objective_functions[best_index]) best_index = k;
+    }
+    if (best_index != 0) {
+      for (j = 0; j < N_parameters; j++) std::swap(vertices[j], vertices[best_index * N_parameters + j]);
+      std::swap(vertex_objective_functions[0], vertex_objective_functions[best_index]);
+    }
+    if (initial_simplex_size < 0) initial_simplex_size = simplex_size();
+
+    if (simplex_size() <= simplex_tolerance * initial_simplex_size || function_evaluations >= max_function_evaluations) break;
+    iteration++;
+
+    for (int step = 0; step < 3; step++) {
+      double* new_vertices = &candidates[step * N_parameters * N_parameters];
+      transform_simplex(N_parameters, vertices.data(), factors[step], new_vertices);
+      for (k = 0; k < N_parameters; k++) Solver::project_onto_bounds(lower_bounds, upper_bounds, &new_vertices[k * N_parameters]);
+    }
+    evaluate(3 * N_parameters, candidates, candidate_objective_functions);
+
+    double best_objective_functions[3];
+    for (int step = 0; step < 3; step++) {
+      best_objective_functions[step] = std::numeric_limits<double>::infinity();
+      for (k = 0; k < N_parameters; k++) {
+	best_objective_functions[step] = std::min(best_objective_functions[step], candidate_objective_functions[step * N_parameters + k]);
+      }
+    }
+    int accepted_step;
+    if (best_objective_functions[0] < vertex_objective_functions[0]) {
+      accepted_step = (best_objective_functions[1] < best_objective_functions[0]) ? 1 : 0;
+    } else {
+      accepted_step = 2;
+    }
+    for (k = 0; k < N_parameters; k++) {
+      for (j = 0; j < N_parameters; j++) vertices[(k + 1) * N_parameters + j] = candidates[(accepted_step * N_parameters + k) * N_parameters + j];
+      vertex_objective_functions[k + 1] = candidate_objective_functions[accepted_step * N_parameters + k];
+    }
+    if (verbose > 0 && proc0_world) std::cout << "Multidirectional search iteration " << iteration << ": accepted " << step_names[accepted_step]
+					      << ", best objective function = " << std::setprecision(16)
+					      << std::min(vertex_objective_functions[0], best_objective_functions[accepted_step]) << std::endl;
+  }
+}
+
+//! Set the vertices after the first to steps from the first vertex along each coordinate direction.
+/**
+ * The steps are initial_step_fraction times the width of the box, or times max(|x_j|, 1) if there are no bound constraints.
+ * Steps that would leave the box are taken in the opposite direction.
+ */
+void mango::Multidirectional_search::initialize_simplex() {
+  for (int k = 1; k <= N_parameters; k++) {
+    for (int j = 0; j < N_parameters; j++) vertices[k * N_parameters + j] = vertices[j];
+  }
+  for (int j = 0; j < N_parameters; j++) {
+    double step;
+    if (bound_constraints_set) {
+      step = initial_step_fraction * (upper_bounds[j] - lower_bounds[j]);
+      if (vertices[j] + step > upper_bounds[j]) step = -step;
+    } else {
+      step = initial_step_fraction * std::max(std::abs(vertices[j]), 1.0);
+    }
+    vertices[(j + 1) * N_parameters + j] += step;
+  }
+}
+
+//! Evaluate the objective function at a set of points, concurrently.
+/**
+ * @param[in] N_set The number of points.
+ * @param[in] points The points, stored contiguously.
+ * @param[out] objective_functions The values of the objective function, on all group leaders. Failed evaluations give infinity.
+ */
+void mango::Multidirectional_search::evaluate(int N_set, std::vector<double>& points, std::vector<double>& objective_functions) {
+  objective_functions.resize(N_set);
+  solver->evaluate_objective_set_in_parallel(N_set, points.data(), objective_functions.data());
+  function_evaluations += N_set;
+  if (solver->stop_requested) max_function_evaluations = function_evaluations;
+}
+
+//! The largest distance, in any coordinate, from the best vertex to another vertex of the simplex.
+double mango::Multidirectional_search::simplex_size() {
+  double size = 0;
+  for (int k = 1; k <= N_parameters; k++) {
+    for (int j = 0; j < N_parameters; j++) size = std::max(size, std::abs(vertices[k * N_parameters + j] - vertices[j]));
+  }
+  return size;
+}
+
+//! Scale the simplex about its first vertex.
+/**
+ * @param[in] N_parameters The number of parameters.
+ * @param[in] vertices The N_parameters+1 vertices of the simplex, stored contiguously.
+ * @param[in] factor The scale factor: -1 for reflection, a number < -1 for expansion, or a number in (0,1) for contraction.
+ * @param[out] new_vertices The N_parameters vertices vertices[0] + factor * (vertices[k] - vertices[0]), for k = 1, ..., N_parameters, stored contiguously.
+ */
+void mango::Multidirectional_search::transform_simplex(int N_parameters, const double* vertices, double factor, double* new_vertices) {
+  for (int k = 0; k < N_parameters; k++) {
+    for (int j = 0; j < N_parameters; j++) {
+      new_vertices[k * N_parameters + j] = vertices[j] + factor * (vertices[(k + 1) * N_parameters + j] - vertices[j]);
+    }
+  }
+}
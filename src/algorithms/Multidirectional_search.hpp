@@ -0,0 +1,46 @@
+#ifndef MANGO_MULTIDIRECTIONAL_SEARCH_H
+#define MANGO_MULTIDIRECTIONAL_SEARCH_H
+
+#include <vector>
+#include "Package_mango.hpp"
+#include "Solver.hpp"
+
+namespace mango {
+  class Multidirectional_search : public Algorithm {
+  public:
+    Solver* solver;
+
+    // Define shorthand variable names:
+    int N_parameters;
+    int verbose;
+    bool proc0_world;
+    MPI_Comm comm_group_leaders;
+    bool bound_constraints_set;
+
+    // Copies of the bound constraints, which are the same on all group leaders:
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+
+    // The N_parameters+1 vertices of the simplex, stored contiguously, with the best vertex first:
+    std::vector<double> vertices;
+    std::vector<double> vertex_objective_functions;
+    double initial_step_fraction;
+    double expansion_factor;
+    double contraction_factor;
+    double simplex_tolerance;
+    int function_evaluations;
+    int max_function_evaluations;
+    int iteration;
+
+    Multidirectional_search(Solver*);
+    void solve();
+    void search();
+    void initialize_simplex();
+    void evaluate(int N_set, std::vector<double>& points, std::vector<double>& objective_functions);
+    double simplex_size();
+
+    static void transform_simplex(int N_parameters, const double* vertices, double factor, double* new_vertices);
+  };
+}
+
+#endif
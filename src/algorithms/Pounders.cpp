@@ -0,0 +1,434 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include "Least_squares_solver.hpp"
+#include "Package_mango.hpp"
+#include "Pounders.hpp"
+
+#ifndef MANGO_EIGEN_AVAILABLE
+// Eigen is NOT available.
+
+mango::Pounders::Pounders(Least_squares_solver* solver_in) {
+  throw std::runtime_error("ERROR: The algorithm mango_pounders was selected. This algorithm requires Eigen, but MANGO was built without Eigen.");
+}
+
+void mango::Pounders::solve() {}
+
+#else
+// The rest of this file is used when Eigen IS available.
+
+//! Constructor
+mango::Pounders::Pounders(Least_squares_solver* solver_in) {
+  solver = solver_in;
+
+  // Define shorthand variable names:
+  N_parameters = solver->N_parameters;
+  N_terms = solver->N_terms;
+  verbose = solver->verbose;
+  N_line_search = solver->N_line_search;
+  max_function_evaluations = solver->max_function_evaluations;
+  proc0_world = solver->mpi_partition->get_proc0_world();
+  comm_group_leaders = solver->mpi_partition->get_comm_group_leaders();
+  bound_constraints_set = solver->bound_constraints_set && algorithms[solver->algorithm].allows_bound_constraints;
+
+  if (N_line_search < 1) throw std::runtime_error("N_line_search must be >= 1.");
+
+  // Make sure all group leaders agree on the bound constraints and initial condition.
+  Eigen::VectorXd x(N_parameters);
+  solver->broadcast_initial_condition(x.data());
+  double max_abs_x = 1.0;
+  for (int j = 0; j < N_parameters; j++) max_abs_x = std::max(max_abs_x, std::abs(x[j]));
+  // The initial trust region radius, relative to the size of the initial condition:
+  initial_radius = 0.1 * max_abs_x;
+  if (bound_constraints_set) {
+    solver->broadcast_bound_constraints(lower_bounds, upper_bounds);
+    for (int j = 0; j < N_parameters; j++) {
+      // Or relative to the box, if it is smaller:
+      initial_radius = std::min(initial_radius, 0.1 * (upper_bounds[j] - lower_bounds[j]));
+    }
+  }
+  Solver::project_onto_bounds(lower_bounds, upper_bounds, x.data());
+  initial_condition = x;
+
+  // Parameters of the algorithm:
+  max_radius = 1.0e3 * initial_radius;
+  // The algorithm stops when the trust region radius has shrunk below this value:
+  radius_tolerance = 1.0e-8 * initial_radius;
+  // Points within model_radius_factor times the trust region radius of the center are used to build the models:
+  model_radius_factor = 2.0;
+  // A point adds a new direction to the linear part of the models if its component orthogonal to the directions already
+  // chosen is at least pivot_threshold times the trust region radius:
+  pivot_threshold = 1.0e-3;
+  // Points beyond the first N_parameters + 1, which add curvature information, must be at least this far (relative to the
+  // trust region radius) from the points already chosen:
+  min_point_separation = 0.1;
+  // At most this many points are used for each model. This is the number needed to determine a full quadratic.
+  max_model_points = (N_parameters + 1) * (N_parameters + 2) / 2;
+  // The trust region shrinks if the ratio of the actual to the predicted decrease is below eta_shrink,
+  // and expands if the ratio is above eta_expand and the step reaches the edge of the trust region:
+  eta_shrink = 0.1;
+  eta_expand = 0.75;
+
+  function_evaluations = 0;
+  iteration = 0;
+}
+
+//! The main driver for the POUNDERS-style model-based least-squares algorithm
+/**
+ * This algorithm follows POUNDERS, by Wild, in "Advances and Trends in Optimization with Engineering Applications", SIAM (2017).
+ * Each residual is approximated by a quadratic model that interpolates it at a set of points near the current center,
+ * with the minimum Frobenius norm of the Hessian. These models are combined into a quadratic model of the total objective function,
+ * which is minimized in a trust region.
+ * The function evaluations are done in concurrent batches: the initial interpolation set of N_parameters + 1 points, the
+ * model-improvement points needed when too few nearby points remain, and the trust region steps for N_line_search radii
+ * \f$ \Delta, \Delta/2, \Delta/4, \ldots \f$, where \f$ \Delta \f$ is the trust region radius.
+ * All group leaders carry out the same computations, using the residuals broadcast from proc0_world.
+ */
+void mango::Pounders::solve() {
+  // Initial interpolation set: the initial condition, and a step along each coordinate direction.
+  Eigen::MatrixXd missing_directions = Eigen::MatrixXd::Identity(N_parameters, N_parameters);
+  radius = initial_radius;
+  center = 0;
+  Eigen::MatrixXd new_points(N_parameters, N_parameters + 1);
+  new_points.col(0) = initial_condition;
+  for (int k = 0; k < N_parameters; k++) {
+    Eigen::VectorXd y = initial_condition + radius * missing_directions.col(k);
+    if (bound_constraints_set && y[k] > upper_bounds[k]) y[k] = initial_condition[k] - radius;
+    Solver::project_onto_bounds(lower_bounds, upper_bounds, y.data());
+    new_points.col(k + 1) = y;
+  }
+  evaluate(new_points);
+  for (int k = 1; k < (int) points.size(); k++) {
+    if (point_objective_functions[k] < point_objective_functions[center]) center = k;
+  }
+
+  std::vector<int> model_points;
+  while (function_evaluations < max_function_evaluations && radius >= radius_tolerance) {
+    iteration++;
+    if (select_model_points(model_points, missing_directions) > 0) {
+      if (verbose > 0 && proc0_world) std::cout << "Pounders iteration " << iteration << ": evaluating " << missing_directions.cols() << " model-improvement points." << std::endl;
+      improve_geometry(missing_directions);
+      continue;
+    }
+    build_model(model_points);
+    trust_region_step();
+  }
+}
+
+//! Evaluate the residuals at a set of points concurrently, and store the points and results on all group leaders.
+/**
+ * @param[in] new_points The points, one per column.
+ */
+void mango::Pounders::evaluate(Eigen::MatrixXd& new_points) {
+  int N_set = new_points.cols();
+  Eigen::MatrixXd residuals(N_terms, N_set);
+  std::vector<double> objective_functions(N_set);
+  // The shifted residuals (residuals - targets) / sigmas are stored. Failed evaluations give an objective function of infinity.
+  solver->evaluate_shifted_residual_set_in_parallel(N_set, new_points.data(), residuals.data(), objective_functions.data());
+
+  for (int j_set = 0; j_set < N_set; j_set++) {
+    points.push_back(new_points.col(j_set));
+    point_residuals.push_back(residuals.col(j_set));
+    point_objective_functions.push_back(objective_functions[j_set]);
+  }
+  function_evaluations += N_set;
+  if (solver->stop_requested) max_function_evaluations = function_evaluations;
+}
+
+//! Choose the points used to build the models around the current center.
+/**
+ * Points within model_radius_factor times the trust region radius are considered in order of distance from the center.
+ * The first points chosen must each add a new direction, until N_parameters directions are spanned. Further points, which
+ * add curvature information, are chosen up to a total of max_model_points - 1 (not counting the center).
+ * @param[out] model_points The indices of the chosen points, not including the center.
+ * @param[out] missing_directions An orthonormal basis, one vector per column, for the directions that are not spanned.
+ * @return The number of missing directions.
+ */
+int mango::Pounders::select_model_points(std::vector<int>& model_points, Eigen::MatrixXd& missing_directions) {
+  std::vector<std::pair<double, int> > candidates;
+  for (int k = 0; k < (int) points.size(); k++) {
+    if (k == center || !std::isfinite(point_objective_functions[k])) continue;
+    double distance = (points[k] - points[center]).norm();
+    if (distance <= model_radius_factor * radius && distance > 0) candidates.push_back(std::make_pair(distance, k));
+  }
+  std::stable_sort(candidates.begin(), candidates.end());
+
+  model_points.clear();
+  Eigen::MatrixXd directions(N_parameters, 0);
+  for (int m = 0; m < (int) candidates.size() && directions.cols() < N_parameters; m++) {
+    Eigen::VectorXd d = (points[candidates[m].second] - points[center]) / radius;
+    Eigen::VectorXd orthogonal = d - directions * (directions.transpose() * d);
+    if (orthogonal.norm() < pivot_threshold) continue;
+    directions.conservativeResize(Eigen::NoChange, directions.cols() + 1);
+    directions.col(directions.cols() - 1) = orthogonal / orthogonal.norm();
+    model_points.push_back(candidates[m].second);
+  }
+
+  int N_missing = N_parameters - directions.cols();
+  if (N_missing > 0) {
+    // Complete the basis with the coordinate directions that are farthest from the span of the directions found.
+    missing_directions.resize(N_parameters, N_missing);
+    for (int m = 0; m < N_missing; m++) {
+      Eigen::VectorXd best;
+      double best_norm = -1;
+      for (int j = 0; j < N_parameters; j++) {
+	Eigen::VectorXd e = Eigen::VectorXd::Unit(N_parameters, j);
+	Eigen::VectorXd orthogonal = e - directions * (directions.transpose() * e);
+	if (orthogonal.norm() > best_norm) {
+	  best_norm = orthogonal.norm();
+	  best = orthogonal / best_norm;
+	}
+      }
+      directions.conservativeResize(Eigen::NoChange, directions.cols() + 1);
+      directions.col(directions.cols() - 1) = best;
+      missing_directions.col(m) = best;
+    }
+    return N_missing;
+  }
+
+  // Add more points for curvature information.
+  for (int m = 0; m < (int) candidates.size() && (int) model_points.size() < max_model_points - 1; m++) {
+    int k = candidates[m].second;
+    if (std::find(model_points.begin(), model_points.end(), k) != model_points.end()) continue;
+    bool separated = true;
+    for (int m2 = 0; m2 < (int) model_points.size(); m2++) {
+      separated = separated && ((points[k] - points[model_points[m2]]).norm() >= min_point_separation * radius);
+    }
+    if (separated) model_points.push_back(k);
+  }
+  return 0;
+}
+
+//! Build the quadratic model of the total objective function around the current center.
+/**
+ * Each shifted residual \f$ r_i \f$ is modeled by \f$ r_i + g_i^T s + s^T H_i s / 2 \f$, and the total objective function by
+ * \f$ f + G^T s + s^T B s / 2 \f$ with \f$ G = 2 \sum_i r_i g_i \f$ and \f$ B = 2 \sum_i (g_i g_i^T + r_i H_i) \f$.
+ * @param[in] model_points The indices of the points used to build the models, not including the center.
+ */
+void mango::Pounders::build_model(const std::vector<int>& model_points) {
+  int N_points = model_points.size();
+  // Displacements are scaled by the trust region radius, for conditioning.
+  Eigen::MatrixXd displacements(N_parameters, N_points);
+  Eigen::MatrixXd values(N_points, N_terms);
+  for (int m = 0; m < N_points; m++) {
+    displacements.col(m) = (points[model_points[m]] - points[center]) / radius;
+    values.row(m) = (point_residuals[model_points[m]] - point_residuals[center]).transpose();
+  }
+  Eigen::MatrixXd gradients, lambdas;
+  fit_models(displacements, values, gradients, lambdas);
+
+  const Eigen::VectorXd& r = point_residuals[center];
+  Eigen::VectorXd weights = lambdas * r;
+  gradient = 2 * gradients * r / radius;
+  Hessian = 2 * gradients * gradients.transpose();
+  for (int m = 0; m < N_points; m++) Hessian += 2 * weights[m] * displacements.col(m) * displacements.col(m).transpose();
+  Hessian /= radius * radius;
+}
+
+//! Evaluate points along the missing directions, so the next models are well determined.
+/**
+ * @param[in] missing_directions An orthonormal basis, one vector per column, for the directions that are not spanned by nearby points.
+ */
+void mango::Pounders::improve_geometry(const Eigen::MatrixXd& missing_directions) {
+  int N_missing = missing_directions.cols();
+  Eigen::MatrixXd new_points(N_parameters, N_missing);
+  for (int m = 0; m < N_missing; m++) {
+    Eigen::VectorXd y = points[center] + radius * missing_directions.col(m);
+    if (bound_constraints_set) {
+      // If the step leaves the box, step the other way if that goes less far outside.
+      Eigen::VectorXd y_projected = y;
+      Solver::project_onto_bounds(lower_bounds, upper_bounds, y_projected.data());
+      Eigen::VectorXd y_reverse = points[center] - radius * missing_directions.col(m);
+      Eigen::VectorXd y_reverse_projected = y_reverse;
+      Solver::project_onto_bounds(lower_bounds, upper_bounds, y_reverse_projected.data());
+      y = ((y_reverse_projected - y_reverse).norm() < (y_projected - y).norm()) ? y_reverse_projected : y_projected;
+    }
+    new_points.col(m) = y;
+  }
+  int old_center = center;
+  int N_old_points = points.size();
+  evaluate(new_points);
+  for (int k = N_old_points; k < (int) points.size(); k++) {
+    if (point_objective_functions[k] < point_objective_functions[center]) center = k;
+  }
+  if (verbose > 0 && proc0_world && center != old_center) std::cout << "Pounders: a model-improvement point is the new center." << std::endl;
+}
+
+//! Evaluate trust region steps for N_line_search radii concurrently, move to the best point if it is an improvement, and update the radius.
+void mango::Pounders::trust_region_step() {
+  Eigen::MatrixXd new_points(N_parameters, N_line_search);
+  std::vector<double> predicted_decreases(N_line_search);
+  double step_radius = radius;
+  for (int j = 0; j < N_line_search; j++) {
+    Eigen::VectorXd step;
+    bounded_trust_region_step(step_radius, step);
+    new_points.col(j) = points[center] + step;
+    predicted_decreases[j] = -(gradient.dot(step) + 0.5 * step.dot(Hessian * step));
+    // If the first step lies inside the trust region, halve its length, so every candidate is different:
+    step_radius = 0.5 * std::min(step_radius, step.norm());
+  }
+
+  if (!(*std::max_element(predicted_decreases.begin(), predicted_decreases.end()) > 0)) {
+    // The model predicts no decrease, so the center is a stationary point of the model. Refine the trust region.
+    radius *= 0.5;
+    if (verbose > 0 && proc0_world) std::cout << "Pounders iteration " << iteration << ": no predicted decrease. New radius = " << radius << std::endl;
+    return;
+  }
+
+  int N_old_points = points.size();
+  double old_objective_function = point_objective_functions[center];
+  evaluate(new_points);
+  int best = N_old_points;
+  for (int k = N_old_points + 1; k < (int) points.size(); k++) {
+    if (point_objective_functions[k] < point_objective_functions[best]) best = k;
+  }
+  double step_norm = (points[best] - points[center]).norm();
+  double ratio = (old_objective_function - point_objective_functions[best]) / predicted_decreases[best - N_old_points];
+  if (point_objective_functions[best] < old_objective_function) center = best;
+
+  if (ratio >= eta_expand && step_norm >= 0.5 * radius) {
+    radius = std::min(2 * radius, max_radius);
+  } else if (!(ratio >= eta_shrink)) {
+    radius = 0.5 * std::min(radius, std::max(step_norm, radius_tolerance));
+  }
+  if (verbose > 0 && proc0_world) std::cout << "Pounders iteration " << iteration << ": objective function = " << std::setprecision(16)
+					    << point_objective_functions[center] << ", ratio = " << ratio << ", new radius = " << radius << std::endl;
+}
+
+//! Minimize the model of the objective function in the trust region, within the bound constraints.
+/**
+ * The trust region subproblem is solved without the bound constraints. Coordinates of the step that would leave the box are then fixed
+ * at the bounds, and the subproblem is solved again for the remaining coordinates, until the step lies in the box.
+ * @param[in] step_radius The trust region radius.
+ * @param[out] step The step from the center.
+ */
+void mango::Pounders::bounded_trust_region_step(double step_radius, Eigen::VectorXd& step) {
+  solve_trust_region_subproblem(gradient, Hessian, step_radius, step);
+  if (!bound_constraints_set) return;
+
+  const Eigen::VectorXd& x = points[center];
+  std::vector<bool> fixed(N_parameters, false);
+  Eigen::VectorXd fixed_step = Eigen::VectorXd::Zero(N_parameters);
+  for (int pass = 0; pass < N_parameters; pass++) {
+    bool changed = false;
+    for (int j = 0; j < N_parameters; j++) {
+      if (fixed[j]) continue;
+      double y = std::min(upper_bounds[j], std::max(lower_bounds[j], x[j] + step[j]));
+      if (y != x[j] + step[j]) {
+	fixed[j] = true;
+	fixed_step[j] = y - x[j];
+	changed = true;
+      }
+    }
+    if (!changed) break;
+
+    std::vector<int> free_indices;
+    for (int j = 0; j < N_parameters; j++) if (!fixed[j]) free_indices.push_back(j);
+    int N_free = free_indices.size();
+    double free_radius_squared = step_radius * step_radius - fixed_step.squaredNorm();
+    step = fixed_step;
+    if (N_free == 0 || free_radius_squared <= 0) break;
+
+    Eigen::VectorXd full_gradient = gradient + Hessian * fixed_step;
+    Eigen::VectorXd free_gradient(N_free);
+    Eigen::MatrixXd free_Hessian(N_free, N_free);
+    for (int m = 0; m < N_free; m++) {
+      free_gradient[m] = full_gradient[free_indices[m]];
+      for (int m2 = 0; m2 < N_free; m2++) free_Hessian(m, m2) = Hessian(free_indices[m], free_indices[m2]);
+    }
+    Eigen::VectorXd free_step;
+    solve_trust_region_subproblem(free_gradient, free_Hessian, sqrt(free_radius_squared), free_step);
+    for (int m = 0; m < N_free; m++) step[free_indices[m]] = free_step[m];
+  }
+  Eigen::VectorXd y = x + step;
+  Solver::project_onto_bounds(lower_bounds, upper_bounds, y.data());
+  step = y - x;
+}
+
+//! Fit quadratic models with minimum Frobenius norm of the Hessian that interpolate values at a set of points.
+/**
+ * Each model \f$ m(s) = g^T s + s^T H s / 2 \f$ vanishes at s = 0 and satisfies \f$ m(s_j) = v_j \f$ at the other points \f$ s_j \f$,
+ * which must span all directions. Among such models, the one with the smallest Frobenius norm of H is found, following
+ * Powell, Mathematical Programming 100, 183 (2004). The Hessian has the form \f$ H = \sum_j \lambda_j s_j s_j^T \f$.
+ * @param[in] displacements The points \f$ s_j \f$, one per column.
+ * @param[in] values The values \f$ v_j \f$, one row per point and one column per model.
+ * @param[out] gradients The gradients g, one column per model.
+ * @param[out] lambdas The coefficients \f$ \lambda_j \f$, one row per point and one column per model.
+ */
+void mango::Pounders::fit_models(const Eigen::MatrixXd& displacements, const Eigen::MatrixXd& values, Eigen::MatrixXd& gradients, Eigen::MatrixXd& lambdas) {
+  int N_parameters = displacements.rows();
+  int N_points = displacements.cols();
+  int N_models = values.cols();
+  Eigen::MatrixXd A = displacements.transpose() * displacements;
+  A = 0.5 * A.cwiseProduct(A);
+
+  // Solve the linear system [A, S^T; S, 0] [lambda; g] = [v; 0].
+  Eigen::MatrixXd system = Eigen::MatrixXd::Zero(N_points + N_parameters, N_points + N_parameters);
+  system.topLeftCorner(N_points, N_points) = A;
+  system.topRightCorner(N_points, N_parameters) = displacements.transpose();
+  system.bottomLeftCorner(N_parameters, N_points) = displacements;
+  Eigen::MatrixXd right_hand_side = Eigen::MatrixXd::Zero(N_points + N_parameters, N_models);
+  right_hand_side.topRows(N_points) = values;
+  Eigen::MatrixXd solution = system.colPivHouseholderQr().solve(right_hand_side);
+  lambdas = solution.topRows(N_points);
+  gradients = solution.bottomRows(N_parameters);
+}
+
+//! Minimize \f$ g^T s + s^T H s / 2 \f$ subject to \f$ |s| \le \Delta \f$.
+/**
+ * The solution \f$ s = -(H + \mu I)^{-1} g \f$ is found using the eigendecomposition of H, with \f$ \mu \ge 0 \f$ determined by bisection,
+ * following More and Sorensen, SIAM J Sci Stat Comput 4, 553 (1983), including the "hard case".
+ * @param[in] gradient The vector g.
+ * @param[in] Hessian The symmetric matrix H.
+ * @param[in] radius The trust region radius \f$ \Delta \f$.
+ * @param[out] step The solution s.
+ */
+void mango::Pounders::solve_trust_region_subproblem(const Eigen::VectorXd& gradient, const Eigen::MatrixXd& Hessian, double radius, Eigen::VectorXd& step) {
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigensolver(Hessian);
+  const Eigen::VectorXd& eigenvalues = eigensolver.eigenvalues(); // In increasing order
+  const Eigen::MatrixXd& eigenvectors = eigensolver.eigenvectors();
+  Eigen::VectorXd g = eigenvectors.transpose() * gradient;
+  int N = g.size();
+
+  auto step_for_shift = [&](double mu) {
+    Eigen::VectorXd s = Eigen::VectorXd::Zero(N);
+    for (int k = 0; k < N; k++) {
+      if (g[k] != 0) s[k] = -g[k] / (eigenvalues[k] + mu);
+    }
+    return s;
+  };
+
+  // If H is positive definite and the Newton step lies in the trust region, it is the solution.
+  Eigen::VectorXd s;
+  if (eigenvalues[0] > 0) {
+    s = step_for_shift(0.0);
+    if (s.norm() <= radius) {
+      step = eigenvectors * s;
+      return;
+    }
+  }
+
+  // Otherwise the solution lies on the boundary. |s(mu)| decreases with mu, and |s(mu_high)| <= radius.
+  double mu_low = std::max(0.0, -eigenvalues[0]);
+  double mu_high = mu_low + gradient.norm() / radius;
+  for (int iteration = 0; iteration < 200 && mu_high > mu_low; iteration++) {
+    double mu = 0.5 * (mu_low + mu_high);
+    if (mu <= mu_low || mu >= mu_high) break;
+    if (step_for_shift(mu).norm() > radius) {
+      mu_low = mu;
+    } else {
+      mu_high = mu;
+    }
+  }
+  s = step_for_shift(mu_high);
+
+  // Hard case: g has no component along the eigenvector with the lowest eigenvalue, so move along that eigenvector to the boundary.
+  if (eigenvalues[0] < 0 && s.norm() < radius) s[0] += sqrt(s[0] * s[0] + radius * radius - s.squaredNorm()) - s[0];
+  step = eigenvectors * s;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef MANGO_POUNDERS_H
+#define MANGO_POUNDERS_H
+
+#include <vector>
+#include "Package_mango.hpp"
+#include "Least_squares_solver.hpp"
+
+#ifdef MANGO_EIGEN_AVAILABLE
+#include <Eigen/Dense>
+#endif
+
+namespace mango {
+  class Pounders : public LeastSquaresAlgorithm {
+  public:
+#ifdef MANGO_EIGEN_AVAILABLE
+    Least_squares_solver* solver;
+
+    // Define shorthand variable names:
+    int N_parameters;
+    int N_terms;
+    int verbose;
+    int N_line_search;
+    bool proc0_world;
+    MPI_Comm comm_group_leaders;
+    bool bound_constraints_set;
+
+    // Copies of the bound constraints and initial condition, which are the same on all group leaders:
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+    Eigen::VectorXd initial_condition;
+
+    // Parameters of the algorithm:
+    double initial_radius;
+    double max_radius;
+    double radius_tolerance;
+    double model_radius_factor;
+    double pivot_threshold;
+    double min_point_separation;
+    int max_model_points;
+    double eta_shrink;
+    double eta_expand;
+
+    // Every point evaluated so far, with its shifted residuals (residuals - targets) / sigmas and objective function:
+    std::vector<Eigen::VectorXd> points;
+    std::vector<Eigen::VectorXd> point_residuals;
+    std::vector<double> point_objective_functions;
+
+    // State of the algorithm:
+    int center;
+    double radius;
+    Eigen::VectorXd gradient;
+    Eigen::MatrixXd Hessian;
+    int function_evaluations;
+    int max_function_evaluations;
+    int iteration;
+
+    void evaluate(Eigen::MatrixXd& new_points);
+    int select_model_points(std::vector<int>& model_points, Eigen::MatrixXd& missing_directions);
+    void build_model(const std::vector<int>& model_points);
+    void improve_geometry(const Eigen::MatrixXd& missing_directions);
+    void trust_region_step();
+    void bounded_trust_region_step(double step_radius, Eigen::VectorXd& step);
+
+    static void fit_models(const Eigen::MatrixXd& displacements, const Eigen::MatrixXd& values, Eigen::MatrixXd& gradients, Eigen::MatrixXd& lambdas);
+    static void solve_trust_region_subproblem(const Eigen::VectorXd& gradient, const Eigen::MatrixXd& Hessian, double radius, Eigen::VectorXd& step);
+
+#endif
+    Pounders(Least_squares_solver*);
+    void solve();
+  };
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifdef MANGO_EIGEN_AVAILABLE // Don't bother doing any testing if Eigen is unavailable.
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "catch.hpp"
+#include "Bayesian_optimization.hpp"
+#include "algorithm_tests.hpp"
+
+TEST_CASE("mango::Bayesian_optimization::expected_improvement()","[Bayesian_optimization]") {
+  // With no uncertainty, the improvement is deterministic:
+  CHECK(mango::Bayesian_optimization::expected_improvement(1.0, 0.0, 3.0) == 2.0);
+  CHECK(mango::Bayesian_optimization::expected_improvement(3.0, 0.0, 1.0) == 0.0);
+  // When the mean equals the best value, E[max(0, -z sigma)] = sigma / sqrt(2 pi):
+  CHECK(mango::Bayesian_optimization::expected_improvement(1.0, 2.0, 1.0) == Approx(2.0 / sqrt(2 * M_PI)).epsilon(1e-14));
+  // The expected improvement exceeds the deterministic improvement, and increases with the uncertainty:
+  double ei1 = mango::Bayesian_optimization::expected_improvement(0.0, 0.5, 1.0);
+  double ei2 = mango::Bayesian_optimization::expected_improvement(0.0, 1.0, 1.0);
+  CHECK(ei1 > 1.0);
+  CHECK(ei2 > ei1);
+  // Far above the best value, the expected improvement is tiny but positive:
+  double ei3 = mango::Bayesian_optimization::expected_improvement(10.0, 1.0, 0.0);
+  CHECK(ei3 > 0.0);
+  CHECK(ei3 < 1e-20);
+}
+
+TEST_CASE("mango::Bayesian_optimization::latin_hypercube(): each parameter has exactly one point in each stratum","[Bayesian_optimization]") {
+  const int N_parameters = 3;
+  const int N_points = GENERATE(1, 2, 7, 20);
+  std::mt19937 random_number_generator(5);
+  Eigen::MatrixXd points(N_parameters, 0);
+  mango::Bayesian_optimization::latin_hypercube(N_points, random_number_generator, points);
+  REQUIRE(points.rows() == N_parameters);
+  REQUIRE(points.cols() == N_points);
+  for (int j = 0; j < N_parameters; j++) {
+    std::vector<int> strata(N_points);
+    for (int k = 0; k < N_points; k++) {
+      CHECK(points(j, k) >= 0.0);
+      CHECK(points(j, k) <= 1.0);
+      strata[k] = (int) floor(points(j, k) * N_points);
+    }
+    std::sort(strata.begin(), strata.end());
+    for (int k = 0; k < N_points; k++) CHECK(strata[k] == k);
+  }
+}
+
+namespace {
+  // Minimum at (1, -0.5), with value 2:
+  void Bayesian_optimization_quadratic(int*, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    *f = 2 + (x[0] - 1) * (x[0] - 1) + 3 * (x[1] + 0.5) * (x[1] + 0.5) + (x[0] - 1) * (x[1] + 0.5);
+    *failed = false;
+  }
+}
+
+TEST_CASE("mango::Bayesian_optimization: Verify that the local penalization spreads out the points of a batch.","[Bayesian_optimization]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {-2.0, 2.0};
+  double lower_bounds[N_parameters] = {-3.0, -2.0};
+  double upper_bounds[N_parameters] = {3.0, 3.0};
+  mango::Problem problem(N_parameters, state_vector, &Bayesian_optimization_quadratic, 0, NULL);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_random_seed(0);
+
+  algorithm_tests::run_on_group_leaders(problem, mango::MANGO_BAYESIAN_OPTIMIZATION, GENERATE(range(1,3)), [&](mango::Solver* solver) {
+      mango::Bayesian_optimization bayesian_optimization(solver);
+      if (!solver->mpi_partition->get_proc0_world()) return;
+
+      // Fit the Gaussian process to a Latin hypercube in the box, without going through the objective function:
+      const int N_points = 10;
+      mango::Bayesian_optimization::latin_hypercube(N_points, bayesian_optimization.random_number_generator, bayesian_optimization.points);
+      for (int k = 0; k < N_points; k++) {
+	double x[N_parameters];
+	for (int j = 0; j < N_parameters; j++) x[j] = lower_bounds[j] + bayesian_optimization.points(j, k) * (upper_bounds[j] - lower_bounds[j]);
+	double f;
+	int failed;
+	Bayesian_optimization_quadratic(NULL, x, &f, &failed, NULL, NULL);
+	bayesian_optimization.objective_functions.push_back(f);
+      }
+      bayesian_optimization.fit_hyperparameters();
+      double best_value = bayesian_optimization.standardized_values.minCoeff();
+
+      // With an empty batch, the acquisition function is the expected improvement:
+      Eigen::MatrixXd batch(N_parameters, 0);
+      std::vector<double> batch_means, batch_standard_deviations;
+      Eigen::Vector2d x(0.4, 0.6);
+      double mean, standard_deviation;
+      bayesian_optimization.predict(x, mean, standard_deviation);
+      CHECK(bayesian_optimization.acquisition(x, best_value, 1.0, batch, batch_means, batch_standard_deviations)
+	    == Approx(mango::Bayesian_optimization::expected_improvement(mean, standard_deviation, best_value)));
+
+      // The penalty for a batch point is below 1 near that point, and increases to 1 away from it:
+      batch.resize(N_parameters, 1);
+      batch.col(0) = x;
+      batch_means.push_back(best_value);
+      batch_standard_deviations.push_back(1.0);
+      double previous_ratio = 0;
+      for (double distance = 0; distance < 0.5; distance += 0.05) {
+	Eigen::Vector2d y(x[0] + distance, x[1]);
+	bayesian_optimization.predict(y, mean, standard_deviation);
+	double ratio = bayesian_optimization.acquisition(y, best_value, 10.0, batch, batch_means, batch_standard_deviations)
+	  / mango::Bayesian_optimization::expected_improvement(mean, standard_deviation, best_value);
+	CHECK(ratio > previous_ratio);
+	CHECK(ratio <= 1.0);
+	previous_ratio = ratio;
+      }
+      CHECK(previous_ratio == Approx(1.0));
+
+      // The first point of a batch maximizes the expected improvement alone, which is what a batch of 1 gives with the same random numbers.
+      // Without the penalties, every point of the batch would be the same.
+      std::mt19937 saved_random_number_generator = bayesian_optimization.random_number_generator;
+      Eigen::MatrixXd single;
+      bayesian_optimization.propose_batch(1, single);
+      bayesian_optimization.random_number_generator = saved_random_number_generator;
+      const int N_set = 4;
+      bayesian_optimization.propose_batch(N_set, batch);
+      REQUIRE(batch.cols() == N_set);
+      CHECK((batch.col(0) - single.col(0)).norm() == 0.0);
+      for (int k = 0; k < N_set; k++) {
+	for (int m = 0; m < k; m++) CHECK((batch.col(k) - batch.col(m)).norm() > 1.0e-3);
+      }
+    });
+}
+
+TEST_CASE("mango::Bayesian_optimization: Verify that the minimum of a quadratic is found in few evaluations, for any number of worker groups.","[Bayesian_optimization]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {-2.0, 2.0};
+  double lower_bounds[N_parameters] = {-3.0, -2.0};
+  double upper_bounds[N_parameters] = {3.0, 3.0};
+  mango::Problem problem(N_parameters, state_vector, &Bayesian_optimization_quadratic, 0, NULL);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_max_function_evaluations(40);
+  problem.set_random_seed(0);
+
+  SECTION("Minimum inside the box") {
+    double best_objective_function = algorithm_tests::run(problem, mango::MANGO_BAYESIAN_OPTIMIZATION, GENERATE(range(1,5)));
+    if (problem.mpi_partition.get_proc0_world()) {
+      CHECK(best_objective_function == Approx(2.0).epsilon(1e-3));
+      CHECK(state_vector[0] == Approx(1.0).margin(0.05));
+      CHECK(state_vector[1] == Approx(-0.5).margin(0.05));
+    }
+  }
+
+  SECTION("Minimum outside the box, so a bound constraint is active") {
+    upper_bounds[0] = 0.0;
+    problem.set_bound_constraints(lower_bounds, upper_bounds);
+    problem.set_N_threads(GENERATE(1, 3));
+    algorithm_tests::run(problem, mango::MANGO_BAYESIAN_OPTIMIZATION, GENERATE(range(1,5)));
+    if (problem.mpi_partition.get_proc0_world()) {
+      // The minimum on x[0] = 0 is at x[1] = -1/3:
+      CHECK(state_vector[0] == Approx(0.0).margin(0.05));
+      CHECK(state_vector[1] == Approx(-1.0 / 3).margin(0.05));
+    }
+  }
+}
+
+#endif // MANGO_EIGEN_AVAILABLE
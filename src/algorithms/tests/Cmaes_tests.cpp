@@ -0,0 +1,111 @@
+#ifdef MANGO_EIGEN_AVAILABLE // Don't bother doing any testing if Eigen is unavailable.
+
+#include <cmath>
+#include <vector>
+#include "catch.hpp"
+#include "Cmaes.hpp"
+#include "algorithm_tests.hpp"
+
+TEST_CASE("mango::Cmaes::round_population_size(), small_population_size(), and compute_weights()","[Cmaes]") {
+  SECTION("The population size is rounded up to a multiple of N_worker_groups") {
+    CHECK(mango::Cmaes::round_population_size(7, 1) == 7);
+    CHECK(mango::Cmaes::round_population_size(7, 2) == 8);
+    CHECK(mango::Cmaes::round_population_size(7, 7) == 7);
+    CHECK(mango::Cmaes::round_population_size(7, 10) == 10);
+    CHECK(mango::Cmaes::round_population_size(12, 4) == 12);
+  }
+
+  SECTION("Small-regime population sizes lie between the default and half the large population size, rounded up to a multiple of N_worker_groups") {
+    int N_worker_groups = GENERATE(range(1,5));
+    int default_population_size = mango::Cmaes::round_population_size(6, N_worker_groups);
+    int large_population_size = 8 * default_population_size;
+    CHECK(mango::Cmaes::small_population_size(default_population_size, large_population_size, 0.0, N_worker_groups) == default_population_size);
+    int previous_population_size = default_population_size;
+    for (int j = 1; j < 10; j++) {
+      int population_size = mango::Cmaes::small_population_size(default_population_size, large_population_size, j / 10.0, N_worker_groups);
+      CHECK(population_size % N_worker_groups == 0);
+      CHECK(population_size >= previous_population_size);
+      CHECK(population_size <= mango::Cmaes::round_population_size(large_population_size / 2, N_worker_groups));
+      previous_population_size = population_size;
+    }
+    CHECK(previous_population_size > default_population_size);
+  }
+
+  SECTION("The weights are positive, decreasing, and sum to 1") {
+    int population_size = GENERATE(4, 7, 10, 31);
+    Eigen::VectorXd weights;
+    double mu_eff;
+    mango::Cmaes::compute_weights(population_size, weights, mu_eff);
+    REQUIRE(weights.size() == population_size / 2);
+    CHECK(weights.sum() == Approx(1.0));
+    for (int k = 0; k < weights.size(); k++) CHECK(weights[k] > 0);
+    for (int k = 1; k < weights.size(); k++) CHECK(weights[k] < weights[k - 1]);
+    CHECK(mu_eff >= 1.0);
+    CHECK(mu_eff <= weights.size());
+  }
+}
+
+namespace {
+  // The Rastrigin function, which has many local minima. The global minimum is 0 at (1, 1).
+  void Cmaes_rastrigin(int* N_parameters, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    *f = 10 * (*N_parameters);
+    for (int j = 0; j < *N_parameters; j++) *f += (x[j] - 1) * (x[j] - 1) - 10 * cos(2 * M_PI * (x[j] - 1));
+    *failed = false;
+  }
+}
+
+TEST_CASE("mango::Cmaes: Verify that the minimum of a quadratic is found, for any number of worker groups.","[Cmaes]") {
+  algorithm_tests::check_quadratic(mango::MANGO_CMAES, 3000, 1e-6, 1e-12);
+}
+
+TEST_CASE("mango::Cmaes: Verify that restarts find the global minimum of a multimodal function.","[Cmaes]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {4.0, -3.0};
+  double lower_bounds[N_parameters] = {-5.0, -5.0};
+  double upper_bounds[N_parameters] = {5.0, 5.0};
+  mango::Problem problem(N_parameters, state_vector, &Cmaes_rastrigin, 0, NULL);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_max_function_evaluations(10000);
+  problem.set_random_seed(0);
+  algorithm_tests::run(problem, mango::MANGO_CMAES, GENERATE(range(1,4)));
+  if (problem.mpi_partition.get_proc0_world()) {
+    CHECK(state_vector[0] == Approx(1.0).margin(1e-6));
+    CHECK(state_vector[1] == Approx(1.0).margin(1e-6));
+  }
+}
+
+TEST_CASE("mango::Cmaes: Verify the BIPOP and IPOP restart schedules, with every population a multiple of the number of worker groups.","[Cmaes]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {4.0, -3.0};
+  double lower_bounds[N_parameters] = {-5.0, -5.0};
+  double upper_bounds[N_parameters] = {5.0, 5.0};
+  mango::Problem problem(N_parameters, state_vector, &Cmaes_rastrigin, 0, NULL);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_max_function_evaluations(3000);
+  problem.set_random_seed(0);
+  bool bipop = GENERATE(true, false);
+  algorithm_tests::run_on_group_leaders(problem, mango::MANGO_CMAES, GENERATE(range(1,5)), [&](mango::Solver* solver) {
+      int N_worker_groups = solver->mpi_partition->get_N_worker_groups();
+      mango::Cmaes cmaes(solver);
+      cmaes.bipop = bipop;
+      CHECK(cmaes.default_population_size % N_worker_groups == 0);
+      CHECK(cmaes.default_population_size >= 6);
+      cmaes.solve();
+      CHECK(cmaes.function_evaluations >= 3000);
+      CHECK(cmaes.evaluations_in_large_regime + cmaes.evaluations_in_small_regime == cmaes.function_evaluations);
+      CHECK(cmaes.N_large_restarts >= 1);
+      CHECK(cmaes.population_size % N_worker_groups == 0);
+      if (bipop) {
+	// Small-population restarts are interleaved, so they use a share of the evaluations.
+	CHECK(cmaes.N_small_restarts >= 1);
+	CHECK(cmaes.evaluations_in_small_regime > 0);
+      } else {
+	// Each IPOP restart doubles the population size.
+	CHECK(cmaes.N_small_restarts == 0);
+	CHECK(cmaes.evaluations_in_small_regime == 0);
+	CHECK(cmaes.population_size == cmaes.default_population_size << cmaes.N_large_restarts);
+      }
+    });
+}
+
+#endif // MANGO_EIGEN_AVAILABLE
@@ -0,0 +1,56 @@
+#include <cmath>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "catch.hpp"
+#include "Differential_evolution.hpp"
+#include "algorithm_tests.hpp"
+
+TEST_CASE("mango::Differential_evolution: Verify that the minimum of a quadratic is found, for any number of worker groups.","[Differential_evolution]") {
+  algorithm_tests::check_quadratic(mango::MANGO_DIFFERENTIAL_EVOLUTION, 6000, 1e-5, 1e-5);
+}
+
+TEST_CASE("mango::Differential_evolution: Verify that with a random seed, the sequence of evaluations does not depend on the number of worker groups.","[Differential_evolution]") {
+  const int N_parameters = 2;
+  double lower_bounds[N_parameters] = {-2.0, -3.0};
+  double upper_bounds[N_parameters] = {3.0, 4.0};
+  std::vector<std::string> reference;
+  for (int N_worker_groups = 1; N_worker_groups <= 4; N_worker_groups++) {
+    double state_vector[N_parameters] = {-1.0, 0.5};
+    mango::Problem problem(N_parameters, state_vector, &algorithm_tests::quadratic, 0, NULL);
+    problem.set_bound_constraints(lower_bounds, upper_bounds);
+    problem.set_max_function_evaluations(300);
+    problem.set_random_seed(17);
+    algorithm_tests::run(problem, mango::MANGO_DIFFERENTIAL_EVOLUTION, N_worker_groups);
+    if (problem.mpi_partition.get_proc0_world()) {
+      std::vector<std::string> lines = algorithm_tests::read_output();
+      CHECK(lines.size() == 301); // The best point is repeated at the end of the file.
+      if (N_worker_groups == 1) {
+	reference = lines;
+      } else {
+	CHECK(lines == reference);
+      }
+    }
+  }
+}
+
+TEST_CASE("mango::Differential_evolution: Verify that without a random seed, using each result as soon as it arrives, the minimum is found.","[Differential_evolution]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {-1.0, 0.5};
+  double lower_bounds[N_parameters] = {-2.0, -3.0};
+  double upper_bounds[N_parameters] = {3.0, 4.0};
+  mango::Problem problem(N_parameters, state_vector, &algorithm_tests::quadratic, 0, NULL);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_max_function_evaluations(4000);
+  problem.set_random_seed(-1);
+  algorithm_tests::run(problem, mango::MANGO_DIFFERENTIAL_EVOLUTION, GENERATE(range(1,5)));
+  if (problem.mpi_partition.get_proc0_world()) {
+    CHECK(state_vector[0] == Approx(1.0).margin(1e-4));
+    CHECK(state_vector[1] == Approx(2.0).margin(1e-4));
+  }
+}
+
+TEST_CASE("mango::Differential_evolution: Verify that least-squares problems can be solved.","[Differential_evolution]") {
+  algorithm_tests::check_least_squares(mango::MANGO_DIFFERENTIAL_EVOLUTION, 6000, 1e-5);
+}
@@ -0,0 +1,136 @@
+#include <cmath>
+#include <vector>
+#include <string>
+#include "catch.hpp"
+#include "Direct.hpp"
+#include "algorithm_tests.hpp"
+
+TEST_CASE("mango::Direct::select_potentially_optimal()","[Direct]") {
+  std::vector<int> selected;
+
+  SECTION("A single rectangle is potentially optimal") {
+    mango::Direct::select_potentially_optimal({0.5}, {3.0}, 1e-4, false, selected);
+    REQUIRE(selected.size() == 1);
+    CHECK(selected[0] == 0);
+  }
+
+  SECTION("Points above the lower right convex hull are not selected") {
+    // (size, value): 0: (1, 5), 1: (1, 4), 2: (0.5, 2), 3: (0.5, 2), 4: (0.25, 3), 5: (0.75, 3.9)
+    std::vector<double> sizes = {1.0, 1.0, 0.5, 0.5, 0.25, 0.75};
+    std::vector<double> values = {5.0, 4.0, 2.0, 2.0, 3.0, 3.9};
+    mango::Direct::select_potentially_optimal(sizes, values, 1e-4, false, selected);
+    // Rectangles 2 and 3 tie for the lowest value, and 1 is the largest. Rectangle 4 is smaller than the best, and 5 lies above the line from 3 to 1.
+    REQUIRE(selected.size() == 3);
+    CHECK(selected[0] == 1);
+    CHECK(selected[1] == 2);
+    CHECK(selected[2] == 3);
+
+    SECTION("The locally biased variant selects one rectangle of each size") {
+      mango::Direct::select_potentially_optimal(sizes, values, 1e-4, true, selected);
+      REQUIRE(selected.size() == 2);
+      CHECK(selected[0] == 1);
+      CHECK(selected[1] == 2);
+    }
+  }
+
+  SECTION("The epsilon condition excludes the best rectangle if it cannot improve enough") {
+    // The slope from the best point (0.1, 1) to (1, 1.00001) is tiny, so 1 - K * 0.1 > 1 - 1e-4.
+    mango::Direct::select_potentially_optimal({0.1, 1.0}, {1.0, 1.00001}, 1e-4, false, selected);
+    REQUIRE(selected.size() == 1);
+    CHECK(selected[0] == 1);
+    mango::Direct::select_potentially_optimal({0.1, 1.0}, {1.0, 1.00001}, 0.0, false, selected);
+    CHECK(selected.size() == 2);
+  }
+}
+
+namespace {
+  // The Branin function, with global minimum 0.397887... at (-pi, 12.275), (pi, 2.275), and (9.42478, 2.475):
+  void Direct_branin(int*, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    double a = x[1] - 5.1 / (4 * M_PI * M_PI) * x[0] * x[0] + 5 / M_PI * x[0] - 6;
+    *f = a * a + 10 * (1 - 1 / (8 * M_PI)) * cos(x[0]) + 10;
+    *failed = false;
+  }
+}
+
+namespace {
+  // In the unit box, the new centers along x[1] are better than those along x[0], and the best is at (0.5, 1/6):
+  void Direct_separable(int*, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    *f = std::abs(x[0] - 0.5) + (x[1] - 0.1) * (x[1] - 0.1);
+    *failed = false;
+  }
+}
+
+TEST_CASE("mango::Direct: Verify the trisection order and the rectangles divided in the first iterations.","[Direct]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {0.0, 0.0};
+  double lower_bounds[N_parameters] = {0.0, 0.0};
+  double upper_bounds[N_parameters] = {1.0, 1.0};
+  mango::Problem problem(N_parameters, state_vector, &Direct_separable, 0, NULL);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  // Exactly enough for the 2 iterations below:
+  problem.set_max_function_evaluations(7);
+  bool locally_biased = GENERATE(false, true);
+
+  algorithm_tests::run_on_group_leaders(problem, mango::MANGO_DIRECT, GENERATE(range(1,4)), [&](mango::Solver* solver) {
+      mango::Direct direct(solver);
+      direct.locally_biased = locally_biased;
+      direct.solve();
+      CHECK(direct.function_evaluations == 7);
+      CHECK(direct.iteration == 2);
+
+      // In the 1st iteration the box is trisected first along x[1], so the 2 new rectangles along x[1] are 3 times as long as the others.
+      // In the 2nd iteration only the rectangle centered at (0.5, 1/6) is potentially optimal. Its longest side is along x[0].
+      const double third = 1.0 / 3;
+      std::vector<double> centers = {0.5, 0.5,
+				     0.5, 0.5 + third,
+				     0.5, 0.5 - third,
+				     0.5 + third, 0.5,
+				     0.5 - third, 0.5,
+				     0.5 + third, 0.5 - third,
+				     0.5 - third, 0.5 - third};
+      std::vector<int> levels = {1, 1,
+				 0, 1,
+				 1, 1,
+				 1, 1,
+				 1, 1,
+				 1, 1,
+				 1, 1};
+      REQUIRE(direct.centers.size() == centers.size());
+      for (int j = 0; j < (int) centers.size(); j++) CHECK(direct.centers[j] == Approx(centers[j]).epsilon(1e-14));
+      CHECK(direct.levels == levels);
+      for (int k = 0; k < 7; k++) {
+	int failed;
+	double f;
+	Direct_separable(NULL, &centers[k * N_parameters], &f, &failed, NULL, NULL);
+	CHECK(direct.objective_functions[k] == Approx(f).epsilon(1e-14));
+      }
+    });
+}
+
+TEST_CASE("mango::Direct: Verify that the global minimum of the Branin function is found, with the same evaluations for any number of worker groups.","[Direct]") {
+  const int N_parameters = 2;
+  double lower_bounds[N_parameters] = {-5.0, 0.0};
+  double upper_bounds[N_parameters] = {10.0, 15.0};
+  mango::algorithm_type algorithm = GENERATE(mango::MANGO_DIRECT, mango::MANGO_DIRECT_L);
+  std::vector<std::string> reference;
+  for (int N_worker_groups = 1; N_worker_groups <= 4; N_worker_groups++) {
+    double state_vector[N_parameters] = {0.0, 0.0};
+    mango::Problem problem(N_parameters, state_vector, &Direct_branin, 0, NULL);
+    problem.set_bound_constraints(lower_bounds, upper_bounds);
+    problem.set_max_function_evaluations(300);
+    algorithm_tests::run(problem, algorithm, N_worker_groups);
+    if (problem.mpi_partition.get_proc0_world()) {
+      int N = N_parameters, failed;
+      double f;
+      Direct_branin(&N, state_vector, &f, &failed, NULL, NULL);
+      CHECK(f == Approx(0.397887357729738).epsilon(1e-4));
+      std::vector<std::string> lines = algorithm_tests::read_output();
+      CHECK(lines.size() <= 301);
+      if (N_worker_groups == 1) {
+	reference = lines;
+      } else {
+	CHECK(lines == reference);
+      }
+    }
+  }
+}
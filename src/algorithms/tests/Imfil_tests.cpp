@@ -0,0 +1,67 @@
+#include <cmath>
+#include <vector>
+#include "catch.hpp"
+#include "Imfil.hpp"
+#include "algorithm_tests.hpp"
+
+TEST_CASE("mango::Imfil::build_stencil() and stencil_gradient()","[Imfil]") {
+  const int N_parameters = 3;
+  std::vector<double> points;
+  std::vector<int> directions;
+  double scale = 0.125;
+  // f = sum_j (j+1) * x_j^2, for which centered differences give the exact gradient.
+  auto f = [](const double* x) {
+    double total = 0;
+    for (int j = 0; j < N_parameters; j++) total += (j + 1) * x[j] * x[j];
+    return total;
+  };
+
+  SECTION("Interior point: all 2*N_parameters points are present, and centered differences are used.") {
+    double x[N_parameters] = {0.5, 0.3, 0.7};
+    int N_stencil = mango::Imfil::build_stencil(N_parameters, x, scale, points, directions);
+    REQUIRE(N_stencil == 2 * N_parameters);
+    std::vector<double> values(N_stencil);
+    for (int k = 0; k < N_stencil; k++) values[k] = f(&points[k * N_parameters]);
+    double gradient[N_parameters];
+    mango::Imfil::stencil_gradient(N_parameters, f(x), scale, directions, values, gradient);
+    for (int j = 0; j < N_parameters; j++) CHECK(gradient[j] == Approx(2 * (j + 1) * x[j]));
+  }
+
+  SECTION("Points near the bounds: stencil points outside the box are omitted, and one-sided differences are used.") {
+    double x[N_parameters] = {0.0, 0.95, 0.5};
+    int N_stencil = mango::Imfil::build_stencil(N_parameters, x, scale, points, directions);
+    REQUIRE(N_stencil == 2 * N_parameters - 2);
+    for (int k = 0; k < N_stencil * N_parameters; k++) {
+      CHECK(points[k] >= 0);
+      CHECK(points[k] <= 1);
+    }
+    std::vector<double> values(N_stencil);
+    for (int k = 0; k < N_stencil; k++) values[k] = f(&points[k * N_parameters]);
+    double gradient[N_parameters];
+    mango::Imfil::stencil_gradient(N_parameters, f(x), scale, directions, values, gradient);
+    CHECK(gradient[0] == Approx(scale));                        // Forward difference of x^2 at 0
+    CHECK(gradient[1] == Approx(2 * (2 * x[1] - scale)));        // Backward difference of 2 x^2
+    CHECK(gradient[2] == Approx(2 * 3 * x[2]));
+  }
+
+  SECTION("Failed evaluations are not used in the gradient.") {
+    double x[N_parameters] = {0.5, 0.5, 0.5};
+    int N_stencil = mango::Imfil::build_stencil(N_parameters, x, scale, points, directions);
+    std::vector<double> values(N_stencil);
+    for (int k = 0; k < N_stencil; k++) values[k] = (directions[k] == -1 ? INFINITY : f(&points[k * N_parameters]));
+    double gradient[N_parameters];
+    mango::Imfil::stencil_gradient(N_parameters, f(x), scale, directions, values, gradient);
+    CHECK(gradient[0] == Approx((f(&points[0]) - f(x)) / scale));
+  }
+}
+
+
+// Implicit filtering resolves the minimum to roughly the smallest stencil scale, 0.5^scale_depth times the width of the box,
+// so the tolerance below is set accordingly.
+TEST_CASE("mango::Imfil: Verify that the minimum of a quadratic is found, for any number of worker groups.","[Imfil]") {
+  algorithm_tests::check_quadratic(mango::MANGO_IMFIL, 2000, 1e-2, 1e-12, true);
+}
+
+TEST_CASE("mango::Imfil: Verify that a least-squares problem can be solved.","[Imfil]") {
+  algorithm_tests::check_least_squares(mango::MANGO_IMFIL, 10000, 1e-2);
+}
@@ -0,0 +1,172 @@
+#include <cmath>
+#include <vector>
+#include <deque>
+#include "catch.hpp"
+#include "Lbfgs.hpp"
+#include "algorithm_tests.hpp"
+
+TEST_CASE("mango::Lbfgs::two_loop_recursion()","[Lbfgs]") {
+  std::deque<std::vector<double> > s_history, y_history;
+  std::vector<double> direction;
+
+  SECTION("One pair: the initial inverse Hessian is scaled by s^T y / y^T y") {
+    s_history.push_back({1.0, 0.0});
+    y_history.push_back({2.0, 0.0});
+    mango::Lbfgs::two_loop_recursion(s_history, y_history, {4.0, -6.0}, direction);
+    CHECK(direction[0] == Approx(-2.0));
+    CHECK(direction[1] == Approx(3.0));
+  }
+
+  SECTION("The secant condition H y = s holds for the most recent pair") {
+    s_history.push_back({1.0, 0.5, -0.2});
+    y_history.push_back({2.0, 0.3, 0.1});
+    s_history.push_back({-0.3, 1.0, 0.4});
+    y_history.push_back({0.1, 1.5, 0.9});
+    mango::Lbfgs::two_loop_recursion(s_history, y_history, y_history[1], direction);
+    for (int j = 0; j < 3; j++) CHECK(-direction[j] == Approx(s_history[1][j]).epsilon(1e-12));
+  }
+
+  SECTION("With N pairs of conjugate steps, a quadratic's inverse Hessian is recovered exactly") {
+    // Hessian diag(1, 4): y = A s.
+    s_history.push_back({1.0, 0.0});
+    y_history.push_back({1.0, 0.0});
+    s_history.push_back({0.0, 1.0});
+    y_history.push_back({0.0, 4.0});
+    mango::Lbfgs::two_loop_recursion(s_history, y_history, {3.0, 8.0}, direction);
+    CHECK(direction[0] == Approx(-3.0).epsilon(1e-12));
+    CHECK(direction[1] == Approx(-2.0).epsilon(1e-12));
+  }
+}
+
+namespace {
+  // Rosenbrock function, with minimum at (1, 1):
+  void Lbfgs_rosenbrock(int*, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    *f = 100 * (x[1] - x[0] * x[0]) * (x[1] - x[0] * x[0]) + (1 - x[0]) * (1 - x[0]);
+    *failed = false;
+  }
+
+  // Minimum at (0, 0):
+  void Lbfgs_sphere(int*, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    *f = x[0] * x[0] + x[1] * x[1];
+    *failed = false;
+  }
+
+  void Lbfgs_residual_function(int*, const double* x, int* N_terms, double* f, int* failed, mango::Problem*, void*) {
+    for (int j = 0; j < *N_terms; j++) f[j] = x[j] - (j + 1) + 0.1 * x[0] * x[1];
+    *failed = false;
+  }
+}
+
+TEST_CASE("mango::Lbfgs: Verify that the Rosenbrock function is minimized, with the same results for any number of worker groups.","[Lbfgs]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {-1.2, 1.0};
+  mango::Problem problem(N_parameters, state_vector, &Lbfgs_rosenbrock, 0, NULL);
+  problem.set_max_function_evaluations(2000);
+  problem.set_N_line_search(3);
+  problem.set_centered_differences(GENERATE(false, true));
+
+  SECTION("No bound constraints") {
+    algorithm_tests::run(problem, mango::MANGO_LBFGS, GENERATE(range(1,5)));
+    if (problem.mpi_partition.get_proc0_world()) {
+      CHECK(state_vector[0] == Approx(1.0).epsilon(1e-4));
+      CHECK(state_vector[1] == Approx(1.0).epsilon(1e-4));
+      CHECK(problem.get_best_function_evaluation() < 1000);
+    }
+  }
+
+  SECTION("Minimum outside the box, so a bound constraint is active") {
+    double lower_bounds[N_parameters] = {-2.0, -2.0};
+    double upper_bounds[N_parameters] = {0.5, 2.0};
+    problem.set_bound_constraints(lower_bounds, upper_bounds);
+    algorithm_tests::run(problem, mango::MANGO_LBFGS, GENERATE(range(1,5)));
+    if (problem.mpi_partition.get_proc0_world()) {
+      CHECK(state_vector[0] == Approx(0.5).epsilon(1e-12));
+      CHECK(state_vector[1] == Approx(0.25).epsilon(1e-4));
+    }
+  }
+}
+
+TEST_CASE("mango::Lbfgs::line_search(): Verify the grid of step lengths evaluated as one set, and the shift to shorter steps.","[Lbfgs]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {1.0, 0.0};
+  mango::Problem problem(N_parameters, state_vector, &Lbfgs_sphere, 0, NULL);
+  problem.set_max_function_evaluations(100);
+  int N_worker_groups = GENERATE(range(1,4));
+
+  SECTION("The longest of 3 step lengths 2, 1, 1/2 is best, so the next steepest descent step may grow") {
+    problem.set_N_line_search(3);
+    algorithm_tests::run_on_group_leaders(problem, mango::MANGO_LBFGS, N_worker_groups, [&](mango::Solver* solver) {
+	mango::Lbfgs lbfgs(solver);
+	lbfgs.objective_function = 1.0;
+	lbfgs.gradient = {2.0, 0.0};
+	// The steps reach x = 0.5, 0.75 and 0.875.
+	CHECK(lbfgs.line_search({-0.25, 0.0}));
+	CHECK(lbfgs.function_evaluations == 3);
+	CHECK(lbfgs.state_vector[0] == Approx(0.5));
+	CHECK(lbfgs.state_vector[1] == 0.0);
+	CHECK(lbfgs.objective_function == Approx(0.25));
+	CHECK(lbfgs.steepest_descent_step == Approx(1.0));
+      });
+  }
+
+  SECTION("No step length of the first grid gives a decrease, so the grid is shifted by a factor 2^N_line_search") {
+    problem.set_N_line_search(2);
+    algorithm_tests::run_on_group_leaders(problem, mango::MANGO_LBFGS, N_worker_groups, [&](mango::Solver* solver) {
+	mango::Lbfgs lbfgs(solver);
+	lbfgs.objective_function = 1.0;
+	lbfgs.gradient = {2.0, 0.0};
+	// The step lengths are sqrt(2) and 1/sqrt(2), reaching x = 1 - 4 sqrt(2) and 1 - 2 sqrt(2), then
+	// sqrt(2) / 4 and 1 / (4 sqrt(2)), reaching x = 1 - sqrt(2) and 1 - 1 / sqrt(2). The last is best.
+	CHECK(lbfgs.line_search({-4.0, 0.0}));
+	CHECK(lbfgs.function_evaluations == 4);
+	CHECK(lbfgs.state_vector[0] == Approx(1 - 1 / sqrt(2.0)));
+	CHECK(lbfgs.objective_function == Approx((1 - 1 / sqrt(2.0)) * (1 - 1 / sqrt(2.0))));
+	CHECK(lbfgs.steepest_descent_step == Approx(1 / sqrt(2.0)));
+      });
+  }
+
+  SECTION("The line search fails when the step lengths have shrunk by about 10^6 without a decrease") {
+    problem.set_N_line_search(3);
+    algorithm_tests::run_on_group_leaders(problem, mango::MANGO_LBFGS, N_worker_groups, [&](mango::Solver* solver) {
+	mango::Lbfgs lbfgs(solver);
+	lbfgs.objective_function = 1.0;
+	lbfgs.gradient = {2.0, 0.0};
+	// An ascent direction never gives a decrease.
+	CHECK(!lbfgs.line_search({1.0, 0.0}));
+	CHECK(lbfgs.max_line_search_iterations == 7);
+	CHECK(lbfgs.function_evaluations == 21);
+	CHECK(lbfgs.state_vector[0] == 1.0);
+      });
+  }
+}
+
+TEST_CASE("mango::Lbfgs: Verify that the number of evaluations stays within max_function_evaluations plus one set.","[Lbfgs]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {-1.2, 1.0};
+  mango::Problem problem(N_parameters, state_vector, &Lbfgs_rosenbrock, 0, NULL);
+  problem.set_max_function_evaluations(20);
+  problem.set_N_line_search(3);
+  algorithm_tests::run(problem, mango::MANGO_LBFGS, GENERATE(range(1,4)));
+  if (problem.mpi_partition.get_proc0_world()) {
+    int N_evaluations = algorithm_tests::read_output().size() - 1; // The best point is repeated at the end of the file.
+    CHECK(N_evaluations >= 20);
+    CHECK(N_evaluations < 23);
+  }
+}
+
+TEST_CASE("mango::Lbfgs: Verify that a least-squares problem can be solved.","[Lbfgs]") {
+  const int N_parameters = 2;
+  const int N_terms = 2;
+  double state_vector[N_parameters] = {0.0, 0.0};
+  double targets[N_terms] = {0.0, 0.0};
+  double sigmas[N_terms] = {1.0, 2.0};
+  double best_residual_function[N_terms];
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &Lbfgs_residual_function, 0, NULL);
+  algorithm_tests::run(problem, mango::MANGO_LBFGS, GENERATE(range(1,4)));
+  if (problem.mpi_partition.get_proc0_world()) {
+    double x = state_vector[0], y = state_vector[1];
+    // The residuals vanish at the minimum:
+    CHECK(x - 1 + 0.1 * x * y == Approx(0.0).margin(1e-5));
+    CHECK(y - 2 + 0.1 * x * y == Approx(0.0).margin(1e-5));
+  }
+}
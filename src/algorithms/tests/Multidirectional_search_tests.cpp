@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "catch.hpp"
+#include "Multidirectional_search.hpp"
+#include "algorithm_tests.hpp"
+
+TEST_CASE("mango::Multidirectional_search::transform_simplex()","[Multidirectional_search]") {
+  const int N_parameters = 2;
+  // Vertices (1,2), (3,2), (1,5):
+  double vertices[(N_parameters + 1) * N_parameters] = {1, 2, 3, 2, 1, 5};
+  double new_vertices[N_parameters * N_parameters];
+
+  SECTION("Reflection") {
+    mango::Multidirectional_search::transform_simplex(N_parameters, vertices, -1.0, new_vertices);
+    CHECK(new_vertices[0] == Approx(-1));
+    CHECK(new_vertices[1] == Approx(2));
+    CHECK(new_vertices[2] == Approx(1));
+    CHECK(new_vertices[3] == Approx(-1));
+  }
+
+  SECTION("Expansion") {
+    mango::Multidirectional_search::transform_simplex(N_parameters, vertices, -2.0, new_vertices);
+    CHECK(new_vertices[0] == Approx(-3));
+    CHECK(new_vertices[1] == Approx(2));
+    CHECK(new_vertices[2] == Approx(1));
+    CHECK(new_vertices[3] == Approx(-4));
+  }
+
+  SECTION("Contraction") {
+    mango::Multidirectional_search::transform_simplex(N_parameters, vertices, 0.5, new_vertices);
+    CHECK(new_vertices[0] == Approx(2));
+    CHECK(new_vertices[1] == Approx(2));
+    CHECK(new_vertices[2] == Approx(1));
+    CHECK(new_vertices[3] == Approx(3.5));
+  }
+}
+
+
+TEST_CASE("mango::Multidirectional_search: Verify that the minimum of a quadratic is found, for any number of worker groups.","[Multidirectional_search]") {
+  algorithm_tests::check_quadratic(mango::MANGO_MULTIDIRECTIONAL_SEARCH, 5000, 1e-6, 1e-12);
+}
+
+TEST_CASE("mango::Multidirectional_search: Verify that a least-squares problem can be solved.","[Multidirectional_search]") {
+  algorithm_tests::check_least_squares(mango::MANGO_MULTIDIRECTIONAL_SEARCH, 10000, 1e-6);
+}
+
+namespace {
+  // A broad well with its minimum of 0 at (6, 6), and a narrow deeper well centered at (6, 5). The global minimum is
+  // 200/201 - 50 at (6, 5 + 1/201).
+  void Multidirectional_search_two_wells(int*, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    double distance_squared = (x[0] - 6) * (x[0] - 6) + (x[1] - 5) * (x[1] - 5);
+    *f = (x[0] - 6) * (x[0] - 6) + (x[1] - 6) * (x[1] - 6) - 50 * std::max(0.0, 1 - distance_squared / 0.25);
+    *failed = false;
+  }
+}
+
+TEST_CASE("mango::Multidirectional_search: Verify that the search restarts from a new simplex when the simplex collapses.","[Multidirectional_search]") {
+  const int N_parameters = 2;
+  double state_vector[N_parameters] = {9.0, 9.0};
+  double lower_bounds[N_parameters] = {0.0, 0.0};
+  double upper_bounds[N_parameters] = {10.0, 10.0};
+  mango::Problem problem(N_parameters, state_vector, &Multidirectional_search_two_wells, 0, NULL);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_max_function_evaluations(10000);
+  algorithm_tests::run_on_group_leaders(problem, mango::MANGO_MULTIDIRECTIONAL_SEARCH, GENERATE(range(1,5)), [&](mango::Solver* solver) {
+      // The first search shrinks its simplex onto the minimum of the broad well, as its steps become too small to find the narrow well.
+      mango::Multidirectional_search single_search(solver);
+      single_search.evaluate(N_parameters + 1, single_search.vertices, single_search.vertex_objective_functions);
+      double initial_simplex_size = single_search.simplex_size();
+      CHECK(initial_simplex_size == Approx(1.0));
+      single_search.search();
+      CHECK(single_search.simplex_size() <= single_search.simplex_tolerance * initial_simplex_size);
+      CHECK(single_search.vertex_objective_functions[0] == Approx(0.0).margin(1e-10));
+
+      // solve() begins with the same search. The restart, with a simplex of the initial size around the best vertex, reaches the narrow well.
+      mango::Multidirectional_search restarted(solver);
+      restarted.solve();
+      CHECK(restarted.function_evaluations > single_search.function_evaluations);
+      CHECK(restarted.vertex_objective_functions[0] == Approx(200.0 / 201 - 50).epsilon(1e-10));
+      CHECK(restarted.vertices[0] == Approx(6.0).margin(1e-6));
+      CHECK(restarted.vertices[1] == Approx(5.0 + 1.0 / 201).margin(1e-6));
+    });
+}
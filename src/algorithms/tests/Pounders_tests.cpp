@@ -0,0 +1,247 @@
+#ifdef MANGO_EIGEN_AVAILABLE // Don't bother doing any testing if Eigen is unavailable.
+
+#include <cmath>
+#include <vector>
+#include "catch.hpp"
+#include "Pounders.hpp"
+#include "algorithm_tests.hpp"
+
+TEST_CASE("mango::Pounders::fit_models(): a quadratic is recovered exactly from (N+1)(N+2)/2 points","[Pounders]") {
+  const int N_parameters = 2;
+  const int N_points = 5; // Not counting the point s = 0.
+  Eigen::MatrixXd displacements(N_parameters, N_points);
+  displacements << 1.0, 0.0, -1.0, 0.0, 0.5,
+                   0.0, 1.0, 0.0, -1.0, 0.5;
+  Eigen::Vector2d g_exact(0.3, -1.7);
+  Eigen::Matrix2d H_exact;
+  H_exact << 2.0, 0.4,
+             0.4, -1.0;
+  Eigen::MatrixXd values(N_points, 1);
+  for (int j = 0; j < N_points; j++) {
+    Eigen::VectorXd s = displacements.col(j);
+    values(j, 0) = g_exact.dot(s) + 0.5 * s.dot(H_exact * s);
+  }
+
+  Eigen::MatrixXd gradients, lambdas;
+  mango::Pounders::fit_models(displacements, values, gradients, lambdas);
+  Eigen::MatrixXd H = Eigen::MatrixXd::Zero(N_parameters, N_parameters);
+  for (int j = 0; j < N_points; j++) H += lambdas(j, 0) * displacements.col(j) * displacements.col(j).transpose();
+  for (int j = 0; j < N_parameters; j++) {
+    CHECK(gradients(j, 0) == Approx(g_exact[j]).epsilon(1e-12));
+    for (int k = 0; k < N_parameters; k++) CHECK(H(j, k) == Approx(H_exact(j, k)).margin(1e-12));
+  }
+
+  SECTION("With only N points, the model is linear") {
+    Eigen::MatrixXd linear_values = g_exact.transpose() * displacements.leftCols(N_parameters);
+    mango::Pounders::fit_models(displacements.leftCols(N_parameters), linear_values.transpose(), gradients, lambdas);
+    for (int j = 0; j < N_parameters; j++) {
+      CHECK(gradients(j, 0) == Approx(g_exact[j]).epsilon(1e-12));
+      CHECK(lambdas(j, 0) == Approx(0.0).margin(1e-12));
+    }
+  }
+}
+
+TEST_CASE("mango::Pounders::solve_trust_region_subproblem()","[Pounders]") {
+  const int N = 3;
+  Eigen::VectorXd gradient(N);
+  gradient << 1.0, -2.0, 0.5;
+  Eigen::MatrixXd Hessian(N, N);
+  Eigen::VectorXd step;
+
+  SECTION("Positive definite Hessian, Newton step inside the trust region") {
+    Hessian << 4.0, 1.0, 0.0,
+               1.0, 3.0, 0.5,
+               0.0, 0.5, 2.0;
+    mango::Pounders::solve_trust_region_subproblem(gradient, Hessian, 10.0, step);
+    Eigen::VectorXd residual = Hessian * step + gradient;
+    CHECK(residual.norm() == Approx(0.0).margin(1e-12));
+  }
+
+  SECTION("The solution lies on the boundary, and satisfies the optimality conditions") {
+    Hessian << 1.0, 0.0, 0.0,
+               0.0, -2.0, 0.0,
+               0.0, 0.0, 0.5;
+    double radius = 0.7;
+    mango::Pounders::solve_trust_region_subproblem(gradient, Hessian, radius, step);
+    CHECK(step.norm() == Approx(radius).epsilon(1e-10));
+    // (H + mu I) s = -g for some mu >= 2, so -(g + H s) is parallel to s:
+    Eigen::VectorXd mu_s = -(gradient + Hessian * step);
+    double mu = mu_s.dot(step) / step.squaredNorm();
+    CHECK(mu >= 2.0);
+    CHECK((mu_s - mu * step).norm() == Approx(0.0).margin(1e-8));
+  }
+
+  SECTION("Hard case: the gradient is orthogonal to the eigenvector with the lowest eigenvalue") {
+    gradient << 0.0, 1.0, 0.0;
+    Hessian << -1.0, 0.0, 0.0,
+                0.0, 1.0, 0.0,
+                0.0, 0.0, 2.0;
+    double radius = 2.0;
+    mango::Pounders::solve_trust_region_subproblem(gradient, Hessian, radius, step);
+    CHECK(step.norm() == Approx(radius).epsilon(1e-10));
+    CHECK(step[1] == Approx(-0.5).epsilon(1e-8));
+    CHECK(step[2] == Approx(0.0).margin(1e-12));
+  }
+
+  SECTION("Zero gradient and positive semidefinite Hessian give no step") {
+    gradient.setZero();
+    Hessian.setIdentity();
+    mango::Pounders::solve_trust_region_subproblem(gradient, Hessian, 1.0, step);
+    CHECK(step.norm() == 0.0);
+  }
+}
+
+namespace {
+  // Residuals for the Rosenbrock function, with minimum at (1, 1):
+  void Pounders_rosenbrock(int*, const double* x, int*, double* f, int* failed, mango::Problem*, void*) {
+    f[0] = 10 * (x[1] - x[0] * x[0]);
+    f[1] = 1 - x[0];
+    *failed = false;
+  }
+
+  // Residuals of a nonlinear fit with more terms than parameters, with a zero-residual minimum at (0.5, -1.5, 2):
+  void Pounders_exponential_fit(int*, const double* x, int* N_terms, double* f, int* failed, mango::Problem*, void*) {
+    for (int j = 0; j < *N_terms; j++) {
+      double t = 0.25 * j;
+      f[j] = x[0] * exp(x[1] * t) + x[2] - (0.5 * exp(-1.5 * t) + 2.0);
+    }
+    *failed = false;
+  }
+}
+
+TEST_CASE("mango::Pounders: Verify the models built from nearby points, and the trust region step with coordinates fixed at the bounds.","[Pounders]") {
+  const int N_parameters = 2;
+  const int N_terms = 2;
+  double state_vector[N_parameters] = {-1.2, 1.0};
+  double targets[N_terms] = {0.0, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0};
+  double best_residual_function[N_terms];
+  double lower_bounds[N_parameters] = {-2.0, -2.0};
+  double upper_bounds[N_parameters] = {2.0, 2.0};
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &Pounders_rosenbrock, 0, NULL);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  int N_worker_groups = GENERATE(range(1,4));
+
+  SECTION("A missing direction is found, and with a full set of points the model of the objective function is exact for quadratic residuals") {
+    algorithm_tests::run_on_group_leaders(problem, mango::MANGO_POUNDERS, N_worker_groups, [&](mango::Solver* solver) {
+	mango::Pounders pounders(dynamic_cast<mango::Least_squares_solver*>(solver));
+	const double x = 0.3, y = -0.4, h = 0.1;
+	pounders.center = 0;
+	pounders.radius = 2 * h;
+	std::vector<int> model_points;
+	Eigen::MatrixXd missing_directions;
+
+	// With the center and one point along x, the y direction is missing.
+	Eigen::MatrixXd new_points(N_parameters, 2);
+	new_points << x, x + h,
+	              y, y;
+	pounders.evaluate(new_points);
+	CHECK(pounders.select_model_points(model_points, missing_directions) == 1);
+	REQUIRE(missing_directions.cols() == 1);
+	CHECK(missing_directions(0, 0) == Approx(0.0).margin(1e-12));
+	CHECK(std::abs(missing_directions(1, 0)) == Approx(1.0));
+
+	// With 6 points in all, a quadratic is determined.
+	new_points.resize(N_parameters, 4);
+	new_points << x,     x - h, x,     x + h,
+	              y + h, y,     y - h, y + h;
+	pounders.evaluate(new_points);
+	CHECK(pounders.select_model_points(model_points, missing_directions) == 0);
+	CHECK(model_points.size() == 5);
+	pounders.build_model(model_points);
+
+	// The residuals 10 (y - x^2) and 1 - x, and their first and second derivatives, at the center:
+	Eigen::Vector2d r(10 * (y - x * x), 1 - x);
+	Eigen::Matrix2d J;
+	J << -20 * x, 10,
+	     -1,      0;
+	Eigen::Matrix2d H0;
+	H0 << -20, 0,
+	      0,   0;
+	Eigen::Vector2d gradient = 2 * J.transpose() * r;
+	Eigen::Matrix2d Hessian = 2 * (J.transpose() * J + r[0] * H0);
+	for (int j = 0; j < N_parameters; j++) {
+	  CHECK(pounders.gradient[j] == Approx(gradient[j]).epsilon(1e-8));
+	  for (int k = 0; k < N_parameters; k++) CHECK(pounders.Hessian(j, k) == Approx(Hessian(j, k)).epsilon(1e-8));
+	}
+      });
+  }
+
+  SECTION("A coordinate of the step that would leave the box is fixed at the bound, and the other coordinates use the rest of the trust region") {
+    algorithm_tests::run_on_group_leaders(problem, mango::MANGO_POUNDERS, N_worker_groups, [&](mango::Solver* solver) {
+	mango::Pounders pounders(dynamic_cast<mango::Least_squares_solver*>(solver));
+	pounders.points.push_back(Eigen::Vector2d(1.9, 0.0));
+	pounders.center = 0;
+	pounders.gradient = Eigen::Vector2d(-2.0, -1.0);
+	pounders.Hessian = Eigen::Matrix2d::Identity();
+	Eigen::VectorXd step;
+	pounders.bounded_trust_region_step(1.0, step);
+	REQUIRE(step.size() == N_parameters);
+	CHECK(step[0] == Approx(0.1));
+	CHECK(step[1] == Approx(sqrt(0.99)));
+
+	// This predicts a larger decrease than projecting the step found without the bounds.
+	Eigen::VectorXd unbounded_step;
+	mango::Pounders::solve_trust_region_subproblem(pounders.gradient, pounders.Hessian, 1.0, unbounded_step);
+	Eigen::VectorXd projected_step = unbounded_step;
+	projected_step[0] = 0.1;
+	auto predicted_decrease = [&](const Eigen::VectorXd& s) { return -(pounders.gradient.dot(s) + 0.5 * s.dot(pounders.Hessian * s)); };
+	CHECK(predicted_decrease(step) > predicted_decrease(projected_step));
+      });
+  }
+}
+
+TEST_CASE("mango::Pounders: Verify that the Rosenbrock function is minimized, with the same results for any number of worker groups.","[Pounders]") {
+  const int N_parameters = 2;
+  const int N_terms = 2;
+  double state_vector[N_parameters] = {-1.2, 1.0};
+  double targets[N_terms] = {0.0, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0};
+  double best_residual_function[N_terms];
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &Pounders_rosenbrock, 0, NULL);
+  problem.set_max_function_evaluations(2000);
+  problem.set_N_line_search(3);
+
+  SECTION("No bound constraints") {
+    algorithm_tests::run(problem, mango::MANGO_POUNDERS, GENERATE(range(1,5)));
+    if (problem.mpi_partition.get_proc0_world()) {
+      CHECK(state_vector[0] == Approx(1.0).epsilon(1e-7));
+      CHECK(state_vector[1] == Approx(1.0).epsilon(1e-7));
+      CHECK(problem.get_best_function_evaluation() < 400);
+    }
+  }
+
+  SECTION("Minimum outside the box, so a bound constraint is active") {
+    double lower_bounds[N_parameters] = {-2.0, -2.0};
+    double upper_bounds[N_parameters] = {0.5, 2.0};
+    problem.set_bound_constraints(lower_bounds, upper_bounds);
+    algorithm_tests::run(problem, mango::MANGO_POUNDERS, GENERATE(range(1,5)));
+    if (problem.mpi_partition.get_proc0_world()) {
+      CHECK(state_vector[0] == Approx(0.5).epsilon(1e-7));
+      CHECK(state_vector[1] == Approx(0.25).epsilon(1e-6));
+    }
+  }
+}
+
+TEST_CASE("mango::Pounders: Verify that a zero-residual nonlinear fit is solved.","[Pounders]") {
+  const int N_parameters = 3;
+  const int N_terms = 12;
+  double state_vector[N_parameters] = {1.0, -1.0, 1.0};
+  double targets[N_terms];
+  double sigmas[N_terms];
+  double best_residual_function[N_terms];
+  for (int j = 0; j < N_terms; j++) {
+    targets[j] = 0.0;
+    sigmas[j] = 1.0;
+  }
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &Pounders_exponential_fit, 0, NULL);
+  problem.set_max_function_evaluations(2000);
+  algorithm_tests::run(problem, mango::MANGO_POUNDERS, GENERATE(range(1,5)));
+  if (problem.mpi_partition.get_proc0_world()) {
+    CHECK(state_vector[0] == Approx(0.5).epsilon(1e-6));
+    CHECK(state_vector[1] == Approx(-1.5).epsilon(1e-6));
+    CHECK(state_vector[2] == Approx(2.0).epsilon(1e-6));
+  }
+}
+
+#endif // MANGO_EIGEN_AVAILABLE
@@ -0,0 +1,147 @@
+#ifndef MANGO_ALGORITHM_TESTS_H
+#define MANGO_ALGORITHM_TESTS_H
+
+// Test fixtures shared by the tests of MANGO's own algorithms.
+// catch.hpp must be included before this file.
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include "mango.hpp"
+#include "Solver.hpp"
+#include "Least_squares_solver.hpp"
+
+namespace algorithm_tests {
+  // Minimum at (1, 2, ..., N_parameters):
+  inline void quadratic(int* N_parameters, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    *f = 0;
+    for (int j = 0; j < *N_parameters; j++) *f += (j + 1) * (x[j] - (j + 1)) * (x[j] - (j + 1));
+    *failed = false;
+  }
+
+  // Residuals that vanish at (1, 2, ..., N_terms):
+  inline void residuals(int*, const double* x, int* N_terms, double* f, int* failed, mango::Problem*, void*) {
+    for (int j = 0; j < *N_terms; j++) f[j] = x[j] - (j + 1);
+    *failed = false;
+  }
+
+  // Run an algorithm with a given number of worker groups, and return the best objective function on proc0_world.
+  inline double run(mango::Problem& problem, mango::algorithm_type algorithm, int N_worker_groups) {
+    double best_objective_function = 0;
+    problem.set_algorithm(algorithm);
+    problem.set_output_filename("mango_out.temp");
+    problem.mpi_partition.set_N_worker_groups(N_worker_groups);
+    problem.mpi_init(MPI_COMM_WORLD);
+    if (problem.mpi_partition.get_proc0_worker_groups()) {
+      best_objective_function = problem.optimize();
+      problem.mpi_partition.stop_workers();
+    } else {
+      while (problem.mpi_partition.continue_worker_loop()) {}
+    }
+    return best_objective_function;
+  }
+
+  // Set up the solver of a problem as Problem::optimize() does, then call test(solver) on every group leader, so a test can
+  // construct one of MANGO's algorithms itself, change its parameters, and call its methods. The workers wait meanwhile.
+  inline void run_on_group_leaders(mango::Problem& problem, mango::algorithm_type algorithm, int N_worker_groups, std::function<void(mango::Solver*)> test) {
+    problem.set_algorithm(algorithm);
+    problem.set_output_filename("mango_out.temp");
+    problem.mpi_partition.set_N_worker_groups(N_worker_groups);
+    problem.mpi_init(MPI_COMM_WORLD);
+    if (problem.mpi_partition.get_proc0_worker_groups()) {
+      mango::Solver* solver = problem.get_solver();
+      if (solver->N_line_search <= 0) solver->N_line_search = problem.mpi_partition.get_N_worker_groups();
+      solver->mpi_partition = &problem.mpi_partition;
+      solver->init_optimization();
+      mango::Least_squares_solver* least_squares_solver = dynamic_cast<mango::Least_squares_solver*>(solver);
+      if (least_squares_solver != NULL) least_squares_solver->current_residuals = least_squares_solver->best_residual_function;
+      test(solver);
+      if (problem.mpi_partition.get_proc0_world()) solver->recorder->finalize();
+      problem.mpi_partition.stop_workers();
+    } else {
+      while (problem.mpi_partition.continue_worker_loop()) {}
+    }
+  }
+
+  // Read the points and objective functions from the output file, skipping the header and the first two columns (the evaluation number and time).
+  // The best point is repeated in the last line.
+  inline std::vector<std::string> read_output() {
+    std::ifstream file("mango_out.temp");
+    std::vector<std::string> lines;
+    std::string line;
+    bool started = false;
+    while (std::getline(file, line)) {
+      if (started) lines.push_back(line.substr(line.find(',', line.find(',') + 1)));
+      if (line.find("function_evaluation") != std::string::npos) started = true;
+    }
+    return lines;
+  }
+
+  // Minimize the quadratic above with 3 parameters, starting from (-1, 0.5, 4), for 1-4 worker groups.
+  // The minimum is found with and without bound constraints, and with some bound constraints active.
+  // If exact_budget is true, the algorithm must also stop within max_function_evaluations.
+  inline void check_quadratic(mango::algorithm_type algorithm, int max_function_evaluations, double tolerance, double bound_tolerance, bool exact_budget = false) {
+    const int N_parameters = 3;
+    double state_vector[N_parameters] = {-1.0, 0.5, 4.0};
+    double lower_bounds[N_parameters] = {-2.0, -3.0, -1.0};
+    double upper_bounds[N_parameters] = {3.0, 4.0, 5.0};
+    mango::Problem problem(N_parameters, state_vector, &quadratic, 0, NULL);
+    problem.set_max_function_evaluations(max_function_evaluations);
+    problem.set_random_seed(0); // So the results of stochastic algorithms do not differ from run to run.
+
+    if (!mango::algorithms[algorithm].requires_bound_constraints) {
+      SECTION("No bound constraints") {
+	run(problem, algorithm, GENERATE(range(1,5)));
+	if (problem.mpi_partition.get_proc0_world()) {
+	  for (int j = 0; j < N_parameters; j++) CHECK(state_vector[j] == Approx(j + 1).margin(tolerance));
+	}
+      }
+    }
+
+    SECTION("Minimum inside the box") {
+      problem.set_bound_constraints(lower_bounds, upper_bounds);
+      run(problem, algorithm, GENERATE(range(1,5)));
+      if (problem.mpi_partition.get_proc0_world()) {
+	for (int j = 0; j < N_parameters; j++) CHECK(state_vector[j] == Approx(j + 1).margin(tolerance));
+	if (exact_budget) CHECK(problem.get_function_evaluations() <= max_function_evaluations);
+      }
+    }
+
+    SECTION("Minimum outside the box, so the bound constraints are active") {
+      upper_bounds[1] = 1.5;
+      lower_bounds[2] = 3.5;
+      problem.set_bound_constraints(lower_bounds, upper_bounds);
+      run(problem, algorithm, GENERATE(range(1,5)));
+      if (problem.mpi_partition.get_proc0_world()) {
+	CHECK(state_vector[0] == Approx(1.0).margin(tolerance));
+	CHECK(state_vector[1] == Approx(1.5).margin(bound_tolerance));
+	CHECK(state_vector[2] == Approx(3.5).margin(bound_tolerance));
+      }
+    }
+  }
+
+  // Solve the least-squares problem for the residuals above with 2 parameters and terms, for 1-3 worker groups.
+  inline void check_least_squares(mango::algorithm_type algorithm, int max_function_evaluations, double tolerance) {
+    const int N_parameters = 2;
+    const int N_terms = 2;
+    double state_vector[N_parameters] = {0.0, 0.0};
+    double lower_bounds[N_parameters] = {-5.0, -5.0};
+    double upper_bounds[N_parameters] = {5.0, 5.0};
+    double targets[N_terms] = {0.0, 0.0};
+    double sigmas[N_terms] = {1.0, 2.0};
+    double best_residual_function[N_terms];
+    mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &residuals, 0, NULL);
+    problem.set_max_function_evaluations(max_function_evaluations);
+    problem.set_random_seed(0); // So the results of stochastic algorithms do not differ from run to run.
+    if (mango::algorithms[algorithm].requires_bound_constraints) problem.set_bound_constraints(lower_bounds, upper_bounds);
+    run(problem, algorithm, GENERATE(range(1,4)));
+    if (problem.mpi_partition.get_proc0_world()) {
+      CHECK(state_vector[0] == Approx(1.0).margin(tolerance));
+      CHECK(state_vector[1] == Approx(2.0).margin(tolerance));
+      CHECK(best_residual_function[0] == Approx(state_vector[0] - 1.0));
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,115 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+#include <mpi.h>
+#include "mango.hpp"
+#include "Solver.hpp"
+
+void mango::Ensemble::add_problem(Problem* problem) {
+  problems.push_back(problem);
+}
+
+int mango::Ensemble::get_N_problems() {
+  return problems.size();
+}
+
+void mango::Ensemble::mpi_init(MPI_Comm mpi_comm) {
+  mpi_partition.init(mpi_comm);
+}
+
+void mango::Ensemble::optimize() {
+  // All processes should call this subroutine!
+
+  MPI_Comm comm_world = mpi_partition.get_comm_world();
+  MPI_Comm comm_worker_groups = mpi_partition.get_comm_worker_groups();
+  bool proc0_world = mpi_partition.get_proc0_world();
+  bool proc0_worker_groups = mpi_partition.get_proc0_worker_groups();
+  int rank_world = mpi_partition.get_rank_world();
+  int N_problems = problems.size();
+
+  // The index of the next problem to solve is kept in a counter on proc0_world. Group leaders take problems from it with
+  // MPI_Fetch_and_op, so a worker group that finishes early moves on to the next problem without waiting for the others.
+  int* counter;
+  MPI_Win window;
+  MPI_Win_allocate((proc0_world ? sizeof(int) : 0), sizeof(int), MPI_INFO_NULL, comm_world, &counter, &window);
+  if (proc0_world) {
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, window);
+    *counter = 0;
+    MPI_Win_unlock(0, window);
+  }
+  MPI_Barrier(comm_world);
+
+  // Each problem is solved by a single worker group, so its partition has one group, and the group leader is alone in comm_group_leaders.
+  MPI_Comm comm_group_leaders = (proc0_worker_groups ? MPI_COMM_SELF : MPI_COMM_NULL);
+  std::vector<int> owners(N_problems, -1); // Rank in comm_world of the group leader that solved each problem
+  optima.assign(N_problems, 0.0);
+  const int one = 1;
+  int j_problem;
+  while (true) {
+    if (proc0_worker_groups) {
+      MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, window);
+      MPI_Fetch_and_op(&one, &j_problem, MPI_INT, 0, 0, MPI_SUM, window);
+      MPI_Win_unlock(0, window);
+      if (j_problem >= N_problems) j_problem = -1;
+    }
+    MPI_Bcast(&j_problem, 1, MPI_INT, 0, comm_worker_groups);
+    if (j_problem < 0) break;
+
+    Problem* problem = problems[j_problem];
+    problem->mpi_partition.set_custom(comm_worker_groups, comm_group_leaders, comm_worker_groups);
+    if (proc0_worker_groups) {
+      if (mpi_partition.verbose > 0) std::cout << "Worker group " << mpi_partition.get_worker_group() << " is solving problem " << j_problem << std::endl;
+      optima[j_problem] = problem->optimize();
+      owners[j_problem] = rank_world;
+      problem->mpi_partition.stop_workers();
+    } else {
+      Solver* solver = problem->get_solver();
+      while (problem->mpi_partition.continue_worker_loop()) {
+	if (solver->worker_function != NULL) solver->worker_function(problem, solver->user_data);
+      }
+    }
+  }
+  MPI_Win_free(&window);
+
+  // Send the result of each problem from the group leader that solved it to all processes.
+  MPI_Allreduce(MPI_IN_PLACE, owners.data(), N_problems, MPI_INT, MPI_MAX, comm_world);
+  worker_groups.assign(N_problems, -1);
+  std::vector<int> worker_group_of_rank(mpi_partition.get_N_procs_world());
+  int worker_group = mpi_partition.get_worker_group();
+  MPI_Allgather(&worker_group, 1, MPI_INT, worker_group_of_rank.data(), 1, MPI_INT, comm_world);
+  for (j_problem = 0; j_problem < N_problems; j_problem++) {
+    Problem* problem = problems[j_problem];
+    MPI_Bcast(&optima[j_problem], 1, MPI_DOUBLE, owners[j_problem], comm_world);
+    MPI_Bcast(problem->get_state_vector(), problem->get_N_parameters(), MPI_DOUBLE, owners[j_problem], comm_world);
+    worker_groups[j_problem] = worker_group_of_rank[owners[j_problem]];
+  }
+}
+
+double mango::Ensemble::get_optimum(int j_problem) {
+  if (j_problem < 0 || j_problem >= (int) optima.size()) throw std::runtime_error("Error in mango::Ensemble::get_optimum. j_problem is out of range, or optimize() has not been called.");
+  return optima[j_problem];
+}
+
+int mango::Ensemble::get_worker_group(int j_problem) {
+  if (j_problem < 0 || j_problem >= (int) worker_groups.size()) throw std::runtime_error("Error in mango::Ensemble::get_worker_group. j_problem is out of range, or optimize() has not been called.");
+  return worker_groups[j_problem];
+}
@@ -0,0 +1,368 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include "mango.hpp"
+
+// Wall-clock time in seconds, used for timeouts.
+static double wall_time() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1.0e-9 * t.tv_nsec;
+}
+
+mango::External_executable::External_executable() {
+  command = "";
+  server_mode = false;
+  scratch_root = ".";
+  input_filename = "mango_state_vector";
+  output_filename = "mango_results";
+  timeout = -1;
+  keep_scratch_directory = false;
+}
+
+mango::External_executable::~External_executable() {
+  for (int j = 0; j < slots.size(); j++) {
+    Slot* slot = slots[j];
+    stop_server(slot);
+    if (!keep_scratch_directory) {
+      // Remove the files we created. If the command left other files behind, rmdir fails and the directory is kept.
+      std::remove((slot->scratch_directory + "/" + input_filename).c_str());
+      std::remove((slot->scratch_directory + "/" + output_filename).c_str());
+      std::remove((slot->scratch_directory + "/mango_stdout").c_str());
+      rmdir(slot->scratch_directory.c_str());
+    }
+    delete slot;
+  }
+}
+
+void mango::External_executable::read_input_file(std::string filename) {
+  std::ifstream file;
+  file.open(filename.c_str());
+  if (!file.is_open()) {
+    std::cerr << "Error! Unable to open file " << filename << std::endl;
+    throw std::runtime_error("Error in mango::External_executable::read_input_file. Unable to open file.");
+  }
+
+  std::string line, keyword, value;
+  while (std::getline(file, line)) {
+    size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos || line[first] == '#' || line[first] == '!') continue;
+    size_t equals = line.find('=');
+    if (equals == std::string::npos) {
+      std::cerr << "Error! Unable to parse this line of " << filename << ": " << line << std::endl;
+      throw std::runtime_error("Error in mango::External_executable::read_input_file. Expected keyword = value.");
+    }
+    keyword = line.substr(first, equals - first);
+    keyword = keyword.substr(0, keyword.find_last_not_of(" \t") + 1);
+    value = line.substr(equals + 1);
+    size_t value_first = value.find_first_not_of(" \t");
+    value = (value_first == std::string::npos) ? "" : value.substr(value_first, value.find_last_not_of(" \t\r") + 1 - value_first);
+
+    if (keyword == "command") {
+      set_command(value);
+    } else if (keyword == "mode") {
+      if (value == "file") {
+	set_server_mode(false);
+      } else if (value == "server") {
+	set_server_mode(true);
+      } else {
+	throw std::runtime_error("Error in mango::External_executable::read_input_file. mode must be file or server.");
+      }
+    } else if (keyword == "scratch_root") {
+      set_scratch_root(value);
+    } else if (keyword == "input_filename") {
+      input_filename = value;
+    } else if (keyword == "output_filename") {
+      output_filename = value;
+    } else if (keyword == "timeout") {
+      set_timeout(std::stod(value));
+    } else if (keyword == "keep_scratch_directory") {
+      set_keep_scratch_directory(value == "true" || value == "T" || value == "1");
+    } else {
+      std::cerr << "Error! Unrecognized keyword in " << filename << ": " << keyword << std::endl;
+      throw std::runtime_error("Error in mango::External_executable::read_input_file. Unrecognized keyword.");
+    }
+  }
+  file.close();
+}
+
+void mango::External_executable::set_command(std::string command_in) {
+  command = command_in;
+}
+
+void mango::External_executable::set_server_mode(bool server_mode_in) {
+  if (server_mode_in != server_mode) {
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    for (int j = 0; j < slots.size(); j++) stop_server(slots[j]);
+  }
+  server_mode = server_mode_in;
+}
+
+void mango::External_executable::set_scratch_root(std::string scratch_root_in) {
+  if (!slots.empty()) throw std::runtime_error("Error in mango::External_executable::set_scratch_root. The scratch directory has already been created.");
+  scratch_root = scratch_root_in;
+}
+
+void mango::External_executable::set_filenames(std::string input_filename_in, std::string output_filename_in) {
+  input_filename = input_filename_in;
+  output_filename = output_filename_in;
+}
+
+void mango::External_executable::set_timeout(double timeout_in) {
+  timeout = timeout_in;
+}
+
+void mango::External_executable::set_keep_scratch_directory(bool keep) {
+  keep_scratch_directory = keep;
+}
+
+std::string mango::External_executable::get_scratch_directory() {
+  std::lock_guard<std::mutex> lock(slots_mutex);
+  if (slots.empty()) return "";
+  return slots[0]->scratch_directory;
+}
+
+mango::External_executable::Slot* mango::External_executable::acquire_slot() {
+  // Take a slot that no other evaluation is using, creating a new one if they are all in use.
+  std::lock_guard<std::mutex> lock(slots_mutex);
+  if (!free_slots.empty()) {
+    Slot* slot = free_slots.back();
+    free_slots.pop_back();
+    return slot;
+  }
+
+  // Each slot gets its own directory, named using the rank in MPI_COMM_WORLD and the process ID
+  // so that simultaneous runs sharing a scratch root do not collide, and the slot number so that
+  // concurrent evaluations from several threads do not collide.
+  int rank = 0, mpi_initialized;
+  MPI_Initialized(&mpi_initialized);
+  if (mpi_initialized) MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  std::ostringstream name;
+  name << scratch_root << "/mango_scratch_" << rank << "_" << getpid();
+  if (!slots.empty()) name << "_" << slots.size();
+  if (mkdir(name.str().c_str(), 0755) != 0 && errno != EEXIST) {
+    std::cerr << "Error! Unable to create scratch directory " << name.str() << std::endl;
+    throw std::runtime_error("Error in mango::External_executable::acquire_slot.");
+  }
+  Slot* slot = new Slot;
+  slot->scratch_directory = name.str();
+  slot->server_pid = -1;
+  slot->server_fd = -1;
+  slots.push_back(slot);
+  return slot;
+}
+
+void mango::External_executable::release_slot(Slot* slot) {
+  std::lock_guard<std::mutex> lock(slots_mutex);
+  free_slots.push_back(slot);
+}
+
+bool mango::External_executable::evaluate(int N_parameters, const double* state_vector, int N_terms, double* results) {
+  if (command == "") throw std::runtime_error("Error in mango::External_executable::evaluate. No command has been set.");
+  Slot* slot = acquire_slot();
+  bool succeeded;
+  if (server_mode) {
+    succeeded = evaluate_with_server(slot, N_parameters, state_vector, N_terms, results);
+  } else {
+    succeeded = evaluate_with_files(slot, N_parameters, state_vector, N_terms, results);
+  }
+  release_slot(slot);
+  return succeeded;
+}
+
+bool mango::External_executable::evaluate_with_files(Slot* slot, int N_parameters, const double* state_vector, int N_terms, double* results) {
+  std::string input_path = slot->scratch_directory + "/" + input_filename;
+  std::string output_path = slot->scratch_directory + "/" + output_filename;
+  std::string stdout_path = slot->scratch_directory + "/mango_stdout";
+
+  std::ofstream input_file(input_path.c_str());
+  input_file << std::setprecision(17) << std::scientific;
+  for (int j = 0; j < N_parameters; j++) input_file << state_vector[j] << std::endl;
+  input_file.close();
+  // Make sure results from a previous evaluation cannot be mistaken for results of this one.
+  std::remove(output_path.c_str());
+
+  pid_t pid = fork();
+  if (pid < 0) throw std::runtime_error("Error in mango::External_executable::evaluate_with_files. fork failed.");
+  if (pid == 0) {
+    // Child process. Only async-signal-safe calls are allowed here.
+    setpgid(0, 0);
+    if (chdir(slot->scratch_directory.c_str()) != 0) _exit(127);
+    int fd = open(stdout_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+    }
+    execl("/bin/sh", "sh", "-c", command.c_str(), (char*) NULL);
+    _exit(127);
+  }
+
+  // The parent also puts the child in its own process group, so the group exists before any kill(-pid) below,
+  // whichever process runs first. This fails harmlessly if the child has already called setpgid or exec.
+  setpgid(pid, pid);
+
+  // Parent process: wait for the child, killing it if the timeout is exceeded.
+  double start_time = wall_time();
+  int status;
+  while (true) {
+    pid_t result = waitpid(pid, &status, WNOHANG);
+    if (result == pid) break;
+    if (result < 0) return false;
+    if (timeout > 0 && wall_time() - start_time > timeout) {
+      kill(-pid, SIGKILL);
+      waitpid(pid, &status, 0);
+      std::cerr << "Warning: external command exceeded the timeout of " << timeout << " seconds in " << slot->scratch_directory << std::endl;
+      return false;
+    }
+    usleep(1000);
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return false;
+
+  std::ifstream output_file(output_path.c_str());
+  if (!output_file.is_open()) return false;
+  for (int j = 0; j < N_terms; j++) {
+    if (!(output_file >> results[j])) return false;
+  }
+  return true;
+}
+
+void mango::External_executable::start_server(Slot* slot) {
+  // A socket pair is used rather than two pipes so that writing to a server that has died
+  // returns an error (with MSG_NOSIGNAL) instead of raising SIGPIPE. The sockets are close-on-exec so that
+  // servers started at the same time by other threads do not inherit them; dup2 below clears the flag for the server's copies.
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) throw std::runtime_error("Error in mango::External_executable::start_server. socketpair failed.");
+
+  pid_t pid = fork();
+  if (pid < 0) throw std::runtime_error("Error in mango::External_executable::start_server. fork failed.");
+  if (pid == 0) {
+    // Child process. Only async-signal-safe calls are allowed here.
+    setpgid(0, 0);
+    close(fds[0]);
+    if (chdir(slot->scratch_directory.c_str()) != 0) _exit(127);
+    dup2(fds[1], STDIN_FILENO);
+    dup2(fds[1], STDOUT_FILENO);
+    close(fds[1]);
+    execl("/bin/sh", "sh", "-c", command.c_str(), (char*) NULL);
+    _exit(127);
+  }
+  setpgid(pid, pid); // See evaluate_with_files().
+  close(fds[1]);
+  slot->server_pid = pid;
+  slot->server_fd = fds[0];
+  slot->server_buffer = "";
+}
+
+void mango::External_executable::stop_server(Slot* slot) {
+  if (slot->server_pid <= 0) return;
+  close(slot->server_fd);
+  kill(-slot->server_pid, SIGKILL);
+  waitpid(slot->server_pid, NULL, 0);
+  slot->server_pid = -1;
+  slot->server_fd = -1;
+  slot->server_buffer = "";
+}
+
+bool mango::External_executable::evaluate_with_server(Slot* slot, int N_parameters, const double* state_vector, int N_terms, double* results) {
+  if (slot->server_pid <= 0) start_server(slot);
+
+  std::ostringstream request;
+  request << std::setprecision(17) << std::scientific;
+  for (int j = 0; j < N_parameters; j++) request << (j > 0 ? " " : "") << state_vector[j];
+  request << "\n";
+  std::string message = request.str();
+  size_t N_sent = 0;
+  while (N_sent < message.size()) {
+    ssize_t N = send(slot->server_fd, message.data() + N_sent, message.size() - N_sent, MSG_NOSIGNAL);
+    if (N <= 0) {
+      stop_server(slot);
+      return false;
+    }
+    N_sent += N;
+  }
+
+  // Read until a complete line is available.
+  double start_time = wall_time();
+  size_t newline;
+  char buffer[4096];
+  while ((newline = slot->server_buffer.find('\n')) == std::string::npos) {
+    int wait_ms = -1;
+    if (timeout > 0) {
+      double remaining = timeout - (wall_time() - start_time);
+      if (remaining <= 0) {
+	std::cerr << "Warning: external server exceeded the timeout of " << timeout << " seconds in " << slot->scratch_directory << std::endl;
+	stop_server(slot);
+	return false;
+      }
+      wait_ms = (int)(remaining * 1000) + 1;
+    }
+    struct pollfd pfd;
+    pfd.fd = slot->server_fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, wait_ms) < 0) {
+      if (errno == EINTR) continue;
+      stop_server(slot);
+      return false;
+    }
+    if (pfd.revents == 0) continue; // Timed out; checked at the top of the loop.
+    ssize_t N = read(slot->server_fd, buffer, sizeof(buffer));
+    if (N <= 0) {
+      // The server exited or the connection broke.
+      stop_server(slot);
+      return false;
+    }
+    slot->server_buffer.append(buffer, N);
+  }
+  std::string line = slot->server_buffer.substr(0, newline);
+  slot->server_buffer.erase(0, newline + 1);
+
+  std::istringstream reply(line);
+  for (int j = 0; j < N_terms; j++) {
+    if (!(reply >> results[j])) return false;
+  }
+  return true;
+}
+
+void mango::External_executable::objective_function(int* N_parameters, const double* state_vector, double* f, int* failed, mango::Problem*, void* user_data) {
+  External_executable* executable = (External_executable*) user_data;
+  *failed = !executable->evaluate(*N_parameters, state_vector, 1, f);
+}
+
+void mango::External_executable::residual_function(int* N_parameters, const double* state_vector, int* N_terms, double* residuals, int* failed, mango::Problem*, void* user_data) {
+  External_executable* executable = (External_executable*) user_data;
+  *failed = !executable->evaluate(*N_parameters, state_vector, *N_terms, residuals);
+}
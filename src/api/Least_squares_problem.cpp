@@ -62,6 +62,19 @@ void mango::Least_squares_problem::set_print_residuals_in_output_file(bool new_b
   least_squares_solver->print_residuals_in_output_file = new_bool;
 }
 
+void mango::Least_squares_problem::set_residual_storage(residual_storage_type policy) {
+  least_squares_solver->residual_storage = policy;
+}
+
+void mango::Least_squares_problem::set_residual_storage_interval(int interval) {
+  if (interval < 1) throw std::runtime_error("Error! residual_storage_interval must be >= 1.");
+  least_squares_solver->residual_storage_interval = interval;
+}
+
+void mango::Least_squares_problem::set_batch_residual_function(batch_vector_function_type batch_residual_function) {
+  least_squares_solver->batch_residual_function = batch_residual_function;
+}
+
 int mango::Least_squares_problem::get_N_terms() {
   return least_squares_solver->N_terms;
 }
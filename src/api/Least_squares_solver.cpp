@@ -32,9 +32,12 @@ mango::Least_squares_solver::Least_squares_solver(Least_squares_problem* problem
   targets = NULL;
   sigmas = NULL;
   residual_function = NULL;
+  batch_residual_function = NULL;
   best_residual_function = NULL;
   residuals = new double[N_terms_in];
   print_residuals_in_output_file = true;
+  residual_storage = RESIDUALS_ALL;
+  residual_storage_interval = 1;
   objective_function = &least_squares_to_single_objective;
 
   recorder = new Recorder_least_squares(this);
@@ -44,6 +47,7 @@ mango::Least_squares_solver::Least_squares_solver(Least_squares_problem* problem
 mango::Least_squares_solver::Least_squares_solver()
   : Solver() // Call constructor of base class
 {
+  batch_residual_function = NULL;
 }
 
 // Destructor
@@ -51,6 +55,26 @@ mango::Least_squares_solver::~Least_squares_solver() {
   delete[] residuals;
 }
 
+void mango::Least_squares_solver::evaluate_without_recording(const double* x, bool* failed) {
+  // This method overrides mango::Solver::evaluate_without_recording().
+  double* temp_residuals = new double[N_terms];
+  int failed_int;
+  residual_function(&N_parameters, x, &N_terms, temp_residuals, &failed_int, problem, user_data);
+  *failed = (failed_int != 0);
+  delete[] temp_residuals;
+}
+
+bool mango::Least_squares_solver::is_user_function(vector_function_type vector_function) {
+  // This method overrides mango::Solver::is_user_function().
+  return (vector_function == residual_function) || mango::Solver::is_user_function(vector_function);
+}
+
+mango::batch_vector_function_type mango::Least_squares_solver::get_batch_function(vector_function_type vector_function) {
+  // This method overrides mango::Solver::get_batch_function().
+  if (vector_function == residual_function && batch_residual_function != NULL) return batch_residual_function;
+  return mango::Solver::get_batch_function(vector_function);
+}
+
 void mango::Least_squares_solver::finite_difference_Jacobian(const double* state_vector_arg, double* base_case_residual, double* Jacobian) {
   // Call Solver::finite_difference_Jacobian
   mango::Solver::finite_difference_Jacobian(residual_function, N_terms, state_vector_arg, base_case_residual, Jacobian);
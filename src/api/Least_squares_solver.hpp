@@ -39,9 +39,12 @@ namespace mango {
     double* targets;
     double* sigmas;
     vector_function_type residual_function;
+    batch_vector_function_type batch_residual_function;
     double* best_residual_function;
     double* residuals;
     bool print_residuals_in_output_file;
+    residual_storage_type residual_storage;
+    int residual_storage_interval;
     double* current_residuals;
     Least_squares_problem* least_squares_problem;
 
@@ -54,6 +57,13 @@ namespace mango {
     void objective_function_wrapper(const double*, double*, bool*); 
     bool record_function_evaluation(const double*, double, bool);
     void record_function_evaluation_pointer(const double*, double*, bool);
+    void notify_observers(const double*, double, bool, clock_t);
+    batch_vector_function_type get_batch_function(vector_function_type);
+    bool is_user_function(vector_function_type);
+    void evaluate_without_recording(const double*, bool*);
+    void evaluate_objective_set_in_parallel(int, double*, double*);
+    void evaluate_shifted_residual_set_in_parallel(int, double*, double*, double*);
+    void evaluate_objective_asynchronously(int, std::function<bool(int, double*)>, std::function<void(int, const double*, double)>);
 
     // Methods that do not exist in the base class Solver:
     double residuals_to_single_objective(double*);
@@ -0,0 +1,144 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <cstdio>
+#include <cmath>
+#include <mpi.h>
+#include "mango.hpp"
+#include "Solver.hpp"
+#include "Metrics_exporter.hpp"
+
+mango::Metrics_exporter::Metrics_exporter(Solver* solver_in) {
+  solver = solver_in;
+  running = false;
+}
+
+bool mango::Metrics_exporter::enabled() {
+  // Metrics are only written by proc0_world, and only if a filename has been set.
+  return (!solver->metrics_filename.empty()) && solver->mpi_partition->get_proc0_world();
+}
+
+void mango::Metrics_exporter::init() {
+  if (!enabled()) return;
+
+  start_wall_time = MPI_Wtime();
+  last_write_time = start_wall_time;
+  last_improvement_time = start_wall_time;
+  failed_function_evaluations = 0;
+  // Until a set of concurrent function evaluations is performed, only one worker group is busy at a time.
+  worker_group_utilization = 1.0 / solver->mpi_partition->get_N_worker_groups();
+  levenberg_marquardt_active = false;
+  levenberg_marquardt_iteration = 0;
+  levenberg_marquardt_lambda = 0.0;
+  running = true;
+
+  write_file();
+}
+
+void mango::Metrics_exporter::record_function_evaluation(bool new_optimum, bool failed) {
+  if (!running) return;
+
+  if (failed) failed_function_evaluations++;
+  if (new_optimum) last_improvement_time = MPI_Wtime();
+  write_if_due();
+}
+
+void mango::Metrics_exporter::set_worker_group_utilization(int N_set) {
+  // N_set function evaluations were distributed round-robin among the worker groups,
+  // so in the last round some worker groups may have been idle.
+  if (!running) return;
+
+  int N_worker_groups = solver->mpi_partition->get_N_worker_groups();
+  int N_rounds = (N_set + N_worker_groups - 1) / N_worker_groups;
+  if (N_rounds > 0) worker_group_utilization = ((double) N_set) / (N_rounds * N_worker_groups);
+}
+
+void mango::Metrics_exporter::set_levenberg_marquardt_state(int iteration, double lambda) {
+  if (!running) return;
+
+  levenberg_marquardt_active = true;
+  levenberg_marquardt_iteration = iteration;
+  levenberg_marquardt_lambda = lambda;
+  write_if_due();
+}
+
+void mango::Metrics_exporter::finalize() {
+  if (!running) return;
+
+  running = false;
+  write_file();
+}
+
+void mango::Metrics_exporter::write_if_due() {
+  if (MPI_Wtime() - last_write_time >= solver->metrics_interval) write_file();
+}
+
+#define write_metric(name, type, help, value) \
+  file << "# HELP " << name << " " << help << std::endl << "# TYPE " << name << " " << type << std::endl \
+  << name << labels << " " << value << std::endl;
+
+void mango::Metrics_exporter::write_file() {
+  // To avoid the metrics collector ever reading a partially written file, the file is written
+  // under a temporary name in the same directory and then renamed, which is atomic on POSIX systems.
+  double now = MPI_Wtime();
+  last_write_time = now;
+  std::string temp_filename = solver->metrics_filename + ".tmp";
+
+  std::ofstream file(temp_filename.c_str());
+  if (!file.is_open()) {
+    std::cerr << "metrics file: " << temp_filename << std::endl;
+    throw std::runtime_error("Error in mango::Metrics_exporter::write_file. Unable to open metrics file.");
+  }
+
+  std::string labels = "{output_filename=\"";
+  for (int j=0; j<solver->output_filename.size(); j++) {
+    char c = solver->output_filename[j];
+    if (c == '\\' || c == '"') labels += '\\';
+    labels += c;
+  }
+  labels += "\"}";
+
+  double elapsed_minutes = (now - start_wall_time) / 60;
+  double evaluations_per_minute = (elapsed_minutes > 0) ? solver->function_evaluations / elapsed_minutes : 0.0;
+
+  file << std::setprecision(16);
+  write_metric("mango_running", "gauge", "1 while the optimization is in progress, 0 once it has finished.", (running ? 1 : 0));
+  write_metric("mango_function_evaluations_total", "counter", "Number of function evaluations recorded.", solver->function_evaluations);
+  write_metric("mango_failed_function_evaluations_total", "counter", "Number of function evaluations that reported failure.", failed_function_evaluations);
+  write_metric("mango_function_evaluations_per_minute", "gauge", "Average rate of function evaluations since the optimization began.", evaluations_per_minute);
+  if (solver->at_least_one_success) {
+    write_metric("mango_best_objective_function", "gauge", "Best value of the objective function found so far.", solver->best_objective_function);
+  }
+  write_metric("mango_seconds_since_last_improvement", "gauge", "Wall-clock seconds since the best objective function last improved.", now - last_improvement_time);
+  write_metric("mango_worker_groups", "gauge", "Number of worker groups.", solver->mpi_partition->get_N_worker_groups());
+  write_metric("mango_worker_group_utilization", "gauge", "Fraction of worker groups that were busy in the most recent set of concurrent function evaluations.", worker_group_utilization);
+  if (levenberg_marquardt_active) {
+    write_metric("mango_levenberg_marquardt_iteration", "gauge", "Outer iteration of the Levenberg-Marquardt algorithm.", levenberg_marquardt_iteration);
+    write_metric("mango_levenberg_marquardt_lambda", "gauge", "Current central value of the Levenberg-Marquardt parameter lambda.", levenberg_marquardt_lambda);
+  }
+  file.close();
+
+  if (std::rename(temp_filename.c_str(), solver->metrics_filename.c_str()) != 0) {
+    std::cerr << "metrics file: " << solver->metrics_filename << std::endl;
+    throw std::runtime_error("Error in mango::Metrics_exporter::write_file. Unable to rename metrics file.");
+  }
+}
@@ -0,0 +1,57 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#ifndef MANGO_METRICS_EXPORTER_H
+#define MANGO_METRICS_EXPORTER_H
+
+#include <string>
+
+namespace mango {
+
+  class Solver;
+
+  // Writes a file in the Prometheus text exposition format, e.g. for the textfile collector of node-exporter,
+  // so long-running optimizations can be monitored. Nothing is done unless a filename has been set.
+  class Metrics_exporter {
+  private:
+    Solver* solver;
+    double start_wall_time;
+    double last_write_time;
+    double last_improvement_time;
+    int failed_function_evaluations;
+    double worker_group_utilization;
+    bool levenberg_marquardt_active;
+    int levenberg_marquardt_iteration;
+    double levenberg_marquardt_lambda;
+    bool running;
+    void write_file();
+    void write_if_due();
+
+  public:
+    Metrics_exporter(Solver*);
+    bool enabled();
+    void init();
+    void record_function_evaluation(bool new_optimum, bool failed);
+    void set_worker_group_utilization(int N_set);
+    void set_levenberg_marquardt_state(int iteration, double lambda);
+    void finalize();
+  };
+
+}
+
+#endif
@@ -0,0 +1,520 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <mpi.h>
+#include "mango.hpp"
+#include "Solver.hpp"
+#include "Least_squares_solver.hpp"
+#include "Recorder.hpp"
+
+namespace {
+  // Direction numbers for dimensions 2 to 21 of the Sobol sequence, from S. Joe and F. Y. Kuo, SIAM J Sci Comput 30, 2635 (2008):
+  // the degree s of the primitive polynomial, its coefficients a, and the initial direction numbers m.
+  struct sobol_direction {
+    int s;
+    int a;
+    int m[7];
+  };
+  const sobol_direction sobol_directions[] = {
+    {1,  0, {1}},
+    {2,  1, {1, 3}},
+    {3,  1, {1, 3, 1}},
+    {3,  2, {1, 1, 1}},
+    {4,  1, {1, 1, 3, 3}},
+    {4,  4, {1, 3, 5, 13}},
+    {5,  2, {1, 1, 5, 5, 17}},
+    {5,  4, {1, 1, 5, 5, 5}},
+    {5,  7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6,  1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7,  1, {1, 3, 7, 11, 23, 15, 103}},
+    {7,  4, {1, 3, 7, 13, 13, 15, 69}}
+  };
+  const int max_sobol_dimensions = 1 + sizeof(sobol_directions) / sizeof(sobol_direction);
+
+  // The progress of the starts, kept in a window on proc0_world. For each start, the window holds the lowest objective function
+  // found so far followed by the corresponding state vector.
+  struct Multistart_board {
+    MPI_Win window;
+    int N_starts;
+    int N_parameters;
+    const double* lower_bounds;
+    const double* upper_bounds;
+    double basin_radius;
+    int j_start; // The start being solved by this sub-partition
+    bool cut_off;
+  };
+
+  // The largest distance between two points in any direction, as a fraction of the width of the box.
+  double multistart_distance(const Multistart_board* board, const double* x1, const double* x2) {
+    double distance = 0;
+    for (int j = 0; j < board->N_parameters; j++) {
+      distance = std::max(distance, std::abs(x1[j] - x2[j]) / (board->upper_bounds[j] - board->lower_bounds[j]));
+    }
+    return distance;
+  }
+
+  void multistart_publish(Multistart_board* board, const double* x, double f) {
+    std::vector<double> entry(board->N_parameters + 1);
+    entry[0] = f;
+    memcpy(&entry[1], x, board->N_parameters * sizeof(double));
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, board->window);
+    MPI_Put(entry.data(), entry.size(), MPI_DOUBLE, 0, board->j_start * entry.size(), entry.size(), MPI_DOUBLE, board->window);
+    MPI_Win_unlock(0, board->window);
+  }
+
+  // Returns true if another start has found a lower objective function than f within the basin radius of x.
+  bool multistart_explored(Multistart_board* board, const double* x, double f) {
+    if (!(board->basin_radius > 0)) return false;
+    if (!std::isfinite(f)) f = std::numeric_limits<double>::infinity();
+    int entry_size = board->N_parameters + 1;
+    std::vector<double> entries(board->N_starts * entry_size);
+    MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, board->window);
+    MPI_Get(entries.data(), entries.size(), MPI_DOUBLE, 0, 0, entries.size(), MPI_DOUBLE, board->window);
+    MPI_Win_unlock(0, board->window);
+    for (int j = 0; j < board->N_starts; j++) {
+      if (j == board->j_start) continue;
+      const double* entry = &entries[j * entry_size];
+      // Ties go to the start with the lower index, so two starts never cut each other off.
+      if (!(entry[0] < f || (entry[0] == f && j < board->j_start))) continue;
+      if (multistart_distance(board, &entry[1], x) < board->basin_radius) return true;
+    }
+    return false;
+  }
+
+  // This observer is called on the proc0_world of each sub-partition after each function evaluation of a start.
+  void multistart_observer(int*, int*, const double* state_vector, double* objective_value,
+			   int*, const double*, int* new_optimum, double*, mango::Problem* problem, void* observer_data) {
+    Multistart_board* board = (Multistart_board*) observer_data;
+    mango::Solver* solver = problem->get_solver();
+    if (!solver->at_least_one_success) return;
+    if (*new_optimum) multistart_publish(board, state_vector, *objective_value);
+    if (!board->cut_off && multistart_explored(board, solver->best_state_vector, solver->best_objective_function)) {
+      board->cut_off = true;
+      // The MANGO algorithms stop after the current set of evaluations, when stop_requested reaches all the group leaders.
+      // Other algorithms that compare function_evaluations to max_function_evaluations as they go will stop at their next check.
+      solver->stop_requested = true;
+      solver->max_function_evaluations = solver->function_evaluations;
+    }
+  }
+}
+
+mango::Multistart::Multistart(Problem* problem_in) {
+  problem = problem_in;
+  N_starts = 4;
+  N_candidates = 64;
+  design = DESIGN_LATIN_HYPERCUBE;
+  basin_radius = 0.05;
+}
+
+void mango::Multistart::set_N_starts(int N_starts_in) {
+  if (N_starts_in < 1) throw std::runtime_error("Error in mango::Multistart::set_N_starts. N_starts must be at least 1.");
+  N_starts = N_starts_in;
+}
+
+void mango::Multistart::set_N_candidates(int N_candidates_in) {
+  if (N_candidates_in < 1) throw std::runtime_error("Error in mango::Multistart::set_N_candidates. N_candidates must be at least 1.");
+  N_candidates = N_candidates_in;
+}
+
+void mango::Multistart::set_design(design_type design_in) {
+  if (design_in != DESIGN_LATIN_HYPERCUBE && design_in != DESIGN_SOBOL) throw std::runtime_error("Error in mango::Multistart::set_design. Invalid design.");
+  design = design_in;
+}
+
+void mango::Multistart::set_basin_radius(double basin_radius_in) {
+  if (!(basin_radius_in >= 0)) throw std::runtime_error("Error in mango::Multistart::set_basin_radius. basin_radius must be >= 0.");
+  basin_radius = basin_radius_in;
+}
+
+void mango::Multistart::mpi_init(MPI_Comm mpi_comm) {
+  mpi_partition.init(mpi_comm);
+}
+
+double mango::Multistart::optimize() {
+  // All processes should call this subroutine!
+
+  MPI_Comm comm_world = mpi_partition.get_comm_world();
+  MPI_Comm comm_worker_groups = mpi_partition.get_comm_worker_groups();
+  MPI_Comm comm_group_leaders = mpi_partition.get_comm_group_leaders();
+  bool proc0_world = mpi_partition.get_proc0_world();
+  bool proc0_worker_groups = mpi_partition.get_proc0_worker_groups();
+  int rank_world = mpi_partition.get_rank_world();
+  int N_worker_groups = mpi_partition.get_N_worker_groups();
+
+  Solver* solver = problem->get_solver();
+  Least_squares_solver* least_squares_solver = dynamic_cast<Least_squares_solver*>(solver);
+  int N_parameters = solver->N_parameters;
+  int N_terms = (least_squares_solver == NULL) ? 0 : least_squares_solver->N_terms;
+  if (!solver->bound_constraints_set) throw std::runtime_error("Error! mango::Multistart requires bound constraints.");
+  if (N_candidates < N_starts) throw std::runtime_error("Error! In mango::Multistart, N_candidates must be at least N_starts.");
+
+  // These settings of the problem are changed for each phase, and restored at the end.
+  std::string output_filename = solver->output_filename;
+  int max_function_evaluations = solver->max_function_evaluations;
+  int N_line_search = solver->N_line_search;
+  // The bound constraints are always used for the design, but only passed on to algorithms that allow them.
+  solver->bound_constraints_set = algorithms[solver->algorithm].allows_bound_constraints;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Evaluate the candidates as one set, using all the worker groups.
+
+  std::vector<double> candidates;
+  std::vector<double> candidate_objective_functions(N_candidates);
+  generate_design(design, N_candidates, N_parameters, solver->broadcast_random_seed(comm_world), candidates);
+  for (int k = 0; k < N_candidates; k++) {
+    for (int j = 0; j < N_parameters; j++) {
+      double* x = &candidates[k * N_parameters + j];
+      *x = solver->lower_bounds[j] + (*x) * (solver->upper_bounds[j] - solver->lower_bounds[j]);
+    }
+  }
+
+  std::vector<double> screening_best_state_vector(N_parameters);
+  std::vector<double> screening_best_residuals(N_terms);
+  double screening_best_objective_function = std::numeric_limits<double>::infinity();
+  int screening_best_function_evaluation = -1;
+  problem->mpi_partition.set_custom(comm_world, comm_group_leaders, comm_worker_groups);
+  solver->output_filename = output_filename + ".candidates";
+  if (proc0_worker_groups) {
+    solver->mpi_partition = &problem->mpi_partition;
+    solver->init_optimization();
+    if (least_squares_solver != NULL) {
+      memset(least_squares_solver->best_residual_function, 0, N_terms * sizeof(double));
+      least_squares_solver->current_residuals = least_squares_solver->best_residual_function;
+    }
+    solver->evaluate_objective_set_in_parallel(N_candidates, candidates.data(), candidate_objective_functions.data());
+    if (proc0_world) {
+      if (solver->at_least_one_success) {
+	memcpy(solver->state_vector, solver->best_state_vector, N_parameters * sizeof(double));
+	memcpy(screening_best_state_vector.data(), solver->best_state_vector, N_parameters * sizeof(double));
+	if (least_squares_solver != NULL) memcpy(screening_best_residuals.data(), least_squares_solver->best_residual_function, N_terms * sizeof(double));
+	screening_best_objective_function = solver->best_objective_function;
+	screening_best_function_evaluation = solver->best_function_evaluation;
+      }
+      solver->recorder->finalize();
+      solver->metrics->finalize();
+    }
+    problem->mpi_partition.stop_workers();
+  } else {
+    while (problem->mpi_partition.continue_worker_loop()) {
+      if (solver->worker_function != NULL) solver->worker_function(problem, solver->user_data);
+    }
+  }
+  MPI_Bcast(&screening_best_objective_function, 1, MPI_DOUBLE, 0, comm_world);
+  MPI_Bcast(&screening_best_function_evaluation, 1, MPI_INT, 0, comm_world);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Choose the starts: the best candidates, in order, skipping any within basin_radius of a better start.
+
+  int N_chosen = 0;
+  std::vector<double> starts(N_starts * N_parameters);
+  std::vector<double> start_objective_functions(N_starts);
+  if (proc0_world) {
+    std::vector<int> order;
+    for (int k = 0; k < N_candidates; k++) {
+      if (std::isfinite(candidate_objective_functions[k])) order.push_back(k);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int k1, int k2) { return candidate_objective_functions[k1] < candidate_objective_functions[k2]; });
+    Multistart_board board = {MPI_WIN_NULL, 0, N_parameters, solver->lower_bounds, solver->upper_bounds, basin_radius, -1, false};
+    for (int m = 0; m < (int) order.size() && N_chosen < N_starts; m++) {
+      const double* x = &candidates[order[m] * N_parameters];
+      bool distinct = true;
+      for (int j_start = 0; j_start < N_chosen; j_start++) {
+	if (multistart_distance(&board, &starts[j_start * N_parameters], x) <= basin_radius) distinct = false;
+      }
+      if (!distinct) continue;
+      memcpy(&starts[N_chosen * N_parameters], x, N_parameters * sizeof(double));
+      start_objective_functions[N_chosen] = candidate_objective_functions[order[m]];
+      N_chosen++;
+    }
+  }
+  MPI_Bcast(&N_chosen, 1, MPI_INT, 0, comm_world);
+  MPI_Bcast(starts.data(), N_chosen * N_parameters, MPI_DOUBLE, 0, comm_world);
+  MPI_Bcast(start_objective_functions.data(), N_chosen, MPI_DOUBLE, 0, comm_world);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Divide the worker groups into sub-partitions, which take the starts one at a time.
+
+  // Algorithms that cannot use concurrent function evaluations get one worker group per sub-partition.
+  int N_sub_partitions = algorithms[solver->algorithm].parallel ? std::max(1, std::min(N_chosen, N_worker_groups)) : N_worker_groups;
+  int color = (mpi_partition.get_worker_group() * N_sub_partitions) / N_worker_groups;
+  // Group leaders come first in the sub-partition's world communicator, so its proc0_world is a group leader.
+  MPI_Comm comm_world_sub, comm_group_leaders_sub = MPI_COMM_NULL;
+  MPI_Comm_split(comm_world, color, (proc0_worker_groups ? 0 : mpi_partition.get_N_procs_world()) + rank_world, &comm_world_sub);
+  if (proc0_worker_groups) MPI_Comm_split(comm_group_leaders, color, rank_world, &comm_group_leaders_sub);
+  problem->mpi_partition.set_custom(comm_world_sub, comm_group_leaders_sub, comm_worker_groups);
+  bool proc0_sub = problem->mpi_partition.get_proc0_world();
+
+  // As in mango::Ensemble, the index of the next start is kept in a counter on proc0_world, and taken with MPI_Fetch_and_op.
+  int* counter;
+  double* board_entries;
+  MPI_Win counter_window;
+  Multistart_board board = {MPI_WIN_NULL, N_chosen, N_parameters, solver->lower_bounds, solver->upper_bounds, basin_radius, -1, false};
+  int entry_size = N_parameters + 1;
+  MPI_Win_allocate((proc0_world ? sizeof(int) : 0), sizeof(int), MPI_INFO_NULL, comm_world, &counter, &counter_window);
+  MPI_Win_allocate((proc0_world ? N_chosen * entry_size * sizeof(double) : 0), sizeof(double), MPI_INFO_NULL, comm_world, &board_entries, &board.window);
+  if (proc0_world) {
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, counter_window);
+    *counter = 0;
+    MPI_Win_unlock(0, counter_window);
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, board.window);
+    for (int j_start = 0; j_start < N_chosen; j_start++) {
+      board_entries[j_start * entry_size] = start_objective_functions[j_start];
+      memcpy(&board_entries[j_start * entry_size + 1], &starts[j_start * N_parameters], N_parameters * sizeof(double));
+    }
+    MPI_Win_unlock(0, board.window);
+  }
+  MPI_Barrier(comm_world);
+  solver->observers.push_back(&multistart_observer);
+  solver->observer_data.push_back(&board);
+
+  // These arrays are filled in only on the proc0_world of the sub-partition that ran each start, and combined afterwards.
+  std::vector<int> owners(N_chosen, -1);
+  std::vector<int> launched(N_chosen, 0);
+  std::vector<int> cut_off_int(N_chosen, 0);
+  std::vector<int> start_function_evaluations(N_chosen, 0);
+  std::vector<int> start_best_function_evaluations(N_chosen, -1);
+  std::vector<double> start_best_state_vectors(N_chosen * N_parameters);
+  std::vector<double> start_best_residuals(N_chosen * N_terms);
+  optima = start_objective_functions;
+  optima.resize(N_chosen);
+  const int one = 1;
+  int data[2];
+  while (true) {
+    if (proc0_sub) {
+      MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, counter_window);
+      MPI_Fetch_and_op(&one, &data[0], MPI_INT, 0, 0, MPI_SUM, counter_window);
+      MPI_Win_unlock(0, counter_window);
+      if (data[0] >= N_chosen) data[0] = -1;
+      board.j_start = data[0];
+      // Do not launch a start whose candidate is already in the basin of a better point found by another start.
+      data[1] = (data[0] >= 0 && !multistart_explored(&board, &starts[data[0] * N_parameters], start_objective_functions[data[0]]));
+    }
+    MPI_Bcast(data, 2, MPI_INT, 0, comm_world_sub);
+    int j_start = data[0];
+    if (j_start < 0) break;
+    if (proc0_sub) {
+      owners[j_start] = rank_world;
+      launched[j_start] = data[1];
+      cut_off_int[j_start] = !data[1];
+      memcpy(&start_best_state_vectors[j_start * N_parameters], &starts[j_start * N_parameters], N_parameters * sizeof(double));
+    }
+    if (!data[1]) continue;
+
+    board.j_start = j_start;
+    board.cut_off = false;
+    memcpy(solver->state_vector, &starts[j_start * N_parameters], N_parameters * sizeof(double));
+    solver->output_filename = output_filename + ".start_" + std::to_string(j_start);
+    solver->max_function_evaluations = max_function_evaluations;
+    if (proc0_worker_groups) {
+      if (mpi_partition.verbose > 0 && proc0_sub) std::cout << "Worker groups starting at " << mpi_partition.get_worker_group() << " are running start " << j_start << std::endl;
+      double optimum = problem->optimize();
+      if (proc0_sub) {
+	optima[j_start] = optimum;
+	cut_off_int[j_start] = board.cut_off;
+	start_function_evaluations[j_start] = solver->function_evaluations;
+	start_best_function_evaluations[j_start] = solver->best_function_evaluation;
+	memcpy(&start_best_state_vectors[j_start * N_parameters], solver->state_vector, N_parameters * sizeof(double));
+	if (least_squares_solver != NULL) memcpy(&start_best_residuals[j_start * N_terms], least_squares_solver->best_residual_function, N_terms * sizeof(double));
+      }
+      problem->mpi_partition.stop_workers();
+    } else {
+      while (problem->mpi_partition.continue_worker_loop()) {
+	if (solver->worker_function != NULL) solver->worker_function(problem, solver->user_data);
+      }
+    }
+  }
+  solver->observers.pop_back();
+  solver->observer_data.pop_back();
+  MPI_Win_free(&counter_window);
+  MPI_Win_free(&board.window);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Send the result of each start to all processes, and find the best point overall.
+
+  MPI_Allreduce(MPI_IN_PLACE, owners.data(), N_chosen, MPI_INT, MPI_MAX, comm_world);
+  MPI_Allreduce(MPI_IN_PLACE, launched.data(), N_chosen, MPI_INT, MPI_MAX, comm_world);
+  MPI_Allreduce(MPI_IN_PLACE, cut_off_int.data(), N_chosen, MPI_INT, MPI_MAX, comm_world);
+  MPI_Allreduce(MPI_IN_PLACE, start_function_evaluations.data(), N_chosen, MPI_INT, MPI_MAX, comm_world);
+  MPI_Allreduce(MPI_IN_PLACE, start_best_function_evaluations.data(), N_chosen, MPI_INT, MPI_MAX, comm_world);
+  cut_off.resize(N_chosen);
+  function_evaluations = start_function_evaluations;
+  for (int j_start = 0; j_start < N_chosen; j_start++) {
+    MPI_Bcast(&optima[j_start], 1, MPI_DOUBLE, owners[j_start], comm_world);
+    cut_off[j_start] = (cut_off_int[j_start] != 0);
+  }
+
+  // winner = -1 means the best point is one of the candidates.
+  int winner = -1;
+  double best_objective_function = screening_best_objective_function;
+  int best_function_evaluation = screening_best_function_evaluation;
+  int first_evaluation = N_candidates + 1;
+  std::vector<int> first_evaluations(N_chosen, 0);
+  for (int j_start = 0; j_start < N_chosen; j_start++) {
+    if (!launched[j_start]) continue;
+    first_evaluations[j_start] = first_evaluation;
+    if (start_best_function_evaluations[j_start] > 0 && optima[j_start] < best_objective_function) {
+      winner = j_start;
+      best_objective_function = optima[j_start];
+      best_function_evaluation = first_evaluation - 1 + start_best_function_evaluations[j_start];
+    }
+    first_evaluation += start_function_evaluations[j_start];
+  }
+  int owner = (winner >= 0) ? owners[winner] : 0;
+  if (rank_world == owner) {
+    if (winner >= 0) {
+      memcpy(solver->state_vector, &start_best_state_vectors[winner * N_parameters], N_parameters * sizeof(double));
+      if (least_squares_solver != NULL) memcpy(least_squares_solver->best_residual_function, &start_best_residuals[winner * N_terms], N_terms * sizeof(double));
+    } else {
+      memcpy(solver->state_vector, screening_best_state_vector.data(), N_parameters * sizeof(double));
+      if (least_squares_solver != NULL) memcpy(least_squares_solver->best_residual_function, screening_best_residuals.data(), N_terms * sizeof(double));
+    }
+  }
+  MPI_Bcast(solver->state_vector, N_parameters, MPI_DOUBLE, owner, comm_world);
+  if (least_squares_solver != NULL) MPI_Bcast(least_squares_solver->best_residual_function, N_terms, MPI_DOUBLE, owner, comm_world);
+  memcpy(solver->best_state_vector, solver->state_vector, N_parameters * sizeof(double));
+  solver->best_objective_function = best_objective_function;
+  solver->best_function_evaluation = best_function_evaluation;
+  solver->function_evaluations = first_evaluation - 1;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Combine the output files of the phases into one, on proc0_world.
+
+  if (proc0_world) {
+    std::ofstream output_file(output_filename.c_str());
+    if (!output_file.is_open()) {
+      std::cerr << "output file: " << output_filename << std::endl;
+      throw std::runtime_error("Error! Unable to open output file.");
+    }
+    std::string filename = output_filename + ".candidates";
+    std::string best_line = append_output_file(output_file, filename, true, 1);
+    std::remove(filename.c_str());
+    for (int j_start = 0; j_start < N_chosen; j_start++) {
+      if (!launched[j_start]) continue;
+      filename = output_filename + ".start_" + std::to_string(j_start);
+      std::string last_line = append_output_file(output_file, filename, false, first_evaluations[j_start]);
+      if (j_start == winner) best_line = last_line;
+      std::remove(filename.c_str());
+    }
+    if (!best_line.empty()) output_file << std::setw(6) << std::right << best_function_evaluation << best_line.substr(best_line.find(',')) << std::endl;
+    output_file.close();
+  }
+
+  // Restore the settings of the problem, and its partition over all the worker groups.
+  solver->output_filename = output_filename;
+  solver->max_function_evaluations = max_function_evaluations;
+  solver->N_line_search = N_line_search;
+  solver->bound_constraints_set = true;
+  problem->mpi_partition.set_custom(comm_world, comm_group_leaders, comm_worker_groups);
+  MPI_Comm_free(&comm_world_sub);
+  if (comm_group_leaders_sub != MPI_COMM_NULL) MPI_Comm_free(&comm_group_leaders_sub);
+
+  return best_objective_function;
+}
+
+int mango::Multistart::get_N_starts() {
+  return optima.size();
+}
+
+double mango::Multistart::get_optimum(int j_start) {
+  if (j_start < 0 || j_start >= (int) optima.size()) throw std::runtime_error("Error in mango::Multistart::get_optimum. j_start is out of range, or optimize() has not been called.");
+  return optima[j_start];
+}
+
+bool mango::Multistart::get_cut_off(int j_start) {
+  if (j_start < 0 || j_start >= (int) cut_off.size()) throw std::runtime_error("Error in mango::Multistart::get_cut_off. j_start is out of range, or optimize() has not been called.");
+  return cut_off[j_start];
+}
+
+int mango::Multistart::get_function_evaluations(int j_start) {
+  if (j_start < 0 || j_start >= (int) function_evaluations.size()) throw std::runtime_error("Error in mango::Multistart::get_function_evaluations. j_start is out of range, or optimize() has not been called.");
+  return function_evaluations[j_start];
+}
+
+void mango::Multistart::generate_design(design_type design, int N_points, int N_dimensions, int seed, std::vector<double>& points) {
+  points.resize(N_points * N_dimensions);
+
+  if (design == DESIGN_LATIN_HYPERCUBE) {
+    // In each direction, a random permutation assigns one point to each slice, and the point is placed randomly within its slice.
+    std::mt19937 random_number_generator(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<int> permutation(N_points);
+    for (int j = 0; j < N_dimensions; j++) {
+      for (int k = 0; k < N_points; k++) permutation[k] = k;
+      std::shuffle(permutation.begin(), permutation.end(), random_number_generator);
+      for (int k = 0; k < N_points; k++) points[k * N_dimensions + j] = (permutation[k] + uniform(random_number_generator)) / N_points;
+    }
+
+  } else if (design == DESIGN_SOBOL) {
+    if (N_dimensions > max_sobol_dimensions) throw std::runtime_error("Error! The Sobol design is available for up to 21 parameters. Use the Latin hypercube design instead.");
+    // Direction number k+1 of dimension j, as a 32-bit binary fraction:
+    const int N_bits = 32;
+    std::vector<uint32_t> directions(N_dimensions * N_bits);
+    for (int j = 0; j < N_dimensions; j++) {
+      uint32_t* v = &directions[j * N_bits];
+      if (j == 0) {
+	for (int k = 0; k < N_bits; k++) v[k] = (uint32_t) 1 << (N_bits - 1 - k);
+	continue;
+      }
+      const sobol_direction& d = sobol_directions[j - 1];
+      for (int k = 0; k < N_bits; k++) {
+	if (k < d.s) {
+	  v[k] = (uint32_t) d.m[k] << (N_bits - 1 - k);
+	} else {
+	  v[k] = v[k - d.s] ^ (v[k - d.s] >> d.s);
+	  for (int i = 1; i < d.s; i++) {
+	    if ((d.a >> (d.s - 1 - i)) & 1) v[k] ^= v[k - i];
+	  }
+	}
+      }
+    }
+    // Generate the points in Gray-code order, starting from the origin, so each point differs from the last by one direction number.
+    std::vector<uint32_t> x(N_dimensions, 0);
+    for (int k = 0; k < N_points; k++) {
+      for (int j = 0; j < N_dimensions; j++) points[k * N_dimensions + j] = x[j] / 4294967296.0;
+      int c = 0;
+      for (unsigned int n = k; n & 1; n >>= 1) c++;
+      for (int j = 0; j < N_dimensions; j++) x[j] ^= directions[j * N_bits + c];
+    }
+
+  } else {
+    throw std::runtime_error("Error in mango::Multistart::generate_design. Invalid design.");
+  }
+}
@@ -0,0 +1,424 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <mpi.h>
+#include "mango.hpp"
+#include "Solver.hpp"
+#include "Least_squares_solver.hpp"
+#include "Recorder.hpp"
+
+namespace {
+  // Divide the worker groups among the algorithms that run until the next checkpoint. On return, colors[j] is the sub-partition
+  // of worker group j, or -1 if the group is idle, and sub_algorithms[k] lists the algorithms run one after another by sub-partition k.
+  void portfolio_assign(const std::vector<int>& running, const std::vector<mango::algorithm_type>& portfolio_algorithms, int N_worker_groups,
+			std::vector<int>& colors, std::vector<std::vector<int> >& sub_algorithms) {
+    int N_running = running.size();
+    colors.assign(N_worker_groups, -1);
+    if (N_running >= N_worker_groups) {
+      // Each worker group is a sub-partition, and takes every N_worker_groups-th algorithm.
+      sub_algorithms.assign(N_worker_groups, std::vector<int>());
+      for (int j = 0; j < N_worker_groups; j++) colors[j] = j;
+      for (int k = 0; k < N_running; k++) sub_algorithms[k % N_worker_groups].push_back(running[k]);
+      return;
+    }
+
+    // Otherwise each algorithm gets its own sub-partition. Algorithms that cannot use concurrent function evaluations get one worker group,
+    // and the other algorithms share the remaining worker groups as evenly as possible.
+    sub_algorithms.assign(N_running, std::vector<int>());
+    int N_parallel = 0;
+    for (int k = 0; k < N_running; k++) {
+      if (mango::algorithms[portfolio_algorithms[running[k]]].parallel) N_parallel++;
+    }
+    int N_spare = N_worker_groups - (N_running - N_parallel);
+    int j_parallel = 0, worker_group = 0;
+    for (int k = 0; k < N_running; k++) {
+      sub_algorithms[k].push_back(running[k]);
+      int N_groups = 1;
+      if (mango::algorithms[portfolio_algorithms[running[k]]].parallel) {
+	N_groups = N_spare / N_parallel + (j_parallel < N_spare % N_parallel ? 1 : 0);
+	j_parallel++;
+      }
+      for (int j = 0; j < N_groups; j++) colors[worker_group++] = k;
+    }
+  }
+
+  // The rank of each entry of rates, with 0 for the largest. Ties go to the lower objective function, and then to the lower index.
+  std::vector<int> portfolio_rank(const std::vector<double>& rates, const std::vector<double>& objective_functions) {
+    int N = rates.size();
+    std::vector<int> order(N), ranks(N);
+    for (int k = 0; k < N; k++) order[k] = k;
+    std::stable_sort(order.begin(), order.end(), [&](int k1, int k2) {
+	if (rates[k1] != rates[k2]) return rates[k1] > rates[k2];
+	return objective_functions[k1] < objective_functions[k2];
+      });
+    for (int k = 0; k < N; k++) ranks[order[k]] = k;
+    return ranks;
+  }
+}
+
+mango::Portfolio::Portfolio(Problem* problem_in) {
+  problem = problem_in;
+  checkpoint_function_evaluations = 10 * (problem->get_N_parameters() + 1);
+  winner = -1;
+}
+
+void mango::Portfolio::add_algorithm(algorithm_type algorithm) {
+  if (algorithm < 0 || algorithm >= NUM_ALGORITHMS) throw std::runtime_error("Error in mango::Portfolio::add_algorithm. Invalid algorithm.");
+  if (algorithms[algorithm].least_squares && dynamic_cast<Least_squares_solver*>(problem->get_solver()) == NULL)
+    throw std::runtime_error("Error in mango::Portfolio::add_algorithm. An algorithm for least-squares problems was added, but the problem is not least-squares.");
+  portfolio_algorithms.push_back(algorithm);
+}
+
+void mango::Portfolio::add_algorithm(std::string algorithm_name) {
+  algorithm_type algorithm;
+  if (!get_algorithm(algorithm_name, &algorithm)) {
+    std::cerr << "Error in mango::Portfolio::add_algorithm. The following algorithm name was requested but not found: " << algorithm_name << std::endl;
+    throw std::runtime_error("Error in mango::Portfolio::add_algorithm: The requested algorithm name was not found.");
+  }
+  add_algorithm(algorithm);
+}
+
+void mango::Portfolio::set_checkpoint_function_evaluations(int checkpoint_function_evaluations_in) {
+  if (checkpoint_function_evaluations_in < 1) throw std::runtime_error("Error in mango::Portfolio::set_checkpoint_function_evaluations. checkpoint_function_evaluations must be at least 1.");
+  checkpoint_function_evaluations = checkpoint_function_evaluations_in;
+}
+
+void mango::Portfolio::mpi_init(MPI_Comm mpi_comm) {
+  mpi_partition.init(mpi_comm);
+}
+
+double mango::Portfolio::optimize() {
+  // All processes should call this subroutine!
+
+  MPI_Comm comm_world = mpi_partition.get_comm_world();
+  MPI_Comm comm_worker_groups = mpi_partition.get_comm_worker_groups();
+  MPI_Comm comm_group_leaders = mpi_partition.get_comm_group_leaders();
+  bool proc0_world = mpi_partition.get_proc0_world();
+  bool proc0_worker_groups = mpi_partition.get_proc0_worker_groups();
+  int rank_world = mpi_partition.get_rank_world();
+  int N_worker_groups = mpi_partition.get_N_worker_groups();
+
+  Solver* solver = problem->get_solver();
+  Least_squares_solver* least_squares_solver = dynamic_cast<Least_squares_solver*>(solver);
+  int N_parameters = solver->N_parameters;
+  int N_terms = (least_squares_solver == NULL) ? 0 : least_squares_solver->N_terms;
+  int N_algorithms = portfolio_algorithms.size();
+  if (N_algorithms == 0) throw std::runtime_error("Error! No algorithms were added to the mango::Portfolio.");
+  for (int j_algorithm = 0; j_algorithm < N_algorithms; j_algorithm++) {
+    if (algorithms[portfolio_algorithms[j_algorithm]].requires_bound_constraints && !solver->bound_constraints_set)
+      throw std::runtime_error("Error! An algorithm that requires bound constraints was added to the mango::Portfolio, but bound constraints were not set.");
+  }
+
+  // These settings of the problem are changed for each phase, and restored at the end.
+  std::string output_filename = solver->output_filename;
+  int max_function_evaluations = solver->max_function_evaluations;
+  int N_line_search = solver->N_line_search;
+  algorithm_type algorithm = solver->algorithm;
+  bool bound_constraints_set = solver->bound_constraints_set;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Evaluate the initial state vector, which is the reference for the progress of every algorithm.
+
+  std::vector<double> initial_state_vector(solver->state_vector, solver->state_vector + N_parameters);
+  std::vector<double> initial_residuals(N_terms);
+  double initial_objective_function;
+  problem->mpi_partition.set_custom(comm_world, comm_group_leaders, comm_worker_groups);
+  solver->output_filename = output_filename + ".initial";
+  solver->algorithm = portfolio_algorithms[0];
+  solver->bound_constraints_set = bound_constraints_set && algorithms[solver->algorithm].allows_bound_constraints;
+  if (proc0_worker_groups) {
+    solver->mpi_partition = &problem->mpi_partition;
+    solver->init_optimization();
+    if (least_squares_solver != NULL) {
+      memset(least_squares_solver->best_residual_function, 0, N_terms * sizeof(double));
+      least_squares_solver->current_residuals = least_squares_solver->best_residual_function;
+    }
+    solver->evaluate_objective_set_in_parallel(1, initial_state_vector.data(), &initial_objective_function);
+    if (proc0_world) {
+      if (least_squares_solver != NULL) memcpy(initial_residuals.data(), least_squares_solver->best_residual_function, N_terms * sizeof(double));
+      solver->recorder->finalize();
+      solver->metrics->finalize();
+    }
+    problem->mpi_partition.stop_workers();
+  } else {
+    while (problem->mpi_partition.continue_worker_loop()) {
+      if (solver->worker_function != NULL) solver->worker_function(problem, solver->user_data);
+    }
+  }
+  MPI_Bcast(&initial_objective_function, 1, MPI_DOUBLE, 0, comm_world);
+  if (least_squares_solver != NULL) MPI_Bcast(initial_residuals.data(), N_terms, MPI_DOUBLE, 0, comm_world);
+  if (!std::isfinite(initial_objective_function)) initial_objective_function = std::numeric_limits<double>::infinity();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Run the algorithms from one checkpoint to the next, eliminating the worse half at each checkpoint.
+
+  // The progress of each algorithm, which is the same on all processes:
+  std::vector<double> best_objective_functions(N_algorithms, std::numeric_limits<double>::infinity());
+  std::vector<double> best_state_vectors(N_algorithms * N_parameters);
+  std::vector<double> best_residuals(N_algorithms * N_terms);
+  std::vector<int> best_function_evaluations(N_algorithms, 1);
+  std::vector<int> best_phases(N_algorithms, -1);
+  std::vector<bool> stalled(N_algorithms, false);
+  for (int j_algorithm = 0; j_algorithm < N_algorithms; j_algorithm++) {
+    memcpy(&best_state_vectors[j_algorithm * N_parameters], initial_state_vector.data(), N_parameters * sizeof(double));
+    if (N_terms > 0) memcpy(&best_residuals[j_algorithm * N_terms], initial_residuals.data(), N_terms * sizeof(double));
+  }
+  function_evaluations.assign(N_algorithms, 0);
+  elapsed_times.assign(N_algorithms, 0.0);
+  eliminations.assign(N_algorithms, 0);
+
+  // Each run of one algorithm between checkpoints is a phase, with its own output file.
+  std::vector<int> phase_first_evaluations;
+  int first_evaluation = 2;
+  int remaining_function_evaluations = max_function_evaluations - 1;
+  int checkpoint = 0;
+  std::vector<int> colors;
+  std::vector<std::vector<int> > sub_algorithms;
+  int record_size = 2 + N_parameters + N_terms;
+  while (remaining_function_evaluations > 0) {
+    std::vector<int> running;
+    int N_alive = 0;
+    for (int j_algorithm = 0; j_algorithm < N_algorithms; j_algorithm++) {
+      if (eliminations[j_algorithm] > 0) continue;
+      N_alive++;
+      if (!stalled[j_algorithm]) running.push_back(j_algorithm);
+    }
+    int N_running = running.size();
+    if (N_running == 0) break;
+    int budget = (N_alive == 1) ? remaining_function_evaluations : std::min(checkpoint_function_evaluations, remaining_function_evaluations / N_running);
+    if (budget < 1) break;
+
+    portfolio_assign(running, portfolio_algorithms, N_worker_groups, colors, sub_algorithms);
+    std::vector<int> phases(N_algorithms, -1);
+    for (int k = 0; k < N_running; k++) phases[running[k]] = phase_first_evaluations.size() + k;
+    int color = colors[mpi_partition.get_worker_group()];
+    // Group leaders come first in the sub-partition's world communicator, so its proc0_world is a group leader.
+    MPI_Comm comm_world_sub, comm_group_leaders_sub = MPI_COMM_NULL;
+    MPI_Comm_split(comm_world, (color >= 0 ? color : MPI_UNDEFINED), (proc0_worker_groups ? 0 : mpi_partition.get_N_procs_world()) + rank_world, &comm_world_sub);
+    if (proc0_worker_groups) MPI_Comm_split(comm_group_leaders, (color >= 0 ? color : MPI_UNDEFINED), rank_world, &comm_group_leaders_sub);
+
+    // These arrays are filled in only on the proc0_world of the sub-partition that ran each algorithm, and combined afterwards.
+    std::vector<int> owners(N_algorithms, -1);
+    std::vector<int> phase_function_evaluations(N_algorithms, 0);
+    std::vector<int> phase_best_function_evaluations(N_algorithms, -1);
+    std::vector<double> records(N_algorithms * record_size, 0.0);
+    if (color >= 0) {
+      problem->mpi_partition.set_custom(comm_world_sub, comm_group_leaders_sub, comm_worker_groups);
+      bool proc0_sub = problem->mpi_partition.get_proc0_world();
+      for (int j_algorithm : sub_algorithms[color]) {
+	solver->algorithm = portfolio_algorithms[j_algorithm];
+	solver->bound_constraints_set = bound_constraints_set && algorithms[solver->algorithm].allows_bound_constraints;
+	memcpy(solver->state_vector, &best_state_vectors[j_algorithm * N_parameters], N_parameters * sizeof(double));
+	solver->output_filename = output_filename + ".phase_" + std::to_string(phases[j_algorithm]);
+	solver->max_function_evaluations = budget;
+	solver->N_line_search = N_line_search;
+	if (proc0_worker_groups) {
+	  if (mpi_partition.verbose > 0 && proc0_sub) std::cout << "Worker groups starting at " << mpi_partition.get_worker_group() << " are running " << algorithms[solver->algorithm].name << std::endl;
+	  double start_time = MPI_Wtime();
+	  problem->optimize();
+	  double elapsed_time = MPI_Wtime() - start_time;
+	  if (proc0_sub) {
+	    owners[j_algorithm] = rank_world;
+	    phase_function_evaluations[j_algorithm] = solver->function_evaluations;
+	    phase_best_function_evaluations[j_algorithm] = (solver->at_least_one_success ? solver->best_function_evaluation : -1);
+	    double* record = &records[j_algorithm * record_size];
+	    record[0] = solver->best_objective_function;
+	    record[1] = elapsed_time;
+	    memcpy(&record[2], solver->state_vector, N_parameters * sizeof(double));
+	    if (least_squares_solver != NULL) memcpy(&record[2 + N_parameters], least_squares_solver->best_residual_function, N_terms * sizeof(double));
+	  }
+	  problem->mpi_partition.stop_workers();
+	} else {
+	  while (problem->mpi_partition.continue_worker_loop()) {
+	    if (solver->worker_function != NULL) solver->worker_function(problem, solver->user_data);
+	  }
+	}
+      }
+      MPI_Comm_free(&comm_world_sub);
+      if (comm_group_leaders_sub != MPI_COMM_NULL) MPI_Comm_free(&comm_group_leaders_sub);
+    }
+
+    // Send the result of each phase to all processes.
+    MPI_Allreduce(MPI_IN_PLACE, owners.data(), N_algorithms, MPI_INT, MPI_MAX, comm_world);
+    MPI_Allreduce(MPI_IN_PLACE, phase_function_evaluations.data(), N_algorithms, MPI_INT, MPI_MAX, comm_world);
+    MPI_Allreduce(MPI_IN_PLACE, phase_best_function_evaluations.data(), N_algorithms, MPI_INT, MPI_MAX, comm_world);
+    for (int j_algorithm : running) {
+      double* record = &records[j_algorithm * record_size];
+      MPI_Bcast(record, record_size, MPI_DOUBLE, owners[j_algorithm], comm_world);
+      phase_first_evaluations.push_back(first_evaluation);
+      function_evaluations[j_algorithm] += phase_function_evaluations[j_algorithm];
+      elapsed_times[j_algorithm] += record[1];
+      remaining_function_evaluations -= phase_function_evaluations[j_algorithm];
+      if (phase_best_function_evaluations[j_algorithm] > 0 && record[0] < best_objective_functions[j_algorithm]) {
+	best_objective_functions[j_algorithm] = record[0];
+	memcpy(&best_state_vectors[j_algorithm * N_parameters], &record[2], N_parameters * sizeof(double));
+	if (N_terms > 0) memcpy(&best_residuals[j_algorithm * N_terms], &record[2 + N_parameters], N_terms * sizeof(double));
+	best_function_evaluations[j_algorithm] = first_evaluation - 1 + phase_best_function_evaluations[j_algorithm];
+	best_phases[j_algorithm] = phases[j_algorithm];
+      } else {
+	// The algorithm has converged, or cannot make progress from its best point, so it is not restarted.
+	stalled[j_algorithm] = true;
+      }
+      first_evaluation += phase_function_evaluations[j_algorithm];
+    }
+    if (N_alive == 1) continue;
+
+    // At the checkpoint, compare the progress of the algorithms that are still in the race, both per function evaluation and per second.
+    checkpoint++;
+    std::vector<int> alive;
+    for (int j_algorithm = 0; j_algorithm < N_algorithms; j_algorithm++) {
+      if (eliminations[j_algorithm] == 0) alive.push_back(j_algorithm);
+    }
+    double reference = initial_objective_function;
+    if (!std::isfinite(reference)) {
+      // If the initial state vector failed, progress is measured from the worst point found by any algorithm.
+      reference = -std::numeric_limits<double>::infinity();
+      for (int j_algorithm : alive) {
+	if (std::isfinite(best_objective_functions[j_algorithm])) reference = std::max(reference, best_objective_functions[j_algorithm]);
+      }
+    }
+    std::vector<double> objective_functions(N_alive), rates_per_evaluation(N_alive), rates_per_second(N_alive);
+    for (int k = 0; k < N_alive; k++) {
+      int j_algorithm = alive[k];
+      objective_functions[k] = best_objective_functions[j_algorithm];
+      if (std::isfinite(objective_functions[k]) && function_evaluations[j_algorithm] > 0) {
+	rates_per_evaluation[k] = (reference - objective_functions[k]) / function_evaluations[j_algorithm];
+	rates_per_second[k] = (reference - objective_functions[k]) / std::max(elapsed_times[j_algorithm], 1.0e-9);
+      } else {
+	rates_per_evaluation[k] = -std::numeric_limits<double>::infinity();
+	rates_per_second[k] = -std::numeric_limits<double>::infinity();
+      }
+    }
+    std::vector<int> ranks_per_evaluation = portfolio_rank(rates_per_evaluation, objective_functions);
+    std::vector<int> ranks_per_second = portfolio_rank(rates_per_second, objective_functions);
+    std::vector<double> scores(N_alive);
+    for (int k = 0; k < N_alive; k++) scores[k] = -(ranks_per_evaluation[k] + ranks_per_second[k]);
+    std::vector<int> ranks = portfolio_rank(scores, objective_functions);
+    for (int k = 0; k < N_alive; k++) {
+      if (ranks[k] >= N_alive - N_alive / 2) eliminations[alive[k]] = checkpoint;
+    }
+    if (mpi_partition.verbose > 0 && proc0_world) {
+      std::cout << "Portfolio checkpoint " << checkpoint << ":" << std::endl;
+      for (int k = 0; k < N_alive; k++) {
+	std::cout << "  " << std::setw(32) << std::left << algorithms[portfolio_algorithms[alive[k]]].name << " best objective function = " << std::setprecision(16)
+		  << objective_functions[k] << ", rank per evaluation " << ranks_per_evaluation[k] << ", rank per second " << ranks_per_second[k]
+		  << (eliminations[alive[k]] > 0 ? ", eliminated" : "") << std::endl;
+      }
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Find the best point overall.
+
+  winner = -1;
+  double best_objective_function = initial_objective_function;
+  for (int j_algorithm = 0; j_algorithm < N_algorithms; j_algorithm++) {
+    if (best_objective_functions[j_algorithm] < best_objective_function) {
+      winner = j_algorithm;
+      best_objective_function = best_objective_functions[j_algorithm];
+    }
+  }
+  int best_function_evaluation = (winner >= 0) ? best_function_evaluations[winner] : 1;
+  if (winner >= 0) {
+    memcpy(solver->state_vector, &best_state_vectors[winner * N_parameters], N_parameters * sizeof(double));
+    if (least_squares_solver != NULL) memcpy(least_squares_solver->best_residual_function, &best_residuals[winner * N_terms], N_terms * sizeof(double));
+  } else {
+    memcpy(solver->state_vector, initial_state_vector.data(), N_parameters * sizeof(double));
+    if (least_squares_solver != NULL) memcpy(least_squares_solver->best_residual_function, initial_residuals.data(), N_terms * sizeof(double));
+  }
+  memcpy(solver->best_state_vector, solver->state_vector, N_parameters * sizeof(double));
+  solver->best_objective_function = best_objective_function;
+  solver->best_function_evaluation = best_function_evaluation;
+  solver->function_evaluations = first_evaluation - 1;
+  optima = best_objective_functions;
+  for (int j_algorithm = 0; j_algorithm < N_algorithms; j_algorithm++) {
+    if (!std::isfinite(optima[j_algorithm])) optima[j_algorithm] = std::numeric_limits<double>::quiet_NaN();
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Combine the output files of the phases into one, on proc0_world.
+
+  if (proc0_world) {
+    std::ofstream output_file(output_filename.c_str());
+    if (!output_file.is_open()) {
+      std::cerr << "output file: " << output_filename << std::endl;
+      throw std::runtime_error("Error! Unable to open output file.");
+    }
+    std::string filename = output_filename + ".initial";
+    std::string best_line = append_output_file(output_file, filename, true, 1);
+    std::remove(filename.c_str());
+    for (int phase = 0; phase < (int) phase_first_evaluations.size(); phase++) {
+      filename = output_filename + ".phase_" + std::to_string(phase);
+      std::string last_line = append_output_file(output_file, filename, false, phase_first_evaluations[phase]);
+      if (winner >= 0 && phase == best_phases[winner]) best_line = last_line;
+      std::remove(filename.c_str());
+    }
+    if (!best_line.empty()) output_file << std::setw(6) << std::right << best_function_evaluation << best_line.substr(best_line.find(',')) << std::endl;
+    output_file.close();
+  }
+
+  // Restore the settings of the problem, and its partition over all the worker groups.
+  solver->output_filename = output_filename;
+  solver->max_function_evaluations = max_function_evaluations;
+  solver->N_line_search = N_line_search;
+  solver->algorithm = algorithm;
+  solver->bound_constraints_set = bound_constraints_set;
+  problem->mpi_partition.set_custom(comm_world, comm_group_leaders, comm_worker_groups);
+
+  return best_objective_function;
+}
+
+int mango::Portfolio::get_N_algorithms() {
+  return portfolio_algorithms.size();
+}
+
+double mango::Portfolio::get_optimum(int j_algorithm) {
+  if (j_algorithm < 0 || j_algorithm >= (int) optima.size()) throw std::runtime_error("Error in mango::Portfolio::get_optimum. j_algorithm is out of range, or optimize() has not been called.");
+  return optima[j_algorithm];
+}
+
+int mango::Portfolio::get_function_evaluations(int j_algorithm) {
+  if (j_algorithm < 0 || j_algorithm >= (int) function_evaluations.size()) throw std::runtime_error("Error in mango::Portfolio::get_function_evaluations. j_algorithm is out of range, or optimize() has not been called.");
+  return function_evaluations[j_algorithm];
+}
+
+double mango::Portfolio::get_elapsed_time(int j_algorithm) {
+  if (j_algorithm < 0 || j_algorithm >= (int) elapsed_times.size()) throw std::runtime_error("Error in mango::Portfolio::get_elapsed_time. j_algorithm is out of range, or optimize() has not been called.");
+  return elapsed_times[j_algorithm];
+}
+
+int mango::Portfolio::get_elimination(int j_algorithm) {
+  if (j_algorithm < 0 || j_algorithm >= (int) eliminations.size()) throw std::runtime_error("Error in mango::Portfolio::get_elimination. j_algorithm is out of range, or optimize() has not been called.");
+  return eliminations[j_algorithm];
+}
+
+int mango::Portfolio::get_winner() {
+  return winner;
+}
@@ -82,10 +82,45 @@ void mango::Problem::set_output_filename(std::string filename) {
   solver->output_filename = filename;
 }
 
+void mango::Problem::set_batch_objective_function(batch_objective_function_type batch_objective_function) {
+  solver->batch_objective_function = batch_objective_function;
+}
+
+void mango::Problem::set_async_functions(async_start_function_type start, async_poll_function_type poll) {
+  if ((start == NULL) != (poll == NULL)) throw std::runtime_error("Error in mango::Problem::set_async_functions. Either both or neither of the subroutines must be NULL.");
+  solver->async_start_function = start;
+  solver->async_poll_function = poll;
+}
+
+void mango::Problem::set_max_async_evaluations(int N) {
+  if (N < 1) throw std::runtime_error("Error! max_async_evaluations must be >= 1.");
+  solver->max_async_evaluations = N;
+}
+
+void mango::Problem::set_async_poll_interval(double interval) {
+  if (interval < 0) throw std::runtime_error("Error! async_poll_interval must be >= 0.");
+  solver->async_poll_interval = interval;
+}
+
+void mango::Problem::set_metrics_filename(std::string filename) {
+  solver->metrics_filename = filename;
+}
+
+void mango::Problem::set_metrics_interval(double interval) {
+  if (interval < 0) throw std::runtime_error("Error! metrics_interval must be >= 0.");
+  solver->metrics_interval = interval;
+}
+
 void mango::Problem::set_user_data(void* user_data) {
   solver->user_data = user_data;
 }
 
+void mango::Problem::add_observer(observer_function_type observer, void* observer_data) {
+  if (observer == NULL) throw std::runtime_error("Error in mango::Problem::add_observer. Observer cannot be NULL.");
+  solver->observers.push_back(observer);
+  solver->observer_data.push_back(observer_data);
+}
+
 #define bold_line "****************************************************************************************"
 void mango::Problem::mpi_init(MPI_Comm mpi_comm_world) {
   // This method basically just calls MPI_Partition::init, but first checks to see if the algorithm
@@ -122,6 +157,28 @@ double mango::Problem::optimize() {
   return solver->optimize(&mpi_partition);
 }
 
+void mango::Problem::begin_session() {
+  if (!mpi_partition.get_proc0_worker_groups()) throw std::runtime_error("Error! mango::Problem::begin_session() should only be called by group leaders.");
+  if (solver->in_session) throw std::runtime_error("Error! mango::Problem::begin_session() was called while a session was already in progress.");
+
+  solver->mpi_partition = &mpi_partition;
+  solver->in_session = true;
+  if (mpi_partition.get_proc0_world()) return;
+
+  // The other group leaders take part in each solve started by proc0_world, until end_session() is called.
+  solver->session_loop();
+  solver->in_session = false;
+}
+
+void mango::Problem::end_session() {
+  if (!mpi_partition.get_proc0_world()) throw std::runtime_error("Error! mango::Problem::end_session() should only be called by proc0_world.");
+  if (!solver->in_session) throw std::runtime_error("Error! mango::Problem::end_session() was called without a session in progress.");
+
+  int data = -1;
+  MPI_Bcast(&data,1,MPI_INT,0,mpi_partition.get_comm_group_leaders());
+  solver->in_session = false;
+}
+
 
 void mango::Problem::set_relative_bound_constraints(double min_factor, double max_factor, double min_radius, bool preserve_sign) {
   if (min_factor < 0) throw std::runtime_error("mango::Problem::set_relative_bound_constraints: min_factor must be >= 0.");
@@ -173,10 +230,27 @@ void mango::Problem::set_relative_bound_constraints(double min_factor, double ma
   }
 }
 
+void mango::Problem::set_N_threads(int N_threads) {
+  if (N_threads < 1) throw std::runtime_error("Error! N_threads must be >= 1.");
+  solver->N_threads = N_threads;
+}
+
+void mango::Problem::set_shared_memory(bool use_shared_memory) {
+  solver->use_shared_memory = use_shared_memory;
+}
+
+void mango::Problem::set_worker_function(worker_function_type worker_function) {
+  solver->worker_function = worker_function;
+}
+
 void mango::Problem::set_N_line_search(int N_line_search) {
   solver->N_line_search = N_line_search;
 }
 
+void mango::Problem::set_random_seed(int random_seed) {
+  solver->random_seed = random_seed;
+}
+
 mango::Solver* mango::Problem::get_solver() {
   return solver;
 }
@@ -20,17 +20,25 @@
 #define MANGO_RECORDER_H
 
 #include <ctime>
+#include <fstream>
+#include <string>
 
 namespace mango {
 
   // All methods of this parent class are empty. Therefore this base version of Recorder does nothing.
   class Recorder {
   public:
+    virtual ~Recorder() {};
     virtual void init() {};
     virtual void record_function_evaluation(int function_evaluations, clock_t print_time, const double* x, double f) {};
     virtual void finalize() {};
   };
 
+  // Copy the function evaluations of one output file to another, numbering them consecutively from first_evaluation.
+  // This is used to combine the output files of several solves into one. The last line of the input file, which
+  // repeats the optimum, is returned instead of being copied.
+  std::string append_output_file(std::ofstream& output_file, const std::string& filename, bool write_header, int first_evaluation);
+
 }
 
 #endif
@@ -19,6 +19,8 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
+#include <string>
 #include <stdexcept>
 #include <ctime>
 #include "Recorder.hpp"
@@ -26,6 +28,12 @@
 
 mango::Recorder_least_squares::Recorder_least_squares(Least_squares_solver* solver_in) {
   solver = solver_in;
+  reference_residuals = NULL;
+}
+
+mango::Recorder_least_squares::~Recorder_least_squares() {
+  // reference_residuals is normally freed by finalize(), but not if the optimization was interrupted.
+  delete[] reference_residuals;
 }
 
 void mango::Recorder_least_squares::init() {
@@ -46,41 +54,88 @@ void mango::Recorder_least_squares::init() {
   }
   output_file << ",objective_function";
   if (solver->print_residuals_in_output_file) {
+    std::string column_prefix = (solver->residual_storage == RESIDUALS_DELTA_FROM_BEST) ? ",dF(" : ",F(";
     for (j=0; j<solver->N_terms; j++) {
-      output_file << ",F(" << j+1 << ")";
+      output_file << column_prefix << j+1 << ")";
     }
   }
   output_file << std::endl << std::flush;
+  best_file_string.clear();
+
+  if (solver->print_residuals_in_output_file && solver->residual_storage == RESIDUALS_DELTA_FROM_BEST) {
+    // Until the first successful function evaluation, residuals are written relative to 0.
+    delete[] reference_residuals;
+    reference_residuals = new double[solver->N_terms];
+    for (j=0; j<solver->N_terms; j++) reference_residuals[j] = 0.0;
+  }
 }
 
 
-void mango::Recorder_least_squares::write_file_line(int function_evaluations, clock_t print_time, const double* x, double f, double* residuals) {
-  // This subroutine writes a line in the output file for non-least-squares problems.
-  /*
-  write_function_evaluation_and_time(print_time);
-  std::string file_string;
-  compose_x_f_string(file_string, x, f);
-  output_file << file_string << std::endl << std::flush;
-  */
+void mango::Recorder_least_squares::compose_file_line(std::string& file_string, int function_evaluations, clock_t print_time, const double* x, double f, double* residuals) {
+  // This subroutine composes a line of the output file for least-squares problems, without the trailing newline.
+  std::ostringstream line;
   double elapsed_time = ((float)(print_time - solver->start_time)) / CLOCKS_PER_SEC;
-  output_file << std::setw(6) << std::right << function_evaluations << "," << std::setw(12) << std::setprecision(4) << std::scientific << elapsed_time;
+  line << std::setw(6) << std::right << function_evaluations << "," << std::setw(12) << std::setprecision(4) << std::scientific << elapsed_time;
   for (int j=0; j<solver->N_parameters; j++) {
-    output_file << "," << std::setw(24) << std::setprecision(16) << std::scientific << x[j];
+    line << "," << std::setw(24) << std::setprecision(16) << std::scientific << x[j];
   }
-  output_file << "," << std::setw(24) << f;
+  line << "," << std::setw(24) << f;
   if (solver->print_residuals_in_output_file) {
-    for (int j=0; j<solver->N_terms; j++) {
-      output_file << "," << std::setw(24) << std::setprecision(16) << std::scientific << residuals[j];
+    if (residuals == NULL) {
+      // The residuals are not stored for this line, but the line still has one (empty) field per term, so every line has the same number of columns.
+      for (int j=0; j<solver->N_terms; j++) line << ",";
+    } else {
+      switch (solver->residual_storage) {
+      case RESIDUALS_SINGLE_PRECISION:
+	for (int j=0; j<solver->N_terms; j++) {
+	  line << "," << std::setw(15) << std::setprecision(8) << std::scientific << (float)residuals[j];
+	}
+	break;
+      case RESIDUALS_DELTA_FROM_BEST:
+	for (int j=0; j<solver->N_terms; j++) {
+	  line << "," << std::setw(24) << std::setprecision(16) << std::scientific << residuals[j] - reference_residuals[j];
+	}
+	break;
+      default:
+	for (int j=0; j<solver->N_terms; j++) {
+	  line << "," << std::setw(24) << std::setprecision(16) << std::scientific << residuals[j];
+	}
+      }
     }
   }
-  output_file << std::endl << std::flush;
+  file_string = line.str();
 }
 
 
 void mango::Recorder_least_squares::record_function_evaluation(int function_evaluations, clock_t print_time, const double* x, double f) {
   if (!solver->mpi_partition->get_proc0_world()) return; // Proceed only on proc0_world.
 
-  write_file_line(function_evaluations, print_time, x, f, solver->current_residuals);
+  // Solver::record_function_evaluation has already updated best_function_evaluation by the time the recorder is called.
+  bool new_optimum = solver->at_least_one_success && (solver->best_function_evaluation == function_evaluations);
+
+  bool write_residuals;
+  switch (solver->residual_storage) {
+  case RESIDUALS_BEST_ONLY:
+    write_residuals = new_optimum;
+    break;
+  case RESIDUALS_EVERY_K:
+    write_residuals = (function_evaluations % solver->residual_storage_interval == 0);
+    break;
+  default:
+    write_residuals = true;
+  }
+
+  std::string file_string;
+  compose_file_line(file_string, function_evaluations, print_time, x, f, write_residuals ? solver->current_residuals : NULL);
+  output_file << file_string << std::endl << std::flush;
+
+  if (new_optimum) {
+    // Keep the line exactly as written, so finalize() can repeat it regardless of the residual storage policy.
+    best_file_string = file_string;
+    if (reference_residuals != NULL) {
+      for (int j=0; j<solver->N_terms; j++) reference_residuals[j] = solver->current_residuals[j];
+    }
+  }
 }
 
 
@@ -89,7 +144,15 @@ void mango::Recorder_least_squares::finalize() {
 
   if (!solver->mpi_partition->get_proc0_world()) return; // Proceed only on proc0_world.
 
-  write_file_line(solver->best_function_evaluation, solver->best_time, solver->state_vector, solver->best_objective_function, solver->best_residual_function);
+  if (best_file_string.empty()) {
+    // There was no successful function evaluation, so there is no interior line to copy.
+    compose_file_line(best_file_string, solver->best_function_evaluation, solver->best_time, solver->state_vector, solver->best_objective_function, NULL);
+  }
+  output_file << best_file_string << std::endl << std::flush;
+  if (reference_residuals != NULL) {
+    delete[] reference_residuals;
+    reference_residuals = NULL;
+  }
 
   output_file.close();
 }
@@ -20,6 +20,7 @@
 #define MANGO_RECORDER_LEAST_SQUARES_H
 
 #include <fstream>
+#include <string>
 #include "Least_squares_solver.hpp"
 #include "Recorder.hpp"
 
@@ -29,10 +30,13 @@ class Recorder_least_squares : public Recorder {
 private:
   Least_squares_solver* solver;
   std::ofstream output_file;
-  void write_file_line(int function_evaluations, clock_t print_time, const double* x, double f, double* residuals);
+  double* reference_residuals; // Only used for the RESIDUALS_DELTA_FROM_BEST policy.
+  std::string best_file_string; // The line for the best function evaluation so far, which finalize() copies to the bottom of the file.
+  void compose_file_line(std::string& file_string, int function_evaluations, clock_t print_time, const double* x, double f, double* residuals);
 
 public:
   Recorder_least_squares(Least_squares_solver*);
+  ~Recorder_least_squares();
   void init();
   void record_function_evaluation(int function_evaluations, clock_t print_time, const double* x, double f);
   void finalize();
@@ -0,0 +1,99 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <stdexcept>
+#include <mpi.h>
+#include "mango.hpp"
+
+mango::Shared_data::Shared_data() {
+  window = MPI_WIN_NULL;
+  comm_node = MPI_COMM_NULL;
+  comm_node_leaders = MPI_COMM_NULL;
+  pointer = NULL;
+  N_bytes = 0;
+}
+
+mango::Shared_data::~Shared_data() {
+  // Objects are often destroyed after MPI_Finalize, in which case MPI resources can no longer be freed.
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (!finalized) release();
+}
+
+void mango::Shared_data::release() {
+  if (window != MPI_WIN_NULL) {
+    MPI_Win_unlock_all(window);
+    MPI_Win_free(&window);
+  }
+  if (comm_node_leaders != MPI_COMM_NULL) MPI_Comm_free(&comm_node_leaders);
+  pointer = NULL;
+  N_bytes = 0;
+}
+
+void mango::Shared_data::allocate(MPI_Partition& mpi_partition, MPI_Aint N_bytes_in) {
+  release();
+  MPI_Comm comm_world = mpi_partition.get_comm_world();
+  comm_node = mpi_partition.get_comm_node();
+  int rank_world, rank_node;
+  MPI_Comm_rank(comm_world, &rank_world);
+  MPI_Comm_rank(comm_node, &rank_node);
+
+  N_bytes = N_bytes_in;
+  MPI_Bcast(&N_bytes, 1, MPI_AINT, 0, comm_world);
+  if (N_bytes < 0) throw std::runtime_error("Error in mango::Shared_data::allocate. N_bytes must be >= 0.");
+
+  // The first process on each node allocates the whole segment, and the others attach to it.
+  // Since comm_node is ordered by rank in comm_world, proc0_world is the first process on its node.
+  MPI_Aint size = (rank_node == 0) ? N_bytes : 0;
+  int disp_unit;
+  if (MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, comm_node, &pointer, &window) != MPI_SUCCESS)
+    throw std::runtime_error("Error in mango::Shared_data::allocate. MPI_Win_allocate_shared failed.");
+  MPI_Win_shared_query(window, 0, &size, &disp_unit, &pointer);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+
+  MPI_Comm_split(comm_world, (rank_node == 0 ? 0 : MPI_UNDEFINED), rank_world, &comm_node_leaders);
+}
+
+void mango::Shared_data::share() {
+  if (window == MPI_WIN_NULL) throw std::runtime_error("Error in mango::Shared_data::share. allocate() must be called first.");
+
+  // Broadcast from proc0_world to the first process on every other node. Datasets can exceed the
+  // range of an int count, so the data are sent in chunks.
+  if (comm_node_leaders != MPI_COMM_NULL) {
+    const MPI_Aint chunk = 1 << 30;
+    char* bytes = (char*) pointer;
+    for (MPI_Aint offset = 0; offset < N_bytes; offset += chunk) {
+      MPI_Aint count = (N_bytes - offset < chunk) ? (N_bytes - offset) : chunk;
+      MPI_Bcast(&bytes[offset], (int) count, MPI_BYTE, 0, comm_node_leaders);
+    }
+  }
+
+  // Make the data visible to all processes on each node.
+  MPI_Win_sync(window);
+  MPI_Barrier(comm_node);
+  MPI_Win_sync(window);
+}
+
+void* mango::Shared_data::get_pointer() {
+  return pointer;
+}
+
+MPI_Aint mango::Shared_data::get_N_bytes() {
+  return N_bytes;
+}
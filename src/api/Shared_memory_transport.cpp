@@ -0,0 +1,94 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <stdexcept>
+#include <mpi.h>
+#include "Shared_memory_transport.hpp"
+
+mango::Shared_memory_transport::Shared_memory_transport(MPI_Comm comm_group_leaders_in) {
+  comm_group_leaders = comm_group_leaders_in;
+  int rank_group_leaders, rank_node;
+  MPI_Comm_rank(comm_group_leaders, &rank_group_leaders);
+
+  // Group the leaders by node. Using rank_group_leaders as the key makes proc0_world the representative of its node.
+  MPI_Comm_split_type(comm_group_leaders, MPI_COMM_TYPE_SHARED, rank_group_leaders, MPI_INFO_NULL, &comm_node);
+  MPI_Comm_rank(comm_node, &rank_node);
+  MPI_Comm_split(comm_group_leaders, (rank_node == 0 ? 0 : MPI_UNDEFINED), rank_group_leaders, &comm_representatives);
+
+  window = MPI_WIN_NULL;
+  buffer = NULL;
+  capacity = 0;
+}
+
+mango::Shared_memory_transport::~Shared_memory_transport() {
+  // Problem objects are often destroyed after MPI_Finalize, in which case MPI resources can no longer be freed.
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (finalized) return;
+  free_window();
+  if (comm_representatives != MPI_COMM_NULL) MPI_Comm_free(&comm_representatives);
+  MPI_Comm_free(&comm_node);
+}
+
+void mango::Shared_memory_transport::free_window() {
+  if (window == MPI_WIN_NULL) return;
+  MPI_Win_unlock_all(window);
+  MPI_Win_free(&window);
+  buffer = NULL;
+  capacity = 0;
+}
+
+MPI_Comm mango::Shared_memory_transport::get_comm_group_leaders() {
+  return comm_group_leaders;
+}
+
+MPI_Comm mango::Shared_memory_transport::get_comm_representatives() {
+  return comm_representatives;
+}
+
+bool mango::Shared_memory_transport::is_representative() {
+  return (comm_representatives != MPI_COMM_NULL);
+}
+
+double* mango::Shared_memory_transport::reserve(MPI_Aint N_doubles) {
+  // Returns a pointer to a node-shared buffer of at least N_doubles doubles. The window is only reallocated when it must grow,
+  // so all the group leaders must call this subroutine with the same N_doubles.
+  if (N_doubles <= capacity) return buffer;
+  free_window();
+
+  // The representative allocates the whole buffer, so the memory is contiguous; the other leaders attach to it.
+  int rank_node, disp_unit;
+  MPI_Aint size;
+  MPI_Comm_rank(comm_node, &rank_node);
+  size = (rank_node == 0) ? N_doubles * sizeof(double) : 0;
+  if (MPI_Win_allocate_shared(size, sizeof(double), MPI_INFO_NULL, comm_node, &buffer, &window) != MPI_SUCCESS)
+    throw std::runtime_error("Error in mango::Shared_memory_transport::reserve. MPI_Win_allocate_shared failed.");
+  MPI_Win_shared_query(window, 0, &size, &disp_unit, &buffer);
+  // Keep a passive-target epoch open for the lifetime of the window, using MPI_Win_sync and barriers for synchronization.
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+  capacity = N_doubles;
+  return buffer;
+}
+
+void mango::Shared_memory_transport::synchronize() {
+  // Make writes to the shared buffer by any leader on this node visible to all the other leaders on this node.
+  MPI_Win_sync(window);
+  MPI_Barrier(comm_node);
+  MPI_Win_sync(window);
+}
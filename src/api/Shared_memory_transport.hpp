@@ -0,0 +1,53 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#ifndef MANGO_SHARED_MEMORY_TRANSPORT_H
+#define MANGO_SHARED_MEMORY_TRANSPORT_H
+
+#include <mpi.h>
+
+namespace mango {
+
+  // Holds the communicators and MPI-3 shared-memory window used by evaluate_set_in_parallel() when the
+  // group leaders on each node exchange state vectors and results through a node-shared buffer.
+  // The group leaders on a node form comm_node, and rank 0 of each comm_node is the node's representative,
+  // the only one that communicates with other nodes. The constructor is collective over all the group leaders,
+  // and reserve() and synchronize() are collective over the group leaders on each node.
+  class Shared_memory_transport {
+  private:
+    MPI_Comm comm_group_leaders;
+    MPI_Comm comm_node;
+    MPI_Comm comm_representatives;
+    MPI_Win window;
+    double* buffer;
+    MPI_Aint capacity;
+    void free_window();
+
+  public:
+    Shared_memory_transport(MPI_Comm comm_group_leaders);
+    ~Shared_memory_transport();
+    MPI_Comm get_comm_group_leaders();
+    MPI_Comm get_comm_representatives();
+    bool is_representative();
+    double* reserve(MPI_Aint N_doubles);
+    void synchronize();
+  };
+
+}
+
+#endif
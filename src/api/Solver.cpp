@@ -19,6 +19,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <cassert>
+#include <chrono>
 #include "mango.hpp"
 #include "Solver.hpp"
 #include "Recorder_standard.hpp"
@@ -32,6 +33,11 @@ mango::Solver::Solver(Problem* problem_in, int N_parameters_in) {
   // Defaults are set in the following lines:
   verbose = 0;
   objective_function = NULL;
+  batch_objective_function = NULL;
+  async_start_function = NULL;
+  async_poll_function = NULL;
+  max_async_evaluations = 1000;
+  async_poll_interval = 0.1;
   function_evaluations = 0;
   argc = 1;
   argv = NULL;
@@ -48,6 +54,17 @@ mango::Solver::Solver(Problem* problem_in, int N_parameters_in) {
   problem = problem_in;
   recorder = new Recorder_standard(this);
   N_line_search = 0;
+  N_threads = 1;
+  use_shared_memory = false;
+  shared_memory_transport = NULL;
+  worker_function = NULL;
+  dynamic_layouts = false;
+  in_session = false;
+  random_seed = -1;
+  stop_requested = false;
+  metrics_filename = "";
+  metrics_interval = 15.0;
+  metrics = new Metrics_exporter(this);
 }
 
 // Constructor with no arguments, used only for unit tests
@@ -55,6 +72,20 @@ mango::Solver::Solver() {
   //  N_parameters = 1;
   //best_state_vector = new double[1];
   recorder = new Recorder();
+  batch_objective_function = NULL;
+  async_start_function = NULL;
+  async_poll_function = NULL;
+  max_async_evaluations = 1000;
+  async_poll_interval = 0.1;
+  N_threads = 1;
+  use_shared_memory = false;
+  shared_memory_transport = NULL;
+  worker_function = NULL;
+  dynamic_layouts = false;
+  in_session = false;
+  random_seed = -1;
+  stop_requested = false;
+  metrics = new Metrics_exporter(this);
 
   // We need a Problem to exist that is connected to this Solver, so create one.
   problem = new Problem(1,NULL,NULL,1,NULL);
@@ -66,6 +97,8 @@ mango::Solver::Solver() {
 // Destructor
 mango::Solver::~Solver() {
   delete[] best_state_vector;
+  delete metrics;
+  if (shared_memory_transport != NULL) delete shared_memory_transport;
 }
 
 void mango::Solver::objective_to_vector_function(int* N_parameters_arg, const double* state_vector_arg, int* N_terms, double* results, int* failed, mango::Problem* problem_arg, void* user_data_arg) {
@@ -79,6 +112,40 @@ void mango::Solver::objective_to_vector_function(int* N_parameters_arg, const do
   //objective_function(N_parameters_arg, state_vector_arg, results, failed, problem_arg, user_data_arg);
 }
 
+void mango::Solver::batch_objective_to_batch_vector_function(int* N_parameters_arg, int* N_points, const double* state_vectors_arg, int* N_terms, double* results, int* failures, mango::Problem* problem_arg, void* user_data_arg) {
+  // Note that this method is static, so there is no "this".
+  assert(*N_terms == 1);
+  problem_arg->get_solver()->batch_objective_function(N_parameters_arg, N_points, state_vectors_arg, results, failures, problem_arg, user_data_arg);
+}
+
+void mango::Solver::evaluate_without_recording(const double* x, bool* failed) {
+  // Call the user's objective function, without counting or recording the evaluation.
+  double f;
+  int failed_int;
+  objective_function(&N_parameters, x, &f, &failed_int, problem, user_data);
+  *failed = (failed_int != 0);
+}
+
+unsigned int mango::Solver::broadcast_random_seed(MPI_Comm comm) {
+  // Returns random_seed if it is >= 0. Otherwise the seed is taken from the clock on rank 0 of comm and broadcast,
+  // so all processes in comm generate the same random numbers, but the numbers differ from run to run.
+  if (random_seed >= 0) return random_seed;
+  unsigned int seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+  MPI_Bcast(&seed, 1, MPI_UNSIGNED, 0, comm);
+  return seed;
+}
+
+bool mango::Solver::is_user_function(vector_function_type vector_function) {
+  // Returns true if vector_function evaluates the user's objective function, rather than some other function.
+  return (vector_function == &objective_to_vector_function);
+}
+
+mango::batch_vector_function_type mango::Solver::get_batch_function(vector_function_type vector_function) {
+  // Returns the batch version of vector_function if the user has supplied one, or NULL otherwise.
+  if (is_user_function(vector_function) && batch_objective_function != NULL) return &batch_objective_to_batch_vector_function;
+  return NULL;
+}
+
 void mango::Solver::finite_difference_gradient(const double* state_vector, double* base_case_objective_function, double* gradient) {
   finite_difference_Jacobian(objective_to_vector_function, 1, state_vector, base_case_objective_function, gradient);
 }
@@ -21,10 +21,14 @@
 
 #include <mpi.h>
 #include <string>
+#include <vector>
+#include <functional>
 #include <ctime>
 #include "mango.hpp"
 #include "Package.hpp"
 #include "Recorder.hpp"
+#include "Metrics_exporter.hpp"
+#include "Shared_memory_transport.hpp"
 
 namespace mango {
 
@@ -42,6 +46,11 @@ namespace mango {
     algorithm_type algorithm;
     int N_parameters;
     objective_function_type objective_function;
+    batch_objective_function_type batch_objective_function;
+    async_start_function_type async_start_function;
+    async_poll_function_type async_poll_function;
+    int max_async_evaluations;
+    double async_poll_interval;
     int function_evaluations;
     int argc;
     char** argv;
@@ -66,20 +75,55 @@ namespace mango {
     Problem* problem;
     Recorder* recorder;
     int N_line_search;
+    int N_threads;
+    std::vector<observer_function_type> observers;
+    std::vector<void*> observer_data;
+    std::string metrics_filename;
+    double metrics_interval;
+    Metrics_exporter* metrics;
+    bool use_shared_memory;
+    Shared_memory_transport* shared_memory_transport;
+    worker_function_type worker_function;
+    bool dynamic_layouts;
+    bool in_session;
+    std::vector<double> session_bounds;
+    int random_seed;
+    bool stop_requested; // Set on proc0_world, e.g. by an observer, to ask a MANGO algorithm to stop after the current set of evaluations.
 
     Solver(Problem*, int);
     ~Solver();
 
     virtual double optimize(MPI_Partition*);
     virtual void init_optimization();
+    void broadcast_settings();
+    void session_loop();
     virtual void objective_function_wrapper(const double*, double*, bool*); 
     virtual void finite_difference_gradient(const double*, double*, double*);
     virtual bool record_function_evaluation(const double*, double, bool); // Called from objective_function_wrapper
     virtual void record_function_evaluation_pointer(const double*, double*, bool); // Called from evaluate_set_in_parallel
+    virtual void notify_observers(const double*, double, bool, clock_t); // Called from record_function_evaluation
+    virtual void evaluate_without_recording(const double*, bool*); // Called from Problem::calibrate_worker_groups
 
+    void set_layout(bool);
+    void worker_loop();
     void finite_difference_Jacobian(vector_function_type, int, const double*, double*, double*);
     void evaluate_set_in_parallel(vector_function_type, int, int, double*, double*, bool*);
+    virtual void evaluate_objective_set_in_parallel(int, double*, double*);
+    void broadcast_stop_requested();
+    void evaluate_asynchronously(vector_function_type, int, int, std::function<bool(int, double*)>, std::function<void(int, const double*, double*, bool)>);
+    virtual void evaluate_objective_asynchronously(int, std::function<bool(int, double*)>, std::function<void(int, const double*, double)>);
+    void evaluate_set_with_shared_memory(vector_function_type, int, int, double*, double*, int*);
+    void evaluate_points(vector_function_type, int, std::vector<int>&, double*, double*, int*);
+    void evaluate_points_with_threads(vector_function_type, int, std::vector<int>&, double*, double*, int*);
+    void evaluate_points_async(int, std::vector<int>&, double*, double*, int*);
+    void broadcast_initial_condition(double*);
+    void broadcast_bound_constraints(std::vector<double>&, std::vector<double>&);
+    unsigned int broadcast_random_seed(MPI_Comm);
+    static void project_onto_bounds(const std::vector<double>&, const std::vector<double>&, double*);
+    virtual batch_vector_function_type get_batch_function(vector_function_type);
+    virtual bool is_user_function(vector_function_type);
     static void objective_to_vector_function(int*, const double*, int*, double*, int*, mango::Problem*, void*);
+    static void batch_objective_to_batch_vector_function(int*, int*, const double*, int*, double*, int*, mango::Problem*, void*);
   };
 
 }
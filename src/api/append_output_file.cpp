@@ -0,0 +1,49 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "Recorder.hpp"
+
+std::string mango::append_output_file(std::ofstream& output_file, const std::string& filename, bool write_header, int first_evaluation) {
+  // Both the standard and least-squares recorders write 5 header lines before the function evaluations.
+  const int N_header_lines = 5;
+  std::ifstream input_file(filename.c_str());
+  if (!input_file.is_open()) {
+    std::cerr << "output file: " << filename << std::endl;
+    throw std::runtime_error("Error in mango::append_output_file. Unable to open the output file of one solve.");
+  }
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(input_file, line)) lines.push_back(line);
+  input_file.close();
+  if (lines.size() <= N_header_lines) return "";
+
+  if (write_header) {
+    for (int j = 0; j < N_header_lines; j++) output_file << lines[j] << std::endl;
+  }
+  for (int j = N_header_lines; j < (int) lines.size() - 1; j++) {
+    std::string::size_type comma = lines[j].find(',');
+    output_file << std::setw(6) << std::right << first_evaluation + j - N_header_lines << lines[j].substr(comma) << std::endl;
+  }
+  return lines.back();
+}
@@ -0,0 +1,57 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "mpi.h"
+#include "mango.hpp"
+#include "Solver.hpp"
+
+// These subroutines are used by the constructors of MANGO's own algorithms, which run on all group leaders.
+
+void mango::Solver::broadcast_initial_condition(double* x) {
+  // x should have been allocated with size N_parameters. On exit it holds proc0_world's initial condition on all group leaders.
+  if (mpi_partition->get_proc0_world()) {
+    for (int j = 0; j < N_parameters; j++) x[j] = state_vector[j];
+  }
+  MPI_Bcast(x, N_parameters, MPI_DOUBLE, 0, mpi_partition->get_comm_group_leaders());
+}
+
+void mango::Solver::broadcast_bound_constraints(std::vector<double>& lower_bounds_out, std::vector<double>& upper_bounds_out) {
+  // On exit, lower_bounds_out and upper_bounds_out hold proc0_world's bound constraints on all group leaders.
+  lower_bounds_out.resize(N_parameters);
+  upper_bounds_out.resize(N_parameters);
+  if (mpi_partition->get_proc0_world()) {
+    for (int j = 0; j < N_parameters; j++) {
+      lower_bounds_out[j] = lower_bounds[j];
+      upper_bounds_out[j] = upper_bounds[j];
+    }
+  }
+  MPI_Bcast(lower_bounds_out.data(), N_parameters, MPI_DOUBLE, 0, mpi_partition->get_comm_group_leaders());
+  MPI_Bcast(upper_bounds_out.data(), N_parameters, MPI_DOUBLE, 0, mpi_partition->get_comm_group_leaders());
+  for (int j = 0; j < N_parameters; j++) {
+    if (!(upper_bounds_out[j] > lower_bounds_out[j]))
+      throw std::runtime_error("Error! " + algorithms[algorithm].name + " requires each upper bound to be larger than the corresponding lower bound.");
+  }
+}
+
+void mango::Solver::project_onto_bounds(const std::vector<double>& lower_bounds_in, const std::vector<double>& upper_bounds_in, double* point) {
+  // Project a point onto the box defined by the bound constraints. If the bounds are empty, there are no bound constraints, and the point is unchanged.
+  for (size_t j = 0; j < lower_bounds_in.size(); j++) point[j] = std::min(upper_bounds_in[j], std::max(lower_bounds_in[j], point[j]));
+}
@@ -0,0 +1,122 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <stdexcept>
+#include <mpi.h>
+#include "mango.hpp"
+#include "Solver.hpp"
+
+void mango::Problem::calibrate_worker_groups(MPI_Comm mpi_comm_world, worker_function_type worker, std::string log_filename, int N_evaluations) {
+  // All processes in mpi_comm_world should call this subroutine.
+
+  if (N_evaluations < 1) throw std::runtime_error("Error in mango::Problem::calibrate_worker_groups. N_evaluations must be >= 1.");
+  if (solver->algorithm < 0 || solver->algorithm >= NUM_ALGORITHMS) throw std::runtime_error("Error in mango::Problem::calibrate_worker_groups. Invalid algorithm.");
+  if (!algorithms[solver->algorithm].parallel) {
+    // There is nothing to calibrate.
+    mpi_init(mpi_comm_world);
+    return;
+  }
+
+  int N_procs_world;
+  MPI_Comm_size(mpi_comm_world, &N_procs_world);
+  int N_parameters = solver->N_parameters;
+  MPI_Bcast(&N_parameters, 1, MPI_INT, 0, mpi_comm_world);
+
+  // Number of points the algorithm evaluates concurrently in each step:
+  int batch_size;
+  if (algorithms[solver->algorithm].uses_derivatives) {
+    batch_size = solver->centered_differences ? 2 * N_parameters + 1 : N_parameters + 1;
+  } else {
+    // Algorithms such as HOPSPACK keep every worker group busy, so throughput is what matters.
+    batch_size = N_procs_world;
+  }
+
+  // Candidates are the numbers of worker groups that divide the processes evenly. More groups than the batch size would be idle.
+  std::vector<int> candidates;
+  for (int N = 1; N <= N_procs_world && N <= batch_size; N++) {
+    if (N_procs_world % N == 0) candidates.push_back(N);
+  }
+
+  std::vector<double> evaluation_times(candidates.size());
+  std::vector<double> predicted_times(candidates.size());
+  int best = 0;
+  bool failed;
+  for (int j = 0; j < candidates.size(); j++) {
+    if (j == 0) {
+      mpi_partition.set_N_worker_groups(candidates[j]);
+      mpi_partition.init(mpi_comm_world);
+    } else {
+      mpi_partition.repartition(candidates[j]);
+    }
+    MPI_Bcast(solver->state_vector, N_parameters, MPI_DOUBLE, 0, mpi_partition.get_comm_world());
+
+    // Every group leader evaluates the function at the same time, as during a real batch.
+    double time_per_evaluation = 0;
+    MPI_Barrier(mpi_partition.get_comm_world());
+    if (mpi_partition.get_proc0_worker_groups()) {
+      double start_time = MPI_Wtime();
+      for (int k = 0; k < N_evaluations; k++) solver->evaluate_without_recording(solver->state_vector, &failed);
+      time_per_evaluation = (MPI_Wtime() - start_time) / N_evaluations;
+      mpi_partition.stop_workers();
+    } else {
+      while (mpi_partition.continue_worker_loop()) {
+	if (worker != NULL) worker(this, solver->user_data);
+      }
+    }
+    // The slowest group determines the time for a batch.
+    MPI_Allreduce(MPI_IN_PLACE, &time_per_evaluation, 1, MPI_DOUBLE, MPI_MAX, mpi_partition.get_comm_world());
+    evaluation_times[j] = time_per_evaluation;
+
+    int N_rounds = (batch_size + candidates[j] - 1) / candidates[j];
+    if (solver->algorithm == MANGO_LEVENBERG_MARQUARDT) {
+      // Each iteration also evaluates a line search, which by default has one point per worker group.
+      int N_line_search = (solver->N_line_search > 0) ? solver->N_line_search : candidates[j];
+      N_rounds += (N_line_search + candidates[j] - 1) / candidates[j];
+    }
+    predicted_times[j] = N_rounds * time_per_evaluation;
+    if (predicted_times[j] < predicted_times[best]) best = j;
+  }
+
+  if (best != candidates.size() - 1) mpi_partition.repartition(candidates[best]);
+
+  if (mpi_partition.get_proc0_world()) {
+    if (solver->verbose > 0) std::cout << "Calibration chose N_worker_groups = " << candidates[best] << std::endl;
+    if (log_filename != "") {
+      std::ofstream log_file(log_filename.c_str());
+      if (!log_file.is_open()) {
+	std::cerr << "Calibration log file: " << log_filename << std::endl;
+	throw std::runtime_error("Error! Unable to open calibration log file.");
+      }
+      log_file << "N_procs_world = " << N_procs_world << ", algorithm = " << algorithms[solver->algorithm].name
+	       << ", points per batch = " << batch_size << std::endl;
+      log_file << "N_worker_groups, N_procs_per_group, time_per_evaluation, predicted_time_per_iteration" << std::endl;
+      log_file << std::scientific << std::setprecision(6);
+      for (int j = 0; j < candidates.size(); j++) {
+	log_file << std::setw(15) << candidates[j] << ", " << std::setw(17) << N_procs_world / candidates[j] << ", "
+		 << std::setw(19) << evaluation_times[j] << ", " << std::setw(28) << predicted_times[j] << std::endl;
+      }
+      log_file << "Chosen N_worker_groups = " << candidates[best] << std::endl;
+      log_file.close();
+    }
+  }
+}
@@ -0,0 +1,203 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <list>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include "mpi.h"
+#include "mango.hpp"
+#include "Least_squares_solver.hpp"
+
+namespace {
+  // Message tags used between proc0_world and the other group leaders in evaluate_asynchronously():
+  const int TAG_POINT = 101;
+  const int TAG_RESULT = 102;
+  const int TAG_STOP = 103;
+  // Each group leader other than proc0_world is given up to this many points at a time, so it can start its next
+  // evaluation immediately even if proc0_world is busy with an evaluation of its own.
+  const int QUEUE_DEPTH = 2;
+}
+
+void mango::Solver::evaluate_asynchronously(vector_function_type vector_function, int N_terms, int lag,
+					    std::function<bool(int, double*)> next_point, std::function<void(int, const double*, double*, bool)> receive_results) {
+  // This subroutine evaluates points one at a time as worker groups become free, with no barrier between evaluations.
+  // All group leaders (but not workers) should call this subroutine.
+  // On proc0_world, next_point(index, x) is called each time a worker group can start another evaluation. It should fill x and return true,
+  // or return false if no more points should be evaluated. The points are given indices 0, 1, 2, ... in the order they are generated.
+  // When an evaluation finishes, receive_results(index, x, results, failed) is called on proc0_world, after the evaluation is recorded,
+  // so the algorithm can match the results to the point by index rather than by comparing coordinates. The other group leaders do not use next_point or receive_results.
+  // If lag < 0, results are received in the order the evaluations finish, so the sequence of points depends on timing.
+  // If lag >= 0, results are received in the order the points were generated, and the k-th point is generated after the results
+  // for exactly the first k - lag points have been received, so the sequence of points is independent of timing and of the number of worker groups.
+  // Any results still waiting when next_point returns false are received at the end.
+
+  MPI_Comm mpi_comm_group_leaders = mpi_partition->get_comm_group_leaders();
+  bool proc0_world = mpi_partition->get_proc0_world();
+  int N_worker_groups = mpi_partition->get_N_worker_groups();
+  int failed_int;
+  MPI_Status status;
+  std::vector<int> just_this_point(1, 0);
+  std::vector<double> message(std::max(1 + N_parameters, 2 + N_terms));
+
+  if (!proc0_world) {
+    // Evaluate points from proc0_world until told to stop.
+    std::vector<double> results(N_terms);
+    while (true) {
+      MPI_Recv(message.data(), 1 + N_parameters, MPI_DOUBLE, 0, MPI_ANY_TAG, mpi_comm_group_leaders, &status);
+      if (status.MPI_TAG == TAG_STOP) break;
+      memset(results.data(), 0, N_terms * sizeof(double));
+      evaluate_points(vector_function, N_terms, just_this_point, &message[1], results.data(), &failed_int);
+      // Send back the index of the point, then the failure flag, then the results:
+      message[1] = failed_int;
+      memcpy(&message[2], results.data(), N_terms * sizeof(double));
+      MPI_Send(message.data(), 2 + N_terms, MPI_DOUBLE, 0, TAG_RESULT, mpi_comm_group_leaders);
+    }
+    return;
+  }
+
+  // Only proc0_world gets here.
+  std::map<int, std::vector<double> > points;   // Points that have been generated but whose results have not been received, by index.
+  std::map<int, std::vector<double> > finished; // Results that have not yet been passed to the algorithm, by index.
+  std::map<int, bool> finished_failed;          // Failure flags for the results in finished, by index.
+  std::vector<int> N_in_flight(N_worker_groups, 0);
+  std::list<std::pair<MPI_Request, std::vector<double> > > sends;
+  int N_generated = 0, N_received = 0, N_total_in_flight = 0;
+  bool generating = true;
+  std::vector<double> results(N_terms);
+
+  // Pass a finished evaluation to the algorithm, after recording it.
+  auto deliver = [&](int index) {
+    bool failed = finished_failed[index];
+    record_function_evaluation_pointer(points[index].data(), finished[index].data(), failed);
+    receive_results(index, points[index].data(), finished[index].data(), failed);
+    points.erase(index);
+    finished.erase(index);
+    finished_failed.erase(index);
+    N_received++;
+  };
+
+  // Generate the next point, if allowed. Returns the index of the point, or -1.
+  auto generate = [&]() {
+    if (!generating) return -1;
+    if (lag >= 0) {
+      // The k-th point may depend on the results for exactly the first k - lag points, so deliver those first, and no others.
+      while (N_received < N_generated - lag) {
+	if (finished.find(N_received) == finished.end()) return -1;
+	deliver(N_received);
+      }
+    }
+    std::vector<double> x(N_parameters);
+    if (!next_point(N_generated, x.data())) {
+      generating = false;
+      return -1;
+    }
+    points[N_generated] = x;
+    return N_generated++;
+  };
+
+  // Store a finished evaluation. If lag < 0 it is passed to the algorithm immediately; otherwise generate() passes it on in order.
+  auto finish = [&](int index, double* point_results, bool failed) {
+    finished[index] = std::vector<double>(point_results, point_results + N_terms);
+    finished_failed[index] = failed;
+    if (lag < 0) deliver(index);
+  };
+
+  // Receive one result from another group leader, and give that group leader more work.
+  auto receive = [&](int source) {
+    MPI_Recv(message.data(), 2 + N_terms, MPI_DOUBLE, source, TAG_RESULT, mpi_comm_group_leaders, &status);
+    N_in_flight[status.MPI_SOURCE]--;
+    N_total_in_flight--;
+    finish((int) message[0], &message[2], message[1] != 0);
+  };
+
+  while (true) {
+    // Keep the other group leaders supplied with points:
+    for (int rank = 1; rank < N_worker_groups; rank++) {
+      while (N_in_flight[rank] < QUEUE_DEPTH) {
+	int index = generate();
+	if (index < 0) break;
+	std::vector<double> buffer(1 + N_parameters);
+	buffer[0] = index;
+	memcpy(&buffer[1], points[index].data(), N_parameters * sizeof(double));
+	sends.push_back(std::make_pair(MPI_Request(), buffer));
+	MPI_Isend(sends.back().second.data(), 1 + N_parameters, MPI_DOUBLE, rank, TAG_POINT, mpi_comm_group_leaders, &sends.back().first);
+	N_in_flight[rank]++;
+	N_total_in_flight++;
+      }
+    }
+    // Free the buffers of completed sends:
+    for (std::list<std::pair<MPI_Request, std::vector<double> > >::iterator it = sends.begin(); it != sends.end();) {
+      int completed;
+      MPI_Test(&it->first, &completed, MPI_STATUS_IGNORE);
+      it = completed ? sends.erase(it) : std::next(it);
+    }
+
+    // Handle any results that have already arrived:
+    int arrived;
+    MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, mpi_comm_group_leaders, &arrived, &status);
+    if (arrived) {
+      receive(status.MPI_SOURCE);
+      continue;
+    }
+
+    // Otherwise, proc0_world's own worker group evaluates a point:
+    int index = generate();
+    if (index >= 0) {
+      memset(results.data(), 0, N_terms * sizeof(double));
+      evaluate_points(vector_function, N_terms, just_this_point, points[index].data(), results.data(), &failed_int);
+      finish(index, results.data(), failed_int != 0);
+      continue;
+    }
+
+    // If there is nothing to evaluate here, wait for another group leader to finish.
+    if (N_total_in_flight > 0) {
+      receive(MPI_ANY_SOURCE);
+      continue;
+    }
+    break;
+  }
+
+  // Pass on any results that are still waiting, in order:
+  while (!finished.empty()) deliver(finished.begin()->first);
+
+  for (std::list<std::pair<MPI_Request, std::vector<double> > >::iterator it = sends.begin(); it != sends.end(); it++) MPI_Wait(&it->first, MPI_STATUS_IGNORE);
+  for (int rank = 1; rank < N_worker_groups; rank++) MPI_Send(message.data(), 1, MPI_DOUBLE, rank, TAG_STOP, mpi_comm_group_leaders);
+}
+
+void mango::Solver::evaluate_objective_asynchronously(int lag, std::function<bool(int, double*)> next_point, std::function<void(int, const double*, double)> receive_objective_function) {
+  // Evaluate the total objective function asynchronously, for algorithms that do not use the residuals. See evaluate_asynchronously().
+  // Failed evaluations, and evaluations that return a value that is not finite, give infinity.
+  evaluate_asynchronously(objective_to_vector_function, 1, lag, next_point,
+			  [&](int index, const double* x, double* results, bool failed) {
+			    receive_objective_function(index, x, (failed || !std::isfinite(results[0])) ? std::numeric_limits<double>::infinity() : results[0]);
+			  });
+}
+
+void mango::Least_squares_solver::evaluate_objective_asynchronously(int lag, std::function<bool(int, double*)> next_point, std::function<void(int, const double*, double)> receive_objective_function) {
+  // This method overrides mango::Solver::evaluate_objective_asynchronously().
+  // The residuals are evaluated, so they are recorded in the output file, and then combined into the total objective function.
+  evaluate_asynchronously(residual_function, N_terms, lag, next_point,
+			  [&](int index, const double* x, double* results, bool failed) {
+			    double objective_function = residuals_to_single_objective(results);
+			    receive_objective_function(index, x, (failed || !std::isfinite(objective_function)) ? std::numeric_limits<double>::infinity() : objective_function);
+			  });
+}
@@ -0,0 +1,70 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include "mango.hpp"
+#include "Solver.hpp"
+
+void mango::Solver::evaluate_points(vector_function_type vector_function, int N_terms, std::vector<int>& points, double* state_vectors, double* results, int* failures) {
+  // This subroutine evaluates vector_function at the state vectors with indices given by points, on this group leader only.
+  // state_vectors, results, and failures are the arrays for the complete set, with sizes N_parameters * N_set, N_terms * N_set, and N_set.
+  // For each point evaluated, failures[j_set] is set to the failure flag returned by the user function.
+  // Note that the use of &results[j_set*N_terms] below means that j_terms must be the least-signficiant dimension in results.
+
+  int N_points = points.size();
+  if (N_points == 0) return;
+
+  batch_vector_function_type batch_function = get_batch_function(vector_function);
+  if (async_start_function != NULL && is_user_function(vector_function)) {
+    // Start the evaluations, and poll until they are all done.
+    evaluate_points_async(N_terms, points, state_vectors, results, failures);
+
+  } else if (batch_function != NULL) {
+    // Evaluate all the points in a single call. The points are gathered into contiguous arrays first,
+    // since the points owned by a group leader are generally not adjacent in the set.
+    double* batch_state_vectors = new double[N_parameters * N_points];
+    double* batch_results = new double[N_terms * N_points];
+    int* batch_failures = new int[N_points];
+    memset(batch_failures, 0, N_points*sizeof(int));
+    for (int j_point = 0; j_point < N_points; j_point++) {
+      memcpy(&batch_state_vectors[j_point*N_parameters], &state_vectors[points[j_point]*N_parameters], N_parameters*sizeof(double));
+    }
+    batch_function(&N_parameters, &N_points, batch_state_vectors, &N_terms, batch_results, batch_failures, problem, user_data);
+    for (int j_point = 0; j_point < N_points; j_point++) {
+      memcpy(&results[points[j_point]*N_terms], &batch_results[j_point*N_terms], N_terms*sizeof(double));
+      failures[points[j_point]] = batch_failures[j_point];
+    }
+    delete[] batch_state_vectors;
+    delete[] batch_results;
+    delete[] batch_failures;
+
+  } else if (N_threads > 1) {
+    // Shared-memory backend: this group leader's share of the set is divided dynamically among threads.
+    evaluate_points_with_threads(vector_function, N_terms, points, state_vectors, results, failures);
+
+  } else {
+    for (int j_point = 0; j_point < N_points; j_point++) {
+      int j_set = points[j_point];
+      failures[j_set] = 0;
+      vector_function(&N_parameters, &state_vectors[j_set*N_parameters], &N_terms, &results[j_set*N_terms], &failures[j_set], problem, user_data);
+    }
+  }
+}
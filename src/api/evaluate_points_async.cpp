@@ -0,0 +1,72 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include "mango.hpp"
+#include "Solver.hpp"
+
+void mango::Solver::evaluate_points_async(int N_terms, std::vector<int>& points, double* state_vectors, double* results, int* failures) {
+  // This subroutine evaluates the user's function at the state vectors with indices given by points, using the
+  // asynchronous start/poll interface. Up to max_async_evaluations evaluations are in flight at any time.
+  // Each evaluation writes its results directly into the corresponding block of results. ASYNC_FAILED sets failures[j_set].
+
+  int N_points = points.size();
+  std::vector<int> handles(N_points);
+  std::list<int> in_flight; // Indices into points of the evaluations that have been started but have not finished.
+  int next_to_start = 0;
+  int N_finished = 0;
+  int status, j_set;
+
+  while (N_finished < N_points) {
+    // Start as many evaluations as allowed:
+    while (next_to_start < N_points && in_flight.size() < max_async_evaluations) {
+      j_set = points[next_to_start];
+      async_start_function(&N_parameters, &state_vectors[j_set*N_parameters], &N_terms, &handles[next_to_start], problem, user_data);
+      if (verbose > 0) std::cout << "Proc " << mpi_partition->get_rank_world() << " started asynchronous evaluation " << j_set << " with handle " << handles[next_to_start] << std::endl;
+      in_flight.push_back(next_to_start);
+      next_to_start++;
+    }
+
+    // Check which evaluations have finished:
+    bool any_finished = false;
+    std::list<int>::iterator it = in_flight.begin();
+    while (it != in_flight.end()) {
+      j_set = points[*it];
+      status = ASYNC_RUNNING;
+      async_poll_function(&handles[*it], &N_terms, &results[j_set*N_terms], &status, problem, user_data);
+      if (status == ASYNC_RUNNING) {
+	it++;
+      } else if (status == ASYNC_SUCCEEDED || status == ASYNC_FAILED) {
+	failures[j_set] = (status == ASYNC_FAILED) ? 1 : 0;
+	it = in_flight.erase(it);
+	N_finished++;
+	any_finished = true;
+      } else {
+	throw std::runtime_error("Error in mango::Solver::evaluate_points_async. The poll subroutine returned an invalid status.");
+      }
+    }
+
+    if (!any_finished && !in_flight.empty()) std::this_thread::sleep_for(std::chrono::duration<double>(async_poll_interval));
+  }
+}
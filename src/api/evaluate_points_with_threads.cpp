@@ -0,0 +1,67 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include "mango.hpp"
+#include "Solver.hpp"
+
+void mango::Solver::evaluate_points_with_threads(vector_function_type vector_function, int N_terms, std::vector<int>& points, double* state_vectors, double* results, int* failures) {
+  // This subroutine evaluates vector_function at the state vectors with indices given by points, using up to N_threads threads.
+  // Each thread evaluates the user function directly into the corresponding block of results and entry of failures, so no copies are made.
+  // Rather than assigning a fixed subset of points to each thread, each thread takes the next unclaimed point
+  // whenever it finishes one, so the load is balanced even if the cost of the user function varies between points.
+
+  int N_points = points.size();
+  if (N_points == 0) return;
+  int N_threads_to_use = (N_threads < N_points) ? N_threads : N_points;
+  if (verbose > 0) std::cout << "Proc " << mpi_partition->get_rank_world() << " is evaluating " << N_points << " points using " << N_threads_to_use << " threads." << std::endl;
+
+  std::atomic<int> next_point(0);
+  std::vector<std::exception_ptr> thread_exceptions(N_threads_to_use);
+
+  auto work = [&](int j_thread) {
+    // Each thread has its own copies of the arguments that the user function could modify.
+    int N_parameters_copy = N_parameters;
+    int N_terms_copy = N_terms;
+    try {
+      for (int j_point = next_point++; j_point < N_points; j_point = next_point++) {
+	int j_set = points[j_point];
+	failures[j_set] = 0;
+	vector_function(&N_parameters_copy, &state_vectors[j_set*N_parameters], &N_terms_copy, &results[j_set*N_terms], &failures[j_set], problem, user_data);
+      }
+    } catch (...) {
+      thread_exceptions[j_thread] = std::current_exception();
+      next_point = N_points; // Tell the other threads to stop.
+    }
+  };
+
+  // The calling thread does a share of the work too.
+  std::vector<std::thread> threads;
+  for (int j_thread = 1; j_thread < N_threads_to_use; j_thread++) threads.push_back(std::thread(work, j_thread));
+  work(0);
+  for (int j_thread = 0; j_thread < threads.size(); j_thread++) threads[j_thread].join();
+
+  for (int j_thread = 0; j_thread < N_threads_to_use; j_thread++) {
+    if (thread_exceptions[j_thread]) std::rethrow_exception(thread_exceptions[j_thread]);
+  }
+}
@@ -21,6 +21,8 @@
 #include <cstring>
 #include <cmath>
 #include <ctime>
+#include <limits>
+#include <vector>
 #include "mpi.h"
 #include "mango.hpp"
 #include "Least_squares_solver.hpp"
@@ -56,40 +58,153 @@ void mango::Solver::evaluate_set_in_parallel(vector_function_type vector_functio
   // Make sure all procs agree on the input data.
   MPI_Bcast(&N_set, 1, MPI_INT, 0, mpi_comm_group_leaders);
   MPI_Bcast(&N_parameters, 1, MPI_INT, 0, mpi_comm_group_leaders);
-  MPI_Bcast(state_vectors, N_set*N_parameters, MPI_DOUBLE, 0, mpi_comm_group_leaders);
-  // We didn't actually need to send all the state vectors to all procs, only the subset of the state vectors
-  // that a given proc will actually be responsible for. But the communication time is negligible compared
-  // to evaluations of the objective function usually, and the approach here has the benefit of simplicity.
-
-  // Each proc now evaluates the user function for its share of the set
-  int failed_int;
-  for(j_set=0; j_set < N_set; j_set++) {
-    if ((j_set % N_worker_groups) == mpi_rank_group_leaders) {
-      // Note that the use of &residual_functions[j_set*N_terms] in the next line means that j_terms must be the least-signficiant dimension in residual_functions.
-      vector_function(&N_parameters, &state_vectors[j_set*N_parameters], &N_terms, &results[j_set*N_terms], &failed_int, problem, user_data);
-      // I should record the failures here.
+  // Each point is evaluated by exactly one group leader, so the failure flags can be combined by a sum, like the results.
+  std::vector<int> failures_int(N_set, 0);
+  if (use_shared_memory) {
+    evaluate_set_with_shared_memory(vector_function, N_terms, N_set, state_vectors, results, failures_int.data());
+  } else {
+    MPI_Bcast(state_vectors, N_set*N_parameters, MPI_DOUBLE, 0, mpi_comm_group_leaders);
+    // We didn't actually need to send all the state vectors to all procs, only the subset of the state vectors
+    // that a given proc will actually be responsible for. But the communication time is negligible compared
+    // to evaluations of the objective function usually, and the approach here has the benefit of simplicity.
+
+    // Each proc now evaluates the user function for its share of the set
+    std::vector<int> my_points;
+    for(j_set=0; j_set < N_set; j_set++) {
+      if ((j_set % N_worker_groups) == mpi_rank_group_leaders) my_points.push_back(j_set);
     }
-  }
+    evaluate_points(vector_function, N_terms, my_points, state_vectors, results, failures_int.data());
 
-  // Send results back to the world master.
-  // Make sure not to reduce over MPI_COMM_WORLD, since then the residual function values will be multiplied by # of workers per worker group.
-  if (proc0_world) {
-    MPI_Reduce(MPI_IN_PLACE, results, N_set * N_terms, MPI_DOUBLE, MPI_SUM, 0, mpi_comm_group_leaders);
-  } else {
-    MPI_Reduce(results,      results, N_set * N_terms, MPI_DOUBLE, MPI_SUM, 0, mpi_comm_group_leaders);
+    // Send results back to the world master.
+    // Make sure not to reduce over MPI_COMM_WORLD, since then the residual function values will be multiplied by # of workers per worker group.
+    if (proc0_world) {
+      MPI_Reduce(MPI_IN_PLACE, results, N_set * N_terms, MPI_DOUBLE, MPI_SUM, 0, mpi_comm_group_leaders);
+      MPI_Reduce(MPI_IN_PLACE, failures_int.data(), N_set, MPI_INT, MPI_SUM, 0, mpi_comm_group_leaders);
+    } else {
+      MPI_Reduce(results,      results, N_set * N_terms, MPI_DOUBLE, MPI_SUM, 0, mpi_comm_group_leaders);
+      MPI_Reduce(failures_int.data(), failures_int.data(), N_set, MPI_INT, MPI_SUM, 0, mpi_comm_group_leaders);
+    }
   }
 
   // Record the results in order in the output file. At the same time, check for any best-yet values of the
   // objective function.
-  double total_objective_function;
-  bool failed = false;
-  clock_t now;
   if (proc0_world) {
+    metrics->set_worker_group_utilization(N_set);
     for(j_set=0; j_set<N_set; j_set++) {
-      //current_residuals = &residual_functions[j_set*N_terms];
-      //total_objective_function = residuals_to_single_objective(current_residuals);
-      record_function_evaluation_pointer(&state_vectors[j_set*N_parameters], &results[j_set*N_terms], failed);
+      failures[j_set] = (failures_int[j_set] != 0);
+      record_function_evaluation_pointer(&state_vectors[j_set*N_parameters], &results[j_set*N_terms], failures[j_set]);
     }
   }
   
 }
+
+void mango::Solver::evaluate_objective_set_in_parallel(int N_set, double* state_vectors, double* objective_functions) {
+  // Evaluate the total objective function at a set of points, for algorithms that do not use the residuals.
+  // All group leaders should call this subroutine, and all group leaders receive the results.
+  // Failed evaluations, and evaluations that return a value that is not finite, give infinity.
+  bool* failures = new bool[N_set];
+  memset(objective_functions, 0, N_set * sizeof(double));
+  evaluate_set_in_parallel(objective_to_vector_function, 1, N_set, state_vectors, objective_functions, failures);
+  if (mpi_partition->get_proc0_world()) {
+    for (int j_set = 0; j_set < N_set; j_set++) {
+      if (failures[j_set] || !std::isfinite(objective_functions[j_set])) objective_functions[j_set] = std::numeric_limits<double>::infinity();
+    }
+  }
+  MPI_Bcast(objective_functions, N_set, MPI_DOUBLE, 0, mpi_partition->get_comm_group_leaders());
+  broadcast_stop_requested();
+  delete[] failures;
+}
+
+void mango::Solver::broadcast_stop_requested() {
+  // Send stop_requested from proc0_world, where observers may set it while the results are recorded, to the other group leaders,
+  // so all group leaders of a MANGO algorithm make the same decision to stop.
+  int stop = stop_requested;
+  MPI_Bcast(&stop, 1, MPI_INT, 0, mpi_partition->get_comm_group_leaders());
+  stop_requested = (stop != 0);
+}
+
+void mango::Least_squares_solver::evaluate_objective_set_in_parallel(int N_set, double* state_vectors, double* objective_functions) {
+  // This method overrides mango::Solver::evaluate_objective_set_in_parallel().
+  // The residuals are evaluated, so they are recorded in the output file, and then combined into the total objective function.
+  double* shifted_residuals = new double[N_set * N_terms];
+  evaluate_shifted_residual_set_in_parallel(N_set, state_vectors, shifted_residuals, objective_functions);
+  delete[] shifted_residuals;
+}
+
+void mango::Least_squares_solver::evaluate_shifted_residual_set_in_parallel(int N_set, double* state_vectors, double* shifted_residuals, double* objective_functions) {
+  // Evaluate the residuals at a set of points, for algorithms that use the residuals.
+  // shifted_residuals should have been allocated with size N_terms * N_set, and receives (residuals - targets) / sigmas.
+  // objective_functions should have been allocated with size N_set, and receives the sum of squares of the shifted residuals.
+  // All group leaders should call this subroutine, and all group leaders receive the results.
+  // Failed evaluations, and evaluations that give a total objective function that is not finite, give an objective function of infinity.
+  bool* failures = new bool[N_set];
+  memset(shifted_residuals, 0, N_set * N_terms * sizeof(double));
+  evaluate_set_in_parallel(residual_function, N_terms, N_set, state_vectors, shifted_residuals, failures);
+  // Apply the transformation involving sigmas and targets on proc0_world, since only proc0_world has the residuals, and possibly only proc0_world has the targets and sigmas.
+  if (mpi_partition->get_proc0_world()) {
+    for (int j_set = 0; j_set < N_set; j_set++) {
+      objective_functions[j_set] = 0;
+      for (int j_term = 0; j_term < N_terms; j_term++) {
+	double shifted_residual = (shifted_residuals[j_set * N_terms + j_term] - targets[j_term]) / sigmas[j_term];
+	shifted_residuals[j_set * N_terms + j_term] = shifted_residual;
+	objective_functions[j_set] += shifted_residual * shifted_residual;
+      }
+      if (failures[j_set] || !std::isfinite(objective_functions[j_set])) objective_functions[j_set] = std::numeric_limits<double>::infinity();
+    }
+  }
+  MPI_Bcast(shifted_residuals, N_set * N_terms, MPI_DOUBLE, 0, mpi_partition->get_comm_group_leaders());
+  MPI_Bcast(objective_functions, N_set, MPI_DOUBLE, 0, mpi_partition->get_comm_group_leaders());
+  broadcast_stop_requested();
+  delete[] failures;
+}
+
+void mango::Solver::evaluate_set_with_shared_memory(vector_function_type vector_function, int N_terms, int N_set, double* state_vectors, double* results, int* failures) {
+  // This subroutine is used by evaluate_set_in_parallel() in place of the broadcast and reduction over all group leaders.
+  // The group leaders on each node share one buffer holding the state vectors, then the results, then the failure flags.
+  // Only the node representatives (which include proc0_world) communicate between nodes.
+
+  MPI_Comm mpi_comm_group_leaders = mpi_partition->get_comm_group_leaders();
+  bool proc0_world = mpi_partition->get_proc0_world();
+  int mpi_rank_group_leaders = mpi_partition->get_rank_group_leaders();
+  int N_worker_groups = mpi_partition->get_N_worker_groups();
+
+  // The communicators and window are created on first use, and recreated if the partition has changed.
+  if (shared_memory_transport != NULL && shared_memory_transport->get_comm_group_leaders() != mpi_comm_group_leaders) {
+    delete shared_memory_transport;
+    shared_memory_transport = NULL;
+  }
+  if (shared_memory_transport == NULL) shared_memory_transport = new Shared_memory_transport(mpi_comm_group_leaders);
+
+  double* shared_state_vectors = shared_memory_transport->reserve((MPI_Aint) N_set * (N_parameters + N_terms + 1));
+  double* shared_results = &shared_state_vectors[N_set * N_parameters];
+  // The failure flags are stored as doubles so they can be reduced together with the results.
+  double* shared_failures = &shared_results[N_set * N_terms];
+
+  if (shared_memory_transport->is_representative()) {
+    if (proc0_world) memcpy(shared_state_vectors, state_vectors, N_set * N_parameters * sizeof(double));
+    MPI_Bcast(shared_state_vectors, N_set * N_parameters, MPI_DOUBLE, 0, shared_memory_transport->get_comm_representatives());
+    // Results and failure flags for points evaluated on other nodes must be 0 for the reduction below.
+    memset(shared_results, 0, N_set * (N_terms + 1) * sizeof(double));
+  }
+  shared_memory_transport->synchronize();
+
+  // Each leader reads its share of the state vectors from the node's buffer, and writes its results directly into it.
+  std::vector<int> my_points;
+  for (int j_set=0; j_set < N_set; j_set++) {
+    if ((j_set % N_worker_groups) == mpi_rank_group_leaders) my_points.push_back(j_set);
+  }
+  std::vector<int> my_failures(N_set, 0);
+  evaluate_points(vector_function, N_terms, my_points, shared_state_vectors, shared_results, my_failures.data());
+  for (size_t j_point = 0; j_point < my_points.size(); j_point++) shared_failures[my_points[j_point]] = my_failures[my_points[j_point]];
+  shared_memory_transport->synchronize();
+
+  // Combine the results and failure flags of all nodes on proc0_world.
+  if (shared_memory_transport->is_representative()) {
+    std::vector<double> combined(proc0_world ? N_set * (N_terms + 1) : 0);
+    MPI_Reduce(shared_results, (proc0_world ? combined.data() : NULL), N_set * (N_terms + 1), MPI_DOUBLE, MPI_SUM, 0, shared_memory_transport->get_comm_representatives());
+    if (proc0_world) {
+      memcpy(results, combined.data(), N_set * N_terms * sizeof(double));
+      for (int j_set = 0; j_set < N_set; j_set++) failures[j_set] = (combined[N_set * N_terms + j_set] != 0) ? 1 : 0;
+    }
+  }
+}
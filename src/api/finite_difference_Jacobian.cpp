@@ -30,6 +30,9 @@ void mango::Solver::finite_difference_Jacobian(vector_function_type vector_funct
   // base_case_residual_function should have been allocated already, with size N_terms.
   // Jacobian should have been allocated already, with size N_parameters * N_terms.
 
+  // The set of points is evaluated concurrently, so switch to the wide layout if needed.
+  if (mpi_partition->get_proc0_world()) set_layout(false);
+
   // To simplify code in this file, make some copies of variables.
   MPI_Comm mpi_comm_group_leaders = mpi_partition->get_comm_group_leaders();
   bool proc0_world = mpi_partition->get_proc0_world();
@@ -33,7 +33,11 @@ void mango::Solver::group_leaders_loop() {
   while (keep_going) {
     // Wait for proc 0 to send us a message.
     MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
-    if (data < 0) {
+    if (data == -2) {
+      // proc0_world is switching to the deep layout, in which this proc is a worker.
+      mpi_partition->switch_layout();
+      worker_loop();
+    } else if (data < 0) {
       if (verbose > 0) std::cout << "proc " << mpi_partition->get_rank_world() << " (a group leader) is exiting." << std::endl;
       keep_going = false;
     } else {
@@ -45,3 +49,36 @@ void mango::Solver::group_leaders_loop() {
   delete[] state_vector;
   delete[] gradient;
 }
+
+void mango::Solver::worker_loop() {
+  // This loop is run by group leaders of the wide layout while the deep layout is in use.
+  // continue_worker_loop() returns false once the wide layout is restored, at which point this proc is a group leader again.
+  while (mpi_partition->continue_worker_loop()) {
+    if (worker_function != NULL) worker_function(problem, user_data);
+  }
+}
+
+void mango::Solver::set_layout(bool deep) {
+  // This method should only be called by proc0_world, while the other group leaders are in group_leaders_loop().
+  if (!dynamic_layouts || mpi_partition->get_deep() == deep) return;
+  if (verbose > 0) std::cout << "Switching to the " << (deep ? "deep" : "wide") << " layout." << std::endl;
+  if (deep) {
+    // Tell the other group leaders to switch layouts. When switching back, they are workers of the deep layout,
+    // so switch_layout() reaches them through comm_worker_groups instead.
+    int data = -2;
+    MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+  }
+  mpi_partition->switch_layout();
+}
+
+void mango::Solver::session_loop() {
+  // This loop is run during a session by the group leaders other than proc0_world (see Problem::begin_session()).
+  // Each solve started by proc0_world runs the same code that optimize() runs on these procs, without returning to the driver code.
+  int data;
+  while (true) {
+    MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+    if (data < 0) break;
+    if (verbose > 0) std::cout << "proc " << mpi_partition->get_rank_world() << " (a group leader) is starting a solve in the session." << std::endl;
+    optimize(mpi_partition);
+  }
+}
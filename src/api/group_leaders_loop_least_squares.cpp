@@ -33,7 +33,11 @@ void mango::Least_squares_solver::group_leaders_loop() {
   while (keep_going) {
     // Wait for proc 0 to send us a message that we should start.
     MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
-    if (data < 0) {
+    if (data == -2) {
+      // proc0_world is switching to the deep layout, in which this proc is a worker.
+      mpi_partition->switch_layout();
+      worker_loop();
+    } else if (data < 0) {
       if (verbose > 0) std::cout << "proc " << mpi_partition->get_rank_world() << 
 			 " (a group leader) is exiting." << std::endl;
       keep_going = false;
@@ -22,6 +22,7 @@
 //#include <cstring>
 #include <stdexcept>
 #include <ctime>
+#include <vector>
 #include "mango.hpp"
 #include "Solver.hpp"
 
@@ -36,20 +37,24 @@ void mango::Solver::init_optimization() {
   at_least_one_success = false;
   best_objective_function = std::numeric_limits<double>::quiet_NaN();
   best_function_evaluation = -1;
+  stop_requested = false;
   start_time = clock();
 
-  // To simplify code a bit...
-  MPI_Comm mpi_comm_group_leaders = mpi_partition->get_comm_group_leaders();
+  if (in_session && mpi_partition->get_proc0_world()) {
+    // Tell the other group leaders, which are waiting in session_loop(), to start another solve.
+    int data = 1;
+    MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+  }
 
   // Make sure that parameters used by the finite-difference gradient routine are the same for all group leaders:
-  MPI_Bcast(&N_parameters, 1, MPI_INT, 0, mpi_comm_group_leaders);
-  MPI_Bcast(&centered_differences, 1, MPI_C_BOOL, 0, mpi_comm_group_leaders);
-  MPI_Bcast(&finite_difference_step_size, 1, MPI_DOUBLE, 0, mpi_comm_group_leaders);
-  MPI_Bcast(&algorithm, 1, MPI_INT, 0, mpi_comm_group_leaders);
+  broadcast_settings();
   // 20200127 These next 2 lines should end up in Least_squares_data::optimize()?
   //  MPI_Bcast(&N_terms, 1, MPI_INT, 0, mpi_comm_group_leaders);
   //  MPI_Bcast(&least_squares, 1, MPI_C_BOOL, 0, mpi_comm_group_leaders);
 
+  // Layouts can only be switched when the group leaders other than proc0_world wait in group_leaders_loop() between finite-difference derivatives.
+  dynamic_layouts = mpi_partition->get_dynamic() && algorithms[algorithm].uses_derivatives && algorithms[algorithm].package != PACKAGE_MANGO;
+
   if (algorithms[algorithm].requires_bound_constraints && (!bound_constraints_set)) 
     throw std::runtime_error("Error! A MANGO algorithm was chosen that requires bound constraints, but bound constraints were not set.");
 
@@ -79,5 +84,62 @@ void mango::Solver::init_optimization() {
       ", max_function_and_gradient_evaluations = " << max_function_and_gradient_evaluations << std::endl;
   }
 
-  if (mpi_partition->get_proc0_world()) recorder->init();
+  if (mpi_partition->get_proc0_world()) {
+    recorder->init();
+    metrics->init();
+  }
+}
+
+void mango::Solver::broadcast_settings() {
+  // Send the settings from proc0_world to the other group leaders in a single message.
+  // During a session, only proc0_world calls the setters, so the initial state vector and bound constraints are sent as well.
+  MPI_Comm mpi_comm_group_leaders = mpi_partition->get_comm_group_leaders();
+  bool proc0_world = mpi_partition->get_proc0_world();
+
+  const int N_ints = 9;
+  int ints[N_ints] = {N_parameters, algorithm, N_threads, max_function_evaluations, N_line_search,
+		      centered_differences, use_shared_memory, bound_constraints_set, random_seed};
+  int N_doubles = 1 + (in_session ? 3 * N_parameters : 0);
+  int ints_size, doubles_size;
+  MPI_Pack_size(N_ints, MPI_INT, mpi_comm_group_leaders, &ints_size);
+  MPI_Pack_size(N_doubles, MPI_DOUBLE, mpi_comm_group_leaders, &doubles_size);
+  std::vector<char> buffer(ints_size + doubles_size);
+  int buffer_size = buffer.size();
+  int position = 0;
+
+  if (proc0_world) {
+    MPI_Pack(ints, N_ints, MPI_INT, buffer.data(), buffer_size, &position, mpi_comm_group_leaders);
+    MPI_Pack(&finite_difference_step_size, 1, MPI_DOUBLE, buffer.data(), buffer_size, &position, mpi_comm_group_leaders);
+    if (in_session) {
+      MPI_Pack(state_vector, N_parameters, MPI_DOUBLE, buffer.data(), buffer_size, &position, mpi_comm_group_leaders);
+      if (bound_constraints_set) {
+	MPI_Pack(lower_bounds, N_parameters, MPI_DOUBLE, buffer.data(), buffer_size, &position, mpi_comm_group_leaders);
+	MPI_Pack(upper_bounds, N_parameters, MPI_DOUBLE, buffer.data(), buffer_size, &position, mpi_comm_group_leaders);
+      }
+    }
+  }
+  MPI_Bcast(buffer.data(), buffer_size, MPI_PACKED, 0, mpi_comm_group_leaders);
+  if (proc0_world) return;
+
+  MPI_Unpack(buffer.data(), buffer_size, &position, ints, N_ints, MPI_INT, mpi_comm_group_leaders);
+  if (in_session && ints[0] != N_parameters) throw std::runtime_error("Error! N_parameters must be the same on all group leaders during a session.");
+  N_parameters = ints[0];
+  algorithm = (algorithm_type) ints[1];
+  N_threads = ints[2];
+  max_function_evaluations = ints[3];
+  N_line_search = ints[4];
+  centered_differences = (ints[5] != 0);
+  use_shared_memory = (ints[6] != 0);
+  bound_constraints_set = (ints[7] != 0);
+  random_seed = ints[8];
+  MPI_Unpack(buffer.data(), buffer_size, &position, &finite_difference_step_size, 1, MPI_DOUBLE, mpi_comm_group_leaders);
+  if (in_session) {
+    MPI_Unpack(buffer.data(), buffer_size, &position, state_vector, N_parameters, MPI_DOUBLE, mpi_comm_group_leaders);
+    if (bound_constraints_set) {
+      session_bounds.resize(2 * N_parameters);
+      MPI_Unpack(buffer.data(), buffer_size, &position, session_bounds.data(), 2 * N_parameters, MPI_DOUBLE, mpi_comm_group_leaders);
+      lower_bounds = session_bounds.data();
+      upper_bounds = session_bounds.data() + N_parameters;
+    }
+  }
 }
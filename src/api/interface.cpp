@@ -87,12 +87,24 @@ extern "C" {
     This->set_output_filename(filename);
   }
 
+  void mango_set_metrics_filename(mango::Problem *This, char filename[mango_interface_string_length]) {
+    This->set_metrics_filename(filename);
+  }
+
+  void mango_set_metrics_interval(mango::Problem *This, double* interval) {
+    This->set_metrics_interval(*interval);
+  }
+
   // For converting communicators between Fortran and C, see
   // https://www.mcs.anl.gov/research/projects/mpi/mpi-standard/mpi-report-2.0/node59.htm
   void mango_mpi_init(mango::Problem *This, MPI_Fint *comm) {
     This->mpi_init(MPI_Comm_f2c(*comm));
   }
 
+  void mango_calibrate_worker_groups(mango::Problem *This, MPI_Fint *comm, mango::worker_function_type worker, char log_filename[mango_interface_string_length], int* N_evaluations) {
+    This->calibrate_worker_groups(MPI_Comm_f2c(*comm), worker, log_filename, *N_evaluations);
+  }
+
   void mango_mpi_partition_set_custom(mango::Problem *This, MPI_Fint *comm_world, MPI_Fint *comm_group_leaders, MPI_Fint *comm_worker_groups) {
     This->mpi_partition.set_custom(MPI_Comm_f2c(*comm_world), MPI_Comm_f2c(*comm_group_leaders), MPI_Comm_f2c(*comm_worker_groups));
   }
@@ -101,6 +113,19 @@ extern "C" {
     This->mpi_partition.set_N_worker_groups(*N_worker_groups);
   }
 
+  void mango_mpi_partition_set_topology(mango::Problem *This, int* topology) {
+    if (*topology < mango::PARTITION_BY_RANK || *topology > mango::PARTITION_BY_NUMA) throw std::runtime_error("Error in interface.cpp mango_mpi_partition_set_topology: invalid topology");
+    This->mpi_partition.set_topology((mango::partition_topology_type)(*topology));
+  }
+
+  int mango_get_node(mango::Problem *This) {
+    return This->mpi_partition.get_node();
+  }
+
+  int mango_get_N_nodes(mango::Problem *This) {
+    return This->mpi_partition.get_N_nodes();
+  }
+
   int mango_get_N_worker_groups(mango::Problem *This) {
     return This->mpi_partition.get_N_worker_groups();
   }
@@ -215,6 +240,27 @@ extern "C" {
     }
   }
 
+  void mango_add_observer(mango::Problem *This, mango::observer_function_type observer, void* observer_data) {
+    This->add_observer(observer, observer_data);
+  }
+
+  void mango_set_batch_objective_function(mango::Problem *This, mango::batch_objective_function_type batch_objective_function) {
+    This->set_batch_objective_function(batch_objective_function);
+  }
+
+  void mango_set_batch_residual_function(mango::Least_squares_problem *This, mango::batch_vector_function_type batch_residual_function) {
+    This->set_batch_residual_function(batch_residual_function);
+  }
+
+  void mango_set_residual_storage(mango::Least_squares_problem *This, int* policy) {
+    if (*policy < mango::RESIDUALS_ALL || *policy > mango::RESIDUALS_DELTA_FROM_BEST) throw std::runtime_error("Error in interface.cpp mango_set_residual_storage: invalid policy");
+    This->set_residual_storage((mango::residual_storage_type)(*policy));
+  }
+
+  void mango_set_residual_storage_interval(mango::Least_squares_problem *This, int* interval) {
+    This->set_residual_storage_interval(*interval);
+  }
+
   void mango_set_user_data(mango::Problem *This, void* user_data) {
     This->set_user_data(user_data);
   }
@@ -223,6 +269,14 @@ extern "C" {
     This->mpi_partition.stop_workers();
   }
 
+  void mango_begin_session(mango::Problem *This) {
+    This->begin_session();
+  }
+
+  void mango_end_session(mango::Problem *This) {
+    This->end_session();
+  }
+
   void mango_mobilize_workers(mango::Problem *This) {
     This->mpi_partition.mobilize_workers();
   }
@@ -232,6 +286,19 @@ extern "C" {
     return (return_bool ? 1 : 0);
   }
 
+  void mango_mobilize_workers_with_data(mango::Problem *This, int* task, double* data) {
+    This->mpi_partition.mobilize_workers(*task, data);
+  }
+
+  int mango_continue_worker_loop_with_data(mango::Problem *This, int* task, double* data) {
+    int return_bool = This->mpi_partition.continue_worker_loop(task, data);
+    return (return_bool ? 1 : 0);
+  }
+
+  void mango_mpi_partition_set_command_size(mango::Problem *This, int* command_size) {
+    This->mpi_partition.set_command_size(*command_size);
+  }
+
   void mango_mpi_partition_write(mango::Problem *This, char filename[mango_interface_string_length]) {
     This->mpi_partition.write(filename);
   }
@@ -245,4 +312,208 @@ extern "C" {
     This->set_N_line_search(*N);
   }
 
+  void mango_set_N_threads(mango::Problem *This, int* N) {
+    This->set_N_threads(*N);
+  }
+
+  void mango_set_random_seed(mango::Problem *This, int* random_seed) {
+    This->set_random_seed(*random_seed);
+  }
+
+  void mango_set_shared_memory(mango::Problem *This, int* use_shared_memory_int) {
+    if (*use_shared_memory_int==1) {
+      This->set_shared_memory(true);
+    } else if (*use_shared_memory_int==0) {
+      This->set_shared_memory(false);
+    } else {
+      throw std::runtime_error("Error in interface.cpp mango_set_shared_memory");
+    }
+  }
+
+  void mango_mpi_partition_set_dynamic(mango::Problem *This, int* dynamic_int) {
+    if (*dynamic_int==1) {
+      This->mpi_partition.set_dynamic(true);
+    } else if (*dynamic_int==0) {
+      This->mpi_partition.set_dynamic(false);
+    } else {
+      throw std::runtime_error("Error in interface.cpp mango_mpi_partition_set_dynamic");
+    }
+  }
+
+  void mango_set_worker_function(mango::Problem *This, mango::worker_function_type worker_function) {
+    This->set_worker_function(worker_function);
+  }
+
+  mango::Shared_data *mango_shared_data_create(mango::Problem *This, long long* N_bytes) {
+    mango::Shared_data* shared_data = new mango::Shared_data();
+    shared_data->allocate(This->mpi_partition, (MPI_Aint)(*N_bytes));
+    return shared_data;
+  }
+
+  void mango_shared_data_share(mango::Shared_data *This) {
+    This->share();
+  }
+
+  void* mango_shared_data_get_pointer(mango::Shared_data *This) {
+    return This->get_pointer();
+  }
+
+  void mango_shared_data_destroy(mango::Shared_data *This) {
+    delete This;
+  }
+
+  mango::Ensemble *mango_ensemble_create() {
+    return new mango::Ensemble();
+  }
+
+  void mango_ensemble_add_problem(mango::Ensemble *This, mango::Problem *problem) {
+    This->add_problem(problem);
+  }
+
+  void mango_ensemble_set_N_worker_groups(mango::Ensemble *This, int* N_worker_groups) {
+    This->mpi_partition.set_N_worker_groups(*N_worker_groups);
+  }
+
+  void mango_ensemble_mpi_init(mango::Ensemble *This, MPI_Fint *comm) {
+    This->mpi_init(MPI_Comm_f2c(*comm));
+  }
+
+  void mango_ensemble_optimize(mango::Ensemble *This) {
+    This->optimize();
+  }
+
+  double mango_ensemble_get_optimum(mango::Ensemble *This, int* j_problem) {
+    return This->get_optimum(*j_problem);
+  }
+
+  int mango_ensemble_get_worker_group(mango::Ensemble *This, int* j_problem) {
+    return This->get_worker_group(*j_problem);
+  }
+
+  void mango_ensemble_destroy(mango::Ensemble *This) {
+    delete This;
+  }
+
+  mango::Multistart *mango_multistart_create(mango::Problem *problem) {
+    return new mango::Multistart(problem);
+  }
+
+  void mango_multistart_set_N_starts(mango::Multistart *This, int* N_starts) {
+    This->set_N_starts(*N_starts);
+  }
+
+  void mango_multistart_set_N_candidates(mango::Multistart *This, int* N_candidates) {
+    This->set_N_candidates(*N_candidates);
+  }
+
+  void mango_multistart_set_design(mango::Multistart *This, int* design) {
+    if (*design < mango::DESIGN_LATIN_HYPERCUBE || *design > mango::DESIGN_SOBOL) throw std::runtime_error("Error in interface.cpp mango_multistart_set_design: invalid design");
+    This->set_design((mango::design_type)(*design));
+  }
+
+  void mango_multistart_set_basin_radius(mango::Multistart *This, double* basin_radius) {
+    This->set_basin_radius(*basin_radius);
+  }
+
+  void mango_multistart_set_N_worker_groups(mango::Multistart *This, int* N_worker_groups) {
+    This->mpi_partition.set_N_worker_groups(*N_worker_groups);
+  }
+
+  void mango_multistart_mpi_init(mango::Multistart *This, MPI_Fint *comm) {
+    This->mpi_init(MPI_Comm_f2c(*comm));
+  }
+
+  double mango_multistart_optimize(mango::Multistart *This) {
+    return This->optimize();
+  }
+
+  int mango_multistart_get_N_starts(mango::Multistart *This) {
+    return This->get_N_starts();
+  }
+
+  double mango_multistart_get_optimum(mango::Multistart *This, int* j_start) {
+    return This->get_optimum(*j_start);
+  }
+
+  int mango_multistart_get_cut_off(mango::Multistart *This, int* j_start) {
+    return This->get_cut_off(*j_start);
+  }
+
+  int mango_multistart_get_function_evaluations(mango::Multistart *This, int* j_start) {
+    return This->get_function_evaluations(*j_start);
+  }
+
+  void mango_multistart_destroy(mango::Multistart *This) {
+    delete This;
+  }
+
+  mango::Portfolio *mango_portfolio_create(mango::Problem *problem) {
+    return new mango::Portfolio(problem);
+  }
+
+  void mango_portfolio_add_algorithm(mango::Portfolio *This, int* algorithm) {
+    if (*algorithm < 0 || *algorithm >= mango::NUM_ALGORITHMS) throw std::runtime_error("Error in interface.cpp mango_portfolio_add_algorithm: invalid algorithm");
+    This->add_algorithm((mango::algorithm_type)(*algorithm));
+  }
+
+  void mango_portfolio_add_algorithm_from_string(mango::Portfolio *This, char algorithm_name[mango_interface_string_length]) {
+    This->add_algorithm(std::string(algorithm_name));
+  }
+
+  void mango_portfolio_set_checkpoint_function_evaluations(mango::Portfolio *This, int* checkpoint_function_evaluations) {
+    This->set_checkpoint_function_evaluations(*checkpoint_function_evaluations);
+  }
+
+  void mango_portfolio_set_N_worker_groups(mango::Portfolio *This, int* N_worker_groups) {
+    This->mpi_partition.set_N_worker_groups(*N_worker_groups);
+  }
+
+  void mango_portfolio_mpi_init(mango::Portfolio *This, MPI_Fint *comm) {
+    This->mpi_init(MPI_Comm_f2c(*comm));
+  }
+
+  double mango_portfolio_optimize(mango::Portfolio *This) {
+    return This->optimize();
+  }
+
+  int mango_portfolio_get_N_algorithms(mango::Portfolio *This) {
+    return This->get_N_algorithms();
+  }
+
+  double mango_portfolio_get_optimum(mango::Portfolio *This, int* j_algorithm) {
+    return This->get_optimum(*j_algorithm);
+  }
+
+  int mango_portfolio_get_function_evaluations(mango::Portfolio *This, int* j_algorithm) {
+    return This->get_function_evaluations(*j_algorithm);
+  }
+
+  double mango_portfolio_get_elapsed_time(mango::Portfolio *This, int* j_algorithm) {
+    return This->get_elapsed_time(*j_algorithm);
+  }
+
+  int mango_portfolio_get_elimination(mango::Portfolio *This, int* j_algorithm) {
+    return This->get_elimination(*j_algorithm);
+  }
+
+  int mango_portfolio_get_winner(mango::Portfolio *This) {
+    return This->get_winner();
+  }
+
+  void mango_portfolio_destroy(mango::Portfolio *This) {
+    delete This;
+  }
+
+  void mango_set_async_functions(mango::Problem *This, mango::async_start_function_type start, mango::async_poll_function_type poll) {
+    This->set_async_functions(start, poll);
+  }
+
+  void mango_set_max_async_evaluations(mango::Problem *This, int* N) {
+    This->set_max_async_evaluations(*N);
+  }
+
+  void mango_set_async_poll_interval(mango::Problem *This, double* interval) {
+    This->set_async_poll_interval(*interval);
+  }
+
 }
@@ -22,6 +22,8 @@
 
 #include <mpi.h>
 #include <string>
+#include <vector>
+#include <mutex>
 
 //! This C++ namespace contains everything related to MANGO.
 namespace mango {
@@ -76,7 +78,15 @@ namespace mango {
     // <enum>
     // This section was automatically generated by ./update_algorithms
     MANGO_LEVENBERG_MARQUARDT,
+    MANGO_LBFGS,
+    MANGO_POUNDERS,
     MANGO_IMFIL,
+    MANGO_MULTIDIRECTIONAL_SEARCH,
+    MANGO_CMAES,
+    MANGO_DIFFERENTIAL_EVOLUTION,
+    MANGO_BAYESIAN_OPTIMIZATION,
+    MANGO_DIRECT,
+    MANGO_DIRECT_L,
     PETSC_NM,
     PETSC_POUNDERS,
     PETSC_BRGN,
@@ -126,7 +136,15 @@ namespace mango {
     // This section was automatically generated by ./update_algorithms
     // name,                            package,         least_squares, uses_derivatives, parallel, allows_bound_constraints, requires_bound_constraints
     {"mango_levenberg_marquardt",       PACKAGE_MANGO,   true,          true,             true,     false,                    false},
+    {"mango_lbfgs",                     PACKAGE_MANGO,   false,         true,             true,     true,                     false},
+    {"mango_pounders",                  PACKAGE_MANGO,   true,          false,            true,     true,                     false},
     {"mango_imfil",                     PACKAGE_MANGO,   false,         false,            true,     true,                     true },
+    {"mango_multidirectional_search",   PACKAGE_MANGO,   false,         false,            true,     true,                     false},
+    {"mango_cmaes",                     PACKAGE_MANGO,   false,         false,            true,     true,                     false},
+    {"mango_differential_evolution",    PACKAGE_MANGO,   false,         false,            true,     true,                     true },
+    {"mango_bayesian_optimization",     PACKAGE_MANGO,   false,         false,            true,     true,                     true },
+    {"mango_direct",                    PACKAGE_MANGO,   false,         false,            true,     true,                     true },
+    {"mango_direct_l",                  PACKAGE_MANGO,   false,         false,            true,     true,                     true },
     {"petsc_nm",                        PACKAGE_PETSC,   false,         false,            false,    false,                    false},
     {"petsc_pounders",                  PACKAGE_PETSC,   true,          false,            false,    true,                     false},
     {"petsc_brgn",                      PACKAGE_PETSC,   true,          true,             true,     true,                     false},
@@ -186,6 +204,13 @@ namespace mango {
   //////////////////////////////////////////////////////////////////////////////////////
   // Items related to partitioning the processors into worker groups:
 
+  //! Ways in which mango::MPI_Partition::init() can assign MPI processes to worker groups.
+  typedef enum {
+    PARTITION_BY_RANK, //!< Worker groups are contiguous blocks of ranks in the world communicator, regardless of where the processes run. This is the default.
+    PARTITION_BY_NODE, //!< Worker groups are aligned to shared-memory nodes, so no worker group spans two nodes unless there are fewer worker groups than nodes.
+    PARTITION_BY_NUMA //!< Like PARTITION_BY_NODE, but aligned to NUMA domains where the MPI library can detect them.
+  } partition_topology_type;
+
   /** \brief A class for dividing the set of MPI processes into worker groups.
    *
    * Each group works together on evaluations of the objective function.
@@ -208,10 +233,38 @@ namespace mango {
     bool proc0_worker_groups;
     int N_worker_groups;
     bool initialized;
+    partition_topology_type topology;
+    int node;
+    int N_nodes;
 
     void verify_initialized();
     void print();
-    void write_line(std::ofstream&, int, std::string[], int[]);
+    void write_line(std::ofstream&, int, std::string[], int[], std::string);
+    MPI_Comm comm_node;
+    bool custom;
+    bool dynamic;
+    bool deep;
+    bool has_deep_layout;
+    // The communicators, ranks, and sizes of the layout that is not currently in use, if dynamic layouts are enabled.
+    MPI_Comm other_comm_worker_groups;
+    MPI_Comm other_comm_group_leaders;
+    int other_N_procs_worker_groups;
+    int other_rank_worker_groups;
+    int other_N_procs_group_leaders;
+    int other_rank_group_leaders;
+    int other_worker_group;
+    bool other_proc0_worker_groups;
+    int other_N_worker_groups;
+    int command_size;
+    std::vector<char> command_buffer;
+    void free_communicators();
+    void init_deep_layout();
+    void swap_layouts();
+    void init_command_buffer();
+    void broadcast_command(int*, int*, const double*, double*);
+    void find_domains(MPI_Comm, partition_topology_type, int*, int*, int*, MPI_Comm*);
+    void find_nodes();
+    void assign_worker_groups_by_topology();
 
   public:
 
@@ -273,6 +326,18 @@ namespace mango {
      */
     MPI_Comm get_comm_group_leaders();
 
+    //! Get an MPI communicator containing the processes of MANGO's world communicator that share this processor's node.
+    /**
+     * The communicator is created with MPI_Comm_split_type(MPI_COMM_TYPE_SHARED), and processes are ordered by their rank in
+     * MANGO's world communicator. It is used for example by mango::Shared_data.
+     * The communicator is created on the first call to this function, mango::MPI_Partition::get_node(), or mango::MPI_Partition::get_N_nodes(),
+     * so that first call must be made by all processes in MANGO's world communicator.
+     * This function can only be called after calling mango::Problem::mpi_init(), mango::MPI_Partition::init(), or
+     * mango::MPI_Partition::set_custom(). Otherwise a C++ exception will be thrown.
+     * @return The MPI communicator for the processes on this node.
+     */
+    MPI_Comm get_comm_node();
+
     //! Determine whether this MPI processor has rank 0 in MANGO's world communicator.
     /**
      * This function can only be called after calling mango::Problem::mpi_init(), mango::MPI_Partition::init(), or
@@ -370,12 +435,108 @@ namespace mango {
      */
     void set_N_worker_groups(int N_worker_groups);
 
+    //! Choose how mango::MPI_Partition::init() assigns MPI processes to worker groups.
+    /**
+     * With PARTITION_BY_NODE or PARTITION_BY_NUMA, the worker groups are distributed among the nodes (or NUMA domains)
+     * in proportion to the number of processes on each, and each worker group is kept within one node. If the sizes of the
+     * worker groups then differ by more than one process, or if there are fewer worker groups than nodes so that some worker groups must span
+     * several nodes, a message describing the imbalance is printed by proc0_world.
+     * This subroutine must be called before mango::MPI_Partition::init().
+     * @param[in] topology The method for assigning processes to worker groups.
+     */
+    void set_topology(partition_topology_type topology);
+
+    //! Get the index of the shared-memory node on which this MPI processor runs.
+    /**
+     * Nodes are numbered from 0, in order of the lowest rank in MANGO's world communicator on each node.
+     * As for mango::MPI_Partition::get_comm_node(), the first call must be made by all processes in MANGO's world communicator.
+     * This function can only be called after calling mango::Problem::mpi_init(), mango::MPI_Partition::init(), or
+     * mango::MPI_Partition::set_custom(). Otherwise a C++ exception will be thrown.
+     * @return The index of this processor's node.
+     */
+    int get_node();
+
+    //! Get the number of shared-memory nodes spanned by MANGO's world communicator.
+    /**
+     * As for mango::MPI_Partition::get_comm_node(), the first call must be made by all processes in MANGO's world communicator.
+     * This function can only be called after calling mango::Problem::mpi_init(), mango::MPI_Partition::init(), or
+     * mango::MPI_Partition::set_custom(). Otherwise a C++ exception will be thrown.
+     * @return The number of nodes.
+     */
+    int get_N_nodes();
+
+    //! Divide processes among worker groups, keeping each worker group within a node or other domain where possible.
+    /**
+     * This function is used by mango::MPI_Partition::init() for PARTITION_BY_NODE and PARTITION_BY_NUMA. It involves no MPI communication,
+     * so it can be used to check the assignment that would result for any layout of processes.
+     * @param[in] N_procs The number of processes.
+     * @param[in] domain_of_proc An array of size <span class="paramname">N_procs</span>, giving the domain (e.g. node) of each process,
+     *   numbered from 0 in order of the first process in each domain.
+     * @param[in] N_worker_groups The number of worker groups, which must be in the range [1, <span class="paramname">N_procs</span>].
+     * @param[out] worker_group_of_proc An array of size <span class="paramname">N_procs</span>, which is set to the worker group of each process.
+     *   Worker groups are numbered in order of their first process.
+     */
+    static void assign_worker_groups_to_domains(int N_procs, const int* domain_of_proc, int N_worker_groups, int* worker_group_of_proc);
+
     //! Write a file with the given filename, showing the worker group assignments and rank of each process in each communicator.
     /**
+     * The file also records the node on which each process runs, both as an index and as the processor name reported by MPI.
      * @param[in] filename The name of the file in which to write the MPI data. If the file already exists, it will be over-written.
      */
     void write(std::string filename);
 
+    //! Divide the processes into a different number of worker groups.
+    /**
+     * The partition is re-split from the same world communicator, using the same topology, and the communicators
+     * of the previous partition are freed. This subroutine must be called by all processes in MANGO's world communicator,
+     * at a time when no worker is inside a worker loop. It cannot be used after mango::MPI_Partition::set_custom().
+     * @param[in] N_worker_groups The new number of worker groups.
+     */
+    void repartition(int N_worker_groups);
+
+    //! Choose whether MANGO can switch between two layouts of the processes during an optimization.
+    /**
+     * If true, mango::MPI_Partition::init() creates a second, "deep" layout alongside the usual "wide" one:
+     * a single worker group containing every process, led by proc0_world. MANGO then switches layouts at batch boundaries,
+     * using the wide layout for concurrent batches such as finite-difference gradients and Jacobians, and the deep layout
+     * when a point is evaluated by itself (for instance in a line search), so that every process can help with
+     * that single evaluation. The switch only swaps precomputed communicators; no communicator is created during the optimization.
+     * Layouts are only switched for algorithms in which the group leaders other than proc0_world only take part in finite-difference
+     * derivatives, i.e. algorithms that use derivatives and are not from the mango package. The wide layout is always restored
+     * before mango::Problem::optimize() returns.
+     *
+     * Worker loops that use mango::MPI_Partition::continue_worker_loop() pick up the new communicators automatically.
+     * Group leaders of the wide layout that become workers in the deep layout run the function supplied
+     * to mango::Problem::set_worker_function() each time they are mobilized, so this function should do the same work as the
+     * body of the worker loop. The default is false. This subroutine should be called before mango::MPI_Partition::init(),
+     * and it has no effect on partitions from mango::MPI_Partition::set_custom().
+     * @param[in] dynamic If true, MANGO may switch between the wide and deep layouts during an optimization.
+     */
+    void set_dynamic(bool dynamic);
+
+    //! Determine whether this partition has a deep layout that MANGO can switch to.
+    /**
+     * @return True if mango::MPI_Partition::set_dynamic() was set to true before the partition was initialized,
+     *   and the wide layout has more than one worker group.
+     */
+    bool get_dynamic();
+
+    //! Determine whether the deep layout is in use.
+    /**
+     * While the deep layout is in use, there is one worker group containing every process, and the getters
+     * of this class (e.g. mango::MPI_Partition::get_comm_worker_groups()) return the values for this layout.
+     * @return True if the deep layout is in use, false if the wide layout is in use.
+     */
+    bool get_deep();
+
+    //! Switch between the wide and deep layouts.
+    /**
+     * This subroutine is normally called by MANGO rather than by the user. It should be called by every group leader of the
+     * layout in use, after which the workers of each group switch inside mango::MPI_Partition::continue_worker_loop().
+     * It can only be used if mango::MPI_Partition::get_dynamic() is true.
+     */
+    void switch_layout();
+
     //! Tell the worker MPI processes (i.e. those that are not group leaders) that the optimization problem is complete.
     /**
      * This subroutine should only be called by group leaders.
@@ -394,15 +555,119 @@ namespace mango {
      */
     void mobilize_workers();
 
+    //! Tell the worker MPI processes to begin a task, sending them a task ID and an array of data (such as the state vector) at the same time.
+    /**
+     * This subroutine should only be called by group leaders. The task ID and the data are sent together with the command
+     * to start, in a single broadcast over the worker group, so the workers do not need a separate broadcast of the state vector.
+     * The workers receive the message with the version of mango::MPI_Partition::continue_worker_loop() that takes the same arguments.
+     * @param[in] task An integer identifying the task, which is passed to the workers. Its meaning is up to the user.
+     * @param[in] data An array of size mango::MPI_Partition::get_command_size(), which is copied to the workers.
+     *   It can be NULL if there are no data to send.
+     */
+    void mobilize_workers(int task, const double* data);
+
     //! For an MPI worker, determine whether to carry out another evaluation of the objective function or exit.
     /**
      * This subroutine should only be called on MPI processors that are not group leaders.
      * You can see typical usage of this subroutine in the examples. However you are also free to
      * use your own approach to controlling the worker processes instead of this subroutine.
+     * If the layout is switched (see mango::MPI_Partition::set_dynamic()), this subroutine updates the partition and keeps waiting,
+     * so the next evaluation uses the communicators of the new layout.
      * @return If true, this processor should help to evaluate the objective function. If false, the optimization has been completed,
-     *   so this processor can move on.
+     *   so this processor can move on. False is also returned if this processor has become a group leader due to a layout switch.
      */
     bool continue_worker_loop();
+
+    //! For an MPI worker, wait for the next task from the group leader, receiving its task ID and data.
+    /**
+     * This subroutine should only be called on MPI processors that are not group leaders. It is the counterpart of
+     * mango::MPI_Partition::mobilize_workers(int, const double*), and it can also be used when the group leader calls
+     * the version of mango::MPI_Partition::mobilize_workers() with no arguments, in which case the task ID is 0 and
+     * <span class="paramname">data</span> is not modified.
+     * @param[out] task Set to the task ID sent by the group leader. It can be NULL.
+     * @param[out] data An array of size mango::MPI_Partition::get_command_size(), which is set to the data sent by the group leader.
+     *   It can be NULL if the data are not needed.
+     * @return If true, this processor should help with the task. If false, the optimization has been completed,
+     *   so this processor can move on.
+     */
+    bool continue_worker_loop(int* task, double* data);
+
+    //! Set the number of floating-point values that are sent to the workers with each task.
+    /**
+     * This is the size of the <span class="paramname">data</span> array in mango::MPI_Partition::mobilize_workers(int, const double*)
+     * and mango::MPI_Partition::continue_worker_loop(int*, double*), typically the number of parameters.
+     * It should be set before mango::MPI_Partition::init() or mango::MPI_Partition::set_custom(); the value on proc0_world is used by every process.
+     * The default is 0.
+     * @param[in] command_size The number of values, which must be >= 0.
+     */
+    void set_command_size(int command_size);
+
+    //! Get the number of floating-point values that are sent to the workers with each task.
+    /**
+     * @return The size of the data array sent with each task. See mango::MPI_Partition::set_command_size().
+     */
+    int get_command_size();
+  };
+
+  /** \brief A read-only block of data, such as a large experimental dataset, stored once per node and shared by all the processes on the node.
+   *
+   * When every MPI process loads its own copy of a large dataset for use in the objective function, the memory per node can be
+   * exceeded. With this class, the data are allocated in a node-shared segment (using MPI_Win_allocate_shared), loaded once
+   * by proc0_world, and broadcast to one process on each other node. Every process then gets a pointer to its node's copy,
+   * which can be passed to mango::Problem::set_user_data(). Typical usage, on all processes of MANGO's world communicator:
+   * \code
+   * mango::Shared_data data;
+   * data.allocate(problem.mpi_partition, N_bytes); // N_bytes only needs to be correct on proc0_world.
+   * if (problem.mpi_partition.get_proc0_world()) read_my_dataset(data.get_pointer());
+   * data.share();
+   * problem.set_user_data(data.get_pointer());
+   * \endcode
+   * After mango::Shared_data::share() the data must not be modified. The object must outlive any use of the pointer.
+   */
+  class Shared_data {
+  private:
+    MPI_Win window;
+    MPI_Comm comm_node;
+    MPI_Comm comm_node_leaders;
+    void* pointer;
+    MPI_Aint N_bytes;
+    void release();
+
+  public:
+    //! Constructor
+    Shared_data();
+
+    //! Destructor
+    /**
+     * The shared segment is freed, unless MPI has already been finalized.
+     */
+    ~Shared_data();
+
+    //! Allocate the node-shared segment.
+    /**
+     * This subroutine must be called by all processes in MANGO's world communicator, after the MPI_Partition has been initialized.
+     * @param[in] mpi_partition The partition whose communicators will be used.
+     * @param[in] N_bytes The size of the data in bytes. Only the value on proc0_world is used.
+     */
+    void allocate(MPI_Partition& mpi_partition, MPI_Aint N_bytes);
+
+    //! Copy the data from proc0_world to every node, and make them visible to all processes.
+    /**
+     * This subroutine must be called by all processes in MANGO's world communicator, after proc0_world has filled in the data.
+     */
+    void share();
+
+    //! Get a pointer to this node's copy of the data.
+    /**
+     * @return The pointer, which can be cast to any type.
+     */
+    void* get_pointer();
+
+    //! Get the size of the data.
+    /**
+     * @return The size in bytes.
+     */
+    MPI_Aint get_N_bytes();
   };
 
   //////////////////////////////////////////////////////////////////////////////////////
@@ -438,6 +703,103 @@ namespace mango {
    */
   typedef void (*vector_function_type)(int* N_parameters, const double* state_vector, int* N_terms, double* residuals, int* failed, mango::Problem* problem, void* user_data);
 
+  //! Format for an optional user-supplied subroutine that computes the objective function at several points in one call
+  /**
+   * This form can be much faster than \ref objective_function_type for models that can be vectorized across points.
+   * It can be registered using mango::Problem::set_batch_objective_function().
+   * @param[in] N_parameters The number of independent variables, i.e. the dimension of the search space.
+   * @param[in] N_points The number of points at which the objective function is to be evaluated.
+   * @param[in] state_vectors An array of size <span class="paramname">N_parameters</span> * <span class="paramname">N_points</span>.
+   *            The state vector for point j (0-based) is stored in elements j * N_parameters through (j + 1) * N_parameters - 1.
+   * @param[out] objective_values An array of size <span class="paramname">N_points</span>, which must be set to the objective function at each point.
+   * @param[out] failures An array of size <span class="paramname">N_points</span>. Set each element to 1 if the calculation for that point fails,
+   *            otherwise 0.
+   * @param[in] problem A pointer to the class representing this optimization problem.
+   * @param[in] user_data Pointer to user-supplied data, which can be set by mango::Problem::set_user_data().
+   */
+  typedef void (*batch_objective_function_type)(int* N_parameters, int* N_points, const double* state_vectors, double* objective_values, int* failures, mango::Problem* problem, void* user_data);
+
+  //! Format for an optional user-supplied subroutine that computes the residuals of a least-squares problem at several points in one call
+  /**
+   * This form can be much faster than \ref vector_function_type for models that can be vectorized across points.
+   * It can be registered using mango::Least_squares_problem::set_batch_residual_function().
+   * @param[in] N_parameters The number of independent variables, i.e. the dimension of the search space.
+   * @param[in] N_points The number of points at which the residuals are to be evaluated.
+   * @param[in] state_vectors An array of size <span class="paramname">N_parameters</span> * <span class="paramname">N_points</span>.
+   *            The state vector for point j (0-based) is stored in elements j * N_parameters through (j + 1) * N_parameters - 1.
+   * @param[in] N_terms The number of least-squares terms that are summed in the total objective function, i.e. the number of residuals.
+   * @param[out] residuals An array of size <span class="paramname">N_terms</span> * <span class="paramname">N_points</span>.
+   *            The residuals for point j must be stored in elements j * N_terms through (j + 1) * N_terms - 1.
+   * @param[out] failures An array of size <span class="paramname">N_points</span>. Set each element to 1 if the calculation for that point fails,
+   *            otherwise 0.
+   * @param[in] problem A pointer to the class representing this optimization problem.
+   * @param[in] user_data Pointer to user-supplied data, which can be set by mango::Problem::set_user_data().
+   */
+  typedef void (*batch_vector_function_type)(int* N_parameters, int* N_points, const double* state_vectors, int* N_terms, double* residuals, int* failures, mango::Problem* problem, void* user_data);
+
+  //! Values that a user-supplied \ref async_poll_function_type subroutine can report for an asynchronous function evaluation.
+  typedef enum {
+    ASYNC_RUNNING, //!< The evaluation has not yet finished.
+    ASYNC_SUCCEEDED, //!< The evaluation has finished, and the results have been stored.
+    ASYNC_FAILED //!< The evaluation has finished but failed.
+  } async_status_type;
+
+  //! Format for an optional user-supplied subroutine that starts an asynchronous function evaluation
+  /**
+   * This subroutine should launch the evaluation (for instance by submitting a job to a job runner) and return promptly,
+   * without waiting for it to finish. See mango::Problem::set_async_functions().
+   * @param[in] N_parameters The number of independent variables, i.e. the dimension of the search space.
+   * @param[in] state_vector An array of size <span class="paramname">N_parameters</span> containing the values of the indpendent variables.
+   *            This array is not guaranteed to remain valid after the subroutine returns, so copy it if needed.
+   * @param[in] N_terms For least-squares problems, the number of residuals. For other problems this value is 1.
+   * @param[out] handle Set this to any integer that identifies the evaluation. It will be passed back to the poll subroutine.
+   * @param[in] problem A pointer to the class representing this optimization problem.
+   * @param[in] user_data Pointer to user-supplied data, which can be set by mango::Problem::set_user_data().
+   */
+  typedef void (*async_start_function_type)(int* N_parameters, const double* state_vector, int* N_terms, int* handle, mango::Problem* problem, void* user_data);
+
+  //! Format for an optional user-supplied subroutine that checks whether an asynchronous function evaluation has finished
+  /**
+   * See mango::Problem::set_async_functions().
+   * @param[in] handle The handle that was set by the start subroutine for this evaluation.
+   * @param[in] N_terms For least-squares problems, the number of residuals. For other problems this value is 1.
+   * @param[out] results An array of size <span class="paramname">N_terms</span>. If the evaluation has finished successfully,
+   *            the residuals (or, for a non-least-squares problem, the objective function) must be stored here. Otherwise do not modify it.
+   * @param[out] status Set this to one of the values of \ref async_status_type.
+   * @param[in] problem A pointer to the class representing this optimization problem.
+   * @param[in] user_data Pointer to user-supplied data, which can be set by mango::Problem::set_user_data().
+   */
+  typedef void (*async_poll_function_type)(int* handle, int* N_terms, double* results, int* status, mango::Problem* problem, void* user_data);
+
+  //! Format for a user-supplied subroutine that is notified of each function evaluation as it is recorded.
+  /**
+   * Observers are called only on proc0_world, immediately after each function evaluation is written to the output file.
+   * They can be registered using mango::Problem::add_observer().
+   * @param[in] function_evaluation The 1-based index of this function evaluation.
+   * @param[in] N_parameters The number of independent variables, i.e. the dimension of the search space.
+   * @param[in] state_vector An array of size <span class="paramname">N_parameters</span> containing the values of the indpendent variables.
+   * @param[in] objective_value The value of the objective function for this function evaluation.
+   * @param[in] N_terms For least-squares problems, the number of residuals. For other problems this value is 0.
+   * @param[in] residuals For least-squares problems, an array of size <span class="paramname">N_terms</span> containing the residuals.
+   *            For other problems this pointer is NULL.
+   * @param[in] new_optimum 1 if this function evaluation is the best found so far, 0 otherwise.
+   * @param[in] elapsed_time The number of seconds since the start of the optimization.
+   * @param[in] problem A pointer to the class representing this optimization problem.
+   * @param[in] observer_data Pointer to the data that was supplied along with the observer to mango::Problem::add_observer().
+   */
+  typedef void (*observer_function_type)(int* function_evaluation, int* N_parameters, const double* state_vector, double* objective_value,
+					 int* N_terms, const double* residuals, int* new_optimum, double* elapsed_time, mango::Problem* problem, void* observer_data);
+
+  //! Format for a user-supplied subroutine that carries out a worker's share of one function evaluation.
+  /**
+   * This is the body of the loop that workers (processes that are not group leaders) normally run with
+   * mango::MPI_Partition::continue_worker_loop(). It is used when MANGO itself needs to run the worker loop,
+   * as in mango::Problem::calibrate_worker_groups(), or for group leaders that become workers (see mango::Problem::set_worker_function()).
+   * @param[in] problem A pointer to the class representing this optimization problem.
+   * @param[in] user_data Pointer to user-supplied data, which can be set by mango::Problem::set_user_data().
+   */
+  typedef void (*worker_function_type)(mango::Problem* problem, void* user_data);
+
   class Solver;
   class Problem {
     friend class Solver;
@@ -474,6 +836,27 @@ namespace mango {
      */
     void mpi_init(MPI_Comm mpi_comm);
 
+    //! Initialize MANGO's MPI partition, choosing the number of worker groups by timing the objective function.
+    /**
+     * This subroutine can be called instead of mango::Problem::mpi_init(), by all processes in
+     * <span class="paramname">mpi_comm</span>, after the algorithm, user data, and initial state vector have been set.
+     * For each number of worker groups that divides the processes evenly (up to the number of points the algorithm evaluates
+     * concurrently), the processes are re-split, and every group leader evaluates the objective function at the initial
+     * state vector while the workers run <span class="paramname">worker</span>. The time to solution is then predicted from the
+     * measured time per evaluation and the algorithm's batch shape: N_parameters+1 points (or 2*N_parameters+1 with centered
+     * differences) for finite-difference derivatives, plus N_line_search points for mango_levenberg_marquardt, or one point per
+     * process for other concurrent algorithms. The partition with the shortest predicted time is kept.
+     * The evaluations made during calibration are not recorded in the output file.
+     * For algorithms that do not support concurrent function evaluations, this subroutine is equivalent to mpi_init().
+     * @param[in] mpi_comm  The MPI communicator to use for the optimization. Usually this is MPI_COMM_WORLD.
+     * @param[in] worker The subroutine that workers run each time they are mobilized. It can be NULL if the objective function
+     *   does not use workers.
+     * @param[in] log_filename If not empty, proc0_world writes the measured and predicted times and the chosen number of worker groups
+     *   to this file, so the choice can be reused with mango::MPI_Partition::set_N_worker_groups() in later runs.
+     * @param[in] N_evaluations The number of evaluations each group leader makes for each candidate partition. The default is 1.
+     */
+    void calibrate_worker_groups(MPI_Comm mpi_comm, worker_function_type worker, std::string log_filename, int N_evaluations = 1);
+
     //! Sets the optimization algorithm
     /**
      * Note the related subroutine of the same name that takes a std::string as input.
@@ -503,6 +886,25 @@ namespace mango {
     */
     void set_output_filename(std::string filename);
 
+    //! Sets the name of a file to which metrics about the optimization's progress are written periodically.
+    /**
+     * The file is written by proc0_world in the Prometheus text exposition format, so it can be scraped by
+     * the textfile collector of node-exporter. It includes the number of function evaluations, the rate of function evaluations,
+     * the best objective function, the time since the objective function last improved, the fraction of worker groups
+     * that were busy, and for mango_levenberg_marquardt the iteration and lambda parameter.
+     * The file is replaced atomically, by writing a temporary file in the same directory and renaming it.
+     * If this method is not called, no metrics are written.
+     * @param[in] filename A string giving the filename to use for the metrics file, typically ending in ".prom".
+     */
+    void set_metrics_filename(std::string filename);
+
+    //! Sets the minimum number of seconds between updates of the metrics file.
+    /**
+     * The default is 15 seconds. The metrics file is always written at the beginning and end of the optimization.
+     * @param[in] interval The minimum wall-clock time in seconds between updates of the metrics file.
+     */
+    void set_metrics_interval(double interval);
+
     //! Sets bound constraints for the optimization problem.
     /**
      * @param[in] lower   An array of lower bounds, corresponding to
@@ -523,6 +925,24 @@ namespace mango {
      */
     double optimize();
 
+    //! Begin a session, in which proc0_world can call mango::Problem::optimize() several times without the other group leaders returning to the driver code.
+    /**
+     * This subroutine should be called by all group leaders after mango::Problem::mpi_init(), in place of mango::Problem::optimize().
+     * On proc0_world it returns immediately, and proc0_world may then call mango::Problem::optimize() any number of times,
+     * changing the initial state vector, bound constraints, targets, algorithm, or other settings between calls, followed by mango::Problem::end_session().
+     * On the other group leaders, it waits for and takes part in each of these solves, and returns when proc0_world calls mango::Problem::end_session().
+     * The settings and initial state vector are sent from proc0_world at the start of each solve, so on the other group leaders
+     * they do not need to be set again. The number of parameters must not change during a session.
+     * The workers stay in their worker loop for the whole session, so mango::Problem::stop_workers() should be called once afterwards, as usual.
+     */
+    void begin_session();
+
+    //! End a session that was started with mango::Problem::begin_session().
+    /**
+     * This subroutine should be called only by proc0_world. It releases the other group leaders from mango::Problem::begin_session().
+     */
+    void end_session();
+
     //! Get the number of independent variables for an optimization problem.
     /*
      * @return       The number of independent variables, i.e. the dimensionality of the parameter space.
@@ -592,6 +1012,56 @@ namespace mango {
      */
     void set_user_data(void* user_data);
 
+    //! Register a subroutine that is called after every function evaluation is recorded.
+    /**
+     * This method allows the progress of an optimization to be monitored without reading the output file,
+     * e.g. for live plotting or for implementing your own stopping criteria.
+     * Any number of observers can be added; they are called in the order they were added, on proc0_world only.
+     * If no observers are added, there is no cost.
+     * @param[in] observer The subroutine to call. See \ref observer_function_type for the format.
+     * @param[in] observer_data A pointer to any data (you can cast any pointer to type void*), which will be passed to the observer.
+     */
+    void add_observer(observer_function_type observer, void* observer_data);
+
+    //! Supply a subroutine that evaluates the objective function at several points in one call.
+    /**
+     * If this subroutine is supplied, then whenever a set of points is evaluated concurrently, such as for a finite-difference
+     * gradient, each group leader evaluates its entire share of the set with a single call. The ordinary objective function
+     * passed to the constructor is still used by algorithms that evaluate one point at a time.
+     * If a batch function is supplied, it takes precedence over mango::Problem::set_N_threads().
+     * @param[in] batch_objective_function The subroutine. See \ref batch_objective_function_type for the format.
+     */
+    void set_batch_objective_function(batch_objective_function_type batch_objective_function);
+
+    //! Supply subroutines that start function evaluations and check for their completion, rather than evaluating synchronously.
+    /**
+     * This interface is useful when each function evaluation is carried out by some external process, such as a job submitted
+     * to a job runner, that takes a long time but uses little CPU on the calling MPI process. Whenever a set of points is
+     * evaluated concurrently, such as for a finite-difference gradient or Jacobian, each group leader starts up to
+     * mango::Problem::set_max_async_evaluations() evaluations from its share of the set at once, and then polls them until they finish.
+     * Therefore many more evaluations can be in flight than there are worker groups.
+     * The ordinary objective or residual function is still used by algorithms that evaluate one point at a time.
+     * For least-squares problems the results are the residuals; otherwise the result is the objective function.
+     * If asynchronous functions are supplied, they take precedence over batch functions and threads.
+     * @param[in] start The subroutine that starts an evaluation. See \ref async_start_function_type for the format.
+     * @param[in] poll The subroutine that checks whether an evaluation has finished. See \ref async_poll_function_type for the format.
+     */
+    void set_async_functions(async_start_function_type start, async_poll_function_type poll);
+
+    //! Sets the maximum number of asynchronous function evaluations that each group leader can have in flight at once.
+    /**
+     * The default value is 1000, so effectively each group leader starts its entire share of a set at once.
+     * @param[in] N The maximum number of asynchronous evaluations per group leader. Must be >= 1.
+     */
+    void set_max_async_evaluations(int N);
+
+    //! Sets the time to wait between rounds of polling asynchronous function evaluations.
+    /**
+     * The default value is 0.1 seconds.
+     * @param[in] interval The time in seconds to wait when no in-flight evaluation has finished. Must be >= 0.
+     */
+    void set_async_poll_interval(double interval);
+
     //! Impose bound constraints on an optimization problem, with the bounds chosen as multiples of the initial state vector.
     /**
      * To use this subroutine, you must first call mango::Problem::set_bound_constraints, so MANGO has pointers to the 
@@ -642,6 +1112,58 @@ namespace mango {
      */
     void set_N_line_search(int N_line_search);
 
+    //! Sets the number of threads each group leader uses for concurrent function evaluations.
+    /**
+     * When a set of function evaluations is performed concurrently, such as for a finite-difference Jacobian,
+     * each group leader normally evaluates its share of the set one point at a time. If the number of threads is > 1,
+     * each group leader instead evaluates its share using this many threads, with each thread writing its results directly
+     * into MANGO's arrays. This is an efficient way to use the cores of a shared-memory node, and it can be combined
+     * with multiple worker groups. The default value is 1, meaning no threads are launched.
+     *
+     * If the number of threads is > 1, your objective or residual function must be thread-safe, and it should not call
+     * mango::MPI_Partition::mobilize_workers() or other MPI routines unless MPI was initialized with MPI_THREAD_MULTIPLE.
+     * @param[in] N_threads The number of threads to use on each group leader. Must be >= 1.
+     */
+    void set_N_threads(int N_threads);
+
+    //! Sets the seed for the random numbers used by stochastic algorithms, and makes their results reproducible.
+    /**
+     * This setting affects mango_cmaes, mango_differential_evolution, mango_bayesian_optimization, and the Latin hypercube design
+     * of mango::Multistart. If the seed is negative, which is the default, the seed is taken from the clock, so results differ
+     * from run to run. In addition, mango_differential_evolution then uses each result as soon as it arrives, so its results
+     * depend on the timing of the function evaluations. If a seed \f$\ge 0\f$ is set, the results of mango_cmaes and
+     * mango_bayesian_optimization are reproducible for a given number of worker groups, and mango_differential_evolution
+     * uses the results in the order the points were generated, with a fixed lag, so its sequence of function evaluations
+     * depends only on the seed, not on timing or on the number of worker groups. Setting a seed is intended for regression tests.
+     * Setting a negative seed restores the default behavior.
+     * @param[in] random_seed The seed.
+     */
+    void set_random_seed(int random_seed);
+
+    //! Choose whether group leaders on the same node exchange data through shared memory during concurrent function evaluations.
+    /**
+     * Normally, when a set of function evaluations is performed concurrently, such as for a finite-difference Jacobian,
+     * proc0_world broadcasts all the state vectors to every group leader and the results are collected with a reduction over all
+     * group leaders. If this option is turned on, the group leaders on each node instead share one buffer,
+     * allocated with MPI_Win_allocate_shared. The state vectors are sent only once per node, each group leader writes its
+     * results directly into the node's buffer, and only one group leader per node communicates with proc0_world.
+     * This reduces memory traffic and communication when there are many group leaders per node and many residuals.
+     * The default is false.
+     * @param[in] use_shared_memory If true, use the shared-memory transport.
+     */
+    void set_shared_memory(bool use_shared_memory);
+
+    //! Supply the work that a worker process does each time it is mobilized.
+    /**
+     * This function is needed only when MANGO may switch layouts during an optimization (see mango::MPI_Partition::set_dynamic()).
+     * Group leaders of the wide layout become workers in the deep layout, and while they are workers
+     * they call this function each time mango::MPI_Partition::mobilize_workers() is called by proc0_world.
+     * It should therefore do the same work as the body of the worker loop in the driver code.
+     * If no function is supplied, these processes do nothing when mobilized.
+     * @param[in] worker_function The function to call, or NULL.
+     */
+    void set_worker_function(worker_function_type worker_function);
+
     //! Get the Solver object associated with the optimization problem.
     /**
      * Users generally should not need this method.
@@ -654,6 +1176,21 @@ namespace mango {
   //////////////////////////////////////////////////////////////////////////////////////
   // A least-squares problem is a subclass of Problem
 
+  //! Policies for which residuals are stored in the output file of a least-squares problem.
+  /**
+   * These policies only have an effect if printing of residuals is turned on,
+   * using mango::Least_squares_problem::set_print_residuals_in_output_file().
+   * In every case, the last line of the output file, which repeats the optimum, contains the full residual vector.
+   */
+  typedef enum {
+    RESIDUALS_ALL, //!< Every residual of every function evaluation is written in double precision. This is the default.
+    RESIDUALS_BEST_ONLY, //!< Residuals are written only for function evaluations that improve on the best objective function so far.
+    RESIDUALS_EVERY_K, //!< Residuals are written only for every k-th function evaluation, where k is set by mango::Least_squares_problem::set_residual_storage_interval().
+    RESIDUALS_SINGLE_PRECISION, //!< Every residual of every function evaluation is written, rounded to single precision.
+    RESIDUALS_DELTA_FROM_BEST //!< Each residual vector is written as the difference from the residual vector of the previous best function evaluation.
+  } residual_storage_type;
+
+
   class Least_squares_solver;
   class Least_squares_problem : public Problem {
   private:
@@ -694,6 +1231,532 @@ namespace mango {
      * @param[in] print Whether or not to print every residual term in the output file.
      */
     void set_print_residuals_in_output_file(bool print);
+
+    //! Determine which residuals are stored in the MANGO output file.
+    /**
+     * For problems with very many terms, storing every residual of every function evaluation can make
+     * the output file very large. This method allows a smaller subset of the residual history to be kept.
+     * Lines for which the residuals are not stored have an empty field for each residual, so every line has the same columns.
+     * The last line of the output file is a copy of the line for the optimum, in the same format.
+     * For the RESIDUALS_DELTA_FROM_BEST policy, the column headers are dF(j) rather than F(j). The reference
+     * residual vector is zero until the first successful function evaluation, and thereafter it is updated
+     * each time a new best objective function is found, so the full residuals can be recovered from the file
+     * by accumulating the rows at which the objective function improved.
+     *
+     * @param[in] policy The policy, one of the values of \ref residual_storage_type.
+     */
+    void set_residual_storage(residual_storage_type policy);
+
+    //! Set how often the residuals are stored when using the RESIDUALS_EVERY_K policy.
+    /**
+     * @param[in] interval The residuals are stored for function evaluations whose index is a multiple of this number. Must be >= 1.
+     */
+    void set_residual_storage_interval(int interval);
+
+    //! Supply a subroutine that evaluates the residuals at several points in one call.
+    /**
+     * If this subroutine is supplied, then whenever a set of points is evaluated concurrently, such as for a finite-difference
+     * Jacobian or the set of lambda values in mango_levenberg_marquardt, each group leader evaluates its entire share of the set
+     * with a single call. The ordinary residual function passed to the constructor is still used by algorithms that evaluate
+     * one point at a time. If a batch function is supplied, it takes precedence over mango::Problem::set_N_threads().
+     * @param[in] batch_residual_function The subroutine. See \ref batch_vector_function_type for the format.
+     */
+    void set_batch_residual_function(batch_vector_function_type batch_residual_function);
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////
+  // Items related to solving many independent problems at once:
+
+  /** \brief A class for solving many independent optimization problems concurrently on one set of MPI processes.
+   *
+   * When there are many small problems, such as a separate fit for each of many surfaces, solving them one at a time
+   * with all the processes leaves most worker groups idle during the serial phases of each algorithm. An Ensemble instead
+   * divides its communicator into worker groups using its own mango::MPI_Partition, and each worker group solves whole problems,
+   * taking the next unsolved problem from a shared counter as soon as it finishes the previous one. Within a worker group, the group
+   * leader runs the optimization algorithm, and the other processes in the group are its workers, available through the
+   * problem's own mango::MPI_Partition as usual. Typical usage, on all processes:
+   * \code
+   * mango::Ensemble ensemble;
+   * for (int j = 0; j < N_problems; j++) ensemble.add_problem(&problems[j]);
+   * ensemble.mpi_partition.set_N_worker_groups(N_worker_groups);
+   * ensemble.mpi_init(MPI_COMM_WORLD);
+   * ensemble.optimize();
+   * \endcode
+   * Every problem must be created and configured on every process, since any worker group may be given any problem.
+   * Do not call mango::Problem::mpi_init() for the problems. Each problem records its function evaluations in its own output file,
+   * so give each problem a different filename with mango::Problem::set_output_filename().
+   * If the objective or residual function uses the workers of its group, the work they do each time they are mobilized
+   * must be supplied with mango::Problem::set_worker_function().
+   */
+  class Ensemble {
+  private:
+    std::vector<Problem*> problems;
+    std::vector<double> optima;
+    std::vector<int> worker_groups;
+
+  public:
+    //! The partition of the processes into the worker groups that share the problems.
+    MPI_Partition mpi_partition;
+
+    //! Add a problem to the ensemble.
+    /**
+     * @param[in] problem A pointer to the problem. The problem must exist until mango::Ensemble::optimize() returns.
+     */
+    void add_problem(Problem* problem);
+
+    //! Get the number of problems in the ensemble.
+    int get_N_problems();
+
+    //! Initialize the partition of the processes into worker groups.
+    /**
+     * This subroutine should be called by all processes, after mango::MPI_Partition::set_N_worker_groups() if desired.
+     * @param[in] mpi_comm  The MPI communicator to use. Usually this is MPI_COMM_WORLD.
+     */
+    void mpi_init(MPI_Comm mpi_comm);
+
+    //! Solve all the problems in the ensemble.
+    /**
+     * This subroutine should be called by all processes. When it returns, the state vector of each problem holds
+     * the best point found for that problem, on every process.
+     */
+    void optimize();
+
+    //! Get the minimum objective function found for one problem.
+    /**
+     * This subroutine can be called on any process after mango::Ensemble::optimize().
+     * @param[in] j_problem The 0-based index of the problem, in the order the problems were added.
+     * @return The minimum objective function.
+     */
+    double get_optimum(int j_problem);
+
+    //! Get the worker group that solved one problem.
+    /**
+     * This subroutine can be called on any process after mango::Ensemble::optimize().
+     * @param[in] j_problem The 0-based index of the problem, in the order the problems were added.
+     * @return The worker group of mango::Ensemble::mpi_partition that solved the problem.
+     */
+    int get_worker_group(int j_problem);
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////
+  // Items related to multistart optimization:
+
+  //! Space-filling designs that mango::Multistart can use to generate candidate starting points.
+  typedef enum {
+    DESIGN_LATIN_HYPERCUBE, //!< A random Latin hypercube, with one point in each of N_candidates slices of the box in each direction. This is the default.
+    DESIGN_SOBOL //!< The first N_candidates points of the Sobol sequence, using the direction numbers of Joe and Kuo. Available for up to 21 parameters.
+  } design_type;
+
+  /** \brief A class for running a local optimization algorithm from many starting points concurrently.
+   *
+   * A Multistart first generates N_candidates points inside the bound constraints of the problem using a space-filling design,
+   * and evaluates them all concurrently as one set, using every worker group. It then chooses the N_starts best candidates,
+   * skipping any candidate that lies within the basin radius of a better one, and runs the algorithm chosen for the problem
+   * (for example mango_levenberg_marquardt or gsl_lm) from each of them. For the local optimizations, the worker groups
+   * are divided into min(N_starts, N_worker_groups) sub-partitions, each of which takes the next start as soon as it finishes
+   * the previous one. Typical usage, on all processes:
+   * \code
+   * mango::Multistart multistart(&problem);
+   * multistart.set_N_starts(N_starts);
+   * multistart.mpi_partition.set_N_worker_groups(N_worker_groups);
+   * multistart.mpi_init(MPI_COMM_WORLD);
+   * multistart.optimize();
+   * \endcode
+   * The problem must be created and configured on every process, bound constraints must be set, and
+   * mango::Problem::mpi_init() should not be called for the problem. If the objective or residual function uses the workers of
+   * its group, the work they do each time they are mobilized must be supplied with mango::Problem::set_worker_function().
+   *
+   * The starts share their progress through a one-sided MPI window. A start is cut off if another start has already found a
+   * lower objective function within the basin radius of its best point, measured as a fraction of the width of the box in each direction.
+   * This check is made before each start is launched, and after each function evaluation of a running start. A running start stops
+   * early for the mango algorithms, which stop after the current set of concurrent evaluations, and for other algorithms that check
+   * max_function_evaluations as they go, such as the gsl algorithms. Other algorithms run to completion once launched.
+   *
+   * All function evaluations are written to the output file of the problem: first the candidates, and then the evaluations of
+   * each start in turn, numbered consecutively. As usual, the last line repeats the best point found.
+   * The seconds column is measured from the start of each phase. Each local optimization uses up to
+   * the max_function_evaluations of the problem, in addition to the N_candidates evaluations of the design.
+   */
+  class Multistart {
+  private:
+    Problem* problem;
+    int N_starts;
+    int N_candidates;
+    design_type design;
+    double basin_radius;
+    std::vector<double> optima;
+    std::vector<bool> cut_off;
+    std::vector<int> function_evaluations;
+
+  public:
+    //! The partition of the processes into the worker groups that evaluate the candidates, and that are divided among the starts.
+    MPI_Partition mpi_partition;
+
+    //! Constructor
+    /**
+     * @param[in] problem A pointer to the problem to solve. The algorithm of the problem is used for the local optimizations.
+     */
+    Multistart(Problem* problem);
+
+    //! Set the number of local optimizations.
+    /**
+     * @param[in] N_starts The number of local optimizations. The default is 4.
+     */
+    void set_N_starts(int N_starts);
+
+    //! Set the number of points of the space-filling design from which the starting points are chosen.
+    /**
+     * @param[in] N_candidates The number of points, which must be at least the number of starts. The default is 64.
+     */
+    void set_N_candidates(int N_candidates);
+
+    //! Set the space-filling design used to generate the candidates.
+    /**
+     * The Latin hypercube uses the random seed of the problem, set by mango::Problem::set_random_seed(). By default the seed is taken from the clock.
+     * @param[in] design One of the values of \ref design_type. The default is DESIGN_LATIN_HYPERCUBE.
+     */
+    void set_design(design_type design);
+
+    //! Set the radius within which two starts are considered to be in the same basin.
+    /**
+     * @param[in] basin_radius The radius, as a fraction of the width of the box in each direction. The default is 0.05.
+     *   If 0, starts are never cut off, and candidates are only skipped if they coincide.
+     */
+    void set_basin_radius(double basin_radius);
+
+    //! Initialize the partition of the processes into worker groups.
+    /**
+     * This subroutine should be called by all processes, after mango::MPI_Partition::set_N_worker_groups() if desired.
+     * @param[in] mpi_comm  The MPI communicator to use. Usually this is MPI_COMM_WORLD.
+     */
+    void mpi_init(MPI_Comm mpi_comm);
+
+    //! Evaluate the candidates and run the local optimizations.
+    /**
+     * This subroutine should be called by all processes. When it returns, the state vector of the problem holds
+     * the best point found, on every process. For least-squares problems, so does the array of residuals at the optimum.
+     * @return The minimum objective function found.
+     */
+    double optimize();
+
+    //! Get the number of starts that were chosen, which may be less than N_starts if there are too few distinct candidates.
+    /**
+     * This subroutine can be called on any process after mango::Multistart::optimize().
+     */
+    int get_N_starts();
+
+    //! Get the minimum objective function found by one start.
+    /**
+     * This subroutine can be called on any process after mango::Multistart::optimize().
+     * @param[in] j_start The 0-based index of the start. Starts are numbered in order of the objective function at their candidate point.
+     * @return The minimum objective function, which is the value at the candidate point if the start was cut off before it was launched.
+     */
+    double get_optimum(int j_start);
+
+    //! Determine whether one start was cut off because another start found a lower objective function in the same basin.
+    /**
+     * This subroutine can be called on any process after mango::Multistart::optimize().
+     * @param[in] j_start The 0-based index of the start.
+     * @return True if the start was cut off, either before or while it ran.
+     */
+    bool get_cut_off(int j_start);
+
+    //! Get the number of function evaluations made by one start.
+    /**
+     * This subroutine can be called on any process after mango::Multistart::optimize().
+     * @param[in] j_start The 0-based index of the start.
+     * @return The number of function evaluations, which is 0 if the start was cut off before it was launched.
+     */
+    int get_function_evaluations(int j_start);
+
+    //! Generate the points of a space-filling design in the unit hypercube.
+    /**
+     * @param[in] design One of the values of \ref design_type.
+     * @param[in] N_points The number of points.
+     * @param[in] N_dimensions The number of dimensions.
+     * @param[in] seed The seed for the random number generator, used only for the Latin hypercube.
+     * @param[out] points The points, stored contiguously, with coordinates in [0, 1).
+     */
+    static void generate_design(design_type design, int N_points, int N_dimensions, int seed, std::vector<double>& points);
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////
+  // Items related to racing several algorithms against each other:
+
+  /** \brief A class for running several algorithms on one problem concurrently, and continuing with whichever makes the best progress.
+   *
+   * Which algorithm works best for a new problem is usually found by trial and error. A Portfolio races the algorithms
+   * instead: the worker groups are divided into sub-partitions, and each algorithm added with mango::Portfolio::add_algorithm()
+   * is run on its own sub-partition, starting from the initial state vector of the problem. Every checkpoint_function_evaluations
+   * function evaluations, all the algorithms stop at a checkpoint, and their progress is compared, both per function evaluation and
+   * per second of wall-clock time. Each algorithm is ranked by both measures, and the worse half by the sum of the two ranks is eliminated.
+   * The worker groups of the eliminated algorithms are then shared among the remaining ones, until only the leading algorithm
+   * is left, and it continues with all the worker groups. Typical usage, on all processes:
+   * \code
+   * mango::Portfolio portfolio(&problem);
+   * portfolio.add_algorithm(mango::MANGO_LEVENBERG_MARQUARDT);
+   * portfolio.add_algorithm(mango::PETSC_POUNDERS);
+   * portfolio.add_algorithm(mango::HOPSPACK);
+   * portfolio.mpi_partition.set_N_worker_groups(N_worker_groups);
+   * portfolio.mpi_init(MPI_COMM_WORLD);
+   * portfolio.optimize();
+   * \endcode
+   * The problem must be created and configured on every process, and mango::Problem::mpi_init() should not be called for the problem.
+   * If the objective or residual function uses the workers of its group, the work they do each time they are mobilized must be
+   * supplied with mango::Problem::set_worker_function().
+   *
+   * The algorithms cannot be suspended and moved to a different set of worker groups while they run, so at each checkpoint
+   * an algorithm returns, and after the checkpoint it is restarted from the best point it has found, with its new sub-partition.
+   * Whatever else the algorithm had learned, such as a trust region radius or a model of the objective function, is lost at
+   * the restart, so the checkpoints should not be too frequent. An algorithm that makes no progress between two checkpoints
+   * is not restarted, but it stays in the race until it is eliminated. Algorithms that cannot use concurrent function evaluations
+   * always get a sub-partition with a single worker group, and algorithms that require bound constraints can only be used if they are set.
+   *
+   * The max_function_evaluations of the problem is the total for all the algorithms together, including one evaluation of the
+   * initial state vector, which is the reference for the progress of each algorithm. All function evaluations are written
+   * to the output file of the problem: first the initial state vector, and then the evaluations of each algorithm between each pair of
+   * checkpoints, in order of the algorithms, numbered consecutively. As usual, the last line repeats the best point found.
+   * The seconds column is measured from the start of each of these phases.
+   */
+  class Portfolio {
+  private:
+    Problem* problem;
+    std::vector<algorithm_type> portfolio_algorithms;
+    int checkpoint_function_evaluations;
+    std::vector<double> optima;
+    std::vector<int> function_evaluations;
+    std::vector<double> elapsed_times;
+    std::vector<int> eliminations;
+    int winner;
+
+  public:
+    //! The partition of the processes into the worker groups that are divided among the algorithms.
+    MPI_Partition mpi_partition;
+
+    //! Constructor
+    /**
+     * @param[in] problem A pointer to the problem to solve. The algorithm of the problem is not used, and is restored when mango::Portfolio::optimize() returns.
+     */
+    Portfolio(Problem* problem);
+
+    //! Add an algorithm to the race.
+    /**
+     * @param[in] algorithm One of the algorithms of \ref algorithm_type. Algorithms for least-squares problems can only be added if the problem is a least-squares problem.
+     */
+    void add_algorithm(algorithm_type algorithm);
+
+    //! Add an algorithm to the race, by name.
+    /**
+     * @param[in] algorithm_name The name of one of the algorithms, such as "mango_levenberg_marquardt".
+     */
+    void add_algorithm(std::string algorithm_name);
+
+    //! Set the number of function evaluations each algorithm makes between checkpoints.
+    /**
+     * @param[in] checkpoint_function_evaluations The number of function evaluations. The default is 10 * (N_parameters + 1).
+     */
+    void set_checkpoint_function_evaluations(int checkpoint_function_evaluations);
+
+    //! Initialize the partition of the processes into worker groups.
+    /**
+     * This subroutine should be called by all processes, after mango::MPI_Partition::set_N_worker_groups() if desired.
+     * @param[in] mpi_comm  The MPI communicator to use. Usually this is MPI_COMM_WORLD.
+     */
+    void mpi_init(MPI_Comm mpi_comm);
+
+    //! Race the algorithms.
+    /**
+     * This subroutine should be called by all processes. When it returns, the state vector of the problem holds
+     * the best point found, on every process. For least-squares problems, so does the array of residuals at the optimum.
+     * @return The minimum objective function found.
+     */
+    double optimize();
+
+    //! Get the number of algorithms in the race.
+    int get_N_algorithms();
+
+    //! Get the minimum objective function found by one algorithm.
+    /**
+     * This subroutine can be called on any process after mango::Portfolio::optimize().
+     * @param[in] j_algorithm The 0-based index of the algorithm, in the order in which the algorithms were added.
+     * @return The minimum objective function, or NaN if every function evaluation of the algorithm failed.
+     */
+    double get_optimum(int j_algorithm);
+
+    //! Get the number of function evaluations made by one algorithm.
+    /**
+     * This subroutine can be called on any process after mango::Portfolio::optimize().
+     * @param[in] j_algorithm The 0-based index of the algorithm.
+     */
+    int get_function_evaluations(int j_algorithm);
+
+    //! Get the wall-clock time spent by one algorithm, in seconds.
+    /**
+     * This subroutine can be called on any process after mango::Portfolio::optimize().
+     * @param[in] j_algorithm The 0-based index of the algorithm.
+     */
+    double get_elapsed_time(int j_algorithm);
+
+    //! Get the checkpoint at which one algorithm was eliminated.
+    /**
+     * This subroutine can be called on any process after mango::Portfolio::optimize().
+     * @param[in] j_algorithm The 0-based index of the algorithm.
+     * @return The 1-based index of the checkpoint, or 0 if the algorithm was never eliminated.
+     */
+    int get_elimination(int j_algorithm);
+
+    //! Get the algorithm that found the best point.
+    /**
+     * This subroutine can be called on any process after mango::Portfolio::optimize().
+     * @return The 0-based index of the algorithm, or -1 if no algorithm improved on the initial state vector.
+     */
+    int get_winner();
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////
+  // Items related to running external executables as the objective function:
+
+  /** \brief A class for evaluating the objective function or residuals by running an external executable.
+   *
+   * This class can be used in place of a hand-written objective or residual function when the
+   * physics code is a standalone executable. To use it, create an object of this type, configure it with
+   * mango::External_executable::read_input_file() or the set_* subroutines, pass the object's address to
+   * mango::Problem::set_user_data(), and pass mango::External_executable::objective_function or
+   * mango::External_executable::residual_function to the constructor of mango::Problem or mango::Least_squares_problem.
+   *
+   * Each MPI process that evaluates the function gets its own scratch directory, created inside the scratch root
+   * (which may be on a tmpfs such as /dev/shm). If several threads evaluate at once (see mango::Problem::set_N_threads()),
+   * each concurrent evaluation gets its own scratch directory, and in server mode its own server process. Two modes are available:
+   *
+   * In "file" mode, for each evaluation the state vector is written to the input file in the scratch directory,
+   * one number per line, the command is run in the scratch directory through /bin/sh, and the objective function or
+   * residuals are read from the output file, separated by whitespace.
+   *
+   * In "server" mode, the command is started once and kept running. For each evaluation, the state vector is written to
+   * the process's standard input as one line of numbers, and the process must reply with one line on its standard output
+   * containing the objective function or residuals. If the process exits or times out, it is restarted for the next evaluation.
+   *
+   * In either mode, an evaluation that exceeds the timeout, exits with nonzero status, or does not produce the expected
+   * number of values is reported to MANGO as a failed evaluation.
+   */
+  class External_executable {
+  private:
+    std::string command;
+    bool server_mode;
+    std::string scratch_root;
+    std::string input_filename;
+    std::string output_filename;
+    double timeout;
+    bool keep_scratch_directory;
+
+    // The scratch directory and server process used by one evaluation at a time. A new slot is created only when
+    // all the existing ones are in use by other threads, so a single-threaded process has a single slot.
+    struct Slot {
+      std::string scratch_directory;
+      int server_pid;
+      int server_fd;
+      std::string server_buffer;
+    };
+    std::vector<Slot*> slots;
+    std::vector<Slot*> free_slots;
+    std::mutex slots_mutex;
+
+    Slot* acquire_slot();
+    void release_slot(Slot*);
+    bool evaluate_with_files(Slot*, int, const double*, int, double*);
+    bool evaluate_with_server(Slot*, int, const double*, int, double*);
+    void start_server(Slot*);
+    void stop_server(Slot*);
+
+  public:
+    //! Constructor
+    External_executable();
+
+    //! Destructor
+    /**
+     * Any server processes are stopped, and the scratch directories are removed unless mango::External_executable::set_keep_scratch_directory() was called.
+     */
+    ~External_executable();
+
+    //! Read the configuration from a file.
+    /**
+     * Each line of the file has the form <tt>keyword = value</tt>. Blank lines and lines beginning with <tt>#</tt> or <tt>!</tt> are ignored.
+     * The recognized keywords are <tt>command</tt>, <tt>mode</tt> (<tt>file</tt> or <tt>server</tt>), <tt>scratch_root</tt>,
+     * <tt>input_filename</tt>, <tt>output_filename</tt>, <tt>timeout</tt>, and <tt>keep_scratch_directory</tt> (<tt>true</tt> or <tt>false</tt>),
+     * corresponding to the set_* subroutines of this class.
+     * @param[in] filename The name of the file to read.
+     */
+    void read_input_file(std::string filename);
+
+    //! Sets the command to run, which is interpreted by /bin/sh in the scratch directory.
+    /**
+     * Relative paths to executables should be given relative to the scratch directory, or else use absolute paths.
+     * @param[in] command The command.
+     */
+    void set_command(std::string command);
+
+    //! Choose between file mode and server mode.
+    /**
+     * @param[in] server_mode If true, the command is kept running and fed over its standard input and output. If false (the default),
+     *   the command is run once for each evaluation, communicating through files.
+     */
+    void set_server_mode(bool server_mode);
+
+    //! Sets the directory in which the per-process scratch directories are created.
+    /**
+     * The default is the current working directory.
+     * @param[in] scratch_root The directory, which must already exist. A tmpfs such as /dev/shm can be used to avoid disk traffic.
+     */
+    void set_scratch_root(std::string scratch_root);
+
+    //! Sets the names of the files used in file mode.
+    /**
+     * The defaults are <tt>mango_state_vector</tt> and <tt>mango_results</tt>.
+     * @param[in] input_filename The file to which the state vector is written.
+     * @param[in] output_filename The file from which the objective function or residuals are read.
+     */
+    void set_filenames(std::string input_filename, std::string output_filename);
+
+    //! Sets the maximum wall-clock time allowed for each evaluation.
+    /**
+     * @param[in] timeout The time in seconds. If this value is <= 0 (the default), there is no limit.
+     */
+    void set_timeout(double timeout);
+
+    //! Choose whether the scratch directory is kept after this object is destroyed.
+    /**
+     * @param[in] keep If true, the scratch directory and its contents are kept, which can be useful for debugging. The default is false.
+     */
+    void set_keep_scratch_directory(bool keep);
+
+    //! Get the scratch directory used by this MPI process.
+    /**
+     * If several threads have evaluated at once, this is the first of the scratch directories; the others have the same name followed by _1, _2, ....
+     * @return The path of the scratch directory, or an empty string if no evaluation has been carried out yet.
+     */
+    std::string get_scratch_directory();
+
+    //! Evaluate the function once.
+    /**
+     * @param[in] N_parameters The number of independent variables.
+     * @param[in] state_vector An array of size <span class="paramname">N_parameters</span>.
+     * @param[in] N_terms The number of values the command must return.
+     * @param[out] results An array of size <span class="paramname">N_terms</span>, which is set to the values returned by the command.
+     * @return true if the evaluation succeeded, false otherwise.
+     */
+    bool evaluate(int N_parameters, const double* state_vector, int N_terms, double* results);
+
+    //! An objective function, with the format of \ref objective_function_type, that runs the executable.
+    /**
+     * The <span class="paramname">user_data</span> must point to a mango::External_executable object.
+     */
+    static void objective_function(int* N_parameters, const double* state_vector, double* f, int* failed, mango::Problem* problem, void* user_data);
+
+    //! A residual function, with the format of \ref vector_function_type, that runs the executable.
+    /**
+     * The <span class="paramname">user_data</span> must point to a mango::External_executable object.
+     */
+    static void residual_function(int* N_parameters, const double* state_vector, int* N_terms, double* residuals, int* failed, mango::Problem* problem, void* user_data);
   };
 }
 
@@ -19,12 +19,22 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <utility>
 #include "mango.hpp"
 
 // Constructor
 mango::MPI_Partition::MPI_Partition() {
   N_worker_groups = -1;
   initialized = false;
+  topology = PARTITION_BY_RANK;
+  custom = false;
+  dynamic = false;
+  deep = false;
+  has_deep_layout = false;
+  command_size = 0;
+  node = -1;
+  N_nodes = -1;
+  comm_node = MPI_COMM_NULL;
   verbose = false;
 }
 
@@ -53,6 +63,12 @@ MPI_Comm mango::MPI_Partition::get_comm_group_leaders() {
   return comm_group_leaders;
 }
 
+MPI_Comm mango::MPI_Partition::get_comm_node() {
+  verify_initialized();
+  find_nodes();
+  return comm_node;
+}
+
 bool mango::MPI_Partition::get_proc0_world() {
   verify_initialized();
   return proc0_world;
@@ -108,24 +124,179 @@ void mango::MPI_Partition::set_N_worker_groups(int N_worker_groups_in) {
   N_worker_groups = N_worker_groups_in;
 }
 
+void mango::MPI_Partition::set_topology(partition_topology_type topology_in) {
+  if (initialized) throw std::runtime_error("Error! MPI_Partition::set_topology called after initialization.");
+  topology = topology_in;
+}
+
+int mango::MPI_Partition::get_node() {
+  verify_initialized();
+  find_nodes();
+  return node;
+}
+
+int mango::MPI_Partition::get_N_nodes() {
+  verify_initialized();
+  find_nodes();
+  return N_nodes;
+}
+
+void mango::MPI_Partition::repartition(int N_worker_groups_in) {
+  verify_initialized();
+  if (custom) throw std::runtime_error("Error! MPI_Partition::repartition cannot be used with a partition from set_custom.");
+  MPI_Comm comm_world_old = comm_world;
+  N_worker_groups = N_worker_groups_in;
+  init(comm_world_old); // init() makes its own duplicate of comm_world_old.
+  MPI_Comm_free(&comm_world_old);
+}
+
+void mango::MPI_Partition::free_communicators() {
+  // Free the communicators created by a previous call to init() or set_custom().
+  // The communicators passed to set_custom() belong to the caller, so only comm_node is freed in that case.
+  if (comm_node != MPI_COMM_NULL) MPI_Comm_free(&comm_node);
+  node = -1;
+  N_nodes = -1;
+  if (custom) return;
+  MPI_Comm_free(&comm_worker_groups);
+  if (comm_group_leaders != MPI_COMM_NULL) MPI_Comm_free(&comm_group_leaders);
+  if (has_deep_layout) {
+    MPI_Comm_free(&other_comm_worker_groups);
+    if (other_comm_group_leaders != MPI_COMM_NULL) MPI_Comm_free(&other_comm_group_leaders);
+  }
+}
+
+void mango::MPI_Partition::set_dynamic(bool dynamic_in) {
+  dynamic = dynamic_in;
+}
+
+bool mango::MPI_Partition::get_dynamic() {
+  verify_initialized();
+  return has_deep_layout;
+}
+
+bool mango::MPI_Partition::get_deep() {
+  verify_initialized();
+  return deep;
+}
+
+void mango::MPI_Partition::init_deep_layout() {
+  // Create the deep layout, in which there is a single worker group containing every proc, alongside the wide layout made by init().
+  int ierr = MPI_Comm_dup(comm_world, &other_comm_worker_groups);
+  if (ierr != 0) throw std::runtime_error("Error 1 in mango::MPI_Partition::init_deep_layout.");
+  ierr = MPI_Comm_split(comm_world, (proc0_world ? 0 : MPI_UNDEFINED), rank_world, &other_comm_group_leaders);
+  if (ierr != 0) throw std::runtime_error("Error 2 in mango::MPI_Partition::init_deep_layout.");
+  other_N_procs_worker_groups = N_procs_world;
+  other_rank_worker_groups = rank_world;
+  other_N_procs_group_leaders = (proc0_world ? 1 : -1);
+  other_rank_group_leaders = (proc0_world ? 0 : -1);
+  other_worker_group = 0;
+  other_proc0_worker_groups = proc0_world;
+  other_N_worker_groups = 1;
+  has_deep_layout = true;
+}
+
+void mango::MPI_Partition::swap_layouts() {
+  std::swap(comm_worker_groups, other_comm_worker_groups);
+  std::swap(comm_group_leaders, other_comm_group_leaders);
+  std::swap(N_procs_worker_groups, other_N_procs_worker_groups);
+  std::swap(rank_worker_groups, other_rank_worker_groups);
+  std::swap(N_procs_group_leaders, other_N_procs_group_leaders);
+  std::swap(rank_group_leaders, other_rank_group_leaders);
+  std::swap(worker_group, other_worker_group);
+  std::swap(proc0_worker_groups, other_proc0_worker_groups);
+  std::swap(N_worker_groups, other_N_worker_groups);
+  deep = !deep;
+}
+
+void mango::MPI_Partition::switch_layout() {
+  // This method should only be called from group leaders of the layout in use.
+  verify_initialized();
+  if (!has_deep_layout) throw std::runtime_error("Error! MPI_Partition::switch_layout was called, but dynamic layouts are not enabled.");
+  if (!proc0_worker_groups) throw std::runtime_error("mango::MPI_Partition::switch_layout() should only be called from group leaders.");
+  int command = -2; // Tells the workers to switch layouts.
+  int task = 0;
+  broadcast_command(&command, &task, NULL, NULL);
+  swap_layouts();
+}
+
+void mango::MPI_Partition::set_command_size(int command_size_in) {
+  if (command_size_in < 0) throw std::runtime_error("Error! MPI_Partition::set_command_size must be >= 0.");
+  command_size = command_size_in;
+}
+
+int mango::MPI_Partition::get_command_size() {
+  return command_size;
+}
+
+void mango::MPI_Partition::init_command_buffer() {
+  // Make sure all procs agree on the size of the messages sent to the workers.
+  MPI_Bcast(&command_size, 1, MPI_INT, 0, comm_world);
+  int header_size, data_size;
+  MPI_Pack_size(3, MPI_INT, comm_world, &header_size);
+  MPI_Pack_size(command_size, MPI_DOUBLE, comm_world, &data_size);
+  command_buffer.resize(header_size + data_size);
+}
+
+void mango::MPI_Partition::broadcast_command(int* command, int* task, const double* data_in, double* data_out) {
+  // Every message from a group leader to its workers goes through this subroutine, so each one is a single broadcast.
+  // The message holds the command (>= 0 to mobilize the workers, -1 to stop them, or -2 to switch layouts),
+  // the task ID, a flag indicating whether data are included, and the data.
+  // On the group leader, data_in is sent if it is not NULL. On the workers, the data are copied to data_out if both are available.
+  int buffer_size = command_buffer.size();
+  int position = 0;
+  int header[3];
+  if (proc0_worker_groups) {
+    header[0] = *command;
+    header[1] = *task;
+    header[2] = (data_in != NULL && command_size > 0) ? 1 : 0;
+    MPI_Pack(header, 3, MPI_INT, command_buffer.data(), buffer_size, &position, comm_worker_groups);
+    if (header[2]) MPI_Pack(data_in, command_size, MPI_DOUBLE, command_buffer.data(), buffer_size, &position, comm_worker_groups);
+  }
+  MPI_Bcast(command_buffer.data(), buffer_size, MPI_PACKED, 0, comm_worker_groups);
+  if (!proc0_worker_groups) {
+    MPI_Unpack(command_buffer.data(), buffer_size, &position, header, 3, MPI_INT, comm_worker_groups);
+    *command = header[0];
+    *task = header[1];
+    if (header[2] && data_out != NULL) MPI_Unpack(command_buffer.data(), buffer_size, &position, data_out, command_size, MPI_DOUBLE, comm_worker_groups);
+  }
+}
+
 void mango::MPI_Partition::stop_workers() {
   // This method should only be called from group leaders.
   if (!proc0_worker_groups) throw std::runtime_error("mango::MPI_Partition::stop_workers() should only be called from group leaders.");
-  int data = -1; // Any negative value will do here.
-  MPI_Bcast(&data, 1, MPI_INT, 0, comm_worker_groups);
+  int command = -1; // Any negative value will do here.
+  int task = 0;
+  broadcast_command(&command, &task, NULL, NULL);
 }
 
 void mango::MPI_Partition::mobilize_workers() {
+  mobilize_workers(0, NULL);
+}
+
+void mango::MPI_Partition::mobilize_workers(int task, const double* data) {
   // This method should only be called from group leaders.
   if (!proc0_worker_groups) throw std::runtime_error("mango::MPI_Partition::mobilize_workers() should only be called from group leaders.");
-  int data = 1; // Any nonnegative value will do here.
-  MPI_Bcast(&data, 1, MPI_INT, 0, comm_worker_groups);
+  int command = 1; // Any nonnegative value will do here.
+  broadcast_command(&command, &task, data, NULL);
 }
 
 bool mango::MPI_Partition::continue_worker_loop() {
+  return continue_worker_loop(NULL, NULL);
+}
+
+bool mango::MPI_Partition::continue_worker_loop(int* task_out, double* data) {
   // This method should NOT be called from group leaders.
   if (proc0_worker_groups) throw std::runtime_error("mango::MPI_Partition::continue_worker_loop() should not be called from group leaders.");
-  int data;
-  MPI_Bcast(&data, 1, MPI_INT, 0, comm_worker_groups);
-  return (data >= 0);
+  int command, task;
+  while (true) {
+    broadcast_command(&command, &task, NULL, data);
+    if (command != -2) {
+      if (task_out != NULL) *task_out = task;
+      return (command >= 0);
+    }
+    // The group leader is switching layouts.
+    swap_layouts();
+    // If this proc leads a group in the new layout, it must leave the worker loop.
+    if (proc0_worker_groups) return false;
+  }
 }
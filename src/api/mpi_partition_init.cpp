@@ -24,6 +24,13 @@
 void mango::MPI_Partition::init(MPI_Comm mpi_comm_world_in) {
   int ierr;
 
+  // If this partition was initialized before, free the old communicators, except comm_world which may be the argument.
+  if (initialized) free_communicators();
+  initialized = false;
+  custom = false;
+  has_deep_layout = false;
+  deep = false;
+
   ierr = MPI_Comm_dup(mpi_comm_world_in, &comm_world);
   if (ierr != 0) throw std::runtime_error("Error 1 in mango::MPI_Partition::init.");
 
@@ -43,7 +50,12 @@ void mango::MPI_Partition::init(MPI_Comm mpi_comm_world_in) {
 
   // if (proc0_world) std::cout << "Number of worker groups, after validation: " << N_worker_groups << std::endl;
 
-  worker_group = (rank_world * N_worker_groups) / N_procs_world; // Note integer division, so there is an implied floor()
+  // The node communicator is only created if it is needed, by find_nodes().
+  if (topology == PARTITION_BY_RANK) {
+    worker_group = (rank_world * N_worker_groups) / N_procs_world; // Note integer division, so there is an implied floor()
+  } else {
+    assign_worker_groups_by_topology();
+  }
 
   // color = worker_group, key = rank_world
 
@@ -72,6 +84,9 @@ void mango::MPI_Partition::init(MPI_Comm mpi_comm_world_in) {
     N_procs_group_leaders = -1;
   }
 
+  if (dynamic && N_worker_groups > 1) init_deep_layout();
+  init_command_buffer();
+
   print();
   initialized = true;
 }
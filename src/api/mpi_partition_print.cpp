@@ -49,9 +49,13 @@ void mango::MPI_Partition::print() {
 
 
 void mango::MPI_Partition::write(std::string filename) {
-  const int N_data_items = 8;
-  std::string columns[N_data_items] = {"rank_world","N_procs_world","worker_group","N_worker_groups","rank_worker_groups","N_procs_worker_groups","rank_group_leaders","N_procs_group_leaders"};
-  int            data[N_data_items] = { rank_world , N_procs_world , worker_group , N_worker_groups , rank_worker_groups , N_procs_worker_groups , rank_group_leaders , N_procs_group_leaders };
+  find_nodes();
+  const int N_data_items = 10;
+  std::string columns[N_data_items] = {"rank_world","N_procs_world","worker_group","N_worker_groups","rank_worker_groups","N_procs_worker_groups","rank_group_leaders","N_procs_group_leaders","node","N_nodes"};
+  int            data[N_data_items] = { rank_world , N_procs_world , worker_group , N_worker_groups , rank_worker_groups , N_procs_worker_groups , rank_group_leaders , N_procs_group_leaders , node , N_nodes };
+  char processor_name[MPI_MAX_PROCESSOR_NAME];
+  int processor_name_length;
+  MPI_Get_processor_name(processor_name, &processor_name_length);
 
   std::ofstream output_file;
   int j;
@@ -67,7 +71,7 @@ void mango::MPI_Partition::write(std::string filename) {
     // Write the header line
     output_file << columns[0];
     for (j=1; j<N_data_items; j++) output_file << ", " << columns[j];
-    output_file << std::endl;
+    output_file << ", processor_name" << std::endl;
   }
 
   MPI_Status status;
@@ -75,14 +79,16 @@ void mango::MPI_Partition::write(std::string filename) {
   MPI_Barrier(comm_world);
   // Each processor sends their data to proc0_world, and proc0_world writes the result to the file in order.
   if (proc0_world) {
-    write_line(output_file, N_data_items, columns, data);
+    write_line(output_file, N_data_items, columns, data, processor_name);
     for (tag = 1; tag < N_procs_world; tag++) {
       MPI_Recv(data, N_data_items, MPI_INT, tag, tag, comm_world, &status);
-      write_line(output_file, N_data_items, columns, data);
+      MPI_Recv(processor_name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, tag, tag, comm_world, &status);
+      write_line(output_file, N_data_items, columns, data, processor_name);
     }
   } else {
     tag = rank_world;
     MPI_Send(data, N_data_items, MPI_INT, 0, tag, comm_world);
+    MPI_Send(processor_name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, tag, comm_world);
   }
 
 
@@ -90,9 +96,9 @@ void mango::MPI_Partition::write(std::string filename) {
 }
 
 
-void mango::MPI_Partition::write_line(std::ofstream& output_file, int N_data_items, std::string columns[], int data[]) {
+void mango::MPI_Partition::write_line(std::ofstream& output_file, int N_data_items, std::string columns[], int data[], std::string processor_name) {
   // This subroutine writes one line of the mango_mpi output file.
   output_file << std::setw(columns[0].length()) << data[0];
   for (int j=1; j<N_data_items; j++)  output_file << ", " << std::setw(columns[j].length()) << data[j];
-  output_file << std::endl;
+  output_file << ", " << processor_name << std::endl;
 }
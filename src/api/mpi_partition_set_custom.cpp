@@ -26,6 +26,13 @@ void mango::MPI_Partition::set_custom(MPI_Comm comm_world_in, MPI_Comm comm_grou
 
   int ierr;
   
+  // If this partition was initialized before, free the communicators it created.
+  if (initialized) free_communicators();
+  initialized = false;
+  custom = true;
+  // Dynamic layouts are not available for custom partitions.
+  has_deep_layout = false;
+  deep = false;
   comm_world = comm_world_in;
   comm_group_leaders = comm_group_leaders_in;
   comm_worker_groups = comm_worker_groups_in;
@@ -61,6 +68,8 @@ void mango::MPI_Partition::set_custom(MPI_Comm comm_world_in, MPI_Comm comm_grou
   worker_group = rank_group_leaders; // We'll say the worker group corresponds to the rank of the corresponding master proc in comm_group_leaders.
   MPI_Bcast(&worker_group, 1, MPI_INT, 0, comm_worker_groups);
 
+  // The node communicator is only created if it is needed, by find_nodes().
+  init_command_buffer();
   print();
   initialized = true;
 }
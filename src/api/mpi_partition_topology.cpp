@@ -0,0 +1,175 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <mpi.h>
+#include "mango.hpp"
+
+void mango::MPI_Partition::find_domains(MPI_Comm comm, partition_topology_type domain_type, int* my_domain, int* N_domains, int* domain_of_proc, MPI_Comm* comm_domain_out) {
+  // Determine which processes in comm share a node (or NUMA domain). On exit, *my_domain is the index of this process's domain,
+  // *N_domains is the number of domains, and if domain_of_proc is not NULL, it is filled with the domain of every process in comm.
+  // Domains are numbered in order of the lowest rank in each. If comm_domain_out is not NULL, it is set to a communicator
+  // containing the processes in this process's domain, ordered by rank in comm; otherwise that communicator is freed.
+  int rank, N_procs;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &N_procs);
+
+  MPI_Comm comm_domain = MPI_COMM_NULL;
+  if (domain_type == PARTITION_BY_NUMA) {
+#if defined(OPEN_MPI)
+    MPI_Comm_split_type(comm, OMPI_COMM_TYPE_NUMA, rank, MPI_INFO_NULL, &comm_domain);
+#elif MPI_VERSION >= 4
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "mpi_hw_resource_type", "NUMANode");
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_HW_GUIDED, rank, info, &comm_domain);
+    MPI_Info_free(&info);
+#endif
+    // If the MPI library cannot detect NUMA domains (for instance if the processes are not bound), fall back to nodes.
+    int any_failed = (comm_domain == MPI_COMM_NULL);
+    MPI_Allreduce(MPI_IN_PLACE, &any_failed, 1, MPI_INT, MPI_MAX, comm);
+    if (any_failed) {
+      if (comm_domain != MPI_COMM_NULL) MPI_Comm_free(&comm_domain);
+      comm_domain = MPI_COMM_NULL;
+      if (rank == 0) std::cerr << "WARNING! NUMA domains could not be determined, so worker groups will be aligned to nodes instead." << std::endl;
+    }
+  }
+  if (comm_domain == MPI_COMM_NULL) MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &comm_domain);
+
+  // The lowest rank in each domain identifies the domain.
+  int domain_leader = rank;
+  MPI_Allreduce(MPI_IN_PLACE, &domain_leader, 1, MPI_INT, MPI_MIN, comm_domain);
+  if (comm_domain_out != NULL) {
+    *comm_domain_out = comm_domain;
+  } else {
+    MPI_Comm_free(&comm_domain);
+  }
+  std::vector<int> leaders(N_procs);
+  MPI_Allgather(&domain_leader, 1, MPI_INT, leaders.data(), 1, MPI_INT, comm);
+
+  std::vector<int> index(N_procs, -1);
+  int count = 0;
+  for (int j = 0; j < N_procs; j++) {
+    if (leaders[j] == j) index[j] = count++;
+  }
+  *N_domains = count;
+  *my_domain = index[domain_leader];
+  if (domain_of_proc != NULL) {
+    for (int j = 0; j < N_procs; j++) domain_of_proc[j] = index[leaders[j]];
+  }
+}
+
+void mango::MPI_Partition::find_nodes() {
+  // Create comm_node and set node and N_nodes, if this has not been done since the last call to init() or set_custom().
+  // This is not done in init(), since it is a collective operation that the default PARTITION_BY_RANK layout does not need.
+  // All processes in comm_world must call this subroutine the first time.
+  if (comm_node != MPI_COMM_NULL) return;
+  find_domains(comm_world, PARTITION_BY_NODE, &node, &N_nodes, NULL, &comm_node);
+}
+
+void mango::MPI_Partition::assign_worker_groups_to_domains(int N_procs, const int* domain_of_proc, int N_worker_groups, int* worker_group_of_proc) {
+  if (N_worker_groups < 1 || N_worker_groups > N_procs) throw std::runtime_error("Error in mango::MPI_Partition::assign_worker_groups_to_domains. N_worker_groups is out of range.");
+
+  int N_domains = 0;
+  for (int j = 0; j < N_procs; j++) if (domain_of_proc[j] + 1 > N_domains) N_domains = domain_of_proc[j] + 1;
+  std::vector<int> procs_per_domain(N_domains, 0);
+  for (int j = 0; j < N_procs; j++) procs_per_domain[domain_of_proc[j]]++;
+
+  std::vector<int> group_of_proc(N_procs);
+  int k;
+  if (N_worker_groups < N_domains) {
+    // Some worker groups must span several domains. Assign whole domains to worker groups, in contiguous blocks.
+    for (int j = 0; j < N_procs; j++) group_of_proc[j] = (domain_of_proc[j] * N_worker_groups) / N_domains;
+
+  } else {
+    // Distribute the worker groups among the domains in proportion to the number of processes in each,
+    // with at least 1 and at most procs_per_domain[k] worker groups in domain k.
+    std::vector<int> groups_per_domain(N_domains);
+    int N_assigned = 0;
+    for (k = 0; k < N_domains; k++) {
+      groups_per_domain[k] = (N_worker_groups * procs_per_domain[k]) / N_procs;
+      if (groups_per_domain[k] < 1) groups_per_domain[k] = 1;
+      N_assigned += groups_per_domain[k];
+    }
+    // Adjust, one group at a time, giving a group to the domain with the largest groups or taking one from the domain with the smallest groups.
+    while (N_assigned != N_worker_groups) {
+      int best = -1;
+      for (k = 0; k < N_domains; k++) {
+	if (N_assigned < N_worker_groups) {
+	  if (groups_per_domain[k] >= procs_per_domain[k]) continue;
+	  if (best < 0 || procs_per_domain[k] * groups_per_domain[best] > procs_per_domain[best] * groups_per_domain[k]) best = k;
+	} else {
+	  if (groups_per_domain[k] <= 1) continue;
+	  if (best < 0 || procs_per_domain[k] * groups_per_domain[best] < procs_per_domain[best] * groups_per_domain[k]) best = k;
+	}
+      }
+      groups_per_domain[best] += (N_assigned < N_worker_groups) ? 1 : -1;
+      N_assigned += (N_assigned < N_worker_groups) ? 1 : -1;
+    }
+
+    // Within each domain, divide the processes evenly among that domain's worker groups, in rank order.
+    std::vector<int> first_group(N_domains, 0);
+    for (k = 1; k < N_domains; k++) first_group[k] = first_group[k-1] + groups_per_domain[k-1];
+    std::vector<int> rank_in_domain(N_domains, 0);
+    for (int j = 0; j < N_procs; j++) {
+      k = domain_of_proc[j];
+      group_of_proc[j] = first_group[k] + (rank_in_domain[k] * groups_per_domain[k]) / procs_per_domain[k];
+      rank_in_domain[k]++;
+    }
+  }
+
+  // Renumber the worker groups in order of their first process, so the group leaders are ordered
+  // the same way in comm_group_leaders and in comm_world.
+  std::vector<int> new_label(N_worker_groups, -1);
+  int N_labeled = 0;
+  for (int j = 0; j < N_procs; j++) {
+    if (new_label[group_of_proc[j]] < 0) new_label[group_of_proc[j]] = N_labeled++;
+    worker_group_of_proc[j] = new_label[group_of_proc[j]];
+  }
+}
+
+void mango::MPI_Partition::assign_worker_groups_by_topology() {
+  // This subroutine is called by init() to set worker_group when topology is not PARTITION_BY_RANK.
+  std::vector<int> domain_of_proc(N_procs_world), worker_group_of_proc(N_procs_world);
+  int my_domain, N_domains;
+  find_domains(comm_world, topology, &my_domain, &N_domains, domain_of_proc.data(), NULL);
+  assign_worker_groups_to_domains(N_procs_world, domain_of_proc.data(), N_worker_groups, worker_group_of_proc.data());
+  worker_group = worker_group_of_proc[rank_world];
+
+  if (!proc0_world) return;
+  // Report any imbalance that had to be accepted.
+  std::string domain_name = (topology == PARTITION_BY_NUMA) ? "NUMA domains" : "nodes";
+  std::vector<int> group_sizes(N_worker_groups, 0);
+  for (int j = 0; j < N_procs_world; j++) group_sizes[worker_group_of_proc[j]]++;
+  int min_size = N_procs_world, max_size = 0;
+  for (int j = 0; j < N_worker_groups; j++) {
+    if (group_sizes[j] < min_size) min_size = group_sizes[j];
+    if (group_sizes[j] > max_size) max_size = group_sizes[j];
+  }
+  if (N_worker_groups < N_domains) {
+    std::cerr << "WARNING! There are fewer worker groups (" << N_worker_groups << ") than " << domain_name << " (" << N_domains
+	      << "), so some worker groups span more than one." << std::endl;
+  }
+  // The default partition never differs by more than 1 process between worker groups, so only report worse imbalance.
+  if (max_size - min_size > 1) {
+    std::cerr << "WARNING! To align worker groups with " << domain_name << ", worker groups have between " << min_size << " and " << max_size << " processes." << std::endl;
+  }
+}
@@ -27,6 +27,9 @@
 void mango::Solver::objective_function_wrapper(const double* x, double* f, bool* failed) {
   if (verbose > 0) std::cout << "Hello from objective_function_wrapper" << std::endl;
 
+  // A single point is being evaluated, so let every proc help with it if possible.
+  set_layout(true);
+
   int failed_int = 123;
   objective_function(&N_parameters, x, f, &failed_int, problem, user_data);
   *failed = (failed_int != 0);
@@ -55,9 +58,23 @@ bool mango::Solver::record_function_evaluation(const double* x, double f, bool f
     best_time = now;
   }
 
-  if (mpi_partition->get_proc0_world()) recorder->record_function_evaluation(function_evaluations, now, x, f);
+  if (mpi_partition->get_proc0_world()) {
+    recorder->record_function_evaluation(function_evaluations, now, x, f);
+    metrics->record_function_evaluation(new_optimum, failed);
+    if (!observers.empty()) notify_observers(x, f, new_optimum, now);
+  }
 
   return new_optimum;
 }
 
 
+void mango::Solver::notify_observers(const double* x, double f, bool new_optimum, clock_t now) {
+  int N_terms = 0;
+  int new_optimum_int = (new_optimum ? 1 : 0);
+  double elapsed_time = ((double)(now - start_time)) / CLOCKS_PER_SEC;
+  for (int j=0; j<observers.size(); j++) {
+    observers[j](&function_evaluations, &N_parameters, x, &f, &N_terms, NULL, &new_optimum_int, &elapsed_time, problem, observer_data[j]);
+  }
+}
+
+
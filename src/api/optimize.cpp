@@ -35,8 +35,10 @@ double mango::Solver::optimize(MPI_Partition* mpi_partition_in) {
 
   init_optimization();
 
-  if (algorithms[algorithm].uses_derivatives && !proc0_world) {
+  if (algorithms[algorithm].uses_derivatives && !proc0_world && algorithms[algorithm].package != PACKAGE_MANGO) {
     // All group leaders that are not proc0_world do group_leaders_loop(), then return.
+    // MANGO's own algorithms are excluded, as in optimize_least_squares(), since they evaluate their line searches
+    // concurrently as well as their gradients, so they launch their own parallel evaluations on every group leader.
     group_leaders_loop();
     return(std::numeric_limits<double>::quiet_NaN());
   }
@@ -51,16 +53,23 @@ double mango::Solver::optimize(MPI_Partition* mpi_partition_in) {
   // Hand control over to one of the concrete Packages to carry out the main work of the optimization.
   package->optimize(this);
 
-  if (!proc0_world) return(std::numeric_limits<double>::quiet_NaN());
+  if (!proc0_world) {
+    // Receive the exit code that proc0_world sends below, so it is not mistaken for a later message (e.g. in Solver::session_loop()).
+    int data;
+    MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+    return(std::numeric_limits<double>::quiet_NaN());
+  }
   // Only proc0_world continues past this point.
 
-  // Tell the other group leaders to exit.
+  // Restore the wide layout, so the other group leaders are in group_leaders_loop() again, then tell them to exit.
+  set_layout(false);
   int data = -1;
   MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
 
   memcpy(state_vector, best_state_vector, N_parameters * sizeof(double)); // Make sure we leave state_vector equal to the best state vector seen.
 
   recorder->finalize();
+  metrics->finalize();
 
   if (verbose > 0) {
     std::cout << "Here comes the optimal state_vector from optimize.cpp: " << state_vector[0];
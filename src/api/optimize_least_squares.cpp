@@ -112,16 +112,23 @@ double mango::Least_squares_solver::optimize(MPI_Partition* mpi_partition_in) {
     package->optimize(this);
   }
 
-  if (!proc0_world) return std::numeric_limits<double>::quiet_NaN();
+  if (!proc0_world) {
+    // Receive the exit code that proc0_world sends below, so it is not mistaken for a later message (e.g. in Solver::session_loop()).
+    int data;
+    MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+    return std::numeric_limits<double>::quiet_NaN();
+  }
   // Only proc0_world continues past this point.
 
-  // Tell the other group leaders to exit.
+  // Restore the wide layout, so the other group leaders are in group_leaders_loop() again, then tell them to exit.
+  set_layout(false);
   int data = -1;
   MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
 
   memcpy(state_vector, best_state_vector, N_parameters * sizeof(double)); // Make sure we leave state_vector equal to the best state vector seen.
 
   recorder->finalize();
+  metrics->finalize();
   /*
   // Copy the line corresponding to the optimum to the bottom of the output file.
   int function_evaluations_temp= function_evaluations;
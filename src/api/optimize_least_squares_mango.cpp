@@ -24,6 +24,7 @@
 // <includes>
     // This section was automatically generated by ./update_algorithms
 #include "Levenberg_marquardt.hpp"
+#include "Pounders.hpp"
 // </includes>
 
 void mango::Package_mango::optimize_least_squares(Least_squares_solver* solver) {
@@ -37,6 +38,9 @@ void mango::Package_mango::optimize_least_squares(Least_squares_solver* solver)
   case MANGO_LEVENBERG_MARQUARDT:
     algorithm = new Levenberg_marquardt(solver);
     break;
+  case MANGO_POUNDERS:
+    algorithm = new Pounders(solver);
+    break;
     // </algorithms>
   default:
     throw std::runtime_error("Error in mango::Package_mango::optimize_least_squares. Unexpected algorithm.");
@@ -21,7 +21,14 @@
 #include "Package_mango.hpp"
 // <includes>
     // This section was automatically generated by ./update_algorithms
+#include "Lbfgs.hpp"
 #include "Imfil.hpp"
+#include "Multidirectional_search.hpp"
+#include "Cmaes.hpp"
+#include "Differential_evolution.hpp"
+#include "Bayesian_optimization.hpp"
+#include "Direct.hpp"
+#include "Direct_l.hpp"
 // </includes>
 
 void mango::Package_mango::optimize(Solver* solver) {
@@ -30,9 +37,30 @@ void mango::Package_mango::optimize(Solver* solver) {
   switch (solver->algorithm) {
     // <algorithms>
     // This section was automatically generated by ./update_algorithms
+  case MANGO_LBFGS:
+    algorithm = new Lbfgs(solver);
+    break;
   case MANGO_IMFIL:
     algorithm = new Imfil(solver);
     break;
+  case MANGO_MULTIDIRECTIONAL_SEARCH:
+    algorithm = new Multidirectional_search(solver);
+    break;
+  case MANGO_CMAES:
+    algorithm = new Cmaes(solver);
+    break;
+  case MANGO_DIFFERENTIAL_EVOLUTION:
+    algorithm = new Differential_evolution(solver);
+    break;
+  case MANGO_BAYESIAN_OPTIMIZATION:
+    algorithm = new Bayesian_optimization(solver);
+    break;
+  case MANGO_DIRECT:
+    algorithm = new Direct(solver);
+    break;
+  case MANGO_DIRECT_L:
+    algorithm = new Direct_l(solver);
+    break;
     // </algorithms>
   default:
     throw std::runtime_error("Error in mango::Package_mango::optimize(). Unexpected algorithm.");
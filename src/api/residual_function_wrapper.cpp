@@ -33,6 +33,9 @@ void mango::Least_squares_solver::residual_function_wrapper(const double* x, dou
 
   // For non-least-squares algorithms, 
 
+  // A single point is being evaluated, so let every proc help with it if possible.
+  set_layout(true);
+
   int failed_int;
   residual_function(&(N_parameters), x, &N_terms, f, &failed_int, problem, user_data);
   *failed = (failed_int != 0);
@@ -87,6 +90,16 @@ bool mango::Least_squares_solver::record_function_evaluation(const double* x, do
 }
 
 
+void mango::Least_squares_solver::notify_observers(const double* x, double f, bool new_optimum, clock_t now) {
+  // This method overrides mango::Solver::notify_observers(), so the observers also receive the residuals.
+  int new_optimum_int = (new_optimum ? 1 : 0);
+  double elapsed_time = ((double)(now - start_time)) / CLOCKS_PER_SEC;
+  for (int j=0; j<observers.size(); j++) {
+    observers[j](&function_evaluations, &N_parameters, x, &f, &N_terms, current_residuals, &new_optimum_int, &elapsed_time, problem, observer_data[j]);
+  }
+}
+
+
 void mango::Least_squares_solver::objective_function_wrapper(const double* x, double* f, bool* failed) {
   // This method overrides mango::Solver::objective_function_wrapper().
   // The difference from that method is that here we do not call record_function_evaluation,
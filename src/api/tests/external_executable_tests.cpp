@@ -0,0 +1,163 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include "catch.hpp"
+#include "mango.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <ctime>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// The unit tests are run from the tests/ directory, which contains the fake_simulation script.
+std::string fake_simulation_path() {
+  char buffer[4096];
+  if (getcwd(buffer, sizeof(buffer)) == NULL) return "fake_simulation";
+  return std::string(buffer) + "/fake_simulation";
+}
+
+TEST_CASE("External_executable: evaluations through files and through a server.","[External_executable]") {
+  mango::External_executable executable;
+  const int N_parameters = 2;
+  double x[N_parameters] = {1.5, -0.5};
+  const int N_terms = 3;
+  double results[N_terms];
+  // result j = sum_i (x_i - j)^2:
+  double correct_results[N_terms] = {2.5, 2.5, 6.5};
+
+  SECTION("File mode") {
+    executable.set_command(fake_simulation_path() + " file 3");
+    CHECK(executable.evaluate(N_parameters, x, N_terms, results));
+    for (int j = 0; j < N_terms; j++) CHECK(results[j] == Approx(correct_results[j]).epsilon(1e-14));
+    // A second evaluation at a new point should not reuse the old results.
+    x[0] = 0;
+    x[1] = 0;
+    CHECK(executable.evaluate(N_parameters, x, N_terms, results));
+    CHECK(results[0] == Approx(0.0).margin(1e-14));
+    CHECK(results[2] == Approx(8.0).epsilon(1e-14));
+  }
+
+  SECTION("Server mode") {
+    executable.set_command(fake_simulation_path() + " server 3");
+    executable.set_server_mode(true);
+    executable.set_timeout(10);
+    for (int k = 0; k < 3; k++) {
+      CHECK(executable.evaluate(N_parameters, x, N_terms, results));
+      for (int j = 0; j < N_terms; j++) CHECK(results[j] == Approx(correct_results[j]).epsilon(1e-14));
+    }
+    // The server should have been started only once:
+    std::string starts_filename = executable.get_scratch_directory() + "/server_starts";
+    std::ifstream starts_file(starts_filename.c_str());
+    std::string line;
+    int N_starts = 0;
+    while (std::getline(starts_file, line)) N_starts++;
+    starts_file.close();
+    CHECK(N_starts == 1);
+    std::remove(starts_filename.c_str());
+  }
+
+  SECTION("Several threads at once") {
+    // The command is slow enough that the evaluations overlap, so they must not share a scratch directory.
+    executable.set_command("sleep 0.2; " + fake_simulation_path() + " file 3");
+    const int N_threads = 4;
+    double thread_x[N_threads][N_parameters];
+    double thread_results[N_threads][N_terms];
+    bool thread_succeeded[N_threads];
+    std::vector<std::thread> threads;
+    for (int k = 0; k < N_threads; k++) {
+      thread_x[k][0] = k;
+      thread_x[k][1] = -k;
+      threads.push_back(std::thread([&, k]() { thread_succeeded[k] = executable.evaluate(N_parameters, thread_x[k], N_terms, thread_results[k]); }));
+    }
+    for (int k = 0; k < N_threads; k++) threads[k].join();
+    for (int k = 0; k < N_threads; k++) {
+      CAPTURE(k);
+      CHECK(thread_succeeded[k]);
+      for (int j = 0; j < N_terms; j++) CHECK(thread_results[k][j] == Approx((k - j) * (k - j) + (k + j) * (k + j)).epsilon(1e-14));
+    }
+    struct stat info;
+    CHECK(stat((executable.get_scratch_directory() + "_1").c_str(), &info) == 0);
+  }
+
+  SECTION("Failures and timeouts") {
+    executable.set_command(fake_simulation_path() + " fail");
+    CHECK_FALSE(executable.evaluate(N_parameters, x, N_terms, results));
+
+    // The command exits without writing the results:
+    executable.set_command("true");
+    CHECK_FALSE(executable.evaluate(N_parameters, x, N_terms, results));
+
+    // Too few results:
+    executable.set_command(fake_simulation_path() + " file 2");
+    CHECK_FALSE(executable.evaluate(N_parameters, x, N_terms, results));
+
+    time_t start_time = time(NULL);
+    executable.set_command("sleep 20");
+    executable.set_timeout(0.2);
+    CHECK_FALSE(executable.evaluate(N_parameters, x, N_terms, results));
+
+    // A server that hangs, and a server that exits immediately:
+    executable.set_server_mode(true);
+    CHECK_FALSE(executable.evaluate(N_parameters, x, N_terms, results));
+    executable.set_command("true");
+    CHECK_FALSE(executable.evaluate(N_parameters, x, N_terms, results));
+    CHECK(time(NULL) - start_time < 10);
+  }
+}
+
+TEST_CASE("External_executable: configuration from an input file and use as a residual function.","[External_executable]") {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  std::ostringstream input_filename;
+  input_filename << "mango_external_executable.temp." << rank;
+  std::ofstream input_file(input_filename.str().c_str());
+  input_file << "# A configuration for the fake simulation" << std::endl;
+  input_file << "command = " << fake_simulation_path() << " server 2" << std::endl;
+  input_file << "mode = server" << std::endl;
+  input_file << "timeout = 10" << std::endl;
+  input_file << std::endl;
+  input_file << "scratch_root = ." << std::endl;
+  input_file.close();
+
+  mango::External_executable executable;
+  executable.read_input_file(input_filename.str());
+  std::remove(input_filename.str().c_str());
+
+  int N_parameters = 3;
+  int N_terms = 2;
+  double x[] = {1.0, 2.0, 3.0};
+  double residuals[2];
+  int failed = 1;
+  mango::External_executable::residual_function(&N_parameters, x, &N_terms, residuals, &failed, NULL, &executable);
+  CHECK(failed == 0);
+  CHECK(residuals[0] == Approx(14.0).epsilon(1e-14));
+  CHECK(residuals[1] == Approx(5.0).epsilon(1e-14));
+
+  double f;
+  N_parameters = 1;
+  mango::External_executable::objective_function(&N_parameters, x, &f, &failed, NULL, &executable);
+  CHECK(failed == 0);
+  CHECK(f == Approx(1.0).epsilon(1e-14));
+  std::remove((executable.get_scratch_directory() + "/server_starts").c_str());
+}
@@ -21,10 +21,17 @@
 #include "Solver.hpp"
 #include "Least_squares_solver.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <iomanip>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <chrono>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Test finite-difference gradient, for a non-least-squares problem.
@@ -36,6 +43,57 @@ void objective_function_1(int* N_parameters, const double* x, double* f, int* fa
   *failed_int = false;
 }
 
+// Record which threads evaluate the objective function, to check that the threaded backend is actually used.
+std::set<std::thread::id> objective_thread_ids;
+std::mutex objective_thread_ids_mutex;
+
+void objective_function_1_recording_threads(int* N_parameters, const double* x, double* f, int* failed_int, mango::Problem* problem, void* user_data) {
+  {
+    std::lock_guard<std::mutex> lock(objective_thread_ids_mutex);
+    objective_thread_ids.insert(std::this_thread::get_id());
+  }
+  // Make each evaluation slow enough that every thread gets a share of the points.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  objective_function_1(N_parameters, x, f, failed_int, problem, user_data);
+}
+
+int batch_objective_calls;
+
+void batch_objective_function_1(int* N_parameters, int* N_points, const double* x, double* f, int* failures, mango::Problem* problem, void* user_data) {
+  assert(*N_points >= 1);
+  batch_objective_calls++;
+  for (int j_point = 0; j_point < *N_points; j_point++) {
+    objective_function_1(N_parameters, &x[j_point * (*N_parameters)], &f[j_point], &failures[j_point], problem, user_data);
+  }
+}
+
+// A mock asynchronous interface, in which each evaluation finishes on the second poll.
+std::vector<std::vector<double> > async_state_vectors;
+std::vector<int> async_polls;
+int async_in_flight, async_max_in_flight;
+
+void async_start_function_1(int* N_parameters, const double* x, int* N_terms, int* handle, mango::Problem*, void*) {
+  assert(*N_terms == 1);
+  *handle = async_state_vectors.size();
+  async_state_vectors.push_back(std::vector<double>(x, x + *N_parameters));
+  async_polls.push_back(0);
+  async_in_flight++;
+  if (async_in_flight > async_max_in_flight) async_max_in_flight = async_in_flight;
+}
+
+void async_poll_function_1(int* handle, int*, double* f, int* status, mango::Problem* problem, void* user_data) {
+  async_polls[*handle]++;
+  if (async_polls[*handle] < 2) {
+    *status = mango::ASYNC_RUNNING;
+    return;
+  }
+  int N_parameters = async_state_vectors[*handle].size();
+  int failed_int;
+  objective_function_1(&N_parameters, async_state_vectors[*handle].data(), f, &failed_int, problem, user_data);
+  *status = mango::ASYNC_SUCCEEDED;
+  async_in_flight--;
+}
+
 
 TEST_CASE_METHOD(mango::Solver, "Solver::finite_difference_gradient()","[Solver][finite difference]") {
   // The Catch2 macros automatically call the mango::Solver() constructor (the version with no arguments).
@@ -91,6 +149,116 @@ TEST_CASE_METHOD(mango::Solver, "Solver::finite_difference_gradient()","[Solver]
       // Also check best_state_vector, best_objective_function and best_function_evaluation?
     }
   }
+  SECTION("1-sided differences, with threads") {
+    centered_differences = false;
+    N_threads = 3;
+    objective_function = &objective_function_1_recording_threads;
+    objective_thread_ids.clear();
+
+    if (mpi_partition->get_proc0_world()) {
+      // Case of proc0_world
+      finite_difference_gradient(state_vector, &base_case_objective_function, gradient);
+      // Tell group leaders to exit.
+      int data = -1;
+      MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+    } else {
+      // Case for group leaders:
+      if (mpi_partition->get_proc0_worker_groups()) {
+	group_leaders_loop();
+      } else {
+	// Everybody else, i.e. workers. Nothing to do here.
+      }
+    }
+    
+    if (mpi_partition->get_proc0_world()) {
+      // The results should be identical to the case without threads.
+      CHECK(        function_evaluations == 4);
+      CHECK(base_case_objective_function == Approx(correct_objective_function).epsilon(1e-14));
+      CHECK(                 gradient[0] == Approx( 5.865176283537110e-01).epsilon(1e-13));
+      CHECK(                 gradient[1] == Approx(-6.010834349701177e-01).epsilon(1e-13));
+      CHECK(                 gradient[2] == Approx( 2.250910244305793e-01).epsilon(1e-13));
+    }
+    if (mpi_partition->get_proc0_worker_groups()) {
+      // Each group leader should have used up to 3 threads for its share of the 4 points.
+      int N_my_points = 0;
+      for (int j_set = 0; j_set < 4; j_set++) {
+	if ((j_set % mpi_partition->get_N_worker_groups()) == mpi_partition->get_rank_group_leaders()) N_my_points++;
+      }
+      CHECK(objective_thread_ids.size() == std::min(3, N_my_points));
+    } else {
+      CHECK(objective_thread_ids.size() == 0);
+    }
+  }
+  SECTION("1-sided differences, with a batch objective function") {
+    centered_differences = false;
+    batch_objective_function = &batch_objective_function_1;
+    batch_objective_calls = 0;
+
+    if (mpi_partition->get_proc0_world()) {
+      // Case of proc0_world
+      finite_difference_gradient(state_vector, &base_case_objective_function, gradient);
+      // Tell group leaders to exit.
+      int data = -1;
+      MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+    } else {
+      // Case for group leaders:
+      if (mpi_partition->get_proc0_worker_groups()) {
+	group_leaders_loop();
+      } else {
+	// Everybody else, i.e. workers. Nothing to do here.
+      }
+    }
+    
+    if (mpi_partition->get_proc0_world()) {
+      // The results should be identical to the case without a batch function.
+      CHECK(        function_evaluations == 4);
+      CHECK(base_case_objective_function == Approx(correct_objective_function).epsilon(1e-14));
+      CHECK(                 gradient[0] == Approx( 5.865176283537110e-01).epsilon(1e-13));
+      CHECK(                 gradient[1] == Approx(-6.010834349701177e-01).epsilon(1e-13));
+      CHECK(                 gradient[2] == Approx( 2.250910244305793e-01).epsilon(1e-13));
+    }
+    // Each group leader should have evaluated its share of the points in a single call to the batch function.
+    CHECK(batch_objective_calls == (mpi_partition->get_proc0_worker_groups() ? 1 : 0));
+  }
+  SECTION("1-sided differences, with asynchronous evaluations") {
+    centered_differences = false;
+    async_start_function = &async_start_function_1;
+    async_poll_function = &async_poll_function_1;
+    max_async_evaluations = 2;
+    async_poll_interval = 0;
+    async_state_vectors.clear();
+    async_polls.clear();
+    async_in_flight = 0;
+    async_max_in_flight = 0;
+
+    if (mpi_partition->get_proc0_world()) {
+      // Case of proc0_world
+      finite_difference_gradient(state_vector, &base_case_objective_function, gradient);
+      // Tell group leaders to exit.
+      int data = -1;
+      MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+    } else {
+      // Case for group leaders:
+      if (mpi_partition->get_proc0_worker_groups()) {
+	group_leaders_loop();
+      } else {
+	// Everybody else, i.e. workers. Nothing to do here.
+      }
+    }
+    
+    if (mpi_partition->get_proc0_world()) {
+      // The results should be identical to the case of synchronous evaluations.
+      CHECK(        function_evaluations == 4);
+      CHECK(base_case_objective_function == Approx(correct_objective_function).epsilon(1e-14));
+      CHECK(                 gradient[0] == Approx( 5.865176283537110e-01).epsilon(1e-13));
+      CHECK(                 gradient[1] == Approx(-6.010834349701177e-01).epsilon(1e-13));
+      CHECK(                 gradient[2] == Approx( 2.250910244305793e-01).epsilon(1e-13));
+      // With a single worker group, proc0 owns all 4 points, so it should keep the maximum number in flight.
+      CHECK(async_max_in_flight <= 2);
+      if (mpi_partition->get_N_worker_groups() == 1) CHECK(async_max_in_flight == 2);
+    }
+    CHECK(async_in_flight == 0);
+  }
   SECTION("centered differences") {
     centered_differences = true;
 
@@ -124,6 +292,202 @@ TEST_CASE_METHOD(mango::Solver, "Solver::finite_difference_gradient()","[Solver]
   delete[] gradient;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Test that failed evaluations are reported by each way of evaluating a set of points.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void failing_objective_function(int* N_parameters, const double* x, double* f, int* failed_int, mango::Problem* problem, void* user_data) {
+  // Like objective_function_1, except that evaluations with x[0] < 0 fail, returning a value that would otherwise be the best.
+  objective_function_1(N_parameters, x, f, failed_int, problem, user_data);
+  if (x[0] < 0) {
+    *f = -1.0e10;
+    *failed_int = true;
+  }
+}
+
+void batch_failing_objective_function(int* N_parameters, int* N_points, const double* x, double* f, int* failures, mango::Problem* problem, void* user_data) {
+  batch_objective_calls++;
+  for (int j_point = 0; j_point < *N_points; j_point++) {
+    failing_objective_function(N_parameters, &x[j_point * (*N_parameters)], &f[j_point], &failures[j_point], problem, user_data);
+  }
+}
+
+void async_poll_failing_function(int* handle, int*, double* f, int* status, mango::Problem* problem, void* user_data) {
+  async_polls[*handle]++;
+  if (async_polls[*handle] < 2) {
+    *status = mango::ASYNC_RUNNING;
+    return;
+  }
+  int N_parameters = async_state_vectors[*handle].size();
+  int failed_int;
+  failing_objective_function(&N_parameters, async_state_vectors[*handle].data(), f, &failed_int, problem, user_data);
+  *status = (failed_int ? mango::ASYNC_FAILED : mango::ASYNC_SUCCEEDED);
+  async_in_flight--;
+}
+
+TEST_CASE_METHOD(mango::Solver, "Solver::evaluate_objective_set_in_parallel(): failed evaluations give infinity and are never the best point.","[Solver]") {
+  N_parameters = 3;
+  best_state_vector = new double[N_parameters];
+  state_vector = new double[N_parameters];
+  objective_function = &failing_objective_function;
+  function_evaluations = 0;
+  at_least_one_success = false;
+  verbose = 0;
+
+  // Set up MPI:
+  mpi_partition = new mango::MPI_Partition();
+  auto N_worker_groups_requested = GENERATE(range(1,5)); // Scan over N_worker_groups
+  mpi_partition->set_N_worker_groups(N_worker_groups_requested);
+  mpi_partition->init(MPI_COMM_WORLD);
+
+  // The third point fails.
+  const int N_set = 4;
+  double state_vectors[N_set * 3] = {1.2, 0.9, -0.4,  0.5, 0.9, -0.4,  -0.3, 0.9, -0.4,  0.8, 0.9, -0.4};
+  double correct_objective_functions[N_set];
+  for (int j_set = 0; j_set < N_set; j_set++) {
+    int failed_int;
+    objective_function_1(&N_parameters, &state_vectors[j_set * N_parameters], &correct_objective_functions[j_set], &failed_int, NULL, NULL);
+  }
+  correct_objective_functions[2] = std::numeric_limits<double>::infinity();
+
+  SECTION("One point at a time") {
+  }
+  SECTION("With threads") {
+    N_threads = 3;
+  }
+  SECTION("With a batch objective function") {
+    batch_objective_function = &batch_failing_objective_function;
+  }
+  SECTION("With asynchronous evaluations") {
+    async_start_function = &async_start_function_1;
+    async_poll_function = &async_poll_failing_function;
+    max_async_evaluations = 2;
+    async_poll_interval = 0;
+    async_state_vectors.clear();
+    async_polls.clear();
+    async_in_flight = 0;
+  }
+
+  double objective_functions[N_set];
+  if (mpi_partition->get_proc0_worker_groups()) {
+    evaluate_objective_set_in_parallel(N_set, state_vectors, objective_functions);
+    // The results should be available on every group leader.
+    for (int j_set = 0; j_set < N_set; j_set++) {
+      CAPTURE(j_set);
+      CHECK(objective_functions[j_set] == Approx(correct_objective_functions[j_set]).epsilon(1e-14));
+    }
+  }
+
+  if (mpi_partition->get_proc0_world()) {
+    // The failed point has the smallest value returned, but the best point should be the second point.
+    CHECK(function_evaluations == N_set);
+    CHECK(at_least_one_success);
+    CHECK(best_function_evaluation == 2);
+    CHECK(best_objective_function == Approx(correct_objective_functions[1]).epsilon(1e-14));
+    CHECK(best_state_vector[0] == 0.5);
+  }
+
+  delete[] state_vector;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Test switching between the wide and deep layouts of the processes.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Size of the worker group that took part in the last evaluation.
+int dynamic_group_size;
+
+void dynamic_worker(mango::Problem*, void* user_data) {
+  mango::MPI_Partition* mpi_partition = (mango::MPI_Partition*) user_data;
+  int N = 1;
+  MPI_Allreduce(MPI_IN_PLACE, &N, 1, MPI_INT, MPI_SUM, mpi_partition->get_comm_worker_groups());
+}
+
+void dynamic_objective_function(int* N_parameters, const double* x, double* f, int* failed_int, mango::Problem* problem, void* user_data) {
+  mango::MPI_Partition* mpi_partition = (mango::MPI_Partition*) user_data;
+  mpi_partition->mobilize_workers();
+  int N = 1;
+  MPI_Allreduce(MPI_IN_PLACE, &N, 1, MPI_INT, MPI_SUM, mpi_partition->get_comm_worker_groups());
+  dynamic_group_size = N;
+  objective_function_1(N_parameters, x, f, failed_int, problem, user_data);
+}
+
+TEST_CASE_METHOD(mango::Solver, "Solver::set_layout(): Verify that single evaluations use every proc, while finite-difference gradients use the wide layout.","[Solver][finite difference][mpi_partition]") {
+  N_parameters = 3;
+  best_state_vector = new double[N_parameters];
+  state_vector = new double[N_parameters];
+  double* gradient = new double[N_parameters];
+  objective_function = &dynamic_objective_function;
+  worker_function = &dynamic_worker;
+  function_evaluations = 0;
+  verbose = 0;
+  centered_differences = false;
+  finite_difference_step_size = 1.0e-7;
+  double base_case_objective_function, f;
+  bool failed;
+
+  int N_procs_world;
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+  mpi_partition = new mango::MPI_Partition();
+  auto N_worker_groups_requested = GENERATE(range(1,5));
+  mpi_partition->set_N_worker_groups(N_worker_groups_requested);
+  mpi_partition->set_dynamic(true);
+  mpi_partition->init(MPI_COMM_WORLD);
+  user_data = mpi_partition;
+  dynamic_layouts = mpi_partition->get_dynamic();
+  CHECK(dynamic_layouts == (mpi_partition->get_N_worker_groups() > 1));
+  int N_procs_wide = mpi_partition->get_N_procs_worker_groups();
+  int N_worker_groups = mpi_partition->get_N_worker_groups();
+
+  state_vector[0] =  1.2;
+  state_vector[1] =  0.9;
+  state_vector[2] = -0.4;
+
+  if (mpi_partition->get_proc0_world()) {
+    finite_difference_gradient(state_vector, &base_case_objective_function, gradient);
+    CHECK(dynamic_group_size == N_procs_wide);
+    CHECK(!mpi_partition->get_deep());
+
+    objective_function_wrapper(state_vector, &f, &failed);
+    CHECK(dynamic_group_size == (dynamic_layouts ? N_procs_world : N_procs_wide));
+    CHECK(mpi_partition->get_deep() == dynamic_layouts);
+    if (dynamic_layouts) {
+      CHECK(mpi_partition->get_N_worker_groups() == 1);
+      CHECK(mpi_partition->get_N_procs_worker_groups() == N_procs_world);
+    }
+    // A second single evaluation should not switch layouts again.
+    objective_function_wrapper(state_vector, &f, &failed);
+    CHECK(dynamic_group_size == (dynamic_layouts ? N_procs_world : N_procs_wide));
+
+    finite_difference_gradient(state_vector, &base_case_objective_function, gradient);
+    CHECK(dynamic_group_size == N_procs_wide);
+    CHECK(!mpi_partition->get_deep());
+    CHECK(function_evaluations == 10);
+    CHECK(f == Approx(2.443823056453063e-01).epsilon(1e-14));
+    CHECK(gradient[0] == Approx( 5.865176283537110e-01).epsilon(1e-13));
+    CHECK(gradient[1] == Approx(-6.010834349701177e-01).epsilon(1e-13));
+    CHECK(gradient[2] == Approx( 2.250910244305793e-01).epsilon(1e-13));
+
+    // Tell group leaders to exit, in the wide layout.
+    set_layout(false);
+    int data = -1;
+    MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+    mpi_partition->stop_workers();
+  } else if (mpi_partition->get_proc0_worker_groups()) {
+    group_leaders_loop();
+    mpi_partition->stop_workers();
+  } else {
+    while (mpi_partition->continue_worker_loop()) dynamic_worker(problem, user_data);
+  }
+
+  // Every proc should be back in the wide layout.
+  CHECK(!mpi_partition->get_deep());
+  CHECK(mpi_partition->get_N_worker_groups() == N_worker_groups);
+  CHECK(mpi_partition->get_N_procs_worker_groups() == N_procs_wide);
+
+  delete[] gradient;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Now consider a least-squares problem, and test both finite_difference_Jacobian() and
 // finite_difference_gradient().
@@ -138,6 +502,13 @@ void residual_function_1(int* N_parameters, const double* x, int* N_terms, doubl
   *failed_int = false;
 }
 
+void batch_residual_function_1(int* N_parameters, int* N_points, const double* x, int* N_terms, double* f, int* failures, mango::Problem* problem, void* user_data) {
+  assert(*N_points >= 1);
+  for (int j_point = 0; j_point < *N_points; j_point++) {
+    residual_function_1(N_parameters, &x[j_point * (*N_parameters)], N_terms, &f[j_point * (*N_terms)], &failures[j_point], problem, user_data);
+  }
+}
+
 
 TEST_CASE_METHOD(mango::Least_squares_solver, "Least_squares_solver::finite_difference_Jacobian() and problem::finite_difference_gradient()","[problem][finite difference]") {
   // The Catch2 macros automatically call the mango::problem() constructor (the version with no arguments).
@@ -249,6 +620,67 @@ TEST_CASE_METHOD(mango::Least_squares_solver, "Least_squares_solver::finite_diff
       
     }
   }
+  SECTION("1-sided differences, Jacobian, with a batch residual function") {
+    centered_differences = false;
+    batch_residual_function = &batch_residual_function_1;
+
+    if (mpi_partition->get_proc0_world()) {
+      // Case of proc0_world
+      finite_difference_Jacobian(state_vector, base_case_residuals, Jacobian);
+      // Tell group leaders to exit.
+      int data = -1;
+      MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+    } else {
+      // Case for group leaders:
+      if (mpi_partition->get_proc0_worker_groups()) {
+	group_leaders_loop();
+      } else {
+	// Everybody else, i.e. workers. Nothing to do here.
+      }
+    }
+    
+    if (mpi_partition->get_proc0_world()) {
+      // The results should be identical to the case without a batch function.
+      CHECK(function_evaluations == 3);
+      for (int k=0; k<N_terms; k++) {
+	CHECK(base_case_residuals[k] == Approx(correct_residuals[k]).epsilon(1e-14));
+	CHECK(Jacobian[k]            == Approx(correct_d_residuals_d_x0_1sided[k]).epsilon(1e-13));
+	CHECK(Jacobian[k+N_terms]    == Approx(correct_d_residuals_d_x1_1sided[k]).epsilon(1e-13));
+      }
+    }
+  }
+  SECTION("1-sided differences, Jacobian, with the shared-memory transport") {
+    centered_differences = false;
+    use_shared_memory = true;
+
+    // Evaluate the Jacobian twice, to check that the shared buffer can be reused.
+    for (int j_repeat = 0; j_repeat < 2; j_repeat++) {
+      if (mpi_partition->get_proc0_world()) {
+	// Case of proc0_world
+	finite_difference_Jacobian(state_vector, base_case_residuals, Jacobian);
+	// Tell group leaders to exit.
+	int data = -1;
+	MPI_Bcast(&data,1,MPI_INT,0,mpi_partition->get_comm_group_leaders());
+      } else {
+	// Case for group leaders:
+	if (mpi_partition->get_proc0_worker_groups()) {
+	  group_leaders_loop();
+	} else {
+	  // Everybody else, i.e. workers. Nothing to do here.
+	}
+      }
+    }
+    
+    if (mpi_partition->get_proc0_world()) {
+      // The results should be identical to the case without shared memory.
+      CHECK(function_evaluations == 6);
+      for (int k=0; k<N_terms; k++) {
+	CHECK(base_case_residuals[k] == Approx(correct_residuals[k]).epsilon(1e-14));
+	CHECK(Jacobian[k]            == Approx(correct_d_residuals_d_x0_1sided[k]).epsilon(1e-13));
+	CHECK(Jacobian[k+N_terms]    == Approx(correct_d_residuals_d_x1_1sided[k]).epsilon(1e-13));
+      }
+    }
+  }
   SECTION("Centered differences, Jacobian") { // This section tests finite_difference_Jacobian()
     centered_differences = true;
 
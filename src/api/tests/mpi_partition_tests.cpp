@@ -16,6 +16,11 @@
 // License along with MANGO.  If not, see
 // <https://www.gnu.org/licenses/>.
 
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
 #include "catch.hpp"
 #include "mango.hpp"
 
@@ -255,6 +260,490 @@ TEST_CASE("MPI_Partition.set_custom(): Verify that for any choice of N_worker_gr
 }
 
 
+TEST_CASE("MPI_Partition::assign_worker_groups_to_domains(): Verify the assignment for several layouts of processes on nodes.","[mpi_partition]") {
+  int worker_group_of_proc[6];
+
+  SECTION("2 nodes with 3 procs each, 2 worker groups") {
+    int node_of_proc[6] = {0, 0, 0, 1, 1, 1};
+    int correct[6] = {0, 0, 0, 1, 1, 1};
+    mango::MPI_Partition::assign_worker_groups_to_domains(6, node_of_proc, 2, worker_group_of_proc);
+    for (int j = 0; j < 6; j++) CHECK(worker_group_of_proc[j] == correct[j]);
+  }
+
+  SECTION("2 nodes with 3 procs each, 4 worker groups. The default partition would put procs 2 and 3 in the same group.") {
+    int node_of_proc[6] = {0, 0, 0, 1, 1, 1};
+    int correct[6] = {0, 0, 1, 2, 2, 3};
+    mango::MPI_Partition::assign_worker_groups_to_domains(6, node_of_proc, 4, worker_group_of_proc);
+    for (int j = 0; j < 6; j++) CHECK(worker_group_of_proc[j] == correct[j]);
+  }
+
+  SECTION("Ranks placed round-robin on 2 nodes") {
+    int node_of_proc[6] = {0, 1, 0, 1, 0, 1};
+    int correct[6] = {0, 1, 0, 1, 0, 1};
+    mango::MPI_Partition::assign_worker_groups_to_domains(6, node_of_proc, 2, worker_group_of_proc);
+    for (int j = 0; j < 6; j++) CHECK(worker_group_of_proc[j] == correct[j]);
+  }
+
+  SECTION("Nodes of unequal size") {
+    int node_of_proc[6] = {0, 0, 0, 0, 1, 1};
+    int correct[6] = {0, 0, 1, 1, 2, 2};
+    mango::MPI_Partition::assign_worker_groups_to_domains(6, node_of_proc, 3, worker_group_of_proc);
+    for (int j = 0; j < 6; j++) CHECK(worker_group_of_proc[j] == correct[j]);
+  }
+
+  SECTION("Fewer worker groups than nodes, so whole nodes are combined") {
+    int node_of_proc[6] = {0, 0, 1, 1, 2, 2};
+    int correct[6] = {0, 0, 0, 0, 1, 1};
+    mango::MPI_Partition::assign_worker_groups_to_domains(6, node_of_proc, 2, worker_group_of_proc);
+    for (int j = 0; j < 6; j++) CHECK(worker_group_of_proc[j] == correct[j]);
+  }
+
+  SECTION("One worker group per proc") {
+    int node_of_proc[6] = {0, 1, 1, 0, 2, 2};
+    mango::MPI_Partition::assign_worker_groups_to_domains(6, node_of_proc, 6, worker_group_of_proc);
+    for (int j = 0; j < 6; j++) CHECK(worker_group_of_proc[j] == j);
+  }
+
+  SECTION("Invalid N_worker_groups") {
+    int node_of_proc[6] = {0, 0, 0, 1, 1, 1};
+    CHECK_THROWS(mango::MPI_Partition::assign_worker_groups_to_domains(6, node_of_proc, 0, worker_group_of_proc));
+    CHECK_THROWS(mango::MPI_Partition::assign_worker_groups_to_domains(6, node_of_proc, 7, worker_group_of_proc));
+  }
+}
+
+
+TEST_CASE("MPI_Partition.init(): Verify that properties make sense when worker groups are aligned to nodes.","[mpi_partition]") {
+  int rank_world, N_procs_world;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank_world);
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+  auto topology = GENERATE(mango::PARTITION_BY_NODE, mango::PARTITION_BY_NUMA);
+
+  for (int N_worker_groups_requested = 1; N_worker_groups_requested <= N_procs_world; N_worker_groups_requested++) {
+    mango::MPI_Partition mp;
+    mp.set_N_worker_groups(N_worker_groups_requested);
+    mp.set_topology(topology);
+    mp.init(MPI_COMM_WORLD);
+
+    CAPTURE(rank_world, N_worker_groups_requested);
+
+    CHECK(mp.get_N_worker_groups() == N_worker_groups_requested);
+    CHECK(mp.get_N_nodes() >= 1);
+    CHECK(mp.get_N_nodes() <= N_procs_world);
+    CHECK(mp.get_node() >= 0);
+    CHECK(mp.get_node() < mp.get_N_nodes());
+    CHECK(mp.get_worker_group() >= 0);
+    CHECK(mp.get_worker_group() < N_worker_groups_requested);
+    CHECK(mp.get_proc0_world() == (rank_world==0));
+    if (rank_world == 0) CHECK(mp.get_proc0_worker_groups());
+    // evaluate_set_in_parallel() relies on the group leaders being ordered by worker group:
+    if (mp.get_proc0_worker_groups()) CHECK(mp.get_rank_group_leaders() == mp.get_worker_group());
+    CHECK_THROWS(mp.set_topology(mango::PARTITION_BY_RANK));
+
+    // All procs in a worker group should be on the same node when there are at least as many groups as nodes.
+    if (N_worker_groups_requested >= mp.get_N_nodes()) {
+      int node_min = mp.get_node();
+      int node_max = mp.get_node();
+      MPI_Allreduce(MPI_IN_PLACE, &node_min, 1, MPI_INT, MPI_MIN, mp.get_comm_worker_groups());
+      MPI_Allreduce(MPI_IN_PLACE, &node_max, 1, MPI_INT, MPI_MAX, mp.get_comm_worker_groups());
+      CHECK(node_min == node_max);
+    }
+  }
+}
+
+TEST_CASE("MPI_Partition: Verify that a partition can be set up again with init() and set_custom() in any order.","[mpi_partition]") {
+  // Each set-up frees the communicators created by the previous one, including the node communicator, but not those passed to set_custom().
+  int rank_world, N_procs_world;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank_world);
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+
+  mango::MPI_Partition mp_init;
+  mp_init.set_N_worker_groups(2);
+  mp_init.init(MPI_COMM_WORLD);
+
+  mango::MPI_Partition mp;
+  mp.set_N_worker_groups(N_procs_world);
+  for (int j = 0; j < 5; j++) {
+    CAPTURE(j);
+    if (j % 2 == 0) {
+      mp.init(MPI_COMM_WORLD);
+    } else {
+      mp.set_custom(mp_init.get_comm_world(), mp_init.get_comm_group_leaders(), mp_init.get_comm_worker_groups());
+      CHECK(mp.get_N_worker_groups() == mp_init.get_N_worker_groups());
+    }
+    int N_procs_node;
+    MPI_Comm_size(mp.get_comm_node(), &N_procs_node);
+    CHECK(N_procs_node >= 1);
+    CHECK(mp.get_node() >= 0);
+    CHECK(mp.get_node() < mp.get_N_nodes());
+    // The number of procs on all nodes should add up to the number of procs in comm_world:
+    int rank_node;
+    MPI_Comm_rank(mp.get_comm_node(), &rank_node);
+    int N_procs_total = (rank_node == 0) ? N_procs_node : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &N_procs_total, 1, MPI_INT, MPI_SUM, mp.get_comm_world());
+    CHECK(N_procs_total == N_procs_world);
+  }
+  // The communicators passed to set_custom() must still be usable:
+  int N_procs_worker_groups;
+  MPI_Comm_size(mp_init.get_comm_worker_groups(), &N_procs_worker_groups);
+  CHECK(N_procs_worker_groups == mp_init.get_N_procs_worker_groups());
+}
+
+TEST_CASE("Shared_data: Verify that data loaded on proc0_world are visible to every proc.","[mpi_partition][Shared_data]") {
+  int rank_world, N_procs_world;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank_world);
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+  auto N_worker_groups_requested = GENERATE(1, 2);
+
+  mango::MPI_Partition mp;
+  mp.set_N_worker_groups(N_worker_groups_requested);
+  mp.init(MPI_COMM_WORLD);
+
+  int N_procs_node;
+  MPI_Comm_size(mp.get_comm_node(), &N_procs_node);
+  CHECK(N_procs_node >= 1);
+  CHECK(N_procs_node <= N_procs_world);
+
+  const int N = 1000;
+  mango::Shared_data data;
+  // Only the value of N_bytes on proc0_world should matter:
+  data.allocate(mp, (rank_world == 0 ? N * sizeof(double) : 7));
+  CHECK(data.get_N_bytes() == N * sizeof(double));
+  double* x = (double*) data.get_pointer();
+  if (mp.get_proc0_world()) {
+    for (int j = 0; j < N; j++) x[j] = j * 0.5 - 3;
+  }
+  data.share();
+  for (int j = 0; j < N; j++) CHECK(x[j] == j * 0.5 - 3);
+
+  // A second allocation should replace the first.
+  data.allocate(mp, 3);
+  char* c = (char*) data.get_pointer();
+  if (mp.get_proc0_world()) {
+    c[0] = 'a';
+    c[1] = 'b';
+    c[2] = 'c';
+  }
+  data.share();
+  CHECK(c[0] == 'a');
+  CHECK(c[2] == 'c');
+}
+
+TEST_CASE("MPI_Partition.repartition(): Verify that the processes can be re-split into a different number of worker groups.","[mpi_partition]") {
+  int N_procs_world;
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+  auto N_worker_groups_requested = GENERATE(1, 2, 3, 4);
+
+  mango::MPI_Partition mp;
+  // Calling repartition() before init() should cause an exception:
+  CHECK_THROWS(mp.repartition(1));
+
+  mp.set_N_worker_groups(1);
+  mp.init(MPI_COMM_WORLD);
+  CHECK(mp.get_N_worker_groups() == 1);
+
+  mp.repartition(N_worker_groups_requested);
+  int N_worker_groups = (N_worker_groups_requested > N_procs_world) ? N_procs_world : N_worker_groups_requested;
+  CHECK(mp.get_N_worker_groups() == N_worker_groups);
+  CHECK(mp.get_N_procs_world() == N_procs_world);
+  int N_procs_group_leaders = mp.get_proc0_worker_groups() ? mp.get_N_procs_group_leaders() : 0;
+  MPI_Allreduce(MPI_IN_PLACE, &N_procs_group_leaders, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  CHECK(N_procs_group_leaders == N_worker_groups);
+
+  // Going back should also work:
+  mp.repartition(1);
+  CHECK(mp.get_N_worker_groups() == 1);
+  CHECK(mp.get_N_procs_worker_groups() == N_procs_world);
+
+  // Partitions supplied by the user cannot be re-split:
+  mango::MPI_Partition mp_custom;
+  mp_custom.set_custom(MPI_COMM_WORLD, MPI_COMM_WORLD, MPI_COMM_SELF);
+  CHECK_THROWS(mp_custom.repartition(1));
+}
+
+TEST_CASE("MPI_Partition.switch_layout(): Verify that workers pick up the communicators of the deep and wide layouts.","[mpi_partition]") {
+  int N_procs_world;
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+  auto N_worker_groups_requested = GENERATE(1, 2, 3, 4);
+
+  mango::MPI_Partition mp;
+  mp.set_N_worker_groups(N_worker_groups_requested);
+  mp.set_dynamic(true);
+  mp.init(MPI_COMM_WORLD);
+  int N_worker_groups = mp.get_N_worker_groups();
+  int N_procs_worker_groups = mp.get_N_procs_worker_groups();
+  bool proc0_worker_groups = mp.get_proc0_worker_groups();
+  REQUIRE(mp.get_dynamic() == (N_worker_groups > 1));
+  CHECK(!mp.get_deep());
+  if (!mp.get_dynamic()) {
+    if (proc0_worker_groups) CHECK_THROWS(mp.switch_layout());
+    return;
+  }
+
+  // Switch to the deep layout, and carry out an evaluation in which the workers count themselves.
+  int N = 1;
+  if (proc0_worker_groups) mp.switch_layout();
+  if (mp.get_proc0_world()) {
+    mp.mobilize_workers();
+  } else {
+    CHECK(mp.continue_worker_loop());
+  }
+  CHECK(mp.get_deep());
+  CHECK(mp.get_N_worker_groups() == 1);
+  CHECK(mp.get_N_procs_worker_groups() == N_procs_world);
+  CHECK(mp.get_proc0_worker_groups() == mp.get_proc0_world());
+  MPI_Allreduce(MPI_IN_PLACE, &N, 1, MPI_INT, MPI_SUM, mp.get_comm_worker_groups());
+  CHECK(N == N_procs_world);
+
+  // Switch back. Group leaders of the wide layout leave the worker loop right away, while the other workers keep waiting
+  // in continue_worker_loop() until their group leader calls stop_workers().
+  if (mp.get_proc0_world()) {
+    mp.switch_layout();
+  } else {
+    bool keep_working = mp.continue_worker_loop();
+    CHECK(keep_working == false);
+    CHECK(mp.get_proc0_worker_groups() == proc0_worker_groups);
+  }
+  if (proc0_worker_groups) {
+    CHECK(!mp.get_deep());
+    CHECK(mp.get_N_worker_groups() == N_worker_groups);
+    CHECK(mp.get_N_procs_worker_groups() == N_procs_worker_groups);
+    mp.stop_workers();
+  }
+  CHECK(!mp.get_deep());
+  N = 1;
+  MPI_Allreduce(MPI_IN_PLACE, &N, 1, MPI_INT, MPI_SUM, mp.get_comm_worker_groups());
+  CHECK(N == N_procs_worker_groups);
+}
+
+TEST_CASE("MPI_Partition.mobilize_workers(task, data): Verify that the task ID and data reach the workers in one message.","[mpi_partition]") {
+  auto N_worker_groups_requested = GENERATE(1, 2, 3);
+  auto use_custom = GENERATE(false, true);
+  const int N = 4;
+
+  mango::MPI_Partition mp_init;
+  mp_init.set_N_worker_groups(N_worker_groups_requested);
+  mango::MPI_Partition mp;
+  CHECK_THROWS(mp.set_command_size(-1));
+  // Only the value on proc0_world should matter:
+  int rank_world;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank_world);
+  mp.set_command_size(rank_world == 0 ? N : 7);
+  if (use_custom) {
+    mp_init.init(MPI_COMM_WORLD);
+    mp.set_custom(mp_init.get_comm_world(), mp_init.get_comm_group_leaders(), mp_init.get_comm_worker_groups());
+  } else {
+    mp.set_N_worker_groups(N_worker_groups_requested);
+    mp.init(MPI_COMM_WORLD);
+  }
+  CHECK(mp.get_command_size() == N);
+
+  double data[N];
+  int task;
+  if (mp.get_proc0_worker_groups()) {
+    for (int j = 0; j < N; j++) data[j] = mp.get_worker_group() + 0.5 * j;
+    mp.mobilize_workers(17, data);
+    mp.mobilize_workers(); // No data this time.
+    mp.mobilize_workers(3, NULL);
+    mp.stop_workers();
+  } else {
+    for (int j = 0; j < N; j++) data[j] = -1;
+    REQUIRE(mp.continue_worker_loop(&task, data));
+    CHECK(task == 17);
+    for (int j = 0; j < N; j++) CHECK(data[j] == mp.get_worker_group() + 0.5 * j);
+
+    // If no data are sent, the array should not change.
+    for (int j = 0; j < N; j++) data[j] = -1;
+    REQUIRE(mp.continue_worker_loop(&task, data));
+    CHECK(task == 0);
+    REQUIRE(mp.continue_worker_loop(&task, data));
+    CHECK(task == 3);
+    for (int j = 0; j < N; j++) CHECK(data[j] == -1);
+
+    CHECK(!mp.continue_worker_loop(&task, data));
+  }
+}
+
+namespace {
+  // Time for one evaluation of the residuals. The constant factor is the time if all of MPI_COMM_WORLD is used.
+  struct Calibration_data {
+    double base_time;
+    double exponent;
+  };
+
+  void calibration_residual_function(int*, const double* x, int* N_terms, double* f, int* failed, mango::Problem* problem, void* user_data) {
+    Calibration_data* data = (Calibration_data*) user_data;
+    int N_procs = problem->mpi_partition.get_N_procs_worker_groups();
+    problem->mpi_partition.mobilize_workers();
+    usleep((useconds_t) (1.0e6 * data->base_time / pow(N_procs, data->exponent)));
+    for (int j = 0; j < *N_terms; j++) f[j] = x[j];
+    *failed = false;
+  }
+
+  void calibration_worker(mango::Problem*, void*) {
+    // Nothing to do; the group leader does all the work.
+  }
+}
+
+TEST_CASE("Problem::calibrate_worker_groups(): Verify that the number of worker groups is chosen correctly for functions with known scaling.","[mpi_partition]") {
+  int N_procs_world;
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+
+  const int N_parameters = 3;
+  const int N_terms = 3;
+  double state_vector[N_parameters] = {1.0, 2.0, 3.0};
+  double targets[N_terms] = {0.0, 0.0, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0, 1.0};
+  double best_residual_function[N_terms];
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &calibration_residual_function, 0, NULL);
+  problem.set_algorithm(mango::MANGO_LEVENBERG_MARQUARDT);
+  Calibration_data data;
+  problem.set_user_data(&data);
+  std::string log_filename = "mango_calibration.temp";
+
+  // With N_parameters=3, each iteration evaluates 4 points for the Jacobian plus the line search.
+  // The largest number of worker groups that divides N_procs_world and is <= 4 is:
+  int largest = 1;
+  for (int j = 1; j <= N_procs_world && j <= N_parameters + 1; j++) {
+    if (N_procs_world % j == 0) largest = j;
+  }
+
+  SECTION("The time per evaluation does not depend on the number of procs, so there should be as many groups as possible.") {
+    data.base_time = 0.01;
+    data.exponent = 0;
+    problem.calibrate_worker_groups(MPI_COMM_WORLD, &calibration_worker, log_filename);
+    CHECK(problem.mpi_partition.get_N_worker_groups() == largest);
+  }
+
+  SECTION("The time per evaluation drops faster than linearly with the number of procs, so there should be a single group.") {
+    data.base_time = 0.03;
+    data.exponent = 2;
+    problem.calibrate_worker_groups(MPI_COMM_WORLD, &calibration_worker, log_filename);
+    CHECK(problem.mpi_partition.get_N_worker_groups() == 1);
+    CHECK(problem.mpi_partition.get_N_procs_worker_groups() == N_procs_world);
+  }
+
+  // The log file should end with the chosen number of worker groups.
+  if (problem.mpi_partition.get_proc0_world()) {
+    std::ifstream log_file(log_filename.c_str());
+    REQUIRE(log_file.is_open());
+    std::string line, last_line;
+    while (std::getline(log_file, line)) last_line = line;
+    CHECK(last_line == "Chosen N_worker_groups = " + std::to_string(problem.mpi_partition.get_N_worker_groups()));
+  }
+}
+
+namespace {
+  void session_residual_function(int*, const double* x, int* N_terms, double* f, int* failed, mango::Problem* problem, void* user_data) {
+    int* N_evaluations = (int*) user_data;
+    (*N_evaluations)++;
+    problem->mpi_partition.mobilize_workers();
+    for (int j = 0; j < *N_terms; j++) f[j] = x[j];
+    *failed = false;
+  }
+}
+
+TEST_CASE("Problem::begin_session(): Verify that proc0_world can run several solves while the other procs stay in their loops.","[mpi_partition]") {
+  int N_procs_world;
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+
+  const int N_parameters = 2;
+  const int N_terms = 2;
+  const int N_solves = 3;
+  double state_vector[N_parameters] = {1.0, 1.0};
+  double targets[N_terms] = {0.0, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0};
+  double best_residual_function[N_terms];
+  int N_evaluations = 0;
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &session_residual_function, 0, NULL);
+  problem.set_algorithm(mango::MANGO_LEVENBERG_MARQUARDT);
+  problem.set_user_data(&N_evaluations);
+  problem.set_output_filename("mango_out.temp");
+  problem.mpi_partition.set_N_worker_groups((N_procs_world + 1) / 2);
+  problem.mpi_init(MPI_COMM_WORLD);
+
+  int N_worker_loops = 0;
+  if (problem.mpi_partition.get_proc0_worker_groups()) {
+    problem.begin_session();
+    if (problem.mpi_partition.get_proc0_world()) {
+      for (int j_solve = 0; j_solve < N_solves; j_solve++) {
+	// Change the initial condition and targets between solves. Only proc0_world sets them.
+	state_vector[0] = 2.0 + j_solve;
+	state_vector[1] = -1.0 - j_solve;
+	targets[0] = 0.5 * j_solve;
+	targets[1] = -0.25 * j_solve;
+	problem.optimize();
+	CHECK(state_vector[0] == Approx(targets[0]).margin(1e-6));
+	CHECK(state_vector[1] == Approx(targets[1]).margin(1e-6));
+      }
+      problem.end_session();
+    }
+    problem.mpi_partition.stop_workers();
+  } else {
+    while (problem.mpi_partition.continue_worker_loop()) N_worker_loops++;
+  }
+
+  // Every group leader made evaluations in every solve when N_worker_groups > 1, and the workers stayed in a single loop throughout.
+  int N_evaluations_min;
+  int N_evaluations_local = problem.mpi_partition.get_proc0_worker_groups() ? N_evaluations : 1000000;
+  MPI_Allreduce(&N_evaluations_local, &N_evaluations_min, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  if (problem.mpi_partition.get_N_worker_groups() > 1) CHECK(N_evaluations_min >= N_solves);
+  if (!problem.mpi_partition.get_proc0_worker_groups()) CHECK(N_worker_loops > 0);
+}
+
+namespace {
+  void ensemble_worker(mango::Problem*, void* user_data) {
+    int* N_worker_calls = (int*) user_data;
+    (*N_worker_calls)++;
+  }
+}
+
+TEST_CASE("Ensemble: Verify that every problem of an ensemble is solved, and the results are available on every proc.","[mpi_partition]") {
+  int N_procs_world;
+  MPI_Comm_size(MPI_COMM_WORLD, &N_procs_world);
+
+  const int N_problems = 5;
+  const int N_parameters = 2;
+  const int N_terms = 2;
+  double state_vectors[N_problems][N_parameters];
+  double targets[N_problems][N_terms];
+  double sigmas[N_terms] = {1.0, 1.0};
+  double best_residual_functions[N_problems][N_terms];
+  int N_worker_calls = 0;
+  std::vector<mango::Least_squares_problem*> problems;
+  mango::Ensemble ensemble;
+  for (int j = 0; j < N_problems; j++) {
+    state_vectors[j][0] = 1.0 + j;
+    state_vectors[j][1] = -1.0;
+    targets[j][0] = 0.5 * j;
+    targets[j][1] = -0.25 * j;
+    problems.push_back(new mango::Least_squares_problem(N_parameters, state_vectors[j], N_terms, targets[j], sigmas, best_residual_functions[j], &session_residual_function, 0, NULL));
+    problems[j]->set_algorithm(mango::MANGO_LEVENBERG_MARQUARDT);
+    problems[j]->set_user_data(&N_worker_calls);
+    problems[j]->set_worker_function(&ensemble_worker);
+    problems[j]->set_output_filename("mango_ensemble_" + std::to_string(j) + ".temp");
+    ensemble.add_problem(problems[j]);
+  }
+  CHECK(ensemble.get_N_problems() == N_problems);
+
+  int N_worker_groups = GENERATE(range(1,5));
+  ensemble.mpi_partition.set_N_worker_groups(N_worker_groups);
+  ensemble.mpi_init(MPI_COMM_WORLD);
+  ensemble.optimize();
+
+  for (int j = 0; j < N_problems; j++) {
+    CHECK(state_vectors[j][0] == Approx(targets[j][0]).margin(1e-6));
+    CHECK(state_vectors[j][1] == Approx(targets[j][1]).margin(1e-6));
+    CHECK(ensemble.get_optimum(j) == Approx(0.0).margin(1e-10));
+    CHECK(ensemble.get_worker_group(j) >= 0);
+    CHECK(ensemble.get_worker_group(j) < ensemble.mpi_partition.get_N_worker_groups());
+  }
+  // Workers were mobilized by the residual function of the problems their group solved.
+  if (!ensemble.mpi_partition.get_proc0_worker_groups()) CHECK(N_worker_calls > 0);
+  CHECK_THROWS(ensemble.get_optimum(N_problems));
+
+  for (int j = 0; j < N_problems; j++) delete problems[j];
+}
+
 /*
 TEST_CASE("minimal example") {
   int N;
@@ -0,0 +1,241 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "mango.hpp"
+
+TEST_CASE("Multistart::generate_design(): Verify that the designs are stratified.","[Multistart]") {
+  std::vector<double> points;
+
+  SECTION("Latin hypercube") {
+    const int N_points = 13, N_dimensions = 4;
+    mango::Multistart::generate_design(mango::DESIGN_LATIN_HYPERCUBE, N_points, N_dimensions, 0, points);
+    REQUIRE(points.size() == N_points * N_dimensions);
+    for (int j = 0; j < N_dimensions; j++) {
+      std::vector<int> counts(N_points, 0);
+      for (int k = 0; k < N_points; k++) counts[(int) floor(points[k * N_dimensions + j] * N_points)]++;
+      for (int m = 0; m < N_points; m++) CHECK(counts[m] == 1);
+    }
+  }
+
+  SECTION("Sobol") {
+    const int N_points = 64, N_dimensions = 21;
+    mango::Multistart::generate_design(mango::DESIGN_SOBOL, N_points, N_dimensions, 0, points);
+    REQUIRE(points.size() == N_points * N_dimensions);
+    // The first points of the first 2 dimensions:
+    double x[4][2] = {{0.0, 0.0}, {0.5, 0.5}, {0.75, 0.25}, {0.25, 0.75}};
+    for (int k = 0; k < 4; k++) {
+      CHECK(points[k * N_dimensions] == x[k][0]);
+      CHECK(points[k * N_dimensions + 1] == x[k][1]);
+    }
+    // In every dimension, the first 2^n points have one point in each interval of width 2^(-n).
+    for (int j = 0; j < N_dimensions; j++) {
+      for (int n = 1; n <= 6; n++) {
+	int N = 1 << n;
+	std::vector<int> counts(N, 0);
+	for (int k = 0; k < N; k++) counts[(int) floor(points[k * N_dimensions + j] * N)]++;
+	for (int m = 0; m < N; m++) CHECK(counts[m] == 1);
+      }
+    }
+    // In the first 2 dimensions, the 64 points have one point in each box of area 1/64.
+    for (int n = 0; n <= 6; n++) {
+      int N0 = 1 << n, N1 = 64 / N0;
+      std::vector<int> counts(64, 0);
+      for (int k = 0; k < N_points; k++) counts[(int) floor(points[k * N_dimensions] * N0) * N1 + (int) floor(points[k * N_dimensions + 1] * N1)]++;
+      for (int m = 0; m < 64; m++) CHECK(counts[m] == 1);
+    }
+    CHECK_THROWS(mango::Multistart::generate_design(mango::DESIGN_SOBOL, N_points, 22, 0, points));
+  }
+}
+
+namespace {
+  // Residuals whose sum of squares has a global minimum of 0 at (1, 0.5), and a local minimum of about 0.35 near (-0.95, 0.5).
+  void multistart_residual_function(int*, const double* x, int*, double* f, int* failed, mango::Problem* problem, void* user_data) {
+    int* N_evaluations = (int*) user_data;
+    (*N_evaluations)++;
+    problem->mpi_partition.mobilize_workers();
+    f[0] = x[0] * x[0] - 1;
+    f[1] = x[1];
+    f[2] = 0.3 * (x[0] - 1);
+    *failed = false;
+  }
+
+  void multistart_worker(mango::Problem*, void* user_data) {
+    int* N_worker_calls = (int*) user_data;
+    (*N_worker_calls)++;
+  }
+}
+
+TEST_CASE("Multistart: Verify that the global minimum is found from the best starts, and that the output file combines all the evaluations.","[Multistart]") {
+  const int N_parameters = 2;
+  const int N_terms = 3;
+  double state_vector[N_parameters] = {0.0, 0.0};
+  double targets[N_terms] = {0.0, 0.5, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0, 1.0};
+  double best_residual_function[N_terms];
+  double lower_bounds[N_parameters] = {-2.0, -2.0};
+  double upper_bounds[N_parameters] = {2.0, 2.0};
+  int N_worker_calls = 0;
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &multistart_residual_function, 0, NULL);
+  problem.set_algorithm(mango::MANGO_LEVENBERG_MARQUARDT);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_user_data(&N_worker_calls);
+  problem.set_worker_function(&multistart_worker);
+  problem.set_output_filename("mango_multistart.temp");
+  problem.set_max_function_evaluations(200);
+  problem.set_random_seed(0);
+
+  mango::design_type design = GENERATE(mango::DESIGN_LATIN_HYPERCUBE, mango::DESIGN_SOBOL);
+  int N_worker_groups = GENERATE(range(1,5));
+  mango::Multistart multistart(&problem);
+  multistart.set_N_starts(3);
+  multistart.set_N_candidates(16);
+  multistart.set_design(design);
+  multistart.mpi_partition.set_N_worker_groups(N_worker_groups);
+  multistart.mpi_init(MPI_COMM_WORLD);
+  double optimum = multistart.optimize();
+
+  CHECK(optimum == Approx(0.0).margin(1e-10));
+  CHECK(state_vector[0] == Approx(1.0).margin(1e-6));
+  CHECK(state_vector[1] == Approx(0.5).margin(1e-6));
+  CHECK(best_residual_function[0] == Approx(0.0).margin(1e-6));
+  CHECK(best_residual_function[1] == Approx(0.5).margin(1e-6));
+  CHECK(best_residual_function[2] == Approx(0.0).margin(1e-6));
+  CHECK(multistart.get_N_starts() >= 1);
+  CHECK(multistart.get_N_starts() <= 3);
+  for (int j_start = 0; j_start < multistart.get_N_starts(); j_start++) CHECK(multistart.get_optimum(j_start) >= optimum);
+  CHECK_THROWS(multistart.get_optimum(multistart.get_N_starts()));
+  if (!multistart.mpi_partition.get_proc0_worker_groups()) CHECK(N_worker_calls > 0);
+
+  if (multistart.mpi_partition.get_proc0_world()) {
+    // The evaluations are numbered consecutively, and the last line repeats the best one.
+    std::ifstream file("mango_multistart.temp");
+    std::string line;
+    for (int j = 0; j < 5; j++) std::getline(file, line);
+    CHECK(line.find("function_evaluation") == 0);
+    std::vector<int> numbers;
+    while (std::getline(file, line)) numbers.push_back(std::stoi(line.substr(0, line.find(','))));
+    REQUIRE(numbers.size() == problem.get_function_evaluations() + 1);
+    CHECK(problem.get_function_evaluations() > 16);
+    for (int j = 0; j < (int) numbers.size() - 1; j++) CHECK(numbers[j] == j + 1);
+    CHECK(numbers.back() == problem.get_best_function_evaluation());
+    // The output files of the phases have been removed.
+    CHECK(!std::ifstream("mango_multistart.temp.candidates").is_open());
+    CHECK(!std::ifstream("mango_multistart.temp.start_0").is_open());
+  }
+}
+
+TEST_CASE("Multistart: Verify that starts in the basin of a better start are cut off.","[Multistart]") {
+  const int N_parameters = 2;
+  const int N_terms = 3;
+  double state_vector[N_parameters] = {0.0, 0.0};
+  double targets[N_terms] = {0.0, 0.5, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0, 1.0};
+  double best_residual_function[N_terms];
+  double lower_bounds[N_parameters] = {-2.0, -2.0};
+  double upper_bounds[N_parameters] = {2.0, 2.0};
+  int N_worker_calls = 0;
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &multistart_residual_function, 0, NULL);
+  problem.set_algorithm(mango::MANGO_LEVENBERG_MARQUARDT);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_user_data(&N_worker_calls);
+  problem.set_worker_function(&multistart_worker);
+  problem.set_output_filename("mango_multistart.temp");
+  problem.set_random_seed(0);
+
+  // With a radius of 0, no start is cut off. With a radius of 1, the whole box is one basin, so only one start is chosen.
+  double basin_radius = GENERATE(0.0, 0.1, 1.0);
+  int N_worker_groups = GENERATE(range(1,5));
+  mango::Multistart multistart(&problem);
+  multistart.set_N_starts(3);
+  multistart.set_N_candidates(16);
+  multistart.set_design(mango::DESIGN_SOBOL);
+  multistart.set_basin_radius(basin_radius);
+  multistart.mpi_partition.set_N_worker_groups(N_worker_groups);
+  multistart.mpi_init(MPI_COMM_WORLD);
+  double optimum = multistart.optimize();
+
+  CHECK(optimum == Approx(0.0).margin(1e-10));
+  int N_cut_off = 0;
+  for (int j_start = 0; j_start < multistart.get_N_starts(); j_start++) {
+    if (multistart.get_cut_off(j_start)) N_cut_off++;
+  }
+  if (basin_radius == 0) {
+    CHECK(multistart.get_N_starts() == 3);
+    CHECK(N_cut_off == 0);
+  } else if (basin_radius == 1) {
+    CHECK(multistart.get_N_starts() == 1);
+  } else if (N_worker_groups == 1) {
+    // The starts run one after another, and the best candidates include two in the basin of the global minimum,
+    // so the second of these is cut off as it approaches the point found by the first.
+    CHECK(multistart.get_N_starts() == 3);
+    CHECK(!multistart.get_cut_off(0));
+    CHECK(N_cut_off >= 1);
+  }
+  CHECK_THROWS(multistart.get_cut_off(multistart.get_N_starts()));
+}
+
+TEST_CASE("Multistart: Verify that a start using a MANGO algorithm stops early when it is cut off.","[Multistart]") {
+  const int N_parameters = 2;
+  const int N_terms = 3;
+  const int max_function_evaluations = 400;
+  double state_vector[N_parameters] = {0.0, 0.0};
+  double targets[N_terms] = {0.0, 0.5, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0, 1.0};
+  double best_residual_function[N_terms];
+  double lower_bounds[N_parameters] = {-2.0, -2.0};
+  double upper_bounds[N_parameters] = {2.0, 2.0};
+  int N_worker_calls = 0;
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &multistart_residual_function, 0, NULL);
+  // CMA-ES restarts until max_function_evaluations is reached, so a start that makes fewer evaluations has been stopped.
+  problem.set_algorithm(mango::MANGO_CMAES);
+  problem.set_bound_constraints(lower_bounds, upper_bounds);
+  problem.set_random_seed(0);
+  problem.set_user_data(&N_worker_calls);
+  problem.set_worker_function(&multistart_worker);
+  problem.set_output_filename("mango_multistart.temp");
+  problem.set_max_function_evaluations(max_function_evaluations);
+
+  int N_worker_groups = GENERATE(range(1,5));
+  mango::Multistart multistart(&problem);
+  multistart.set_N_starts(3);
+  multistart.set_N_candidates(16);
+  multistart.set_design(mango::DESIGN_SOBOL);
+  multistart.set_basin_radius(0.1);
+  multistart.mpi_partition.set_N_worker_groups(N_worker_groups);
+  multistart.mpi_init(MPI_COMM_WORLD);
+  double optimum = multistart.optimize();
+
+  CHECK(optimum == Approx(0.0).margin(1e-8));
+  int N_stopped = 0;
+  for (int j_start = 0; j_start < multistart.get_N_starts(); j_start++) {
+    int function_evaluations = multistart.get_function_evaluations(j_start);
+    if (!multistart.get_cut_off(j_start)) CHECK(function_evaluations >= max_function_evaluations);
+    if (function_evaluations > 0 && function_evaluations < max_function_evaluations) N_stopped++;
+  }
+  if (multistart.mpi_partition.get_N_worker_groups() == 1) {
+    // The starts run one after another, and the second start in the basin of the global minimum is cut off while it runs.
+    CHECK(!multistart.get_cut_off(0));
+    CHECK(N_stopped >= 1);
+  }
+  CHECK_THROWS(multistart.get_function_evaluations(multistart.get_N_starts()));
+}
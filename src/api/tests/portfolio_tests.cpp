@@ -0,0 +1,128 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "mango.hpp"
+
+namespace {
+  void portfolio_worker(mango::Problem*, void* user_data) {
+    int* N_worker_calls = (int*) user_data;
+    (*N_worker_calls)++;
+  }
+
+  // The Rosenbrock function as a sum of squares, with minimum 0 at (1, 1).
+  void portfolio_residual_function(int*, const double* x, int*, double* f, int* failed, mango::Problem* problem, void*) {
+    problem->mpi_partition.mobilize_workers();
+    f[0] = 10 * (x[1] - x[0] * x[0]);
+    f[1] = 1 - x[0];
+    *failed = false;
+  }
+
+  void portfolio_objective_function(int*, const double* x, double* f, int* failed, mango::Problem*, void*) {
+    *f = x[0] * x[0];
+    *failed = false;
+  }
+}
+
+TEST_CASE("Portfolio: Verify that algorithms and settings are checked.","[Portfolio]") {
+  double state_vector[1] = {1.0};
+  mango::Problem problem(1, state_vector, &portfolio_objective_function, 0, NULL);
+  mango::Portfolio portfolio(&problem);
+  CHECK(portfolio.get_N_algorithms() == 0);
+  CHECK_THROWS(portfolio.add_algorithm((mango::algorithm_type) -1));
+  CHECK_THROWS(portfolio.add_algorithm(mango::NUM_ALGORITHMS));
+  CHECK_THROWS(portfolio.add_algorithm(mango::MANGO_LEVENBERG_MARQUARDT)); // A least-squares algorithm, but the problem is not least-squares.
+  CHECK_THROWS(portfolio.add_algorithm("not_an_algorithm"));
+  portfolio.add_algorithm(mango::MANGO_LBFGS);
+  portfolio.add_algorithm("mango_multidirectional_search");
+  CHECK(portfolio.get_N_algorithms() == 2);
+  CHECK_THROWS(portfolio.set_checkpoint_function_evaluations(0));
+  CHECK_THROWS(portfolio.get_optimum(0));
+  CHECK_THROWS(portfolio.get_elimination(0));
+}
+
+TEST_CASE("Portfolio: Verify that the algorithms that make the least progress are eliminated, and that the output file combines all the evaluations.","[Portfolio]") {
+  const int N_parameters = 2;
+  const int N_terms = 2;
+  double state_vector[N_parameters] = {-1.2, 1.0};
+  double targets[N_terms] = {0.0, 0.0};
+  double sigmas[N_terms] = {1.0, 1.0};
+  double best_residual_function[N_terms];
+  int N_worker_calls = 0;
+  const int max_function_evaluations = 600;
+  mango::Least_squares_problem problem(N_parameters, state_vector, N_terms, targets, sigmas, best_residual_function, &portfolio_residual_function, 0, NULL);
+  problem.set_algorithm(mango::MANGO_POUNDERS);
+  problem.set_user_data(&N_worker_calls);
+  problem.set_worker_function(&portfolio_worker);
+  problem.set_output_filename("mango_portfolio.temp");
+  problem.set_max_function_evaluations(max_function_evaluations);
+
+  int N_worker_groups = GENERATE(range(1,5));
+  mango::Portfolio portfolio(&problem);
+  portfolio.add_algorithm(mango::MANGO_MULTIDIRECTIONAL_SEARCH);
+  portfolio.add_algorithm(mango::MANGO_LEVENBERG_MARQUARDT);
+  portfolio.add_algorithm(mango::MANGO_LBFGS);
+  portfolio.set_checkpoint_function_evaluations(30);
+  portfolio.mpi_partition.set_N_worker_groups(N_worker_groups);
+  portfolio.mpi_init(MPI_COMM_WORLD);
+  double optimum = portfolio.optimize();
+
+  CAPTURE(N_worker_groups, portfolio.get_optimum(0), portfolio.get_optimum(1), portfolio.get_optimum(2));
+  CHECK(optimum == Approx(0.0).margin(1e-10));
+  CHECK(state_vector[0] == Approx(1.0).margin(1e-5));
+  CHECK(state_vector[1] == Approx(1.0).margin(1e-5));
+  CHECK(best_residual_function[0] == Approx(0.0).margin(1e-5));
+  CHECK(best_residual_function[1] == Approx(0.0).margin(1e-5));
+  // After the first checkpoint, the multidirectional search has made the least progress per function evaluation.
+  CHECK(portfolio.get_elimination(0) >= 1);
+  CHECK(portfolio.get_elimination(portfolio.get_winner()) == 0);
+  CHECK(portfolio.get_winner() != 0);
+  int N_eliminated = 0;
+  int total_function_evaluations = 1;
+  for (int j_algorithm = 0; j_algorithm < 3; j_algorithm++) {
+    CHECK(portfolio.get_optimum(j_algorithm) >= optimum);
+    CHECK(portfolio.get_function_evaluations(j_algorithm) > 0);
+    CHECK(portfolio.get_elapsed_time(j_algorithm) >= 0);
+    if (portfolio.get_elimination(j_algorithm) > 0) N_eliminated++;
+    total_function_evaluations += portfolio.get_function_evaluations(j_algorithm);
+  }
+  CHECK(N_eliminated == 2);
+  CHECK(problem.get_function_evaluations() == total_function_evaluations);
+  CHECK(problem.get_function_evaluations() <= max_function_evaluations);
+  CHECK_THROWS(portfolio.get_function_evaluations(3));
+  if (!portfolio.mpi_partition.get_proc0_worker_groups()) CHECK(N_worker_calls > 0);
+
+  if (portfolio.mpi_partition.get_proc0_world()) {
+    // The evaluations are numbered consecutively, starting with the initial state vector, and the last line repeats the best one.
+    std::ifstream file("mango_portfolio.temp");
+    std::string line;
+    for (int j = 0; j < 5; j++) std::getline(file, line);
+    CHECK(line.find("function_evaluation") == 0);
+    std::vector<int> numbers;
+    while (std::getline(file, line)) numbers.push_back(std::stoi(line.substr(0, line.find(','))));
+    REQUIRE(numbers.size() == problem.get_function_evaluations() + 1);
+    for (int j = 0; j < (int) numbers.size() - 1; j++) CHECK(numbers[j] == j + 1);
+    CHECK(numbers.back() == problem.get_best_function_evaluation());
+    // The output files of the phases have been removed.
+    CHECK(!std::ifstream("mango_portfolio.temp.initial").is_open());
+    CHECK(!std::ifstream("mango_portfolio.temp.phase_0").is_open());
+  }
+}
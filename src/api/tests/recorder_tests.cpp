@@ -0,0 +1,247 @@
+// Copyright 2019, University of Maryland and the MANGO development team.
+//
+// This file is part of MANGO.
+//
+// MANGO is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// MANGO is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with MANGO.  If not, see
+// <https://www.gnu.org/licenses/>.
+
+
+#include "catch.hpp"
+#include "mango.hpp"
+#include "Solver.hpp"
+#include "Least_squares_solver.hpp"
+#include "Recorder_least_squares.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+
+std::vector<std::string> read_recorder_test_file(std::string filename) {
+  std::vector<std::string> lines;
+  std::ifstream file(filename.c_str());
+  std::string line;
+  while (std::getline(file, line)) lines.push_back(line);
+  return lines;
+}
+
+int count_columns(std::string line) {
+  return std::count(line.begin(), line.end(), ',') + 1;
+}
+
+double get_column(std::string line, int column) {
+  // column is 0-based.
+  for (int j=0; j<column; j++) line = line.substr(line.find(',') + 1);
+  return std::atof(line.c_str());
+}
+
+
+TEST_CASE_METHOD(mango::Least_squares_solver, "Recorder_least_squares: residual storage policies.","[Recorder][least_squares]") {
+  // The Catch2 macros automatically call the mango::Least_squares_solver() constructor (the version with no arguments).
+  N_parameters = 1;
+  N_terms = 2;
+  best_state_vector = new double[N_parameters];
+  residuals = new double[N_terms]; // We must allocate this variable since the destructor will delete it.
+  best_residual_function = new double[N_terms];
+  state_vector = best_state_vector;
+  verbose = 0;
+  output_filename = "mango_out.temp";
+  print_residuals_in_output_file = true;
+  residual_storage_interval = 2;
+  mpi_partition = new mango::MPI_Partition();
+  mpi_partition->init(MPI_COMM_WORLD);
+  delete recorder;
+  recorder = new mango::Recorder_least_squares(this);
+
+  // A sequence of evaluations in which the 1st and 3rd are new optima, and the 4th fails:
+  const int N_evals = 5;
+  double x[N_evals] = {1.0, 2.0, 3.0, 4.0, 5.0};
+  double r[N_evals][2] = {{1.0, 2.0}, {3.0, 3.0}, {0.5, 1.0}, {0.25, 0.25}, {2.0, 0.0}};
+  bool failures[N_evals] = {false, false, false, true, false};
+
+  auto policy = GENERATE(mango::RESIDUALS_ALL, mango::RESIDUALS_BEST_ONLY, mango::RESIDUALS_EVERY_K,
+			 mango::RESIDUALS_SINGLE_PRECISION, mango::RESIDUALS_DELTA_FROM_BEST);
+  residual_storage = policy;
+
+  function_evaluations = 0;
+  at_least_one_success = false;
+  start_time = clock();
+  recorder->init();
+  for (int j=0; j<N_evals; j++) {
+    current_residuals = r[j];
+    record_function_evaluation(&x[j], r[j][0]*r[j][0] + r[j][1]*r[j][1], failures[j]);
+  }
+  recorder->finalize();
+
+  if (mpi_partition->get_proc0_world()) {
+    std::vector<std::string> lines = read_recorder_test_file(output_filename);
+    // 5 header lines, 1 line per evaluation, and the final line for the optimum:
+    REQUIRE(lines.size() == 5 + N_evals + 1);
+    CHECK(lines[4].find(policy == mango::RESIDUALS_DELTA_FROM_BEST ? ",dF(1)" : ",F(1)") != std::string::npos);
+
+    // Columns are evaluation, time, x, f, and then the residuals. Every line has all the columns, but the residual fields are empty when they are not stored.
+    int columns_with_residuals = 4 + N_terms;
+    for (int j=0; j<N_evals; j++) {
+      bool stored;
+      switch (policy) {
+      case mango::RESIDUALS_BEST_ONLY:
+	stored = (j==0 || j==2);
+	break;
+      case mango::RESIDUALS_EVERY_K:
+	stored = ((j+1) % 2 == 0);
+	break;
+      default:
+	stored = true;
+      }
+      CHECK(count_columns(lines[5+j]) == columns_with_residuals);
+      std::string empty_residuals(N_terms, ',');
+      bool residuals_empty = (lines[5+j].size() >= empty_residuals.size() && lines[5+j].compare(lines[5+j].size() - empty_residuals.size(), empty_residuals.size(), empty_residuals) == 0);
+      CHECK(residuals_empty == !stored);
+    }
+
+    if (policy == mango::RESIDUALS_DELTA_FROM_BEST) {
+      // The reference is 0 until the first success, then the residuals of evaluation 1, then those of evaluation 3.
+      double reference[N_evals][2] = {{0.0, 0.0}, {1.0, 2.0}, {1.0, 2.0}, {0.5, 1.0}, {0.5, 1.0}};
+      for (int j=0; j<N_evals; j++) {
+	CHECK(get_column(lines[5+j], 4) == Approx(r[j][0] - reference[j][0]).epsilon(1e-14));
+	CHECK(get_column(lines[5+j], 5) == Approx(r[j][1] - reference[j][1]).epsilon(1e-14));
+      }
+    }
+
+    // The final line repeats the line of the optimum, which was evaluation 3, in the same format.
+    std::string last_line = lines[5 + N_evals];
+    CHECK(get_column(last_line, 0) == 3);
+    CHECK(last_line == lines[5 + 2]);
+  }
+}
+
+
+typedef struct {
+  int N_calls;
+  int function_evaluations[3];
+  int new_optima[3];
+  int N_terms;
+  double residual_0[3];
+  double objective_values[3];
+} observer_test_data;
+
+void test_observer(int* function_evaluation, int*, const double*, double* f, int* N_terms, const double* residuals,
+		   int* new_optimum, double*, mango::Problem*, void* observer_data) {
+  observer_test_data* data = (observer_test_data*)observer_data;
+  int j = data->N_calls;
+  data->function_evaluations[j] = *function_evaluation;
+  data->new_optima[j] = *new_optimum;
+  data->N_terms = *N_terms;
+  data->residual_0[j] = (residuals == NULL) ? -1.0 : residuals[0];
+  data->objective_values[j] = *f;
+  data->N_calls++;
+}
+
+
+TEST_CASE_METHOD(mango::Least_squares_solver, "Problem::add_observer(): observers receive each function evaluation on proc0_world.","[Recorder][observer]") {
+  N_parameters = 1;
+  N_terms = 2;
+  best_state_vector = new double[N_parameters];
+  residuals = new double[N_terms]; // We must allocate this variable since the destructor will delete it.
+  best_residual_function = new double[N_terms];
+  verbose = 0;
+  mpi_partition = new mango::MPI_Partition();
+  mpi_partition->init(MPI_COMM_WORLD);
+
+  observer_test_data data;
+  data.N_calls = 0;
+  problem->add_observer(&test_observer, &data);
+  CHECK_THROWS(problem->add_observer(NULL, NULL));
+
+  double x[3] = {1.0, 2.0, 3.0};
+  double r[3][2] = {{1.0, 2.0}, {3.0, 3.0}, {0.5, 1.0}};
+  function_evaluations = 0;
+  at_least_one_success = false;
+  start_time = clock();
+  for (int j=0; j<3; j++) {
+    current_residuals = r[j];
+    record_function_evaluation(&x[j], r[j][0]*r[j][0] + r[j][1]*r[j][1], false);
+  }
+
+  if (mpi_partition->get_proc0_world()) {
+    REQUIRE(data.N_calls == 3);
+    CHECK(data.N_terms == 2);
+    for (int j=0; j<3; j++) {
+      CHECK(data.function_evaluations[j] == j+1);
+      CHECK(data.residual_0[j] == r[j][0]);
+      CHECK(data.objective_values[j] == Approx(r[j][0]*r[j][0] + r[j][1]*r[j][1]));
+    }
+    CHECK(data.new_optima[0] == 1);
+    CHECK(data.new_optima[1] == 0);
+    CHECK(data.new_optima[2] == 1);
+  } else {
+    CHECK(data.N_calls == 0);
+  }
+}
+
+
+TEST_CASE_METHOD(mango::Solver, "Metrics_exporter: the metrics file is written atomically in Prometheus text format.","[Recorder][metrics]") {
+  N_parameters = 1;
+  best_state_vector = new double[N_parameters];
+  verbose = 0;
+  output_filename = "mango_out.temp";
+  metrics_filename = "mango_metrics.temp.prom";
+  metrics_interval = 0.0; // Rewrite the file at every opportunity.
+  mpi_partition = new mango::MPI_Partition();
+  auto N_worker_groups_requested = GENERATE(range(1,5)); // Scan over N_worker_groups
+  mpi_partition->set_N_worker_groups(N_worker_groups_requested);
+  mpi_partition->init(MPI_COMM_WORLD);
+  int N_worker_groups = mpi_partition->get_N_worker_groups();
+
+  double x[3] = {1.0, 2.0, 3.0};
+  double f[3] = {5.0, 7.0, 2.5};
+  function_evaluations = 0;
+  at_least_one_success = false;
+  metrics->init();
+  for (int j=0; j<3; j++) record_function_evaluation(&x[j], f[j], j==1);
+  metrics->set_worker_group_utilization(N_worker_groups + 1);
+  metrics->set_levenberg_marquardt_state(4, 0.125);
+
+  if (mpi_partition->get_proc0_world()) {
+    std::vector<std::string> lines = read_recorder_test_file(metrics_filename);
+    std::string labels = "{output_filename=\"mango_out.temp\"}";
+    CHECK(std::find(lines.begin(), lines.end(), "# TYPE mango_function_evaluations_total counter") != lines.end());
+    CHECK(std::find(lines.begin(), lines.end(), "mango_running" + labels + " 1") != lines.end());
+    CHECK(std::find(lines.begin(), lines.end(), "mango_function_evaluations_total" + labels + " 3") != lines.end());
+    CHECK(std::find(lines.begin(), lines.end(), "mango_failed_function_evaluations_total" + labels + " 1") != lines.end());
+    CHECK(std::find(lines.begin(), lines.end(), "mango_best_objective_function" + labels + " 2.5") != lines.end());
+    CHECK(std::find(lines.begin(), lines.end(), "mango_levenberg_marquardt_iteration" + labels + " 4") != lines.end());
+    CHECK(std::find(lines.begin(), lines.end(), "mango_levenberg_marquardt_lambda" + labels + " 0.125") != lines.end());
+    // N_worker_groups + 1 evaluations take 2 rounds, so the utilization is (N_worker_groups + 1) / (2 * N_worker_groups).
+    std::ostringstream utilization;
+    utilization << std::setprecision(16) << (N_worker_groups + 1.0) / (2 * N_worker_groups);
+    CHECK(std::find(lines.begin(), lines.end(), "mango_worker_group_utilization" + labels + " " + utilization.str()) != lines.end());
+    // The temporary file should have been renamed:
+    std::ifstream temp_file((metrics_filename + ".tmp").c_str());
+    CHECK(!temp_file.is_open());
+  }
+
+  metrics->finalize();
+  if (mpi_partition->get_proc0_world()) {
+    std::vector<std::string> lines = read_recorder_test_file(metrics_filename);
+    CHECK(std::find(lines.begin(), lines.end(), "mango_running{output_filename=\"mango_out.temp\"} 0") != lines.end());
+  } else {
+    // Only proc0_world writes the metrics file.
+    CHECK(!metrics->enabled());
+  }
+}